@@ -34,6 +34,7 @@ LOCAL_SRC_FILES    += ./gl-shared/samples/chapter12/sample_pmd_alpha2pass.c
 LOCAL_SRC_FILES    += ./gl-shared/samples/chapter12/sample_pmd_edge.c
 LOCAL_SRC_FILES    += ./gl-shared/samples/chapter12/sample_pmd_facechange.c
 LOCAL_SRC_FILES    += ./gl-shared/samples/chapter12/sample_pmd_load.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter12/sample_pmd_morph.c
 LOCAL_SRC_FILES    += ./gl-shared/samples/chapter12/sample_pmd_multirender.c
 LOCAL_SRC_FILES    += ./gl-shared/samples/chapter12/sample_pmd_multirender_vbo.c
 LOCAL_SRC_FILES    += ./gl-shared/samples/chapter12/sample_pmd_rendering_highp.c
@@ -45,18 +46,51 @@ LOCAL_SRC_FILES    += ./gl-shared/samples/chapter15/sample_pmd_framebuffer_depth
 LOCAL_SRC_FILES    += ./gl-shared/samples/chapter15/sample_pmd_framebuffer_depth_notsupport.c
 LOCAL_SRC_FILES    += ./gl-shared/samples/chapter15/sample_pmd_framebuffer_depthshadow.c
 LOCAL_SRC_FILES    += ./gl-shared/samples/chapter16/sample_async_load.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_bvh_benchmark.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_math_benchmark.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_meshlet_culling.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_occlusion_culling.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_resource_handle.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_scene_graph.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_sprite_batch.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_static_batch.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_texture_atlas.c
+LOCAL_SRC_FILES    += ./gl-shared/samples/chapter17/sample_toon_edge.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_Arena.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Bvh.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_CompressedTexture_KtxImage.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_CompressedTexture_PkmImage.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_CompressedTexture_PvrtcImage.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Frustum.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Occlusion.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Pmd.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_PmdBounds.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_PmdCompact.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_PmdDrawMesh.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_PmdEdge.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_PmdLod.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_PmdMeshlet.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_PmdMorph.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_PmdOptimize.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Pmx.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Resource.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_SceneGraph.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Shader.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Sprite.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_SpriteBatch.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_StaticBatch.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_StreamBuffer.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Texture.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_TextureAtlas.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Texture_RawPixelImage.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Transform.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_Vector.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_gl_VertexLayout.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_HandlePool.c
 LOCAL_SRC_FILES    += ./gl-shared/support/support_RawData.c
+LOCAL_SRC_FILES    += ./gl-shared/support/support_Thread.c
 LOCAL_SRC_FILES    += ./impl/ES20_impl.c
 LOCAL_SRC_FILES    += ./impl/ES20App_impl.c
 LOCAL_SRC_FILES    += ./impl/NDKApplication_impl.c
@@ -64,8 +98,20 @@ LOCAL_SRC_FILES    += ./impl/RawData_impl.c
 LOCAL_SRC_FILES    += ./impl/RawPixelImage_impl.c
 LOCAL_SRC_FILES    += ./support_ndk.c
 
+# armeabi-v7aではNEONを有効にする
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_ARM_NEON := true
+endif
+
+# 三角関数・逆平方根を近似せず、libmで計算する場合は有効にする
+# LOCAL_CFLAGS += -DSUPPORT_MATH_PRECISE=1
+
+# PmdVertex.extraを参照する既存コードをビルドする場合は有効にする
+# LOCAL_CFLAGS += -DSUPPORT_PMD_VERTEX_EXTRA=1
+
 # libs
 LOCAL_LDLIBS += -lGLESv2
+LOCAL_LDLIBS += -lEGL
 LOCAL_LDLIBS += -llog
 
 include $(BUILD_SHARED_LIBRARY)
@@ -32,6 +32,7 @@ SAMPLE_PROTOTYPES(RectangleIndicesDegenerate);
 SAMPLE_PROTOTYPES(PmdLoad);
 SAMPLE_PROTOTYPES(PmdRenderingHighp);
 SAMPLE_PROTOTYPES(PmdFacechange);
+SAMPLE_PROTOTYPES(PmdMorph);
 SAMPLE_PROTOTYPES(RenderAlpha);
 SAMPLE_PROTOTYPES(RenderAlpha2Pass);
 SAMPLE_PROTOTYPES(PmdEdge);
@@ -56,6 +57,18 @@ SAMPLE_PROTOTYPES(DepthShadow);
 /*    CHAPTER    */
 SAMPLE_PROTOTYPES(AsyncLoad);
 
+/*    CHAPTER    */
+SAMPLE_PROTOTYPES(BvhBenchmark);
+SAMPLE_PROTOTYPES(OcclusionCulling);
+SAMPLE_PROTOTYPES(MeshletCulling);
+SAMPLE_PROTOTYPES(StaticBatch);
+SAMPLE_PROTOTYPES(SpriteBatch);
+SAMPLE_PROTOTYPES(TextureAtlas);
+SAMPLE_PROTOTYPES(MathBenchmark);
+SAMPLE_PROTOTYPES(SceneGraph);
+SAMPLE_PROTOTYPES(ResourceHandle);
+SAMPLE_PROTOTYPES(ToonEdge);
+
 #define SAMPLE_FUNCTIONS(name)  sample_##name##_initialize, sample_##name##_resized, sample_##name##_rendering, sample_##name##_destroy
 
 static SampleInfo g_sample_initializes[] = {
@@ -111,6 +124,8 @@ static SampleInfo g_sample_advance3d[] = {
         { "highp精度で描画する", SAMPLE_FUNCTIONS(PmdRenderingHighp) },
         //
         { "テクスチャを工夫して演出を行う", SAMPLE_FUNCTIONS(PmdFacechange) },
+        //
+        { "表情モーフで演出を行う", SAMPLE_FUNCTIONS(PmdMorph) },
 // 終端
         { "", NULL } };
 
@@ -159,6 +174,30 @@ static SampleInfo g_sample_async[] = {
         // 終端
         { "", NULL } };
 
+static SampleInfo g_sample_scene[] = {
+//
+        { "BVHで大量のインスタンスを判定する", SAMPLE_FUNCTIONS(BvhBenchmark) },
+        //
+        { "CPUで遮蔽物をラスタライズする", SAMPLE_FUNCTIONS(OcclusionCulling) },
+        //
+        { "クラスタ単位で裏面と画面外を除く", SAMPLE_FUNCTIONS(MeshletCulling) },
+        //
+        { "動かない背景をまとめて描画する", SAMPLE_FUNCTIONS(StaticBatch) },
+        //
+        { "スプライトをまとめて描画する", SAMPLE_FUNCTIONS(SpriteBatch) },
+        //
+        { "テクスチャをアトラスへまとめる", SAMPLE_FUNCTIONS(TextureAtlas) },
+        //
+        { "行列演算の速度を計測する", SAMPLE_FUNCTIONS(MathBenchmark) },
+        //
+        { "動いたノードだけ行列を更新する", SAMPLE_FUNCTIONS(SceneGraph) },
+        //
+        { "GL資源をハンドルで管理する", SAMPLE_FUNCTIONS(ResourceHandle) },
+        //
+        { "トゥーン輪郭を1パスで描画する", SAMPLE_FUNCTIONS(ToonEdge) },
+        // 終端
+        { "", NULL } };
+
 static ChapterInfo g_chapter_info[] = {
 //
         { "サンプルプログラムと補助関数", 3, g_sample_initializes },
@@ -180,6 +219,8 @@ static ChapterInfo g_chapter_info[] = {
         { "オフスクリーンレンダリング", 11, g_sample_framebuffer },
         //
         { "OpenGL ESのマルチスレッド", 14, g_sample_async },
+        //
+        { "大規模なシーンの最適化", 17, g_sample_scene },
 // 終端
         { "", -1, NULL }, };
 
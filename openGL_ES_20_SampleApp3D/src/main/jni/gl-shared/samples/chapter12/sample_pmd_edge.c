@@ -174,6 +174,16 @@ void sample_PmdEdge_initialize(GLApplication *app) {
         extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
         assert(extension->pmd);
 
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
         // テクスチャを読み込む
         extension->textureList = PmdFile_createTextureList(app, extension->pmd);
 
@@ -283,7 +293,7 @@ void sample_PmdEdge_rendering(GLApplication *app) {
             }
 
             // インデックスバッファでレンダリング
-            glDrawElements(GL_TRIANGLES, mat->indices_num, GL_UNSIGNED_SHORT, pmd->indices + beginIndicesIndex);
+            glDrawElements(GL_TRIANGLES, mat->indices_num, pmd->index_type, PmdFile_getIndices(pmd, beginIndicesIndex));
             assert(glGetError() == GL_NO_ERROR);
             beginIndicesIndex += mat->indices_num;
         }
@@ -319,7 +329,7 @@ void sample_PmdEdge_rendering(GLApplication *app) {
         assert(glGetError() == GL_NO_ERROR);
 
         // インデックスバッファでレンダリング
-        glDrawElements(GL_TRIANGLES, pmd->indices_num, GL_UNSIGNED_SHORT, pmd->indices);
+        glDrawElements(GL_TRIANGLES, pmd->indices_num, pmd->index_type, PmdFile_getIndices(pmd, 0));
         assert(glGetError() == GL_NO_ERROR);
 
     }
@@ -332,6 +342,11 @@ void sample_PmdEdge_rendering(GLApplication *app) {
  * アプリのデータ削除を行う
  */
 void sample_PmdEdge_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
     // サンプルアプリ用データを取り出す
     Extension_PmdEdge *extension = (Extension_PmdEdge*) app->extension;
 
@@ -36,6 +36,15 @@ typedef struct {
 
     // 描画する口番号
     int mouthNumber;
+
+    // 表情コントローラー
+    PmdMorphController *morph;
+
+    // 頂点バッファ
+    GLuint vertices_buffer;
+
+    // インデックスバッファ
+    GLuint indices_buffer;
 } Extension_PmdFacechange;
 
 /**
@@ -115,6 +124,16 @@ void sample_PmdFacechange_initialize(GLApplication *app) {
         extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
         assert(extension->pmd);
 
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
         // テクスチャを読み込む
         extension->textureList = PmdFile_createTextureList(app, extension->pmd);
 
@@ -125,6 +144,24 @@ void sample_PmdFacechange_initialize(GLApplication *app) {
         }
     }
 
+    // 頂点とインデックスは初期化時に転送し、マテリアルごとの描画で共有する
+    // 目と口はUVのずらしで切り替えるため、頂点は表情（モーフ）で変化した範囲だけを転送する
+    {
+        PmdFile *pmd = extension->pmd;
+
+        extension->morph = PmdMorphController_create(pmd);
+
+        glGenBuffers(1, &extension->vertices_buffer);
+        glGenBuffers(1, &extension->indices_buffer);
+        assert(extension->vertices_buffer && extension->indices_buffer);
+
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * pmd->vertices_num, pmd->vertices, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(pmd) * pmd->indices_num, PmdFile_getIndices(pmd, 0), GL_STATIC_DRAW);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+
     // シェーダーの利用を開始する
     glUseProgram(extension->shader_program);
     assert(glGetError() == GL_NO_ERROR);
@@ -194,9 +231,16 @@ void sample_PmdFacechange_rendering(GLApplication *app) {
         PmdFile *pmd = extension->pmd;
         int i = 0;
 
+        // 表情で変化した頂点範囲だけを転送する
+        if (PmdMorphController_update(extension->morph)) {
+            PmdMorphController_upload(extension->morph, extension->vertices_buffer);
+        }
+
         // 頂点をバインドする
-        glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), &pmd->vertices[0].position);
-        glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), &pmd->vertices[0].uv);
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+        glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
+        glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) sizeof(vec3));
 
         // 描画行列アップロード
         glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) wlpMatrix.m);
@@ -235,7 +279,7 @@ void sample_PmdFacechange_rendering(GLApplication *app) {
             }
 
             // インデックスバッファでレンダリング
-            glDrawElements(GL_TRIANGLES, mat->indices_num, GL_UNSIGNED_SHORT, pmd->indices + beginIndicesIndex);
+            glDrawElements(GL_TRIANGLES, mat->indices_num, pmd->index_type, (GLvoid*) (PmdFile_getIndexSize(pmd) * beginIndicesIndex));
             assert(glGetError() == GL_NO_ERROR);
             beginIndicesIndex += mat->indices_num;
         }
@@ -260,6 +304,11 @@ void sample_PmdFacechange_rendering(GLApplication *app) {
  * アプリのデータ削除を行う
  */
 void sample_PmdFacechange_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
     // サンプルアプリ用データを取り出す
     Extension_PmdFacechange *extension = (Extension_PmdFacechange*) app->extension;
 
@@ -271,7 +320,14 @@ void sample_PmdFacechange_destroy(GLApplication *app) {
     glDeleteProgram(extension->shader_program);
     assert(glGetError() == GL_NO_ERROR);
 
+    // バッファオブジェクトの解放
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &extension->vertices_buffer);
+    glDeleteBuffers(1, &extension->indices_buffer);
+
     // PMDファイルを解放する
+    PmdMorphController_free(extension->morph);
     PmdFile_free(extension->pmd);
     PmdFile_freeTextureList(extension->textureList);
 
@@ -0,0 +1,319 @@
+#include "support.h"
+
+typedef struct {
+    // レンダリング用シェーダープログラム
+    GLuint shader_program;
+
+    // 位置情報属性
+    GLint attr_pos;
+
+    // UV座標属性
+    GLint attr_uv;
+
+    // フラグメントシェーダの描画色
+    GLint unif_color;
+
+    // Diffuseテクスチャ
+    GLint unif_tex_diffuse;
+
+    // 描画行列
+    GLint unif_wlp;
+
+    // サンプル用のPMDファイル
+    PmdFile *pmd;
+
+    // サンプルPMD用のテクスチャリスト
+    PmdTextureList *textureList;
+
+    // 表情コントローラー
+    PmdMorphController *morph;
+
+    // 頂点バッファ
+    GLuint vertices_buffer;
+
+    // インデックスバッファ
+    GLuint indices_buffer;
+
+    // 現在の描画フレーム
+    int frame;
+} Extension_PmdMorph;
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_PmdMorph_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_PmdMorph*) malloc(sizeof(Extension_PmdMorph));
+    // サンプルアプリ用データを取り出す
+    Extension_PmdMorph *extension = (Extension_PmdMorph*) app->extension;
+
+    // 頂点シェーダーを用意する
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute highp vec4 attr_pos;"
+                        "attribute mediump vec2 attr_uv;"
+
+                        // uniforms
+                        "uniform highp mat4 unif_wlp;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = unif_wlp * attr_pos;"
+                        "   vary_uv = attr_uv;"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+
+        // uniforms
+                "uniform lowp vec4 unif_color;"
+                        "uniform sampler2D unif_tex_diffuse;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   if(unif_color.a == 0.0) {"
+                        "       gl_FragColor = texture2D(unif_tex_diffuse, vary_uv);"
+                        "   } else {"
+                        "       gl_FragColor = unif_color;"
+                        "   }"
+                        "}";
+
+        // コンパイルとリンクを行う
+        extension->shader_program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+    }
+
+    // attributeを取り出す
+    {
+        extension->attr_pos = glGetAttribLocation(extension->shader_program, "attr_pos");
+        assert(extension->attr_pos >= 0);
+
+        extension->attr_uv = glGetAttribLocation(extension->shader_program, "attr_uv");
+        assert(extension->attr_uv >= 0);
+    }
+
+    // uniform変数のlocationを取得する
+    {
+        extension->unif_wlp = glGetUniformLocation(extension->shader_program, "unif_wlp");
+        assert(extension->unif_wlp >= 0);
+
+        extension->unif_color = glGetUniformLocation(extension->shader_program, "unif_color");
+        assert(extension->unif_color >= 0);
+
+        extension->unif_tex_diffuse = glGetUniformLocation(extension->shader_program, "unif_tex_diffuse");
+        assert(extension->unif_tex_diffuse >= 0);
+    }
+
+    {
+        // PMDを読み込む
+        extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
+        assert(extension->pmd);
+
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
+        // テクスチャを読み込む
+        extension->textureList = PmdFile_createTextureList(app, extension->pmd);
+
+        // 表情コントローラーを生成する
+        extension->morph = PmdMorphController_create(extension->pmd);
+
+        // 読み込んだ表情名を表示
+        int i = 0;
+        for (i = 0; i < extension->pmd->morphs_num; ++i) {
+            __logf("Morph[%d] name(%s) type(%d)", i, extension->pmd->morphs[i].name, (int) extension->pmd->morphs[i].type);
+        }
+
+        // 頂点用バッファオブジェクトを生成＆転送する
+        // 表情で書き換えるため、GL_DYNAMIC_DRAWを指定する
+        {
+            glGenBuffers(1, &extension->vertices_buffer);
+            assert(glGetError() == GL_NO_ERROR);
+
+            glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * extension->pmd->vertices_num, extension->pmd->vertices, GL_DYNAMIC_DRAW);
+            assert(glGetError() == GL_NO_ERROR);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        // インデックス用バッファオブジェクトを生成＆転送する
+        {
+            glGenBuffers(1, &extension->indices_buffer);
+            assert(glGetError() == GL_NO_ERROR);
+
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(extension->pmd) * extension->pmd->indices_num, PmdFile_getIndices(extension->pmd, 0), GL_STATIC_DRAW);
+            assert(glGetError() == GL_NO_ERROR);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+    }
+
+    // シェーダーの利用を開始する
+    glUseProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 深度テストを有効にする
+    glEnable(GL_DEPTH_TEST);
+
+    extension->frame = 0;
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_PmdMorph_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_PmdMorph_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_PmdMorph *extension = (Extension_PmdMorph*) app->extension;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // 表情を更新する
+    {
+        PmdFile *pmd = extension->pmd;
+        int i = 0;
+
+        // リップ表情を周期的に動かし、それ以外は一定周期で瞬きさせる
+        for (i = 1; i < pmd->morphs_num; ++i) {
+            const PmdMorph *morph = &pmd->morphs[i];
+            GLfloat weight = 0;
+            if (morph->type == 3) {
+                weight = (GLfloat) (sin(degree2radian((extension->frame * 12) + (i * 45))) + 1.0) * 0.5f;
+            } else if (morph->type == 2) {
+                weight = (extension->frame % 180) < 8 ? 1.0f : 0.0f;
+            }
+            PmdMorphController_setWeight(extension->morph, i, weight);
+        }
+
+        // 変化のあった頂点範囲だけを転送する
+        if (PmdMorphController_update(extension->morph)) {
+            PmdMorphController_upload(extension->morph, extension->vertices_buffer);
+        }
+    }
+
+    // 属性を有効にする
+    glEnableVertexAttribArray(extension->attr_pos);
+    glEnableVertexAttribArray(extension->attr_uv);
+
+    mat4 wlpMatrix;
+
+    // カメラを初期化する
+    {
+        vec3 pmdMax;
+        vec3 pmdMin;
+
+        PmdFile_calcAABB(extension->pmd, &pmdMin, &pmdMax);
+
+        // カメラをセットアップする
+        const vec3 camera_pos = vec3_create(0, pmdMax.y * 0.7f, pmdMin.z * 7.0f); // カメラ位置
+        const vec3 camera_look = vec3_create(0, pmdMax.y * 0.3f, 0); // カメラ注視
+        const vec3 camera_up = vec3_create(0, 1, 0); // カメラ上ベクトル
+
+        const GLfloat prj_near = 1.0f;
+        const GLfloat prj_far = (pmdMax.z - pmdMin.z) * 30.0f;
+        const GLfloat prj_fovY = 45.0f;
+        const GLfloat prj_aspect = (GLfloat) (app->surface_width) / (GLfloat) (app->surface_height);
+
+        const mat4 lookMatrix = mat4_lookAt(camera_pos, camera_look, camera_up);
+        const mat4 projectionMatrix = mat4_perspective(prj_near, prj_far, prj_fovY, prj_aspect);
+
+        wlpMatrix = mat4_multiply(projectionMatrix, lookMatrix);
+    }
+
+    // PMDのレンダリングを行う
+    {
+        PmdFile *pmd = extension->pmd;
+        int i = 0;
+
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+
+        // 頂点をバインドする
+        glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
+        glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) sizeof(vec3));
+
+        // 描画行列アップロード
+        glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) wlpMatrix.m);
+
+        GLint beginIndicesIndex = 0;
+
+        // マテリアル数だけ描画を行う
+        for (i = 0; i < pmd->materials_num; ++i) {
+            PmdMaterial *mat = &pmd->materials[i];
+
+            // テクスチャを取り出す
+            Texture *tex = PmdFile_getTexture(extension->textureList, mat->diffuse_texture_name);
+            if (tex) {
+                // テクスチャがロードできている
+                glBindTexture(GL_TEXTURE_2D, tex->id);
+                glUniform1i(extension->unif_tex_diffuse, 0);
+                glUniform4f(extension->unif_color, 0, 0, 0, 0);
+            } else {
+                // カラー情報
+                glUniform4f(extension->unif_color, mat->diffuse.x, mat->diffuse.y, mat->diffuse.z, mat->diffuse.w);
+            }
+
+            // インデックスバッファでレンダリング
+            glDrawElements(GL_TRIANGLES, mat->indices_num, pmd->index_type, (GLvoid*) (beginIndicesIndex * PmdFile_getIndexSize(pmd)));
+            assert(glGetError() == GL_NO_ERROR);
+            beginIndicesIndex += mat->indices_num;
+        }
+    }
+
+    ++extension->frame;
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_PmdMorph_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
+    // サンプルアプリ用データを取り出す
+    Extension_PmdMorph *extension = (Extension_PmdMorph*) app->extension;
+
+    // シェーダーの利用を終了する
+    glUseProgram(0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // シェーダープログラムを廃棄する
+    glDeleteProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // バッファオブジェクトの解放
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &extension->vertices_buffer);
+    glDeleteBuffers(1, &extension->indices_buffer);
+
+    // PMDファイルを解放する
+    PmdMorphController_free(extension->morph);
+    PmdFile_free(extension->pmd);
+    PmdFile_freeTextureList(extension->textureList);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
@@ -37,6 +37,9 @@ typedef struct {
         // 法線
         GLint attr_normal;
 
+        // 頂点ごとの押し出し倍率
+        GLint attr_edge_scale;
+
         /**
          * エッジの描画サイズ
          */
@@ -58,6 +61,21 @@ typedef struct {
     // サンプルPMD用のテクスチャマッピング
     PmdTextureList *textureList;
 
+    // 輪郭を描画する三角形の一覧
+    PmdEdgeList *edges;
+
+    // 頂点バッファ
+    GLuint vertices_buffer;
+
+    // インデックスバッファ
+    GLuint indices_buffer;
+
+    // 輪郭のインデックスバッファ
+    GLuint edge_indices_buffer;
+
+    // 頂点ごとの押し出し倍率のバッファ
+    GLuint edge_scales_buffer;
+
     // フィギュアの回転
     GLfloat rotate;
 
@@ -140,12 +158,13 @@ void sample_PmdMultirender_initialize(GLApplication *app) {
         // attributes
                 "attribute highp vec3 attr_pos;"
                         "attribute mediump vec3 attr_normal;"
+                        "attribute mediump float attr_edge_scale;"
                         // uniforms
                         "uniform mediump float unif_edgesize;"
                         "uniform highp mat4 unif_wlp;"
                         // main
                         "void main() {"
-                        "   gl_Position = unif_wlp * vec4( attr_pos + (attr_normal * unif_edgesize), 1.0 );"
+                        "   gl_Position = unif_wlp * vec4( attr_pos + (attr_normal * unif_edgesize * attr_edge_scale), 1.0 );"
                         "}";
 
         const GLchar *fragment_shader_source =
@@ -166,6 +185,9 @@ void sample_PmdMultirender_initialize(GLApplication *app) {
 
             extension->edge_shader.attr_normal = glGetAttribLocation(extension->edge_shader.program, "attr_normal");
             assert(extension->edge_shader.attr_normal >= 0);
+
+            extension->edge_shader.attr_edge_scale = glGetAttribLocation(extension->edge_shader.program, "attr_edge_scale");
+            assert(extension->edge_shader.attr_edge_scale >= 0);
         }
 
         // uniform変数のlocationを取得する
@@ -186,8 +208,19 @@ void sample_PmdMultirender_initialize(GLApplication *app) {
         extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
         assert(extension->pmd);
 
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
         // テクスチャを読み込む
         extension->textureList = PmdFile_createTextureList(app, extension->pmd);
+        PmdFile_bindTextureList(extension->pmd, extension->textureList);
 
         // 読み込んだテクスチャファイル名を表示
         int i = 0;
@@ -196,6 +229,32 @@ void sample_PmdMultirender_initialize(GLApplication *app) {
         }
 
         extension->rotate = 0;
+
+        // 輪郭フラグを持つ材質の三角形だけを輪郭の描画対象とする
+        extension->edges = PmdEdgeList_create(extension->pmd);
+    }
+
+    // 頂点とインデックスは変化しないため、初期化時に1度だけ転送して全モデルの描画で共有する
+    // クライアント側配列を指定すると、描画のたびにドライバが配列全体をコピーする
+    {
+        PmdFile *pmd = extension->pmd;
+
+        glGenBuffers(1, &extension->vertices_buffer);
+        glGenBuffers(1, &extension->indices_buffer);
+        assert(extension->vertices_buffer && extension->indices_buffer);
+
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * pmd->vertices_num, pmd->vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(pmd) * pmd->indices_num, PmdFile_getIndices(pmd, 0), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        assert(glGetError() == GL_NO_ERROR);
+
+        extension->edge_indices_buffer = PmdEdgeList_createIndexBuffer(extension->edges, GL_STATIC_DRAW);
+
+        // 輪郭の無効な頂点は押し出さない
+        extension->edge_scales_buffer = PmdEdge_createVertexScaleBuffer(pmd, GL_STATIC_DRAW);
     }
 
     // 深度テストを有効にする
@@ -243,17 +302,18 @@ void sample_PmdMultirender_renderingPMD(Extension_PmdMultirender *extension, con
         int i = 0;
 
         // 頂点をバインドする
-        glVertexAttribPointer(extension->main_shader.attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) pmd->vertices);
-        glVertexAttribPointer(extension->main_shader.attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) ((GLbyte*) pmd->vertices + sizeof(vec3)));
-
-        GLint beginIndicesIndex = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+        glVertexAttribPointer(extension->main_shader.attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
+        glVertexAttribPointer(extension->main_shader.attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) sizeof(vec3));
 
         // マテリアル数だけ描画を行う
+        // 描画に必要な情報は材質ごとの配列から参照する
         for (i = 0; i < pmd->materials_num; ++i) {
-            PmdMaterial *mat = &pmd->materials[i];
+            const PmdDrawRange *range = &pmd->draw_ranges[i];
 
             // テクスチャを取り出す
-            Texture *tex = PmdFile_getTexture(extension->textureList, mat->diffuse_texture_name);
+            Texture *tex = pmd->diffuse_textures[i];
             if (tex) {
                 // テクスチャがロードできている
                 glBindTexture(GL_TEXTURE_2D, tex->id);
@@ -261,13 +321,13 @@ void sample_PmdMultirender_renderingPMD(Extension_PmdMultirender *extension, con
                 glUniform4f(extension->main_shader.unif_color, 0, 0, 0, 0);
             } else {
                 // カラー情報
-                glUniform4f(extension->main_shader.unif_color, mat->diffuse.x, mat->diffuse.y, mat->diffuse.z, mat->diffuse.w);
+                const vec4 *diffuse = &pmd->diffuse_colors[i];
+                glUniform4f(extension->main_shader.unif_color, diffuse->x, diffuse->y, diffuse->z, diffuse->w);
             }
 
             // インデックスバッファでレンダリング
-            glDrawElements(GL_TRIANGLES, mat->indices_num, GL_UNSIGNED_SHORT, pmd->indices + beginIndicesIndex);
+            glDrawElements(GL_TRIANGLES, range->indices_num, pmd->index_type, (GLvoid*) (PmdFile_getIndexSize(pmd) * range->indices_begin));
             assert(glGetError() == GL_NO_ERROR);
-            beginIndicesIndex += mat->indices_num;
         }
     }
 
@@ -283,16 +343,19 @@ void sample_PmdMultirender_renderingPMD(Extension_PmdMultirender *extension, con
         // 属性を有効にする
         glEnableVertexAttribArray(extension->edge_shader.attr_pos);
         glEnableVertexAttribArray(extension->edge_shader.attr_normal);
+        glEnableVertexAttribArray(extension->edge_shader.attr_edge_scale);
 
         // 行列アップロード
         glUniformMatrix4fv(extension->edge_shader.unif_wlp, 1, GL_FALSE, (GLfloat*) wlpMatrix.m);
         assert(glGetError() == GL_NO_ERROR);
 
-        PmdFile *pmd = extension->pmd;
-
         // 頂点をバインドする
-        glVertexAttribPointer(extension->edge_shader.attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), &pmd->vertices[0].position);
-        glVertexAttribPointer(extension->edge_shader.attr_normal, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), &pmd->vertices[0].normal);
+        // 頂点バッファは通常の描画と共有し、インデックスだけ輪郭用に切り替える
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->edge_indices_buffer);
+        glVertexAttribPointer(extension->edge_shader.attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
+        glVertexAttribPointer(extension->edge_shader.attr_normal, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) (sizeof(vec3) + sizeof(vec2)));
+        glBindBuffer(GL_ARRAY_BUFFER, extension->edge_scales_buffer);
+        glVertexAttribPointer(extension->edge_shader.attr_edge_scale, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat), (GLvoid*) 0);
 
         // エッジ色情報
         glUniform4f(extension->edge_shader.unif_color, 0.0f, 0.0f, 0.0f, 1.0f);
@@ -300,7 +363,8 @@ void sample_PmdMultirender_renderingPMD(Extension_PmdMultirender *extension, con
         glUniform1f(extension->edge_shader.unif_edgesize, 0.025f);
         assert(glGetError() == GL_NO_ERROR);
 
-        glDrawElements(GL_TRIANGLES, pmd->indices_num, GL_UNSIGNED_SHORT, pmd->indices);
+        // 輪郭を持つ三角形だけをレンダリングする
+        glDrawElements(GL_TRIANGLES, extension->edges->indices_num, extension->edges->index_type, (GLvoid*) 0);
         assert(glGetError() == GL_NO_ERROR);
     }
 }
@@ -384,6 +448,11 @@ void sample_PmdMultirender_rendering(GLApplication *app) {
  * アプリのデータ削除を行う
  */
 void sample_PmdMultirender_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
     // サンプルアプリ用データを取り出す
     Extension_PmdMultirender *extension = (Extension_PmdMultirender*) app->extension;
 
@@ -397,6 +466,16 @@ void sample_PmdMultirender_destroy(GLApplication *app) {
     glDeleteProgram(extension->edge_shader.program);
     assert(glGetError() == GL_NO_ERROR);
 
+    // バッファオブジェクトの解放
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &extension->vertices_buffer);
+    glDeleteBuffers(1, &extension->indices_buffer);
+    glDeleteBuffers(1, &extension->edge_indices_buffer);
+    glDeleteBuffers(1, &extension->edge_scales_buffer);
+
+    PmdEdgeList_free(extension->edges);
+
     // PMDファイルを解放する
     PmdFile_free(extension->pmd);
     PmdFile_freeTextureList(extension->textureList);
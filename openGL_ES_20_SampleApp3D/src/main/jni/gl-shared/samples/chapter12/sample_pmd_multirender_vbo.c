@@ -1,6 +1,18 @@
 #include "support.h"
 #include <time.h>
 
+/**
+ * 並べるモデル数（横・奥）
+ */
+#define MULTIRENDERVBO_SAMPLE_MODELS_X  8
+#define MULTIRENDERVBO_SAMPLE_MODELS_Z  8
+
+/**
+ * 描画するモデルの総数
+ * カリング・行列計算・LODの選択状態はこの数で確保する
+ */
+#define MULTIRENDERVBO_SAMPLE_MODELS    (MULTIRENDERVBO_SAMPLE_MODELS_X * MULTIRENDERVBO_SAMPLE_MODELS_Z)
+
 typedef struct {
 
     // 通常レンダリング用シェーダ
@@ -22,6 +34,18 @@ typedef struct {
 
         // 描画行列
         GLint unif_wlp;
+
+        // 位置の復元用オフセット
+        GLint unif_pos_offset;
+
+        // 位置の復元用スケール
+        GLint unif_pos_scale;
+
+        // UVの復元用オフセット
+        GLint unif_uv_offset;
+
+        // UVの復元用スケール
+        GLint unif_uv_scale;
     } main_shader;
 
     // エッジ描画用シェーダー
@@ -44,20 +68,90 @@ typedef struct {
         // フラグメントシェーダの描画色
         GLint unif_color;
 
+        // 位置の復元用オフセット
+        GLint unif_pos_offset;
+
+        // 位置の復元用スケール
+        GLint unif_pos_scale;
     } edge_shader;
 
     // サンプル用のPMDファイル
     PmdFile *pmd;
 
+    // GPU転送用に量子化した頂点
+    PmdCompactMesh *compact;
+
+    // 描画用のインデックス構成
+    PmdDrawMesh *draw_mesh;
+
     // 頂点バッファ
     GLuint vertices_buffer;
 
     // インデックスバッファ
     GLuint indices_buffer;
 
+    // 遠景用に簡略化したLODチェーン
+    // 分割描画が必要なモデルではNULLとなる
+    PmdLodChain *lod;
+
+    // LODチェーンのインデックスバッファ
+    GLuint lod_indices_buffer;
+
+    // 輪郭を描画する三角形の一覧
+    // 分割されている場合はサブメッシュごとの範囲となる
+    PmdEdgeList *edges;
+
+    // 輪郭のインデックスバッファ
+    GLuint edge_indices_buffer;
+
+    // LODの段ごとの輪郭を描画する三角形の一覧
+    // 最高詳細度の段（[0]）はedgesを利用するためNULLとなる
+    PmdEdgeList *lod_edges[PMDLOD_LEVELS_MAX];
+
+    // LODの段ごとの輪郭のインデックスバッファ
+    GLuint lod_edge_indices_buffers[PMDLOD_LEVELS_MAX];
+
+    // 輪郭として描画した三角形数の累計
+    GLuint edge_triangles_drawn;
+
+    // モデルごとに前回選択したLODの段
+    int lod_levels[MULTIRENDERVBO_SAMPLE_MODELS];
+
+    // 描画パスごとの頂点属性の構成
+    // 分割されている場合はサブメッシュごと、分割されていなければ1つとなる
+    VertexLayout **main_layouts;
+    VertexLayout **edge_layouts;
+    GLuint layouts_num;
+
+    // LODチェーンのインデックスバッファを参照する構成
+    // 輪郭は段ごとのインデックスバッファを参照する
+    VertexLayout *main_lod_layout;
+    VertexLayout *edge_lod_layouts[PMDLOD_LEVELS_MAX];
+
+    // 頂点属性・バッファ関連のGL呼び出し回数の累計
+    GLuint state_changes;
+
+    // 描画した三角形数の累計
+    GLuint triangles_drawn;
+
+    // 全て最高詳細度で描画した場合の三角形数の累計
+    GLuint triangles_full;
+
     // サンプルPMD用のテクスチャマッピング
     PmdTextureList *textureList;
 
+    // モデルごとの位置・回転
+    TransformList *transforms;
+
+    // モデル単位の視錐台カリング
+    CullingList *culling;
+
+    // カリングを分割処理するスレッドプール
+    ThreadPool *pool;
+
+    // 材質ごとの可視判定結果
+    GLubyte *material_visible;
+
     // フィギュアの回転
     GLfloat rotate;
 
@@ -65,6 +159,72 @@ typedef struct {
     time_t startTime;
 } Extension_PmdMultirenderVBO;
 
+/**
+ * 輪郭の一覧のうち、可視な材質の範囲を描画する
+ * 一覧は材質ごとの範囲（分割されていないメッシュ）でなければならない。
+ * インデックスが連続する範囲はまとめて1回で描画する。
+ * 描画したインデックス数を返す。
+ */
+static GLuint sample_PmdMultirenderVBO_drawEdgeRanges(const PmdEdgeList *edges, const GLubyte *material_visible) {
+    const GLsizeiptr indexSize = edges->index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+    GLuint begin = 0;
+    GLuint num = 0;
+    GLuint result = 0;
+    int m = 0;
+
+    for (m = 0; m < edges->materials_num; ++m) {
+        const PmdDrawRange *range = &edges->draw_ranges[m];
+        if (!material_visible[m] || !range->indices_num) {
+            continue;
+        }
+
+        if (num && begin + num == range->indices_begin) {
+            num += range->indices_num;
+            continue;
+        }
+
+        if (num) {
+            glDrawElements(GL_TRIANGLES, num, edges->index_type, (GLvoid*) (indexSize * begin));
+            result += num;
+        }
+        begin = range->indices_begin;
+        num = range->indices_num;
+    }
+
+    if (num) {
+        glDrawElements(GL_TRIANGLES, num, edges->index_type, (GLvoid*) (indexSize * begin));
+        result += num;
+    }
+    assert(glGetError() == GL_NO_ERROR);
+    return result;
+}
+
+/**
+ * 通常レンダリング用の頂点属性の構成を生成する
+ * vertex_beginは構成が参照する先頭頂点となる
+ */
+static VertexLayout* sample_PmdMultirenderVBO_createMainLayout(Extension_PmdMultirenderVBO *extension, const GLuint indices_buffer, const GLuint vertex_begin) {
+    const GLintptr offset = sizeof(PmdCompactVertex) * vertex_begin;
+    VertexLayout *result = VertexLayout_create(extension->vertices_buffer, indices_buffer);
+
+    VertexLayout_addAttribute(result, extension->main_shader.attr_pos, 3, GL_SHORT, GL_TRUE, sizeof(PmdCompactVertex), offset);
+    VertexLayout_addAttribute(result, extension->main_shader.attr_uv, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PmdCompactVertex), offset + sizeof(GLshort) * 4);
+    return result;
+}
+
+/**
+ * エッジ描画用の頂点属性の構成を生成する
+ * 法線の3要素目には頂点ごとの押し出し倍率が格納されている
+ */
+static VertexLayout* sample_PmdMultirenderVBO_createEdgeLayout(Extension_PmdMultirenderVBO *extension, const GLuint indices_buffer, const GLuint vertex_begin) {
+    const GLintptr offset = sizeof(PmdCompactVertex) * vertex_begin;
+    VertexLayout *result = VertexLayout_create(extension->vertices_buffer, indices_buffer);
+
+    VertexLayout_addAttribute(result, extension->edge_shader.attr_pos, 3, GL_SHORT, GL_TRUE, sizeof(PmdCompactVertex), offset);
+    VertexLayout_addAttribute(result, extension->edge_shader.attr_normal, 3, GL_BYTE, GL_TRUE, sizeof(PmdCompactVertex), offset + sizeof(GLshort) * 4 + sizeof(GLushort) * 2);
+    return result;
+}
+
 /**
  * アプリの初期化を行う
  */
@@ -76,20 +236,24 @@ void sample_PmdMultirenderVBO_initialize(GLApplication *app) {
 
     // 頂点シェーダーを用意する
     {
-        // カメラ用の行列を計算に加える
+        // 量子化された位置とUVを復元して利用する
         const GLchar *vertex_shader_source =
         // attributes
-                "attribute highp vec4 attr_pos;"
+                "attribute highp vec3 attr_pos;"
                         "attribute mediump vec2 attr_uv;"
 
                         // uniforms
                         "uniform highp mat4 unif_wlp;"
+                        "uniform highp vec3 unif_pos_offset;"
+                        "uniform highp vec3 unif_pos_scale;"
+                        "uniform mediump vec2 unif_uv_offset;"
+                        "uniform mediump vec2 unif_uv_scale;"
                         // varyings
                         "varying mediump vec2 vary_uv;"
                         // main
                         "void main() {"
-                        "   gl_Position = unif_wlp * attr_pos;"
-                        "   vary_uv = attr_uv;"
+                        "   gl_Position = unif_wlp * vec4(unif_pos_offset + attr_pos * unif_pos_scale, 1.0);"
+                        "   vary_uv = unif_uv_offset + attr_uv * unif_uv_scale;"
                         "}";
 
         const GLchar *fragment_shader_source =
@@ -130,12 +294,25 @@ void sample_PmdMultirenderVBO_initialize(GLApplication *app) {
 
             extension->main_shader.unif_tex_diffuse = glGetUniformLocation(extension->main_shader.program, "unif_tex_diffuse");
             assert(extension->main_shader.unif_tex_diffuse >= 0);
+
+            extension->main_shader.unif_pos_offset = glGetUniformLocation(extension->main_shader.program, "unif_pos_offset");
+            assert(extension->main_shader.unif_pos_offset >= 0);
+
+            extension->main_shader.unif_pos_scale = glGetUniformLocation(extension->main_shader.program, "unif_pos_scale");
+            assert(extension->main_shader.unif_pos_scale >= 0);
+
+            extension->main_shader.unif_uv_offset = glGetUniformLocation(extension->main_shader.program, "unif_uv_offset");
+            assert(extension->main_shader.unif_uv_offset >= 0);
+
+            extension->main_shader.unif_uv_scale = glGetUniformLocation(extension->main_shader.program, "unif_uv_scale");
+            assert(extension->main_shader.unif_uv_scale >= 0);
         }
     }
 
     // エッジシェーダーを用意する
     {
-        // カメラ用の行列を計算に加える
+        // 量子化された位置と八面体エンコードされた法線を復元して利用する
+        // 輪郭の無効な頂点は押し出し倍率（attr_normal.z）が0となる
         const GLchar *vertex_shader_source =
         // attributes
                 "attribute highp vec3 attr_pos;"
@@ -143,9 +320,14 @@ void sample_PmdMultirenderVBO_initialize(GLApplication *app) {
                         // uniforms
                         "uniform mediump float unif_edgesize;"
                         "uniform highp mat4 unif_wlp;"
+                        "uniform highp vec3 unif_pos_offset;"
+                        "uniform highp vec3 unif_pos_scale;"
+                        // functions
+                        PMDCOMPACT_GLSL_DECODE_NORMAL
                         // main
                         "void main() {"
-                        "   gl_Position = unif_wlp * vec4( attr_pos + (attr_normal * unif_edgesize), 1.0 );"
+                        "   highp vec3 pos = unif_pos_offset + attr_pos * unif_pos_scale;"
+                        "   gl_Position = unif_wlp * vec4( pos + (PmdCompact_decodeNormal(attr_normal.xy) * unif_edgesize * attr_normal.z), 1.0 );"
                         "}";
 
         const GLchar *fragment_shader_source =
@@ -178,6 +360,12 @@ void sample_PmdMultirenderVBO_initialize(GLApplication *app) {
 
             extension->edge_shader.unif_color = glGetUniformLocation(extension->edge_shader.program, "unif_color");
             assert(extension->edge_shader.unif_color >= 0);
+
+            extension->edge_shader.unif_pos_offset = glGetUniformLocation(extension->edge_shader.program, "unif_pos_offset");
+            assert(extension->edge_shader.unif_pos_offset >= 0);
+
+            extension->edge_shader.unif_pos_scale = glGetUniformLocation(extension->edge_shader.program, "unif_pos_scale");
+            assert(extension->edge_shader.unif_pos_scale >= 0);
         }
     }
 
@@ -186,8 +374,16 @@ void sample_PmdMultirenderVBO_initialize(GLApplication *app) {
         extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
         assert(extension->pmd);
 
+        // VBOへ転送する前に頂点キャッシュ・オーバードロー向けにメッシュを並べ替える
+        {
+            PmdOptimizeReport report;
+            PmdFile_optimize(extension->pmd, &report);
+            __logf("ACMR before(%.3f) after(%.3f)", report.acmr_before, report.acmr_after);
+        }
+
         // テクスチャを読み込む
         extension->textureList = PmdFile_createTextureList(app, extension->pmd);
+        PmdFile_bindTextureList(extension->pmd, extension->textureList);
 
         // 読み込んだテクスチャファイル名を表示
         int i = 0;
@@ -197,42 +393,94 @@ void sample_PmdMultirenderVBO_initialize(GLApplication *app) {
 
         extension->rotate = 0;
 
+        // 描画用のインデックス構成を決める
+        // 65536頂点を超えるモデルは32bitインデックスを利用するか、16bitインデックスで描画できるよう分割する
+        extension->draw_mesh = PmdDrawMesh_create(extension->pmd, ES20_hasExtension("GL_OES_element_index_uint"));
+
         // 頂点用バッファオブジェクトを生成＆転送する
+        // シェーダーが必要とする要素だけを量子化して転送する
         {
-            // バッファ生成
-            glGenBuffers(1, &extension->vertices_buffer);
-            assert(glGetError() == GL_NO_ERROR);
-            assert(extension->vertices_buffer != 0);
-
-            // バインド
-            glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
-            assert(glGetError() == GL_NO_ERROR);
-
-            // アップロード
-            glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * extension->pmd->vertices_num, extension->pmd->vertices, GL_STATIC_DRAW);
-            assert(glGetError() == GL_NO_ERROR);
+            extension->compact = PmdCompactMesh_create(extension->pmd);
+
+            // 分割した場合はサブメッシュごとに頂点を並べ替える
+            PmdCompactVertex *gathered = PmdDrawMesh_gatherVertices(extension->draw_mesh, extension->compact->vertices, sizeof(PmdCompactVertex));
+            if (gathered) {
+                free(extension->compact->vertices);
+                extension->compact->vertices = gathered;
+                extension->compact->vertices_num = extension->draw_mesh->vertices_num;
+            }
 
-            // バインドを解除する
-            // バインドを解除しない場合、VBOが優先される
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            extension->vertices_buffer = PmdCompactMesh_createVertexBuffer(extension->compact, GL_STATIC_DRAW);
         }
-        // インデックス用バッファオブジェクトを生成する
-        {
-            // バッファ生成
-            glGenBuffers(1, &extension->indices_buffer);
-            assert(glGetError() == GL_NO_ERROR);
-            assert(extension->indices_buffer != 0);
+        // インデックス用バッファオブジェクトを生成＆転送する
+        extension->indices_buffer = PmdDrawMesh_createIndexBuffer(extension->draw_mesh, GL_STATIC_DRAW);
+
+        // 遠景用のLODチェーンを生成する
+        // 縮約は既存の頂点を使うため、頂点バッファは共有できる
+        extension->lod = NULL;
+        extension->lod_indices_buffer = 0;
+        if (!extension->draw_mesh->vertex_sources) {
+            extension->lod = PmdLodChain_create(extension->pmd, 4, 0.35f);
+            extension->lod_indices_buffer = PmdLodChain_createIndexBuffer(extension->lod, GL_STATIC_DRAW);
+        }
+        memset(extension->lod_levels, 0x00, sizeof(extension->lod_levels));
+        extension->triangles_drawn = 0;
+        extension->triangles_full = 0;
+
+        // 輪郭フラグを持つ材質の三角形だけを輪郭の描画対象とする
+        // 分割されている場合はサブメッシュ単位で同じ判定を行う
+        extension->edges = PmdEdgeList_createFromDrawMesh(extension->pmd, extension->draw_mesh);
+        extension->edge_indices_buffer = PmdEdgeList_createIndexBuffer(extension->edges, GL_STATIC_DRAW);
+
+        // LODの段ごとに同じ判定を行い、詳細度によって輪郭の範囲が変わらないようにする
+        memset(extension->lod_edges, 0x00, sizeof(extension->lod_edges));
+        memset(extension->lod_edge_indices_buffers, 0x00, sizeof(extension->lod_edge_indices_buffers));
+        if (extension->lod) {
+            PmdLodChain *lod = extension->lod;
+            int level = 0;
+
+            for (level = 1; level < lod->levels_num; ++level) {
+                extension->lod_edges[level] = PmdEdgeList_createFromRanges(extension->pmd, lod->index_type, lod->indices, lod->levels[level].draw_ranges);
+                extension->lod_edge_indices_buffers[level] = PmdEdgeList_createIndexBuffer(extension->lod_edges[level], GL_STATIC_DRAW);
+            }
+        }
+        extension->edge_triangles_drawn = 0;
+    }
 
-            // バインド
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+    // 描画パスごとの頂点属性を初期化時に1度だけ記述する
+    // 分割されている場合は、サブメッシュの先頭頂点を指すように属性をずらした構成を用意する
+    {
+        PmdDrawMesh *mesh = extension->draw_mesh;
+        GLuint i = 0;
+
+        extension->layouts_num = mesh->vertex_sources ? mesh->submeshes_num : 1;
+        extension->main_layouts = calloc(extension->layouts_num, sizeof(VertexLayout*));
+        extension->edge_layouts = calloc(extension->layouts_num, sizeof(VertexLayout*));
+        for (i = 0; i < extension->layouts_num; ++i) {
+            const GLuint vertex_begin = mesh->vertex_sources ? mesh->submeshes[i].vertex_begin : 0;
+            extension->main_layouts[i] = sample_PmdMultirenderVBO_createMainLayout(extension, extension->indices_buffer, vertex_begin);
+            extension->edge_layouts[i] = sample_PmdMultirenderVBO_createEdgeLayout(extension, extension->edge_indices_buffer, vertex_begin);
+        }
 
-            // アップロード
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * extension->pmd->indices_num, extension->pmd->indices, GL_STATIC_DRAW);
-            assert(glGetError() == GL_NO_ERROR);
+        extension->main_lod_layout = NULL;
+        memset(extension->edge_lod_layouts, 0x00, sizeof(extension->edge_lod_layouts));
+        if (extension->lod) {
+            int level = 0;
 
-            // バインドを解除する
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            extension->main_lod_layout = sample_PmdMultirenderVBO_createMainLayout(extension, extension->lod_indices_buffer, 0);
+            for (level = 1; level < extension->lod->levels_num; ++level) {
+                extension->edge_lod_layouts[level] = sample_PmdMultirenderVBO_createEdgeLayout(extension, extension->lod_edge_indices_buffers[level], 0);
+            }
         }
+        extension->state_changes = 0;
+    }
+
+    // 視錐台カリングを用意する
+    {
+        extension->pool = ThreadPool_create(0);
+        extension->culling = CullingList_create(MULTIRENDERVBO_SAMPLE_MODELS);
+        extension->transforms = TransformList_create(MULTIRENDERVBO_SAMPLE_MODELS);
+        extension->material_visible = malloc(sizeof(GLubyte) * (extension->pmd->materials_num ? extension->pmd->materials_num : 1));
     }
 
     // 深度テストを有効にする
@@ -255,11 +503,10 @@ void sample_PmdMultirenderVBO_resized(GLApplication *app) {
 
 /**
  * PMDファイルのレンダリングを行う
+ * lod_levelが0より大きい場合、簡略化した段のインデックスで描画する
  */
-void sample_PmdMultirenderVBO_renderingPMD(Extension_PmdMultirenderVBO *extension, const mat4 wlpMatrix) {
-    // バッファオブジェクトのバインドを行う
-    glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+void sample_PmdMultirenderVBO_renderingPMD(Extension_PmdMultirenderVBO *extension, const mat4 wlpMatrix, const GLubyte *material_visible, const int lod_level) {
+    const PmdLodLevel *lod = lod_level > 0 ? &extension->lod->levels[lod_level] : NULL;
 
     // PMDのレンダリングを行う
     {
@@ -270,28 +517,34 @@ void sample_PmdMultirenderVBO_renderingPMD(Extension_PmdMultirenderVBO *extensio
         // 背面カリング
         glCullFace(GL_BACK);
 
-        // 属性を有効にする
-        glEnableVertexAttribArray(extension->main_shader.attr_pos);
-        glEnableVertexAttribArray(extension->main_shader.attr_uv);
-
         // 行列アップロード
         glUniformMatrix4fv(extension->main_shader.unif_wlp, 1, GL_FALSE, (GLfloat*) wlpMatrix.m);
 
+        // 量子化の復元情報アップロード
+        PmdCompactMesh_uniformPosition(extension->compact, extension->main_shader.unif_pos_offset, extension->main_shader.unif_pos_scale);
+        PmdCompactMesh_uniformUv(extension->compact, extension->main_shader.unif_uv_offset, extension->main_shader.unif_uv_scale);
+
         PmdFile *pmd = extension->pmd;
+        PmdDrawMesh *mesh = extension->draw_mesh;
         int i = 0;
 
-        // 頂点をバインドする
-        glVertexAttribPointer(extension->main_shader.attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
-        glVertexAttribPointer(extension->main_shader.attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) sizeof(vec3));
+        // サブメッシュ数だけ描画を行う
+        // 描画に必要な情報は材質ごとの配列から参照する
+        for (i = 0; i < mesh->submeshes_num; ++i) {
+            const PmdSubMesh *submesh = &mesh->submeshes[i];
+            const GLuint material = submesh->material_index;
 
-        GLint beginIndicesIndex = 0;
+            // 視錐台の外にある材質は描画しない
+            if (!material_visible[material]) {
+                continue;
+            }
 
-        // マテリアル数だけ描画を行う
-        for (i = 0; i < pmd->materials_num; ++i) {
-            PmdMaterial *mat = &pmd->materials[i];
+            // 頂点をバインドする
+            // 前回と同じ構成であればGLの呼び出しは行われない
+            VertexLayout_bind(lod ? extension->main_lod_layout : extension->main_layouts[mesh->vertex_sources ? i : 0]);
 
             // テクスチャを取り出す
-            Texture *tex = PmdFile_getTexture(extension->textureList, mat->diffuse_texture_name);
+            Texture *tex = pmd->diffuse_textures[material];
             if (tex) {
                 // テクスチャがロードできている
                 glBindTexture(GL_TEXTURE_2D, tex->id);
@@ -299,13 +552,21 @@ void sample_PmdMultirenderVBO_renderingPMD(Extension_PmdMultirenderVBO *extensio
                 glUniform4f(extension->main_shader.unif_color, 0, 0, 0, 0);
             } else {
                 // カラー情報
-                glUniform4f(extension->main_shader.unif_color, mat->diffuse.x, mat->diffuse.y, mat->diffuse.z, mat->diffuse.w);
+                const vec4 *diffuse = &pmd->diffuse_colors[material];
+                glUniform4f(extension->main_shader.unif_color, diffuse->x, diffuse->y, diffuse->z, diffuse->w);
             }
 
             // インデックスバッファでレンダリング
-            glDrawElements(GL_TRIANGLES, mat->indices_num, GL_UNSIGNED_SHORT, (GLvoid*) (beginIndicesIndex * sizeof(GLushort)));
+            if (lod) {
+                const PmdDrawRange *range = &lod->draw_ranges[material];
+                glDrawElements(GL_TRIANGLES, range->indices_num, extension->lod->index_type, (GLvoid*) PmdLodChain_getIndexOffset(extension->lod, range));
+                extension->triangles_drawn += range->indices_num / 3;
+            } else {
+                glDrawElements(GL_TRIANGLES, submesh->indices_num, mesh->index_type, (GLvoid*) PmdDrawMesh_getIndexOffset(mesh, submesh));
+                extension->triangles_drawn += submesh->indices_num / 3;
+            }
+            extension->triangles_full += submesh->indices_num / 3;
             assert(glGetError() == GL_NO_ERROR);
-            beginIndicesIndex += mat->indices_num;
         }
     }
 
@@ -318,19 +579,15 @@ void sample_PmdMultirenderVBO_renderingPMD(Extension_PmdMultirenderVBO *extensio
         // 前面カリング
         glCullFace(GL_FRONT);
 
-        // 属性を有効にする
-        glEnableVertexAttribArray(extension->edge_shader.attr_pos);
-        glEnableVertexAttribArray(extension->edge_shader.attr_normal);
-
         // 行列アップロード
         glUniformMatrix4fv(extension->edge_shader.unif_wlp, 1, GL_FALSE, (GLfloat*) wlpMatrix.m);
         assert(glGetError() == GL_NO_ERROR);
 
-        PmdFile *pmd = extension->pmd;
+        PmdDrawMesh *mesh = extension->draw_mesh;
+        int i = 0;
 
-        // 頂点をバインドする
-        glVertexAttribPointer(extension->edge_shader.attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
-        glVertexAttribPointer(extension->edge_shader.attr_normal, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) (sizeof(vec3) + sizeof(vec2)));
+        // 量子化の復元情報アップロード
+        PmdCompactMesh_uniformPosition(extension->compact, extension->edge_shader.unif_pos_offset, extension->edge_shader.unif_pos_scale);
 
         // エッジ色情報
         glUniform4f(extension->edge_shader.unif_color, 0.0f, 0.0f, 0.0f, 1.0f);
@@ -338,9 +595,31 @@ void sample_PmdMultirenderVBO_renderingPMD(Extension_PmdMultirenderVBO *extensio
         glUniform1f(extension->edge_shader.unif_edgesize, 0.025f);
         assert(glGetError() == GL_NO_ERROR);
 
-        // インデックスバッファでレンダリング
-        glDrawElements(GL_TRIANGLES, pmd->indices_num, GL_UNSIGNED_SHORT, (GLvoid*) 0);
-        assert(glGetError() == GL_NO_ERROR);
+        if (!mesh->vertex_sources) {
+            // 分割されていなければ、可視かつ輪郭を持つ材質の範囲だけをレンダリングする
+            // 輪郭のインデックスは材質順に詰めてあるため、可視な材質が続く範囲は1回で描画される
+            if (lod) {
+                VertexLayout_bind(extension->edge_lod_layouts[lod_level]);
+                extension->edge_triangles_drawn += sample_PmdMultirenderVBO_drawEdgeRanges(extension->lod_edges[lod_level], material_visible) / 3;
+            } else {
+                VertexLayout_bind(extension->edge_layouts[0]);
+                extension->edge_triangles_drawn += sample_PmdMultirenderVBO_drawEdgeRanges(extension->edges, material_visible) / 3;
+            }
+        } else {
+            // サブメッシュごとに、輪郭を持つ三角形だけをレンダリングする
+            for (i = 0; i < mesh->submeshes_num; ++i) {
+                const PmdSubMesh *submesh = &mesh->submeshes[i];
+                const PmdDrawRange *range = &extension->edges->draw_ranges[i];
+                if (!material_visible[submesh->material_index] || !range->indices_num) {
+                    continue;
+                }
+
+                VertexLayout_bind(extension->edge_layouts[i]);
+                extension->edge_triangles_drawn += range->indices_num / 3;
+                glDrawElements(GL_TRIANGLES, range->indices_num, extension->edges->index_type, (GLvoid*) PmdEdgeList_getIndexOffset(extension->edges, range));
+                assert(glGetError() == GL_NO_ERROR);
+            }
+        }
     }
 }
 
@@ -360,10 +639,9 @@ void sample_PmdMultirenderVBO_rendering(GLApplication *app) {
 
     // カメラを初期化する
     {
-        vec3 pmdMax;
-        vec3 pmdMin;
-
-        PmdFile_calcAABB(extension->pmd, &pmdMin, &pmdMax);
+        // 読み込み時に計算済みの境界ボリュームを利用する
+        const vec3 pmdMax = extension->pmd->bounds.aabb_max;
+        const vec3 pmdMin = extension->pmd->bounds.aabb_min;
 
         // カメラをセットアップする
         const vec3 camera_pos = vec3_create(pmdMin.z * 10.0f, pmdMax.y * 2, pmdMin.z * 10.0f); // カメラ位置
@@ -381,26 +659,69 @@ void sample_PmdMultirenderVBO_rendering(GLApplication *app) {
 
     // レンダリング負荷を掛けるために大量のモデルを描画する
     {
-        const int xModels = 8; // 横並びのモデル数
-        const int zModels = 8; // 奥へのモデル数
         const GLfloat offset = 3.0f; // モデル同士の隙間距離
 
         mat4 lp = mat4_multiply(projectionMatrix, lookMatrix);
 
+        PmdFile *pmd = extension->pmd;
+        TransformList *transforms = extension->transforms;
+        CullingList *culling = extension->culling;
+        const Frustum frustum = Frustum_create(lp);
+
         int x = 0;
         int z = 0;
+        int i = 0;
+        int m = 0;
+
+        // 回転は全モデル共通のため1度だけ生成する
+        const quat rotate = quat_rotate(vec3_create(0, 1, 0), extension->rotate);
+
+        // 全モデルのワールド行列とWVP行列を一括で計算する
+        TransformList_clear(transforms);
+        for (x = 0; x < MULTIRENDERVBO_SAMPLE_MODELS_X; ++x) {
+            for (z = 0; z < MULTIRENDERVBO_SAMPLE_MODELS_Z; ++z) {
+                TransformList_add(transforms, vec3_create(x * offset, 0, z * offset), rotate, vec3_create(1, 1, 1));
+            }
+        }
+        TransformList_calc(transforms, &lp, NULL);
+
+        // 全モデルの境界ボリュームを登録する
+        CullingList_clear(culling);
+        for (i = 0; i < transforms->num; ++i) {
+            CullingList_add(culling, &pmd->bounds, mat4_fromAffine(&transforms->worlds[i]));
+        }
 
-        for (x = 0; x < xModels; ++x) {
-            for (z = 0; z < zModels; ++z) {
-                // ワールド座標生成
-                mat4 pos = mat4_translate(x * offset, 0, z * offset);
-                mat4 rotate = mat4_rotate(vec3_create(0, 1, 0), extension->rotate);
+        // 可視と判定されたモデルだけを描画する
+        // 材質ごとの判定は可視なモデルに対してのみ行う
+        CullingList_cull(culling, &frustum, extension->pool);
+        for (i = 0; i < culling->visible_num; ++i) {
+            const GLuint model = culling->visible[i];
+            assert(model < MULTIRENDERVBO_SAMPLE_MODELS);
+            const mat4 world = mat4_fromAffine(&transforms->worlds[model]);
+
+            for (m = 0; m < pmd->materials_num; ++m) {
+                const PmdBounds *bounds = &pmd->material_bounds[m];
+                extension->material_visible[m] = Frustum_testSphere(&frustum, mat4_transformPoint(world, bounds->sphere_center), bounds->sphere_radius);
+            }
+
+            // 画面上の誤差が許容値に収まる段を選ぶ
+            int lod_level = 0;
+            if (extension->lod) {
+                const vec3 center = mat4_transformPoint(world, pmd->bounds.sphere_center);
+                const vec3 view = mat4_transformPoint(lookMatrix, center);
+                const GLfloat pixelsPerUnit = PmdLod_calcPixelsPerUnit(projectionMatrix, -view.z, app->surface_height);
 
-                mat4 world = mat4_multiply(pos, rotate);
-                sample_PmdMultirenderVBO_renderingPMD(extension, mat4_multiply(lp, world));
+                extension->lod_levels[model] = PmdLodChain_select(extension->lod, extension->lod_levels[model], pixelsPerUnit, 1.0f);
+                lod_level = extension->lod_levels[model];
             }
+
+            sample_PmdMultirenderVBO_renderingPMD(extension, transforms->wvps[model], extension->material_visible, lod_level);
         }
 
+        // 以降の描画が直接属性を設定できるよう、構成のバインドを解除する
+        VertexLayout_unbind();
+        extension->state_changes += VertexLayout_takeStateChanges();
+
         // 回転を進める
         extension->rotate += 1;
 
@@ -412,6 +733,8 @@ void sample_PmdMultirenderVBO_rendering(GLApplication *app) {
         time(&now);
 
         char message[256] = "";
+        __logf("triangles drawn(%u) full detail(%u) edge(%u)", extension->triangles_drawn, extension->triangles_full, extension->edge_triangles_drawn);
+        __logf("vertex state calls(%.1f/frame) vao(%s)", (double) extension->state_changes / extension->rotate, VertexLayout_hasVertexArrayObject() ? "true" : "false");
         sprintf(message, "[%d]秒で計測を完了しました", (int) (now - extension->startTime));
         GLApplication_abortWithMessage(app, message);
     }
@@ -437,6 +760,21 @@ void sample_PmdMultirenderVBO_destroy(GLApplication *app) {
     glDeleteProgram(extension->edge_shader.program);
     assert(glGetError() == GL_NO_ERROR);
 
+    // 頂点属性の構成を解放する
+    {
+        GLuint i = 0;
+        for (i = 0; i < extension->layouts_num; ++i) {
+            VertexLayout_free(extension->main_layouts[i]);
+            VertexLayout_free(extension->edge_layouts[i]);
+        }
+        free(extension->main_layouts);
+        free(extension->edge_layouts);
+        VertexLayout_free(extension->main_lod_layout);
+        for (i = 0; i < PMDLOD_LEVELS_MAX; ++i) {
+            VertexLayout_free(extension->edge_lod_layouts[i]);
+        }
+    }
+
     // delete前はバッファが有効であり、バインド済みになっているはずである
     {
         // バッファでなければならない
@@ -450,6 +788,18 @@ void sample_PmdMultirenderVBO_destroy(GLApplication *app) {
     // バッファオブジェクトの解放
     glDeleteBuffers(1, &extension->vertices_buffer);
     glDeleteBuffers(1, &extension->indices_buffer);
+    if (extension->lod_indices_buffer) {
+        glDeleteBuffers(1, &extension->lod_indices_buffer);
+    }
+    glDeleteBuffers(1, &extension->edge_indices_buffer);
+    {
+        int i = 0;
+        for (i = 0; i < PMDLOD_LEVELS_MAX; ++i) {
+            if (extension->lod_edge_indices_buffers[i]) {
+                glDeleteBuffers(1, &extension->lod_edge_indices_buffers[i]);
+            }
+        }
+    }
 
     // delete後はバッファが無効であり、バインドが0に戻されているはずである
     {
@@ -462,8 +812,22 @@ void sample_PmdMultirenderVBO_destroy(GLApplication *app) {
     }
 
     // PMDファイルを解放する
+    PmdCompactMesh_free(extension->compact);
+    PmdDrawMesh_free(extension->draw_mesh);
+    PmdLodChain_free(extension->lod);
+    PmdEdgeList_free(extension->edges);
+    {
+        int i = 0;
+        for (i = 0; i < PMDLOD_LEVELS_MAX; ++i) {
+            PmdEdgeList_free(extension->lod_edges[i]);
+        }
+    }
     PmdFile_free(extension->pmd);
     PmdFile_freeTextureList(extension->textureList);
+    CullingList_free(extension->culling);
+    TransformList_free(extension->transforms);
+    ThreadPool_free(extension->pool);
+    free(extension->material_visible);
 
     // サンプルアプリ用のメモリを解放する
     free(app->extension);
@@ -186,6 +186,16 @@ void sample_PmdGlFinish_initialize(GLApplication *app) {
         extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
         assert(extension->pmd);
 
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
         // テクスチャを読み込む
         extension->textureList = PmdFile_createTextureList(app, extension->pmd);
 
@@ -227,7 +237,7 @@ void sample_PmdGlFinish_initialize(GLApplication *app) {
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
 
             // アップロード
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * extension->pmd->indices_num, extension->pmd->indices, GL_STATIC_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(extension->pmd) * extension->pmd->indices_num, PmdFile_getIndices(extension->pmd, 0), GL_STATIC_DRAW);
             assert(glGetError() == GL_NO_ERROR);
 
             // バインドを解除する
@@ -303,7 +313,7 @@ void sample_PmdGlFinish_renderingPMD(Extension_PmdGlFinish *extension, const mat
             }
 
             // インデックスバッファでレンダリング
-            glDrawElements(GL_TRIANGLES, mat->indices_num, GL_UNSIGNED_SHORT, (GLvoid*) (beginIndicesIndex * sizeof(GLushort)));
+            glDrawElements(GL_TRIANGLES, mat->indices_num, pmd->index_type, (GLvoid*) (beginIndicesIndex * PmdFile_getIndexSize(pmd)));
             assert(glGetError() == GL_NO_ERROR);
 
             // GPUでの処理待ちを行う
@@ -343,7 +353,7 @@ void sample_PmdGlFinish_renderingPMD(Extension_PmdGlFinish *extension, const mat
         assert(glGetError() == GL_NO_ERROR);
 
         // インデックスバッファでレンダリング
-        glDrawElements(GL_TRIANGLES, pmd->indices_num, GL_UNSIGNED_SHORT, (GLvoid*) 0);
+        glDrawElements(GL_TRIANGLES, pmd->indices_num, pmd->index_type, (GLvoid*) 0);
         assert(glGetError() == GL_NO_ERROR);
 
         // GPUでの処理待ちを行う
@@ -431,6 +441,11 @@ void sample_PmdGlFinish_rendering(GLApplication *app) {
  * アプリのデータ削除を行う
  */
 void sample_PmdGlFinish_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
     // サンプルアプリ用データを取り出す
     Extension_PmdGlFinish *extension = (Extension_PmdGlFinish*) app->extension;
 
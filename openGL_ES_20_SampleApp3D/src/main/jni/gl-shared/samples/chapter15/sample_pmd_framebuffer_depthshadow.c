@@ -385,6 +385,16 @@ void sample_DepthShadow_initialize(GLApplication *app) {
         extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
         assert(extension->pmd);
 
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
         PmdFile_calcAABB(extension->pmd, &extension->pmd_minPosition, &extension->pmd_maxPosition);
 
         // テクスチャを読み込む
@@ -428,7 +438,7 @@ void sample_DepthShadow_initialize(GLApplication *app) {
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
 
             // アップロード
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * extension->pmd->indices_num, extension->pmd->indices, GL_STATIC_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(extension->pmd) * extension->pmd->indices_num, PmdFile_getIndices(extension->pmd, 0), GL_STATIC_DRAW);
             assert(glGetError() == GL_NO_ERROR);
 
             // バインドを解除する
@@ -480,7 +490,7 @@ void sample_DepthShadow_renderingPMDshadowmap(Extension_DepthShadow *extension,
         PmdFile *pmd = extension->pmd;
 
         // インデックスバッファでレンダリング
-        glDrawElements(GL_TRIANGLES, pmd->indices_num, GL_UNSIGNED_SHORT, 0);
+        glDrawElements(GL_TRIANGLES, pmd->indices_num, pmd->index_type, 0);
         assert(glGetError() == GL_NO_ERROR);
     }
 
@@ -583,7 +593,7 @@ void sample_DepthShadow_renderingPMDwithShadow(Extension_DepthShadow *extension,
             }
 
             // インデックスバッファでレンダリング
-            glDrawElements(GL_TRIANGLES, mat->indices_num, GL_UNSIGNED_SHORT, (GLvoid*) (beginIndicesIndex * sizeof(GLushort)));
+            glDrawElements(GL_TRIANGLES, mat->indices_num, pmd->index_type, (GLvoid*) (beginIndicesIndex * PmdFile_getIndexSize(pmd)));
             assert(glGetError() == GL_NO_ERROR);
             beginIndicesIndex += mat->indices_num;
         }
@@ -808,6 +818,11 @@ void sample_DepthShadow_rendering(GLApplication *app) {
  * アプリのデータ削除を行う
  */
 void sample_DepthShadow_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
     // サンプルアプリ用データを取り出す
     Extension_DepthShadow *extension = (Extension_DepthShadow*) app->extension;
 
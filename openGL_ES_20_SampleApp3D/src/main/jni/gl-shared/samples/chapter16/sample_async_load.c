@@ -359,6 +359,14 @@ void sample_AsyncLoad_async(GLApplication *app) {
     pmd = PmdFile_load(app, "pmd-sample.pmd");
     assert(pmd);
 
+    // 32bitインデックスを描画できない環境では実行を停止する
+    // Extension構造体へ書き戻さないため、描画スレッドからは未ロードのまま扱われる
+    if (!PmdFile_isIndexTypeSupported(pmd)) {
+        GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+        PmdFile_free(pmd);
+        return;
+    }
+
     // 頂点用バッファオブジェクトを生成＆転送する
     {
         // バッファ生成
@@ -387,7 +395,7 @@ void sample_AsyncLoad_async(GLApplication *app) {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
 
         // アップロード
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * pmd->indices_num, pmd->indices, GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(pmd) * pmd->indices_num, PmdFile_getIndices(pmd, 0), GL_STATIC_DRAW);
         assert(glGetError() == GL_NO_ERROR);
 
         // 独立したContextのため、バインドを解除しなくても描画スレッドに影響を与えない
@@ -487,7 +495,7 @@ void sample_AsyncLoad_renderingPMD(Extension_AsyncLoad *extension, const mat4 wl
             }
 
             // インデックスバッファでレンダリング
-            glDrawElements(GL_TRIANGLES, mat->indices_num, GL_UNSIGNED_SHORT, (GLvoid*) (beginIndicesIndex * sizeof(GLushort)));
+            glDrawElements(GL_TRIANGLES, mat->indices_num, pmd->index_type, (GLvoid*) (beginIndicesIndex * PmdFile_getIndexSize(pmd)));
             assert(glGetError() == GL_NO_ERROR);
             beginIndicesIndex += mat->indices_num;
         }
@@ -523,7 +531,7 @@ void sample_AsyncLoad_renderingPMD(Extension_AsyncLoad *extension, const mat4 wl
         assert(glGetError() == GL_NO_ERROR);
 
         // インデックスバッファでレンダリング
-        glDrawElements(GL_TRIANGLES, pmd->indices_num, GL_UNSIGNED_SHORT, (GLvoid*) 0);
+        glDrawElements(GL_TRIANGLES, pmd->indices_num, pmd->index_type, (GLvoid*) 0);
         assert(glGetError() == GL_NO_ERROR);
     }
 }
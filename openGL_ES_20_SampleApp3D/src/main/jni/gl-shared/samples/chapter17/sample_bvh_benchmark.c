@@ -0,0 +1,260 @@
+#include "support.h"
+
+/**
+ * 計測するインスタンス数
+ */
+static const GLuint g_instances_nums[] = { 100, 1000, 10000 };
+
+/**
+ * 計測パターン数
+ */
+#define BVHBENCHMARK_PATTERNS   (sizeof(g_instances_nums) / sizeof(g_instances_nums[0]))
+
+/**
+ * 1パターンで繰り返す判定回数
+ */
+#define BVHBENCHMARK_LOOP       100
+
+/**
+ * 1パターンで判定するレイの本数
+ */
+#define BVHBENCHMARK_RAYS       1000
+
+typedef struct {
+    // サンプル用のPMDファイル
+    PmdFile *pmd;
+
+    // 次に計測するパターン
+    int pattern;
+
+    // 計測結果
+    char message[512];
+} Extension_BvhBenchmark;
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_BvhBenchmark_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_BvhBenchmark*) malloc(sizeof(Extension_BvhBenchmark));
+    // サンプルアプリ用データを取り出す
+    Extension_BvhBenchmark *extension = (Extension_BvhBenchmark*) app->extension;
+
+    // インスタンスの境界ボリュームとしてPMDの境界を利用する
+    extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
+    assert(extension->pmd);
+
+    extension->pattern = 0;
+    strcpy(extension->message, "");
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_BvhBenchmark_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * 0.0〜1.0の乱数を返す
+ */
+static GLfloat sample_BvhBenchmark_random() {
+    return (GLfloat) rand() / (GLfloat) RAND_MAX;
+}
+
+/**
+ * 全インスタンスとレイを総当たりで判定する
+ */
+static bool sample_BvhBenchmark_raycastLinear(const vec3 *aabb_mins, const vec3 *aabb_maxs, const GLuint num, const vec3 origin, const vec3 direction) {
+    GLfloat nearest = -1;
+    GLuint i = 0;
+    int k = 0;
+    for (i = 0; i < num; ++i) {
+        const GLfloat o[3] = { origin.x, origin.y, origin.z };
+        const GLfloat d[3] = { direction.x, direction.y, direction.z };
+        const GLfloat mins[3] = { aabb_mins[i].x, aabb_mins[i].y, aabb_mins[i].z };
+        const GLfloat maxs[3] = { aabb_maxs[i].x, aabb_maxs[i].y, aabb_maxs[i].z };
+
+        GLfloat tmin = 0;
+        GLfloat tmax = 1000000.0f;
+        for (k = 0; k < 3; ++k) {
+            const GLfloat inv = d[k] != 0 ? 1.0f / d[k] : 1000000.0f;
+            const GLfloat t0 = (mins[k] - o[k]) * inv;
+            const GLfloat t1 = (maxs[k] - o[k]) * inv;
+            tmin = fmaxf(tmin, fminf(t0, t1));
+            tmax = fminf(tmax, fmaxf(t0, t1));
+        }
+        if (tmin <= tmax && (nearest < 0 || tmin < nearest)) {
+            nearest = tmin;
+        }
+    }
+    return nearest >= 0;
+}
+
+/**
+ * 指定数のインスタンスで線形カリングとBVHを比較する
+ */
+static void sample_BvhBenchmark_run(Extension_BvhBenchmark *extension, MemoryArena *arena, const GLuint num, const GLfloat aspect) {
+    const PmdBounds *bounds = &extension->pmd->bounds;
+    GLuint i = 0;
+    int loop = 0;
+
+    // インスタンスを立方体状の範囲へランダムに配置する
+    // インスタンス数が増えても密度が変わらないようにする
+    const GLfloat area = cbrtf((GLfloat) num) * bounds->sphere_radius * 4.0f;
+    mat4 *worlds = MemoryArena_alloc(arena, sizeof(mat4) * num);
+    vec3 *aabb_mins = MemoryArena_alloc(arena, sizeof(vec3) * num);
+    vec3 *aabb_maxs = MemoryArena_alloc(arena, sizeof(vec3) * num);
+    GLuint *visible = MemoryArena_alloc(arena, sizeof(GLuint) * num);
+
+    srand(num);
+    for (i = 0; i < num; ++i) {
+        const mat4 pos = mat4_translate( //
+                (sample_BvhBenchmark_random() - 0.5f) * area, //
+                (sample_BvhBenchmark_random() - 0.5f) * area, //
+                (sample_BvhBenchmark_random() - 0.5f) * area);
+        const mat4 rotate = mat4_rotate(vec3_create(0, 1, 0), sample_BvhBenchmark_random() * 360.0f);
+
+        worlds[i] = mat4_multiply(pos, rotate);
+        PmdBounds_transformAABB(bounds, worlds[i], &aabb_mins[i], &aabb_maxs[i]);
+    }
+
+    // 中心から外側を向いたカメラで、一部のインスタンスだけが視界に入るようにする
+    const mat4 lookMatrix = mat4_lookAt(vec3_create(0, 0, 0), vec3_create(1, 0, 1), vec3_create(0, 1, 0));
+    const mat4 projectionMatrix = mat4_perspective(1.0f, area, 45.0f, aspect);
+    const Frustum frustum = Frustum_create(mat4_multiply(projectionMatrix, lookMatrix));
+
+    // 線形カリング
+    double linear_time = 0;
+    GLuint linear_visible = 0;
+    {
+        CullingList *list = CullingList_create(num);
+
+        const double begin = util_getTime();
+        for (loop = 0; loop < BVHBENCHMARK_LOOP; ++loop) {
+            CullingList_clear(list);
+            for (i = 0; i < num; ++i) {
+                CullingList_add(list, bounds, worlds[i]);
+            }
+            linear_visible = CullingList_cull(list, &frustum, NULL);
+        }
+        linear_time = (util_getTime() - begin) * 1000.0 / BVHBENCHMARK_LOOP;
+
+        CullingList_free(list);
+    }
+
+    // BVHの構築
+    double build_time = 0;
+    Bvh *bvh = NULL;
+    {
+        const double begin = util_getTime();
+        bvh = Bvh_create(aabb_mins, aabb_maxs, num);
+        build_time = (util_getTime() - begin) * 1000.0;
+    }
+
+    // BVHによるカリング
+    double bvh_time = 0;
+    GLuint bvh_visible = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < BVHBENCHMARK_LOOP; ++loop) {
+            bvh_visible = Bvh_queryFrustum(bvh, &frustum, visible);
+        }
+        bvh_time = (util_getTime() - begin) * 1000.0 / BVHBENCHMARK_LOOP;
+    }
+
+    // 1割のインスタンスを移動させて境界を修正する
+    double refit_time = 0;
+    {
+        const double begin = util_getTime();
+        for (i = 0; i < num; i += 10) {
+            const mat4 moved = mat4_multiply(mat4_translate(0.5f, 0, 0), worlds[i]);
+            PmdBounds_transformAABB(bounds, moved, &aabb_mins[i], &aabb_maxs[i]);
+            Bvh_updateItem(bvh, i, aabb_mins[i], aabb_maxs[i]);
+        }
+        refit_time = (util_getTime() - begin) * 1000.0;
+    }
+
+    // レイ判定
+    double ray_linear_time = 0;
+    double ray_bvh_time = 0;
+    GLuint ray_linear_hits = 0;
+    GLuint ray_bvh_hits = 0;
+    {
+        vec3 *directions = MemoryArena_alloc(arena, sizeof(vec3) * BVHBENCHMARK_RAYS);
+        for (i = 0; i < BVHBENCHMARK_RAYS; ++i) {
+            directions[i] = vec3_createNormalized(sample_BvhBenchmark_random() - 0.5f, sample_BvhBenchmark_random() - 0.5f, sample_BvhBenchmark_random() - 0.5f);
+        }
+        const vec3 origin = vec3_create(0, 0, 0);
+
+        double begin = util_getTime();
+        for (i = 0; i < BVHBENCHMARK_RAYS; ++i) {
+            if (sample_BvhBenchmark_raycastLinear(aabb_mins, aabb_maxs, num, origin, directions[i])) {
+                ++ray_linear_hits;
+            }
+        }
+        ray_linear_time = (util_getTime() - begin) * 1000.0;
+
+        begin = util_getTime();
+        for (i = 0; i < BVHBENCHMARK_RAYS; ++i) {
+            BvhRayHit hit;
+            if (Bvh_raycast(bvh, origin, directions[i], 1000000.0f, &hit)) {
+                ++ray_bvh_hits;
+            }
+        }
+        ray_bvh_time = (util_getTime() - begin) * 1000.0;
+
+    }
+
+    __logf("instances(%d) linear(%.3f ms / %d visible) bvh(%.3f ms / %d visible) build(%.3f ms) refit(%.3f ms)", //
+            num, linear_time, linear_visible, bvh_time, bvh_visible, build_time, refit_time);
+    __logf("instances(%d) ray linear(%.3f ms / %d hits) bvh(%.3f ms / %d hits)", //
+            num, ray_linear_time, ray_linear_hits, ray_bvh_time, ray_bvh_hits);
+
+    {
+        char line[128] = "";
+        sprintf(line, "[%d] 線形%.2fms BVH%.2fms\n", num, linear_time, bvh_time);
+        strcat(extension->message, line);
+    }
+
+    Bvh_free(bvh);
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_BvhBenchmark_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_BvhBenchmark *extension = (Extension_BvhBenchmark*) app->extension;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // 1フレームに1パターンずつ計測する
+    if (extension->pattern < BVHBENCHMARK_PATTERNS) {
+        const GLfloat aspect = (GLfloat) (app->surface_width) / (GLfloat) (app->surface_height);
+        sample_BvhBenchmark_run(extension, app->frame_arena, g_instances_nums[extension->pattern], aspect);
+        ++extension->pattern;
+    } else {
+        GLApplication_abortWithMessage(app, extension->message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_BvhBenchmark_destroy(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_BvhBenchmark *extension = (Extension_BvhBenchmark*) app->extension;
+
+    // PMDファイルを解放する
+    PmdFile_free(extension->pmd);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
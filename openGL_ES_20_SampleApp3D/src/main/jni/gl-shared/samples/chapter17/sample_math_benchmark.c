@@ -0,0 +1,699 @@
+#include "support.h"
+
+/**
+ * 計測に使う行列数
+ */
+#define MATHBENCHMARK_MATRICES  1024
+
+/**
+ * 行列配列を繰り返す回数
+ */
+#define MATHBENCHMARK_LOOP      500
+
+/**
+ * WVP行列の生成を計測するインスタンス数
+ */
+static const GLuint g_instances_nums[] = { 64, 1000, 10000 };
+
+/**
+ * 計測パターン数
+ * 行列の乗算 + 逆行列・クォータニオン + 三角関数・逆平方根 + インスタンス数ごとのWVP行列生成
+ */
+#define MATHBENCHMARK_PATTERNS  (3 + sizeof(g_instances_nums) / sizeof(g_instances_nums[0]))
+
+/**
+ * WVP行列の生成を繰り返す回数
+ */
+#define MATHBENCHMARK_TRANSFORM_LOOP    100
+
+typedef struct {
+    // 一括変換を分割処理するスレッドプール
+    ThreadPool *pool;
+
+    // 次に計測するパターン
+    int pattern;
+
+    // 計測結果
+    char message[1024];
+} Extension_MathBenchmark;
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_MathBenchmark_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_MathBenchmark*) malloc(sizeof(Extension_MathBenchmark));
+    // サンプルアプリ用データを取り出す
+    Extension_MathBenchmark *extension = (Extension_MathBenchmark*) app->extension;
+
+    extension->pool = ThreadPool_create(0);
+    extension->pattern = 0;
+    strcpy(extension->message, "");
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_MathBenchmark_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * 行列の全要素の和を取得する
+ * 計算結果を利用して、最適化で処理が消えないようにする
+ */
+static GLfloat sample_MathBenchmark_sum(const mat4 *m) {
+    GLfloat result = 0;
+    int i = 0;
+    for (i = 0; i < 16; ++i) {
+        result += m->m[i / 4][i % 4];
+    }
+    return result;
+}
+
+/**
+ * 行列の乗算を計測する
+ */
+static void sample_MathBenchmark_runMultiply(Extension_MathBenchmark *extension, MemoryArena *arena) {
+    const GLuint multiplies = MATHBENCHMARK_MATRICES * MATHBENCHMARK_LOOP;
+    mat4 *worlds = MemoryArena_alloc(arena, sizeof(mat4) * MATHBENCHMARK_MATRICES);
+    mat4 *results = MemoryArena_alloc(arena, sizeof(mat4) * MATHBENCHMARK_MATRICES);
+    const mat4 lp = mat4_multiply(mat4_perspective(1.0f, 100.0f, 45.0f, 1.0f), mat4_lookAt(vec3_create(0, 5, 10), vec3_create(0, 0, 0), vec3_create(0, 1, 0)));
+    GLuint i = 0;
+    int loop = 0;
+
+    for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+        const mat4 pos = mat4_translate((GLfloat) (i % 32), 0, (GLfloat) (i / 32));
+        worlds[i] = mat4_multiply(pos, mat4_rotate(vec3_create(0, 1, 0), (GLfloat) i));
+    }
+
+    // スカラー演算の値渡し
+    double reference_time = 0;
+    GLfloat reference_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                results[i] = mat4_multiplyReference(lp, worlds[i]);
+            }
+            reference_sum += sample_MathBenchmark_sum(&results[loop % MATHBENCHMARK_MATRICES]);
+        }
+        reference_time = (util_getTime() - begin) * 1000000000.0 / multiplies;
+    }
+
+    // SIMD演算の値渡し
+    double value_time = 0;
+    GLfloat value_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                results[i] = mat4_multiply(lp, worlds[i]);
+            }
+            value_sum += sample_MathBenchmark_sum(&results[loop % MATHBENCHMARK_MATRICES]);
+        }
+        value_time = (util_getTime() - begin) * 1000000000.0 / multiplies;
+    }
+
+    // SIMD演算のポインタ渡し
+    double pointer_time = 0;
+    GLfloat pointer_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                mat4_multiply_to(&results[i], &lp, &worlds[i]);
+            }
+            pointer_sum += sample_MathBenchmark_sum(&results[loop % MATHBENCHMARK_MATRICES]);
+        }
+        pointer_time = (util_getTime() - begin) * 1000000000.0 / multiplies;
+    }
+
+    // スカラー演算との誤差を検証する
+    GLfloat error = 0;
+    for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+        const mat4 expected = mat4_multiplyReference(lp, worlds[i]);
+        int k = 0;
+        for (k = 0; k < 16; ++k) {
+            error = fmaxf(error, fabsf(results[i].m[k / 4][k % 4] - expected.m[k / 4][k % 4]));
+        }
+    }
+
+    __logf("mat4_multiply reference(%.2f ns) value(%.2f ns) pointer(%.2f ns) error(%g) sum(%f / %f / %f)", //
+            reference_time, value_time, pointer_time, error, reference_sum, value_sum, pointer_sum);
+
+    {
+        char line[128] = "";
+        sprintf(line, "mat4乗算 %.1fns -> %.1fns -> %.1fns 誤差%g\n", reference_time, value_time, pointer_time, error);
+        strcat(extension->message, line);
+    }
+}
+
+/**
+ * インスタンスごとのWVP行列の生成を計測する
+ */
+static void sample_MathBenchmark_runTransform(Extension_MathBenchmark *extension, MemoryArena *arena, const GLuint num) {
+    const mat4 lp = mat4_multiply(mat4_perspective(1.0f, 100.0f, 45.0f, 1.0f), mat4_lookAt(vec3_create(0, 5, 10), vec3_create(0, 0, 0), vec3_create(0, 1, 0)));
+    mat4 *wvps = MemoryArena_alloc(arena, sizeof(mat4) * num);
+    TransformList *list = TransformList_create(num);
+    GLuint i = 0;
+    int loop = 0;
+
+    for (i = 0; i < num; ++i) {
+        TransformList_add(list, vec3_create((GLfloat) (i % 32), 0, (GLfloat) (i / 32)), quat_rotate(vec3_create(0, 1, 0), (GLfloat) i), vec3_create(1, 1, 1));
+    }
+
+    // インスタンスごとに行列を作って掛ける
+    double matrix_time = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_TRANSFORM_LOOP; ++loop) {
+            for (i = 0; i < num; ++i) {
+                const mat4 pos = mat4_translate((GLfloat) (i % 32), 0, (GLfloat) (i / 32));
+                const mat4 rotate = mat4_rotate(vec3_create(0, 1, 0), (GLfloat) i);
+                const mat4 world = mat4_multiply(pos, rotate);
+                wvps[i] = mat4_multiply(lp, world);
+            }
+        }
+        matrix_time = (util_getTime() - begin) * 1000.0 / MATHBENCHMARK_TRANSFORM_LOOP;
+    }
+
+    // TRSから一括で計算する
+    double batch_time = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_TRANSFORM_LOOP; ++loop) {
+            TransformList_calc(list, &lp, NULL);
+        }
+        batch_time = (util_getTime() - begin) * 1000.0 / MATHBENCHMARK_TRANSFORM_LOOP;
+    }
+
+    // ワーカースレッドへ分割して計算する
+    double parallel_time = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_TRANSFORM_LOOP; ++loop) {
+            TransformList_calc(list, &lp, extension->pool);
+        }
+        parallel_time = (util_getTime() - begin) * 1000.0 / MATHBENCHMARK_TRANSFORM_LOOP;
+    }
+
+    // 行列を作って掛けた結果との誤差を検証する
+    GLfloat error = 0;
+    for (i = 0; i < num; ++i) {
+        int k = 0;
+        for (k = 0; k < 16; ++k) {
+            error = fmaxf(error, fabsf(list->wvps[i].m[k / 4][k % 4] - wvps[i].m[k / 4][k % 4]));
+        }
+    }
+
+    __logf("instances(%d) matrix(%.3f ms) batch(%.3f ms) parallel(%.3f ms) error(%g)", num, matrix_time, batch_time, parallel_time, error);
+
+    {
+        char line[128] = "";
+        sprintf(line, "[%d] WVP %.3fms -> %.3fms / %.3fms\n", num, matrix_time, batch_time, parallel_time);
+        strcat(extension->message, line);
+    }
+
+    TransformList_free(list);
+}
+
+/**
+ * 倍精度で逆行列を計算する
+ * 部分ピボット選択付きのガウス・ジョルダン法で、検証用の正解値とする。
+ */
+static void sample_MathBenchmark_inverseReference(const mat4 *m, double result[4][4]) {
+    double a[4][8];
+    int row = 0;
+    int column = 0;
+
+    for (row = 0; row < 4; ++row) {
+        for (column = 0; column < 4; ++column) {
+            a[row][column] = m->m[column][row];
+            a[row][column + 4] = (row == column) ? 1.0 : 0.0;
+        }
+    }
+
+    for (column = 0; column < 4; ++column) {
+        int pivot = column;
+        for (row = column + 1; row < 4; ++row) {
+            if (fabs(a[row][column]) > fabs(a[pivot][column])) {
+                pivot = row;
+            }
+        }
+
+        int k = 0;
+        for (k = 0; k < 8; ++k) {
+            const double temp = a[column][k];
+            a[column][k] = a[pivot][k];
+            a[pivot][k] = temp;
+        }
+
+        const double inv = 1.0 / a[column][column];
+        for (k = 0; k < 8; ++k) {
+            a[column][k] *= inv;
+        }
+
+        for (row = 0; row < 4; ++row) {
+            if (row != column) {
+                const double scale = a[row][column];
+                for (k = 0; k < 8; ++k) {
+                    a[row][k] -= a[column][k] * scale;
+                }
+            }
+        }
+    }
+
+    // result[列][行]として書き出す
+    for (row = 0; row < 4; ++row) {
+        for (column = 0; column < 4; ++column) {
+            result[column][row] = a[row][column + 4];
+        }
+    }
+}
+
+/**
+ * 倍精度で球面線形補間を行う
+ */
+static void sample_MathBenchmark_slerpReference(const quat a, const quat b, const double t, double result[4]) {
+    double qb[4] = { b.x, b.y, b.z, b.w };
+    double d = (double) a.x * b.x + (double) a.y * b.y + (double) a.z * b.z + (double) a.w * b.w;
+    int i = 0;
+    if (d < 0) {
+        for (i = 0; i < 4; ++i) {
+            qb[i] = -qb[i];
+        }
+        d = -d;
+    }
+
+    const double qa[4] = { a.x, a.y, a.z, a.w };
+    const double theta = acos(d > 1.0 ? 1.0 : d);
+    double wa = 1.0 - t;
+    double wb = t;
+    if (theta > 1e-9) {
+        wa = sin((1.0 - t) * theta) / sin(theta);
+        wb = sin(t * theta) / sin(theta);
+    }
+    for (i = 0; i < 4; ++i) {
+        result[i] = qa[i] * wa + qb[i] * wb;
+    }
+}
+
+/**
+ * 計測用の回転軸を生成する
+ */
+static vec3 sample_MathBenchmark_axis(const GLuint i) {
+    return vec3_normalize(vec3_create((GLfloat) (i % 7) + 0.5f, (GLfloat) (i % 5) - 2.0f, (GLfloat) (i % 3) + 1.0f));
+}
+
+/**
+ * 逆行列・法線行列・クォータニオン・デュアルクォータニオンを計測し、倍精度の結果と比較する
+ */
+static void sample_MathBenchmark_runQuaternion(Extension_MathBenchmark *extension, MemoryArena *arena) {
+    const GLuint operations = MATHBENCHMARK_MATRICES * MATHBENCHMARK_LOOP;
+    mat4 *worlds = MemoryArena_alloc(arena, sizeof(mat4) * MATHBENCHMARK_MATRICES);
+    mat4 *results = MemoryArena_alloc(arena, sizeof(mat4) * MATHBENCHMARK_MATRICES);
+    affine *affines = MemoryArena_alloc(arena, sizeof(affine) * MATHBENCHMARK_MATRICES);
+    affine *affine_results = MemoryArena_alloc(arena, sizeof(affine) * MATHBENCHMARK_MATRICES);
+    mat3 *normals = MemoryArena_alloc(arena, sizeof(mat3) * MATHBENCHMARK_MATRICES);
+    quat *rotations = MemoryArena_alloc(arena, sizeof(quat) * MATHBENCHMARK_MATRICES);
+    quat *quat_results = MemoryArena_alloc(arena, sizeof(quat) * MATHBENCHMARK_MATRICES);
+    dualquat *dualquats = MemoryArena_alloc(arena, sizeof(dualquat) * MATHBENCHMARK_MATRICES);
+    vec3 *points = MemoryArena_alloc(arena, sizeof(vec3) * MATHBENCHMARK_MATRICES);
+    GLuint i = 0;
+    int loop = 0;
+    int k = 0;
+
+    // 回転・非一様な拡縮・移動を持つワールド行列を用意する
+    for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+        const vec3 position = vec3_create((GLfloat) (i % 32) - 16.0f, (GLfloat) (i % 9), (GLfloat) (i / 32) - 16.0f);
+        const quat rotation = quat_rotate(sample_MathBenchmark_axis(i), (GLfloat) (i * 37 % 360));
+        const GLfloat sx = 0.5f + (GLfloat) (i % 4) * 0.5f;
+        const GLfloat sy = 1.0f + (GLfloat) (i % 3) * 0.25f;
+        const GLfloat sz = 2.0f - (GLfloat) (i % 5) * 0.25f;
+
+        rotations[i] = rotation;
+        dualquats[i] = dualquat_create(rotation, position);
+        points[i] = vec3_create((GLfloat) (i % 11) - 5.0f, (GLfloat) (i % 13) - 6.0f, (GLfloat) (i % 17) - 8.0f);
+
+        worlds[i] = mat4_multiply(mat4_translate(position.x, position.y, position.z), mat4_multiply(mat4_fromQuat(rotation), mat4_scale(sx, sy, sz)));
+        for (k = 0; k < 12; ++k) {
+            affines[i].m[k / 4][k % 4] = worlds[i].m[k % 4][k / 4];
+        }
+    }
+
+    // 汎用の逆行列
+    double inverse_time = 0;
+    GLfloat inverse_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                mat4_inverse_to(&results[i], &worlds[i]);
+            }
+            inverse_sum += sample_MathBenchmark_sum(&results[loop % MATHBENCHMARK_MATRICES]);
+        }
+        inverse_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+
+    // 汎用の逆行列と倍精度の誤差（相対誤差）
+    GLfloat inverse_error = 0;
+    GLfloat affine_error = 0;
+    GLfloat normal_error = 0;
+    for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+        double expected[4][4];
+        sample_MathBenchmark_inverseReference(&worlds[i], expected);
+        for (k = 0; k < 16; ++k) {
+            const double e = expected[k / 4][k % 4];
+            inverse_error = fmaxf(inverse_error, (GLfloat) (fabs(results[i].m[k / 4][k % 4] - e) / fmax(1.0, fabs(e))));
+        }
+
+        // 法線行列は逆行列の転置の3x3部分
+        const mat3 normal = mat4_normalMatrix(&worlds[i]);
+        int column = 0;
+        int row = 0;
+        for (column = 0; column < 3; ++column) {
+            for (row = 0; row < 3; ++row) {
+                const double e = expected[row][column];
+                normal_error = fmaxf(normal_error, (GLfloat) (fabs(normal.m[column][row] - e) / fmax(1.0, fabs(e))));
+            }
+        }
+
+        affine inv;
+        affine_inverse_to(&inv, &affines[i]);
+        for (k = 0; k < 12; ++k) {
+            const double e = expected[k % 4][k / 4];
+            affine_error = fmaxf(affine_error, (GLfloat) (fabs(inv.m[k / 4][k % 4] - e) / fmax(1.0, fabs(e))));
+        }
+    }
+
+    // アフィン変換に限定した逆行列
+    double affine_time = 0;
+    GLfloat affine_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                affine_inverse_to(&affine_results[i], &affines[i]);
+            }
+            affine_sum += affine_results[loop % MATHBENCHMARK_MATRICES].m[0][3];
+        }
+        affine_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+
+    // 法線行列
+    double normal_time = 0;
+    GLfloat normal_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                normals[i] = mat4_normalMatrix(&worlds[i]);
+            }
+            normal_sum += normals[loop % MATHBENCHMARK_MATRICES].m[1][1];
+        }
+        normal_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+
+    // 球面線形補間と正規化線形補間
+    double slerp_time = 0;
+    double nlerp_time = 0;
+    GLfloat slerp_sum = 0;
+    GLfloat slerp_error = 0;
+    GLfloat nlerp_angle = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            const GLfloat t = (GLfloat) (loop % 16) / 15.0f;
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                quat_results[i] = quat_slerp(rotations[i], rotations[(i + 1) % MATHBENCHMARK_MATRICES], t);
+            }
+            slerp_sum += quat_results[loop % MATHBENCHMARK_MATRICES].w;
+        }
+        slerp_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            const GLfloat t = (GLfloat) (loop % 16) / 15.0f;
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                quat_results[i] = quat_nlerp(rotations[i], rotations[(i + 1) % MATHBENCHMARK_MATRICES], t);
+            }
+            slerp_sum += quat_results[loop % MATHBENCHMARK_MATRICES].w;
+        }
+        nlerp_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+    for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+        const quat b = rotations[(i + 1) % MATHBENCHMARK_MATRICES];
+        const double t = (double) (i % 16) / 15.0;
+        double expected[4];
+        sample_MathBenchmark_slerpReference(rotations[i], b, t, expected);
+
+        const quat s = quat_slerp(rotations[i], b, (GLfloat) t);
+        slerp_error = fmaxf(slerp_error, (GLfloat) fabs(s.x - expected[0]));
+        slerp_error = fmaxf(slerp_error, (GLfloat) fabs(s.y - expected[1]));
+        slerp_error = fmaxf(slerp_error, (GLfloat) fabs(s.z - expected[2]));
+        slerp_error = fmaxf(slerp_error, (GLfloat) fabs(s.w - expected[3]));
+
+        // 正規化線形補間は近似のため、球面線形補間とのなす角を記録する
+        const quat n = quat_nlerp(rotations[i], b, (GLfloat) t);
+        const double d = fabs(n.x * expected[0] + n.y * expected[1] + n.z * expected[2] + n.w * expected[3]);
+        nlerp_angle = fmaxf(nlerp_angle, (GLfloat) (2.0 * acos(d > 1.0 ? 1.0 : d) * 180.0 / M_PI));
+    }
+
+    // デュアルクォータニオンでの頂点変換と行列での頂点変換
+    double dualquat_time = 0;
+    double matrix_time = 0;
+    GLfloat dualquat_sum = 0;
+    GLfloat dualquat_error = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                const vec3 p = dualquat_transformPoint(dualquats[i], points[i]);
+                dualquat_sum += p.x;
+            }
+        }
+        dualquat_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                const vec3 p = mat4_transformPoint(mat4_fromDualquat(dualquats[i]), points[i]);
+                dualquat_sum += p.x;
+            }
+        }
+        matrix_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+    for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+        // 同じ回転・移動を倍精度の行列で適用した結果と比較する
+        const quat q = rotations[i];
+        const double x = q.x, y = q.y, z = q.z, w = q.w;
+        const double px = points[i].x, py = points[i].y, pz = points[i].z;
+        const double tx = (GLfloat) (i % 32) - 16.0f, ty = (GLfloat) (i % 9), tz = (GLfloat) (i / 32) - 16.0f;
+        const double ex = (1 - 2 * (y * y + z * z)) * px + 2 * (x * y - w * z) * py + 2 * (x * z + w * y) * pz + tx;
+        const double ey = 2 * (x * y + w * z) * px + (1 - 2 * (x * x + z * z)) * py + 2 * (y * z - w * x) * pz + ty;
+        const double ez = 2 * (x * z - w * y) * px + 2 * (y * z + w * x) * py + (1 - 2 * (x * x + y * y)) * pz + tz;
+
+        // 2姿勢のブレンドも同時に検証する（同じ姿勢同士のブレンドは元の姿勢になる）
+        const dualquat pair[2] = { dualquats[i], dualquats[i] };
+        const GLfloat weights[2] = { 0.25f, 0.75f };
+        const vec3 p = dualquat_transformPoint(dualquat_blend(pair, weights, 2), points[i]);
+        dualquat_error = fmaxf(dualquat_error, (GLfloat) fabs(p.x - ex));
+        dualquat_error = fmaxf(dualquat_error, (GLfloat) fabs(p.y - ey));
+        dualquat_error = fmaxf(dualquat_error, (GLfloat) fabs(p.z - ez));
+    }
+
+    __logf("mat4_inverse(%.2f ns, error %g) affine_inverse(%.2f ns, error %g) normalMatrix(%.2f ns, error %g) sum(%f / %f / %f)", //
+            inverse_time, inverse_error, affine_time, affine_error, normal_time, normal_error, inverse_sum, affine_sum, normal_sum);
+    __logf("quat_slerp(%.2f ns, error %g) quat_nlerp(%.2f ns, max %g deg) dualquat(%.2f ns) matrix(%.2f ns) error(%g) sum(%f / %f)", //
+            slerp_time, slerp_error, nlerp_time, nlerp_angle, dualquat_time, matrix_time, dualquat_error, slerp_sum, dualquat_sum);
+
+    {
+        char line[256] = "";
+        sprintf(line, "逆行列 %.1fns / アフィン %.1fns / 法線 %.1fns 誤差%g\n", inverse_time, affine_time, normal_time, fmaxf(inverse_error, fmaxf(affine_error, normal_error)));
+        strcat(extension->message, line);
+        sprintf(line, "slerp %.1fns / nlerp %.1fns / DQ %.1fns 誤差%g\n", slerp_time, nlerp_time, dualquat_time, fmaxf(slerp_error, dualquat_error));
+        strcat(extension->message, line);
+    }
+}
+
+/**
+ * 三角関数と逆平方根の近似を計測し、倍精度のlibmと比較する
+ */
+static void sample_MathBenchmark_runFastMath(Extension_MathBenchmark *extension, MemoryArena *arena) {
+    const GLuint operations = MATHBENCHMARK_MATRICES * MATHBENCHMARK_LOOP;
+    float *angles = MemoryArena_allocAligned(arena, sizeof(float) * MATHBENCHMARK_MATRICES, SIMD4F_ALIGNMENT);
+    float *lengths = MemoryArena_allocAligned(arena, sizeof(float) * MATHBENCHMARK_MATRICES, SIMD4F_ALIGNMENT);
+    float *results = MemoryArena_allocAligned(arena, sizeof(float) * MATHBENCHMARK_MATRICES * 2, SIMD4F_ALIGNMENT);
+    GLuint i = 0;
+    int loop = 0;
+
+    // 回転で使われる範囲の角度と、正規化で使われる範囲の長さを用意する
+    for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+        angles[i] = degree2radianf((GLfloat) (i * 7 % 1440) - 720.0f + (GLfloat) i / MATHBENCHMARK_MATRICES);
+        lengths[i] = 0.001f + (GLfloat) (i * i % 9973) * 0.37f;
+    }
+
+    // libmのsin / cos（倍精度）
+    double libm_time = 0;
+    GLfloat libm_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                results[i * 2 + 0] = sin(angles[i]);
+                results[i * 2 + 1] = cos(angles[i]);
+            }
+            libm_sum += results[loop % MATHBENCHMARK_MATRICES];
+        }
+        libm_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+
+    // 近似のsincos
+    double fast_time = 0;
+    GLfloat fast_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                fastmath_sincos(angles[i], &results[i * 2 + 0], &results[i * 2 + 1]);
+            }
+            fast_sum += results[loop % MATHBENCHMARK_MATRICES];
+        }
+        fast_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+
+    // 4要素ずつ近似のsincos
+    double simd_time = 0;
+    GLfloat simd_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; i += 4) {
+                simd4f s;
+                simd4f c;
+                simd4f_sincos(simd4f_load(angles + i), &s, &c);
+                simd4f_store(results + i, s);
+                simd4f_store(results + MATHBENCHMARK_MATRICES + i, c);
+            }
+            simd_sum += results[loop % MATHBENCHMARK_MATRICES];
+        }
+        simd_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+
+    // 1 / sqrtf
+    double sqrt_time = 0;
+    GLfloat sqrt_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; ++i) {
+                results[i] = 1.0f / sqrtf(lengths[i]);
+            }
+            sqrt_sum += results[loop % MATHBENCHMARK_MATRICES];
+        }
+        sqrt_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+
+    // 近似の逆平方根
+    double rsqrt_time = 0;
+    GLfloat rsqrt_sum = 0;
+    {
+        const double begin = util_getTime();
+        for (loop = 0; loop < MATHBENCHMARK_LOOP; ++loop) {
+            for (i = 0; i < MATHBENCHMARK_MATRICES; i += 4) {
+                simd4f_store(results + i, simd4f_rsqrt(simd4f_load(lengths + i)));
+            }
+            rsqrt_sum += results[loop % MATHBENCHMARK_MATRICES];
+        }
+        rsqrt_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    }
+
+    // 倍精度との最大誤差を検証する
+    GLfloat sincos_error = 0;
+    GLfloat rsqrt_error = 0;
+    for (i = 0; i < MATHBENCHMARK_MATRICES; i += 4) {
+        simd4f s;
+        simd4f c;
+        float vs[4];
+        float vc[4];
+        float vr[4];
+        simd4f_sincos(simd4f_load(angles + i), &s, &c);
+        simd4f_storeu(vs, s);
+        simd4f_storeu(vc, c);
+        simd4f_storeu(vr, simd4f_rsqrt(simd4f_load(lengths + i)));
+
+        int k = 0;
+        for (k = 0; k < 4; ++k) {
+            float fs;
+            float fc;
+            const double a = angles[i + k];
+            const double r = 1.0 / sqrt((double) lengths[i + k]);
+            fastmath_sincos(angles[i + k], &fs, &fc);
+
+            sincos_error = fmaxf(sincos_error, (GLfloat) fmax(fabs(fs - sin(a)), fabs(fc - cos(a))));
+            sincos_error = fmaxf(sincos_error, (GLfloat) fmax(fabs(vs[k] - sin(a)), fabs(vc[k] - cos(a))));
+            rsqrt_error = fmaxf(rsqrt_error, (GLfloat) (fabs(vr[k] - r) / r));
+            rsqrt_error = fmaxf(rsqrt_error, (GLfloat) (fabs(fastmath_rsqrt(lengths[i + k]) - r) / r));
+        }
+    }
+
+    __logf("sincos libm(%.2f ns) fast(%.2f ns) simd(%.2f ns) error(%g) rsqrt sqrtf(%.2f ns) simd(%.2f ns) error(%g) sum(%f / %f / %f / %f / %f)", //
+            libm_time, fast_time, simd_time, sincos_error, sqrt_time, rsqrt_time, rsqrt_error, libm_sum, fast_sum, simd_sum, sqrt_sum, rsqrt_sum);
+
+    {
+        char line[256] = "";
+        sprintf(line, "sincos %.1fns -> %.1fns -> %.1fns 誤差%g\n", libm_time, fast_time, simd_time, sincos_error);
+        strcat(extension->message, line);
+        sprintf(line, "rsqrt %.1fns -> %.1fns 相対誤差%g\n", sqrt_time, rsqrt_time, rsqrt_error);
+        strcat(extension->message, line);
+    }
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_MathBenchmark_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_MathBenchmark *extension = (Extension_MathBenchmark*) app->extension;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // 1フレームに1パターンずつ計測する
+    // 作業用の配列はフレーム単位の一時領域から確保し、次のフレームで自動的に破棄される
+    if (extension->pattern < MATHBENCHMARK_PATTERNS) {
+        if (extension->pattern == 0) {
+            sample_MathBenchmark_runMultiply(extension, app->frame_arena);
+        } else if (extension->pattern == 1) {
+            sample_MathBenchmark_runQuaternion(extension, app->frame_arena);
+        } else if (extension->pattern == 2) {
+            sample_MathBenchmark_runFastMath(extension, app->frame_arena);
+        } else {
+            sample_MathBenchmark_runTransform(extension, app->frame_arena, g_instances_nums[extension->pattern - 3]);
+        }
+        ++extension->pattern;
+    } else {
+        GLApplication_abortWithMessage(app, extension->message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_MathBenchmark_destroy(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_MathBenchmark *extension = (Extension_MathBenchmark*) app->extension;
+
+    ThreadPool_free(extension->pool);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
@@ -0,0 +1,323 @@
+#include "support.h"
+
+typedef struct {
+    // レンダリング用シェーダープログラム
+    GLuint shader_program;
+
+    // 位置情報属性
+    GLint attr_pos;
+
+    // UV座標属性
+    GLint attr_uv;
+
+    // フラグメントシェーダの描画色
+    GLint unif_color;
+
+    // Diffuseテクスチャ
+    GLint unif_tex_diffuse;
+
+    // 描画行列
+    GLint unif_wlp;
+
+    // サンプル用のPMDファイル
+    PmdFile *pmd;
+
+    // サンプルPMD用のテクスチャリスト
+    PmdTextureList *textureList;
+
+    // 頂点バッファ
+    GLuint vertices_buffer;
+
+    // クラスタ一覧
+    PmdMeshletList *meshlets;
+
+    // 判定後のインデックスを書き込むバッファ
+    StreamBuffer *indices_stream;
+
+    // 今フレームのインデックスの書き込み位置
+    GLintptr indices_offset;
+
+    // フィギュアの回転
+    GLfloat rotate;
+
+    // 経過フレーム数
+    int frames;
+
+    // 描画した三角形数の合計
+    double triangles_drawn;
+
+    // 判定にかかった時間の合計（秒）
+    double cull_time;
+} Extension_MeshletCulling;
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_MeshletCulling_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_MeshletCulling*) malloc(sizeof(Extension_MeshletCulling));
+    // サンプルアプリ用データを取り出す
+    Extension_MeshletCulling *extension = (Extension_MeshletCulling*) app->extension;
+
+    // シェーダーを用意する
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute mediump vec4 attr_pos;"
+                        "attribute mediump vec2 attr_uv;"
+
+                        // uniforms
+                        "uniform mediump mat4 unif_wlp;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = unif_wlp * attr_pos;"
+                        "   vary_uv = attr_uv;"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+
+        // uniforms
+                "uniform lowp vec4 unif_color;"
+                        "uniform sampler2D unif_tex_diffuse;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   if(unif_color.a == 0.0) {"
+                        "       gl_FragColor = texture2D(unif_tex_diffuse, vary_uv);"
+                        "   } else {"
+                        "       gl_FragColor = unif_color;"
+                        "   }"
+                        "}";
+
+        // コンパイルとリンクを行う
+        extension->shader_program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+    }
+
+    // attributeを取り出す
+    {
+        extension->attr_pos = glGetAttribLocation(extension->shader_program, "attr_pos");
+        assert(extension->attr_pos >= 0);
+
+        extension->attr_uv = glGetAttribLocation(extension->shader_program, "attr_uv");
+        assert(extension->attr_uv >= 0);
+    }
+
+    // uniform変数のlocationを取得する
+    {
+        extension->unif_wlp = glGetUniformLocation(extension->shader_program, "unif_wlp");
+        assert(extension->unif_wlp >= 0);
+
+        extension->unif_color = glGetUniformLocation(extension->shader_program, "unif_color");
+        assert(extension->unif_color >= 0);
+
+        extension->unif_tex_diffuse = glGetUniformLocation(extension->shader_program, "unif_tex_diffuse");
+        assert(extension->unif_tex_diffuse >= 0);
+    }
+
+    {
+        // PMDを読み込む
+        extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
+        assert(extension->pmd);
+
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
+        // 並べ替えておくと隣接する三角形がクラスタにまとまりやすい
+        {
+            PmdOptimizeReport report;
+            PmdFile_optimize(extension->pmd, &report);
+        }
+
+        // テクスチャを読み込む
+        extension->textureList = PmdFile_createTextureList(app, extension->pmd);
+        PmdFile_bindTextureList(extension->pmd, extension->textureList);
+    }
+
+    // 頂点はそのまま転送する
+    {
+        glGenBuffers(1, &extension->vertices_buffer);
+        assert(extension->vertices_buffer != 0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * extension->pmd->vertices_num, extension->pmd->vertices, GL_STATIC_DRAW);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+
+    // クラスタへ分割する
+    // 判定後のインデックスが全体を超えることはないため、全体の大きさでバッファを確保する
+    {
+        extension->meshlets = PmdMeshletList_create(extension->pmd);
+        extension->indices_stream = StreamBuffer_create(GL_ELEMENT_ARRAY_BUFFER, (extension->meshlets->index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort)) * extension->meshlets->indices_num);
+    }
+
+    extension->rotate = 0;
+    extension->frames = 0;
+    extension->triangles_drawn = 0;
+    extension->cull_time = 0;
+
+    // シェーダーの利用を開始する
+    glUseProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 深度テストを有効にする
+    glEnable(GL_DEPTH_TEST);
+
+    // 片面レンダリングを有効にする
+    glEnable(GL_CULL_FACE);
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_MeshletCulling_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_MeshletCulling_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_MeshletCulling *extension = (Extension_MeshletCulling*) app->extension;
+    PmdFile *pmd = extension->pmd;
+    PmdMeshletList *meshlets = extension->meshlets;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    mat4 lp;
+    vec3 camera_pos;
+
+    // カメラを初期化する
+    // 画面からはみ出す程度に近づけて上半身を映す
+    {
+        const vec3 pmdMax = pmd->bounds.aabb_max;
+        const GLfloat radius = pmd->bounds.sphere_radius;
+
+        camera_pos = vec3_create(0, pmdMax.y * 0.8f, -radius * 1.2f); // カメラ位置
+        const vec3 camera_look = vec3_create(0, pmdMax.y * 0.75f, 0); // カメラ注視
+        const vec3 camera_up = vec3_create(0, 1, 0); // カメラ上ベクトル
+
+        const GLfloat prj_near = 0.1f;
+        const GLfloat prj_far = radius * 10.0f;
+        const GLfloat prj_fovY = 45.0f;
+        const GLfloat prj_aspect = (GLfloat) (app->surface_width) / (GLfloat) (app->surface_height);
+
+        lp = mat4_multiply(mat4_perspective(prj_near, prj_far, prj_fovY, prj_aspect), mat4_lookAt(camera_pos, camera_look, camera_up));
+    }
+
+    const vec3 axis = vec3_create(0, 1, 0);
+    const mat4 world = mat4_rotate(axis, extension->rotate);
+    const mat4 wlp = mat4_multiply(lp, world);
+
+    // モデル座標系で判定する
+    // ワールド行列は回転のみのため、逆回転で視点をモデル座標系へ移す
+    {
+        const double begin = util_getTime();
+        const Frustum frustum = Frustum_create(wlp);
+        const vec3 eye = mat4_transformPoint(mat4_rotate(axis, -extension->rotate), camera_pos);
+
+        extension->triangles_drawn += PmdMeshletList_cull(meshlets, &frustum, eye);
+        StreamBuffer_nextFrame(extension->indices_stream);
+        extension->indices_offset = StreamBuffer_write(extension->indices_stream, meshlets->visible_indices, (meshlets->index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort)) * meshlets->visible_indices_num);
+        extension->cull_time += util_getTime() - begin;
+    }
+
+    // 残ったクラスタを描画する
+    {
+        int i = 0;
+
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glEnableVertexAttribArray(extension->attr_pos);
+        glEnableVertexAttribArray(extension->attr_uv);
+        glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
+        glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) sizeof(vec3));
+        glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) wlp.m);
+
+        // マテリアル数だけ描画を行う
+        for (i = 0; i < pmd->materials_num; ++i) {
+            const PmdDrawRange *range = &meshlets->visible_ranges[i];
+            if (!range->indices_num) {
+                continue;
+            }
+
+            // テクスチャを取り出す
+            Texture *tex = pmd->diffuse_textures[i];
+            if (tex) {
+                // テクスチャがロードできている
+                glBindTexture(GL_TEXTURE_2D, tex->id);
+                glUniform1i(extension->unif_tex_diffuse, 0);
+                glUniform4f(extension->unif_color, 0, 0, 0, 0);
+            } else {
+                // カラー情報
+                const vec4 *diffuse = &pmd->diffuse_colors[i];
+                glUniform4f(extension->unif_color, diffuse->x, diffuse->y, diffuse->z, diffuse->w);
+            }
+
+            // インデックスバッファでレンダリング
+            glDrawElements(GL_TRIANGLES, range->indices_num, meshlets->index_type, (GLvoid*) (extension->indices_offset + (meshlets->index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort)) * range->indices_begin));
+            assert(glGetError() == GL_NO_ERROR);
+        }
+    }
+
+    // 回転を進める
+    extension->rotate += 1;
+
+    // 360フレーム描画したところでチェック
+    if (++extension->frames > 360) {
+        char message[256] = "";
+        sprintf(message, "三角形の%.1f%%を描画 判定%.3fms/frame", //
+                extension->triangles_drawn * 100.0 / ((double) (pmd->indices_num / 3) * extension->frames), extension->cull_time * 1000.0 / extension->frames);
+        GLApplication_abortWithMessage(app, message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_MeshletCulling_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
+    // サンプルアプリ用データを取り出す
+    Extension_MeshletCulling *extension = (Extension_MeshletCulling*) app->extension;
+
+    // シェーダーの利用を終了する
+    glUseProgram(0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // シェーダープログラムを廃棄する
+    glDeleteProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // バッファオブジェクトの解放
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &extension->vertices_buffer);
+    StreamBuffer_free(extension->indices_stream);
+
+    // PMDファイルを解放する
+    PmdMeshletList_free(extension->meshlets);
+    PmdFile_free(extension->pmd);
+    PmdFile_freeTextureList(extension->textureList);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
@@ -0,0 +1,362 @@
+#include "support.h"
+
+/**
+ * 遮蔽物となる壁の頂点数
+ */
+#define OCCLUSIONCULLING_WALL_VERTICES  8
+
+/**
+ * 遮蔽物となる壁のインデックス数
+ */
+#define OCCLUSIONCULLING_WALL_INDICES   36
+
+typedef struct {
+    // レンダリング用シェーダープログラム
+    GLuint shader_program;
+
+    // 位置情報属性
+    GLint attr_pos;
+
+    // UV座標属性
+    GLint attr_uv;
+
+    // フラグメントシェーダの描画色
+    GLint unif_color;
+
+    // Diffuseテクスチャ
+    GLint unif_tex_diffuse;
+
+    // 描画行列
+    GLint unif_wlp;
+
+    // サンプル用のPMDファイル
+    PmdFile *pmd;
+
+    // サンプルPMD用のテクスチャリスト
+    PmdTextureList *textureList;
+
+    // 遮蔽物の深度バッファ
+    OcclusionBuffer *occlusion;
+
+    // ラスタライズを分割処理するスレッドプール
+    ThreadPool *pool;
+
+    // 壁の頂点
+    vec3 wall_positions[OCCLUSIONCULLING_WALL_VERTICES];
+
+    // 壁のインデックス
+    GLushort wall_indices[OCCLUSIONCULLING_WALL_INDICES];
+
+    // 経過フレーム数
+    int frames;
+
+    // 遮蔽されたモデル数の合計
+    int occluded_total;
+
+    // 遮蔽判定にかかった時間の合計（秒）
+    double occlusion_time;
+} Extension_OcclusionCulling;
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_OcclusionCulling_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_OcclusionCulling*) malloc(sizeof(Extension_OcclusionCulling));
+    // サンプルアプリ用データを取り出す
+    Extension_OcclusionCulling *extension = (Extension_OcclusionCulling*) app->extension;
+
+    // シェーダーを用意する
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute mediump vec4 attr_pos;"
+                        "attribute mediump vec2 attr_uv;"
+
+                        // uniforms
+                        "uniform mediump mat4 unif_wlp;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = unif_wlp * attr_pos;"
+                        "   vary_uv = attr_uv;"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+
+        // uniforms
+                "uniform lowp vec4 unif_color;"
+                        "uniform sampler2D unif_tex_diffuse;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   if(unif_color.a == 0.0) {"
+                        "       gl_FragColor = texture2D(unif_tex_diffuse, vary_uv);"
+                        "   } else {"
+                        "       gl_FragColor = unif_color;"
+                        "   }"
+                        "}";
+
+        // コンパイルとリンクを行う
+        extension->shader_program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+    }
+
+    // attributeを取り出す
+    {
+        extension->attr_pos = glGetAttribLocation(extension->shader_program, "attr_pos");
+        assert(extension->attr_pos >= 0);
+
+        extension->attr_uv = glGetAttribLocation(extension->shader_program, "attr_uv");
+        assert(extension->attr_uv >= 0);
+    }
+
+    // uniform変数のlocationを取得する
+    {
+        extension->unif_wlp = glGetUniformLocation(extension->shader_program, "unif_wlp");
+        assert(extension->unif_wlp >= 0);
+
+        extension->unif_color = glGetUniformLocation(extension->shader_program, "unif_color");
+        assert(extension->unif_color >= 0);
+
+        extension->unif_tex_diffuse = glGetUniformLocation(extension->shader_program, "unif_tex_diffuse");
+        assert(extension->unif_tex_diffuse >= 0);
+    }
+
+    {
+        // PMDを読み込む
+        extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
+        assert(extension->pmd);
+
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
+        // テクスチャを読み込む
+        extension->textureList = PmdFile_createTextureList(app, extension->pmd);
+        PmdFile_bindTextureList(extension->pmd, extension->textureList);
+    }
+
+    // 遮蔽物となる壁を用意する
+    // モデル4体分の幅を持つ直方体とする
+    {
+        const vec3 pmdMax = extension->pmd->bounds.aabb_max;
+        const GLfloat width = extension->pmd->bounds.sphere_radius * 4.0f;
+        const GLfloat height = pmdMax.y * 1.5f;
+        const GLushort indices[OCCLUSIONCULLING_WALL_INDICES] = {
+        //
+                0, 1, 3, 0, 3, 2,
+                //
+                4, 6, 7, 4, 7, 5,
+                //
+                0, 2, 6, 0, 6, 4,
+                //
+                1, 5, 7, 1, 7, 3,
+                //
+                0, 4, 5, 0, 5, 1,
+                //
+                2, 3, 7, 2, 7, 6, };
+
+        int i = 0;
+        for (i = 0; i < OCCLUSIONCULLING_WALL_VERTICES; ++i) {
+            extension->wall_positions[i] = vec3_create((i & 0x1) ? width : -width, (i & 0x2) ? height : 0, (i & 0x4) ? 0.5f : 0.0f);
+        }
+        memcpy(extension->wall_indices, indices, sizeof(indices));
+    }
+
+    // 遮蔽判定は低解像度で十分
+    extension->occlusion = OcclusionBuffer_create(256, 128);
+    extension->pool = ThreadPool_create(0);
+
+    extension->frames = 0;
+    extension->occluded_total = 0;
+    extension->occlusion_time = 0;
+
+    // シェーダーの利用を開始する
+    glUseProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 深度テストを有効にする
+    glEnable(GL_DEPTH_TEST);
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_OcclusionCulling_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_OcclusionCulling_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_OcclusionCulling *extension = (Extension_OcclusionCulling*) app->extension;
+    PmdFile *pmd = extension->pmd;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // 属性を有効にする
+    glEnableVertexAttribArray(extension->attr_pos);
+
+    mat4 lp;
+
+    // カメラを初期化する
+    {
+        const vec3 pmdMax = pmd->bounds.aabb_max;
+        const GLfloat radius = pmd->bounds.sphere_radius;
+
+        // 壁の正面からモデルの並ぶ奥を見る
+        const vec3 camera_pos = vec3_create(0, pmdMax.y * 0.7f, -radius * 6.0f); // カメラ位置
+        const vec3 camera_look = vec3_create(0, pmdMax.y * 0.5f, radius * 6.0f); // カメラ注視
+        const vec3 camera_up = vec3_create(0, 1, 0); // カメラ上ベクトル
+
+        const GLfloat prj_near = 1.0f;
+        const GLfloat prj_far = radius * 60.0f;
+        const GLfloat prj_fovY = 45.0f;
+        const GLfloat prj_aspect = (GLfloat) (app->surface_width) / (GLfloat) (app->surface_height);
+
+        lp = mat4_multiply(mat4_perspective(prj_near, prj_far, prj_fovY, prj_aspect), mat4_lookAt(camera_pos, camera_look, camera_up));
+    }
+
+    // 壁を左右へ往復させる
+    const mat4 wallWorld = mat4_translate(sinf((GLfloat) extension->frames / 60.0f) * pmd->bounds.sphere_radius * 4.0f, 0, 0);
+
+    // 壁を遮蔽物としてラスタライズする
+    const double begin = util_getTime();
+    {
+        OcclusionBuffer_begin(extension->occlusion, lp);
+        OcclusionBuffer_addMesh(extension->occlusion, extension->wall_positions, sizeof(vec3), OCCLUSIONCULLING_WALL_VERTICES, extension->wall_indices, GL_UNSIGNED_SHORT, OCCLUSIONCULLING_WALL_INDICES, wallWorld);
+        OcclusionBuffer_rasterize(extension->occlusion, extension->pool);
+    }
+
+    // 壁を描画する
+    {
+        const mat4 wlp = mat4_multiply(lp, wallWorld);
+        glDisableVertexAttribArray(extension->attr_uv);
+        glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), extension->wall_positions);
+        glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) wlp.m);
+        glUniform4f(extension->unif_color, 0.5f, 0.5f, 0.5f, 1.0f);
+        glDrawElements(GL_TRIANGLES, OCCLUSIONCULLING_WALL_INDICES, GL_UNSIGNED_SHORT, extension->wall_indices);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+
+    // 壁の奥に並べたモデルを描画する
+    {
+        const int xModels = 8; // 横並びのモデル数
+        const int zModels = 4; // 奥へのモデル数
+        const GLfloat offset = pmd->bounds.sphere_radius * 1.5f; // モデル同士の隙間距離
+
+        int x = 0;
+        int z = 0;
+        int i = 0;
+        int occluded = 0;
+        double occlusion_time = util_getTime() - begin;
+
+        glEnableVertexAttribArray(extension->attr_uv);
+        glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), &pmd->vertices[0].position);
+        glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), &pmd->vertices[0].uv);
+
+        for (x = 0; x < xModels; ++x) {
+            for (z = 0; z < zModels; ++z) {
+                const mat4 world = mat4_translate((x - xModels / 2 + 0.5f) * offset, 0, (z + 2) * offset);
+
+                // 壁に隠れているモデルは描画しない
+                {
+                    const double test_begin = util_getTime();
+                    vec3 aabb_min;
+                    vec3 aabb_max;
+                    PmdBounds_transformAABB(&pmd->bounds, world, &aabb_min, &aabb_max);
+                    const bool visible = OcclusionBuffer_testAABB(extension->occlusion, aabb_min, aabb_max);
+                    occlusion_time += util_getTime() - test_begin;
+
+                    if (!visible) {
+                        ++occluded;
+                        continue;
+                    }
+                }
+
+                const mat4 wlp = mat4_multiply(lp, world);
+                glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) wlp.m);
+
+                // マテリアル数だけ描画を行う
+                for (i = 0; i < pmd->materials_num; ++i) {
+                    const PmdDrawRange *range = &pmd->draw_ranges[i];
+
+                    // テクスチャを取り出す
+                    Texture *tex = pmd->diffuse_textures[i];
+                    if (tex) {
+                        // テクスチャがロードできている
+                        glBindTexture(GL_TEXTURE_2D, tex->id);
+                        glUniform1i(extension->unif_tex_diffuse, 0);
+                        glUniform4f(extension->unif_color, 0, 0, 0, 0);
+                    } else {
+                        // カラー情報
+                        const vec4 *diffuse = &pmd->diffuse_colors[i];
+                        glUniform4f(extension->unif_color, diffuse->x, diffuse->y, diffuse->z, diffuse->w);
+                    }
+
+                    // インデックスバッファでレンダリング
+                    glDrawElements(GL_TRIANGLES, range->indices_num, pmd->index_type, PmdFile_getIndices(pmd, range->indices_begin));
+                    assert(glGetError() == GL_NO_ERROR);
+                }
+            }
+        }
+
+        extension->occluded_total += occluded;
+        extension->occlusion_time += occlusion_time;
+    }
+
+    // 360フレーム描画したところでチェック
+    if (++extension->frames > 360) {
+        char message[256] = "";
+        sprintf(message, "平均%.1f体を遮蔽 判定%.3fms/frame", //
+                (double) extension->occluded_total / extension->frames, extension->occlusion_time * 1000.0 / extension->frames);
+        GLApplication_abortWithMessage(app, message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_OcclusionCulling_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
+    // サンプルアプリ用データを取り出す
+    Extension_OcclusionCulling *extension = (Extension_OcclusionCulling*) app->extension;
+
+    // シェーダーの利用を終了する
+    glUseProgram(0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // シェーダープログラムを廃棄する
+    glDeleteProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // PMDファイルを解放する
+    PmdFile_free(extension->pmd);
+    PmdFile_freeTextureList(extension->textureList);
+
+    OcclusionBuffer_free(extension->occlusion);
+    ThreadPool_free(extension->pool);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
@@ -0,0 +1,305 @@
+#include "support.h"
+
+/**
+ * 計測に使う要素数
+ */
+#define RESOURCEHANDLE_OBJECTS  4096
+
+/**
+ * 計測を繰り返す回数
+ */
+#define RESOURCEHANDLE_LOOP     100
+
+/**
+ * 計測パターン数
+ * 確保と解放 + 走査 + 解放済みハンドルの検出
+ */
+#define RESOURCEHANDLE_PATTERNS 3
+
+typedef struct {
+    // 次に計測するパターン
+    int pattern;
+
+    // 計測結果
+    char message[512];
+} Extension_ResourceHandle;
+
+/**
+ * 0.0〜1.0の乱数を取得する
+ */
+static GLfloat sample_ResourceHandle_random() {
+    return (GLfloat) rand() / (GLfloat) RAND_MAX;
+}
+
+/**
+ * 配列をシャッフルする
+ */
+static void sample_ResourceHandle_shuffle(GLuint *order, const GLuint num) {
+    GLuint i = 0;
+    for (i = num - 1; i > 0; --i) {
+        const GLuint k = (GLuint) (sample_ResourceHandle_random() * i);
+        const GLuint temp = order[i];
+        order[i] = order[k];
+        order[k] = temp;
+    }
+}
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_ResourceHandle_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_ResourceHandle*) malloc(sizeof(Extension_ResourceHandle));
+    // サンプルアプリ用データを取り出す
+    Extension_ResourceHandle *extension = (Extension_ResourceHandle*) app->extension;
+
+    extension->pattern = 0;
+    strcpy(extension->message, "");
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_ResourceHandle_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * 確保と解放をランダムな順序で繰り返し、malloc/freeと比較する
+ */
+static void sample_ResourceHandle_runChurn(Extension_ResourceHandle *extension, MemoryArena *arena) {
+    const GLuint operations = RESOURCEHANDLE_OBJECTS * RESOURCEHANDLE_LOOP;
+    HandlePool *pool = HandlePool_create(sizeof(Texture), RESOURCEHANDLE_OBJECTS);
+    Handle *handles = MemoryArena_alloc(arena, sizeof(Handle) * RESOURCEHANDLE_OBJECTS);
+    Texture **pointers = MemoryArena_alloc(arena, sizeof(Texture*) * RESOURCEHANDLE_OBJECTS);
+    GLuint *order = MemoryArena_alloc(arena, sizeof(GLuint) * RESOURCEHANDLE_OBJECTS);
+    GLuint i = 0;
+    int loop = 0;
+
+    srand(1);
+    for (i = 0; i < RESOURCEHANDLE_OBJECTS; ++i) {
+        order[i] = i;
+    }
+    sample_ResourceHandle_shuffle(order, RESOURCEHANDLE_OBJECTS);
+
+    // malloc / free
+    double begin = util_getTime();
+    for (loop = 0; loop < RESOURCEHANDLE_LOOP; ++loop) {
+        for (i = 0; i < RESOURCEHANDLE_OBJECTS; ++i) {
+            pointers[i] = malloc(sizeof(Texture));
+            pointers[i]->id = i;
+        }
+        for (i = 0; i < RESOURCEHANDLE_OBJECTS; ++i) {
+            free(pointers[order[i]]);
+        }
+    }
+    const double malloc_time = (util_getTime() - begin) * 1000000000.0 / operations;
+
+    // HandlePool
+    begin = util_getTime();
+    for (loop = 0; loop < RESOURCEHANDLE_LOOP; ++loop) {
+        for (i = 0; i < RESOURCEHANDLE_OBJECTS; ++i) {
+            Texture *texture = HandlePool_alloc(pool, &handles[i]);
+            texture->id = i;
+        }
+        for (i = 0; i < RESOURCEHANDLE_OBJECTS; ++i) {
+            HandlePool_release(pool, handles[order[i]]);
+        }
+    }
+    const double pool_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    assert(pool->alive_num == 0);
+
+    __logf("create/destroy malloc(%.2f ns) pool(%.2f ns)", malloc_time, pool_time);
+
+    {
+        char line[128] = "";
+        sprintf(line, "確保+解放 malloc %.1fns -> pool %.1fns\n", malloc_time, pool_time);
+        strcat(extension->message, line);
+    }
+
+    HandlePool_free(pool);
+}
+
+/**
+ * 生存中の要素を走査し、散らばったポインタの走査と比較する
+ */
+static void sample_ResourceHandle_runIterate(Extension_ResourceHandle *extension, MemoryArena *arena) {
+    const GLuint operations = RESOURCEHANDLE_OBJECTS * RESOURCEHANDLE_LOOP;
+    HandlePool *pool = HandlePool_create(sizeof(Texture), RESOURCEHANDLE_OBJECTS);
+    Texture **pointers = MemoryArena_alloc(arena, sizeof(Texture*) * RESOURCEHANDLE_OBJECTS);
+    void **padding = MemoryArena_alloc(arena, sizeof(void*) * RESOURCEHANDLE_OBJECTS);
+    GLuint *order = MemoryArena_alloc(arena, sizeof(GLuint) * RESOURCEHANDLE_OBJECTS);
+    GLuint i = 0;
+    int loop = 0;
+
+    srand(2);
+    for (i = 0; i < RESOURCEHANDLE_OBJECTS; ++i) {
+        order[i] = i;
+    }
+    sample_ResourceHandle_shuffle(order, RESOURCEHANDLE_OBJECTS);
+
+    // 長時間動作したアプリのように、他の確保を挟んで順不同に配置する
+    for (i = 0; i < RESOURCEHANDLE_OBJECTS; ++i) {
+        padding[i] = malloc(32 + (rand() % 8) * 16);
+        pointers[order[i]] = malloc(sizeof(Texture));
+        pointers[order[i]]->id = i;
+
+        Handle handle = HANDLE_NULL;
+        Texture *texture = HandlePool_alloc(pool, &handle);
+        texture->id = i;
+    }
+
+    GLuint pointer_sum = 0;
+    double begin = util_getTime();
+    for (loop = 0; loop < RESOURCEHANDLE_LOOP; ++loop) {
+        for (i = 0; i < RESOURCEHANDLE_OBJECTS; ++i) {
+            pointer_sum += pointers[i]->id;
+        }
+    }
+    const double pointer_time = (util_getTime() - begin) * 1000000000.0 / operations;
+
+    GLuint pool_sum = 0;
+    begin = util_getTime();
+    for (loop = 0; loop < RESOURCEHANDLE_LOOP; ++loop) {
+        // 要素は連続配置されているため、世代番号を見ながら先頭から順に読む
+        const Texture *textures = (const Texture*) pool->items;
+        for (i = 0; i < pool->capacity; ++i) {
+            if (pool->generations[i] & 0x01) {
+                pool_sum += textures[i].id;
+            }
+        }
+    }
+    const double pool_time = (util_getTime() - begin) * 1000000000.0 / operations;
+    assert(pool_sum == pointer_sum);
+
+    __logf("iterate pointer(%.2f ns) pool(%.2f ns) sum(%u / %u)", pointer_time, pool_time, pointer_sum, pool_sum);
+
+    {
+        char line[128] = "";
+        sprintf(line, "走査 pointer %.2fns -> pool %.2fns\n", pointer_time, pool_time);
+        strcat(extension->message, line);
+    }
+
+    for (i = 0; i < RESOURCEHANDLE_OBJECTS; ++i) {
+        free(pointers[i]);
+        free(padding[i]);
+    }
+    HandlePool_free(pool);
+}
+
+/**
+ * 解放・再生成した資源を古いハンドルで参照し、無効として検出できることを確認する
+ */
+static void sample_ResourceHandle_runStale(GLApplication *app, Extension_ResourceHandle *extension) {
+    int checks = 0;
+    int detected = 0;
+
+    // テクスチャの再読み込み
+    {
+        const TextureHandle old = Texture_getHandle(Texture_load(app, "texture_rgb_512x512.png", TEXTURE_RAW_RGBA8));
+        Texture_freeHandle(old);
+        const TextureHandle reloaded = Texture_getHandle(Texture_load(app, "texture_rgb_512x512.png", TEXTURE_RAW_RGBA8));
+
+        // 同じ領域が再利用されても、世代番号が異なるため区別できる
+        ++checks;
+        if (!Texture_fromHandle(old) && Texture_fromHandle(reloaded)) {
+            ++detected;
+        }
+        Texture_freeHandle(reloaded);
+    }
+
+    // バッファの再生成
+    {
+        const GLfloat vertices[] = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+        const BufferHandle old = BufferObject_create(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        BufferObject_free(old);
+        const BufferHandle recreated = BufferObject_create(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+        ++checks;
+        if (!BufferObject_getId(old) && BufferObject_getId(recreated) && !BufferObject_free(old)) {
+            ++detected;
+        }
+        BufferObject_free(recreated);
+    }
+
+    // シェーダープログラムの再生成
+    {
+        const GLchar *vertex_shader_source = "attribute highp vec4 attr_pos;"
+                "void main() {"
+                "   gl_Position = attr_pos;"
+                "}";
+        const GLchar *fragment_shader_source = "void main() {"
+                "   gl_FragColor = vec4(1.0);"
+                "}";
+        const ProgramHandle old = ShaderProgram_create(vertex_shader_source, fragment_shader_source);
+        ShaderProgram_free(old);
+        const ProgramHandle recreated = ShaderProgram_create(vertex_shader_source, fragment_shader_source);
+
+        ++checks;
+        if (!ShaderProgram_getId(old) && ShaderProgram_getId(recreated)) {
+            ++detected;
+        }
+        ShaderProgram_free(recreated);
+    }
+
+    // フレームバッファの再生成
+    {
+        const FramebufferHandle old = FramebufferObject_create(256, 256, true);
+        const TextureHandle oldColor = FramebufferObject_get(old)->color;
+        FramebufferObject_free(old);
+        const FramebufferHandle recreated = FramebufferObject_create(256, 256, true);
+
+        // カラーバッファのテクスチャも一緒に無効となる
+        ++checks;
+        if (!FramebufferObject_getId(old) && !Texture_fromHandle(oldColor) && FramebufferObject_getId(recreated)) {
+            ++detected;
+        }
+        FramebufferObject_free(recreated);
+    }
+
+    __logf("stale handles detected(%d / %d)", detected, checks);
+
+    {
+        char line[128] = "";
+        sprintf(line, "解放済みハンドルの検出 %d / %d\n", detected, checks);
+        strcat(extension->message, line);
+    }
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_ResourceHandle_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_ResourceHandle *extension = (Extension_ResourceHandle*) app->extension;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // 1フレームに1パターンずつ計測する
+    if (extension->pattern < RESOURCEHANDLE_PATTERNS) {
+        if (extension->pattern == 0) {
+            sample_ResourceHandle_runChurn(extension, app->frame_arena);
+        } else if (extension->pattern == 1) {
+            sample_ResourceHandle_runIterate(extension, app->frame_arena);
+        } else {
+            sample_ResourceHandle_runStale(app, extension);
+        }
+        ++extension->pattern;
+    } else {
+        GLApplication_abortWithMessage(app, extension->message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_ResourceHandle_destroy(GLApplication *app) {
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
@@ -0,0 +1,407 @@
+#include "support.h"
+
+/**
+ * 背景として並べるモデル数（1辺）
+ */
+#define SCENEGRAPH_SAMPLE_MODELS    10
+
+/**
+ * 回転台に載せるモデル数
+ */
+#define SCENEGRAPH_SAMPLE_RIDERS    4
+
+/**
+ * 計測するフレーム数
+ */
+#define SCENEGRAPH_SAMPLE_FRAMES    360
+
+/**
+ * 全ノードの再計算を計測する回数
+ */
+#define SCENEGRAPH_SAMPLE_FULL_LOOP 100
+
+typedef struct {
+    // レンダリング用シェーダープログラム
+    GLuint shader_program;
+
+    // 位置情報属性
+    GLint attr_pos;
+
+    // UV座標属性
+    GLint attr_uv;
+
+    // フラグメントシェーダの描画色
+    GLint unif_color;
+
+    // Diffuseテクスチャ
+    GLint unif_tex_diffuse;
+
+    // 描画行列
+    GLint unif_wlp;
+
+    // サンプル用のPMDファイル
+    PmdFile *pmd;
+
+    // サンプルPMD用のテクスチャリスト
+    PmdTextureList *textureList;
+
+    // 頂点バッファ
+    GLuint vertices_buffer;
+
+    // インデックスバッファ
+    GLuint indices_buffer;
+
+    // 背景と回転台を持つシーングラフ
+    SceneGraph *graph;
+
+    // 回転台のノード番号
+    GLuint carousel;
+
+    // 回転台に載せたモデルのノード番号
+    GLuint riders[SCENEGRAPH_SAMPLE_RIDERS];
+
+    // 経過フレーム数
+    int frames;
+
+    // 差分更新の時間の合計（秒）
+    double update_time;
+
+    // 全ノードを再計算した場合の1回の時間（秒）
+    double full_time;
+
+    // 更新したノード数の合計
+    GLuint updated_nodes;
+
+    // 描画したモデル数の合計
+    GLuint drawn_models;
+} Extension_SceneGraph;
+
+/**
+ * 材質の描画情報を設定する
+ */
+static void sample_SceneGraph_bindMaterial(Extension_SceneGraph *extension, Texture *tex, const vec4 *diffuse) {
+    if (tex) {
+        // テクスチャがロードできている
+        glBindTexture(GL_TEXTURE_2D, tex->id);
+        glUniform1i(extension->unif_tex_diffuse, 0);
+        glUniform4f(extension->unif_color, 0, 0, 0, 0);
+    } else {
+        // カラー情報
+        glUniform4f(extension->unif_color, diffuse->x, diffuse->y, diffuse->z, diffuse->w);
+    }
+}
+
+/**
+ * 回転台の姿勢を設定する
+ */
+static void sample_SceneGraph_moveCarousel(Extension_SceneGraph *extension) {
+    const vec3 one = vec3_create(1, 1, 1);
+    const GLfloat angle = (GLfloat) extension->frames;
+    int i = 0;
+
+    SceneGraph_setTransform(extension->graph, extension->carousel, vec3_create(0, 0, 0), quat_rotate(vec3_create(0, 1, 0), angle), one);
+
+    // 載せたモデルは回転台の上でさらに自転する
+    for (i = 0; i < SCENEGRAPH_SAMPLE_RIDERS; ++i) {
+        const GLfloat radius = extension->pmd->bounds.sphere_radius * 2.0f;
+        const GLfloat offset = 360.0f / SCENEGRAPH_SAMPLE_RIDERS * i;
+        const vec3 position = vec3_create(cosf(degree2radianf(offset)) * radius, 0, sinf(degree2radianf(offset)) * radius);
+        SceneGraph_setTransform(extension->graph, extension->riders[i], position, quat_rotate(vec3_create(0, 1, 0), angle * -3.0f), one);
+    }
+}
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_SceneGraph_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_SceneGraph*) malloc(sizeof(Extension_SceneGraph));
+    // サンプルアプリ用データを取り出す
+    Extension_SceneGraph *extension = (Extension_SceneGraph*) app->extension;
+
+    // シェーダーを用意する
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute mediump vec4 attr_pos;"
+                        "attribute mediump vec2 attr_uv;"
+
+                        // uniforms
+                        "uniform mediump mat4 unif_wlp;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = unif_wlp * attr_pos;"
+                        "   vary_uv = attr_uv;"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+
+        // uniforms
+                "uniform lowp vec4 unif_color;"
+                        "uniform sampler2D unif_tex_diffuse;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   if(unif_color.a == 0.0) {"
+                        "       gl_FragColor = texture2D(unif_tex_diffuse, vary_uv);"
+                        "   } else {"
+                        "       gl_FragColor = unif_color;"
+                        "   }"
+                        "}";
+
+        // コンパイルとリンクを行う
+        extension->shader_program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+    }
+
+    // attributeを取り出す
+    {
+        extension->attr_pos = glGetAttribLocation(extension->shader_program, "attr_pos");
+        assert(extension->attr_pos >= 0);
+
+        extension->attr_uv = glGetAttribLocation(extension->shader_program, "attr_uv");
+        assert(extension->attr_uv >= 0);
+    }
+
+    // uniform変数のlocationを取得する
+    {
+        extension->unif_wlp = glGetUniformLocation(extension->shader_program, "unif_wlp");
+        assert(extension->unif_wlp >= 0);
+
+        extension->unif_color = glGetUniformLocation(extension->shader_program, "unif_color");
+        assert(extension->unif_color >= 0);
+
+        extension->unif_tex_diffuse = glGetUniformLocation(extension->shader_program, "unif_tex_diffuse");
+        assert(extension->unif_tex_diffuse >= 0);
+    }
+
+    {
+        // PMDを読み込む
+        extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
+        assert(extension->pmd);
+
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
+        // テクスチャを読み込む
+        extension->textureList = PmdFile_createTextureList(app, extension->pmd);
+        PmdFile_bindTextureList(extension->pmd, extension->textureList);
+    }
+
+    // モデルを描画するためのバッファを用意する
+    {
+        PmdFile *pmd = extension->pmd;
+
+        glGenBuffers(1, &extension->vertices_buffer);
+        glGenBuffers(1, &extension->indices_buffer);
+        assert(extension->vertices_buffer && extension->indices_buffer);
+
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * pmd->vertices_num, pmd->vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(pmd) * pmd->indices_num, PmdFile_getIndices(pmd, 0), GL_STATIC_DRAW);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+
+    // シーングラフを構築する
+    // 親は必ず子より先に登録する
+    {
+        PmdFile *pmd = extension->pmd;
+        const vec3 one = vec3_create(1, 1, 1);
+        const GLfloat offset = pmd->bounds.sphere_radius * 1.5f;
+        int x = 0;
+        int z = 0;
+        int i = 0;
+
+        extension->graph = SceneGraph_create(SCENEGRAPH_SAMPLE_MODELS * SCENEGRAPH_SAMPLE_MODELS + SCENEGRAPH_SAMPLE_RIDERS + 2);
+
+        // 背景は動かないステージの子として並べる
+        const GLuint stage = SceneGraph_add(extension->graph, SCENEGRAPH_ROOT, vec3_create(0, 0, 0), quat_identity(), one, NULL);
+        for (x = 0; x < SCENEGRAPH_SAMPLE_MODELS; ++x) {
+            for (z = 0; z < SCENEGRAPH_SAMPLE_MODELS; ++z) {
+                // 中央は回転台のために空けておく
+                if (abs(x - SCENEGRAPH_SAMPLE_MODELS / 2) <= 1 && abs(z - SCENEGRAPH_SAMPLE_MODELS / 2) <= 1) {
+                    continue;
+                }
+
+                const vec3 position = vec3_create((x - SCENEGRAPH_SAMPLE_MODELS / 2) * offset, 0, (z - SCENEGRAPH_SAMPLE_MODELS / 2) * offset);
+                SceneGraph_add(extension->graph, stage, position, quat_rotate(vec3_create(0, 1, 0), (GLfloat) (x * 37 + z * 11)), one, &pmd->bounds);
+            }
+        }
+
+        // 回転台とそれに載せるモデル
+        extension->carousel = SceneGraph_add(extension->graph, SCENEGRAPH_ROOT, vec3_create(0, 0, 0), quat_identity(), one, NULL);
+        for (i = 0; i < SCENEGRAPH_SAMPLE_RIDERS; ++i) {
+            extension->riders[i] = SceneGraph_add(extension->graph, extension->carousel, vec3_create(0, 0, 0), quat_identity(), one, &pmd->bounds);
+        }
+    }
+
+    extension->frames = 0;
+    extension->update_time = 0;
+    extension->updated_nodes = 0;
+    extension->drawn_models = 0;
+
+    // 比較用に、毎フレーム全ノードを再計算した場合の時間を計測する
+    {
+        const double begin = util_getTime();
+        int loop = 0;
+        for (loop = 0; loop < SCENEGRAPH_SAMPLE_FULL_LOOP; ++loop) {
+            SceneGraph_invalidate(extension->graph);
+            SceneGraph_update(extension->graph);
+        }
+        extension->full_time = (util_getTime() - begin) / SCENEGRAPH_SAMPLE_FULL_LOOP;
+    }
+
+    // シェーダーの利用を開始する
+    glUseProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 深度テストを有効にする
+    glEnable(GL_DEPTH_TEST);
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_SceneGraph_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_SceneGraph_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_SceneGraph *extension = (Extension_SceneGraph*) app->extension;
+    PmdFile *pmd = extension->pmd;
+    SceneGraph *graph = extension->graph;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    mat4 lp;
+
+    // ステージの一部を見下ろすカメラ
+    {
+        const GLfloat radius = pmd->bounds.sphere_radius * SCENEGRAPH_SAMPLE_MODELS * 0.5f;
+        const GLfloat angle = degree2radianf((GLfloat) extension->frames);
+
+        const vec3 camera_pos = vec3_create(sinf(angle) * radius, radius * 0.5f, cosf(angle) * radius); // カメラ位置
+        const vec3 camera_look = vec3_create(0, 0, 0); // カメラ注視
+        const vec3 camera_up = vec3_create(0, 1, 0); // カメラ上ベクトル
+
+        const GLfloat prj_near = 1.0f;
+        const GLfloat prj_far = radius * 4.0f;
+        const GLfloat prj_fovY = 45.0f;
+        const GLfloat prj_aspect = (GLfloat) (app->surface_width) / (GLfloat) (app->surface_height);
+
+        lp = mat4_multiply(mat4_perspective(prj_near, prj_far, prj_fovY, prj_aspect), mat4_lookAt(camera_pos, camera_look, camera_up));
+    }
+
+    // 回転台だけを動かし、変更されたノードだけを更新する
+    {
+        sample_SceneGraph_moveCarousel(extension);
+
+        const double begin = util_getTime();
+        extension->updated_nodes += SceneGraph_update(graph);
+        extension->update_time += util_getTime() - begin;
+    }
+
+    // 更新済みの境界ボリュームで視錐台カリングを行う
+    const Frustum frustum = Frustum_create(lp);
+    CullingList_cull(graph->culling, &frustum, NULL);
+
+    glEnableVertexAttribArray(extension->attr_pos);
+    glEnableVertexAttribArray(extension->attr_uv);
+    glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+    glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
+    glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) sizeof(vec3));
+
+    {
+        GLuint i = 0;
+        int m = 0;
+        for (i = 0; i < graph->culling->visible_num; ++i) {
+            const GLuint node = graph->culling->visible[i];
+
+            // ステージや回転台のような描画物を持たないノードは飛ばす
+            if (!(graph->flags[node] & SCENEGRAPH_FLAG_BOUNDS)) {
+                continue;
+            }
+
+            const mat4 world = SceneGraph_getWorld(graph, node);
+            mat4 wlp;
+            mat4_multiply_to(&wlp, &lp, &world);
+            glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) wlp.m);
+
+            for (m = 0; m < pmd->materials_num; ++m) {
+                const PmdDrawRange *range = &pmd->draw_ranges[m];
+                sample_SceneGraph_bindMaterial(extension, pmd->diffuse_textures[m], &pmd->diffuse_colors[m]);
+                glDrawElements(GL_TRIANGLES, range->indices_num, pmd->index_type, (GLvoid*) (PmdFile_getIndexSize(pmd) * range->indices_begin));
+                assert(glGetError() == GL_NO_ERROR);
+            }
+            ++extension->drawn_models;
+        }
+    }
+
+    // 一周したところでチェック
+    if (++extension->frames >= SCENEGRAPH_SAMPLE_FRAMES) {
+        char message[256] = "";
+        __logf("SceneGraph nodes(%d) updated(%.1f / frame) update(%.4f ms) full(%.4f ms) drawn(%.1f / frame)", graph->num, //
+                (double) extension->updated_nodes / SCENEGRAPH_SAMPLE_FRAMES, extension->update_time * 1000.0 / SCENEGRAPH_SAMPLE_FRAMES, //
+                extension->full_time * 1000.0, (double) extension->drawn_models / SCENEGRAPH_SAMPLE_FRAMES);
+        sprintf(message, "更新ノード %d -> %.1f / %.4fms -> %.4fms", graph->num, (double) extension->updated_nodes / SCENEGRAPH_SAMPLE_FRAMES, //
+                extension->full_time * 1000.0, extension->update_time * 1000.0 / SCENEGRAPH_SAMPLE_FRAMES);
+        GLApplication_abortWithMessage(app, message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_SceneGraph_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
+    // サンプルアプリ用データを取り出す
+    Extension_SceneGraph *extension = (Extension_SceneGraph*) app->extension;
+
+    // シェーダーの利用を終了する
+    glUseProgram(0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // シェーダープログラムを廃棄する
+    glDeleteProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // バッファオブジェクトの解放
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &extension->vertices_buffer);
+    glDeleteBuffers(1, &extension->indices_buffer);
+
+    SceneGraph_free(extension->graph);
+
+    // PMDファイルを解放する
+    PmdFile_free(extension->pmd);
+    PmdFile_freeTextureList(extension->textureList);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
@@ -0,0 +1,277 @@
+#include "support.h"
+
+/**
+ * 描画するスプライト数
+ */
+#define SPRITEBATCH_SAMPLE_SPRITES  500
+
+/**
+ * 各方式で計測するフレーム数
+ */
+#define SPRITEBATCH_SAMPLE_FRAMES   180
+
+typedef struct {
+    // レンダリング用シェーダープログラム
+    GLuint shader_program;
+
+    // 位置情報属性
+    GLint attr_pos;
+
+    // UV座標属性
+    GLint attr_uv;
+
+    // 乗算色属性
+    GLint attr_color;
+
+    // 描画行列
+    GLint unif_wlp;
+
+    // UV行列
+    GLint unif_uvm;
+
+    // テクスチャ
+    GLint unif_texture;
+
+    // 描画するテクスチャ
+    Texture *textures[2];
+
+    // スプライトバッチ
+    SpriteBatch *batch;
+
+    // 経過フレーム数
+    int frames;
+
+    // 方式ごとの描画時間の合計（秒）
+    double sprite_time;
+    double batch_time;
+
+    // バッチでの描画回数
+    GLuint batch_draws;
+} Extension_SpriteBatch;
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_SpriteBatch_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_SpriteBatch*) malloc(sizeof(Extension_SpriteBatch));
+    // サンプルアプリ用データを取り出す
+    Extension_SpriteBatch *extension = (Extension_SpriteBatch*) app->extension;
+
+    // シェーダーを用意する
+    // バッチでは頂点が変換済みのため、単位行列を渡して同じシェーダーで描画する
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute mediump vec4 attr_pos;"
+                        "attribute mediump vec2 attr_uv;"
+                        "attribute lowp vec4 attr_color;"
+                        // uniforms
+                        "uniform mediump mat4 unif_wlp;"
+                        "uniform mediump mat4 unif_uvm;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        "varying lowp vec4 vary_color;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = unif_wlp * attr_pos;"
+                        "   vary_uv = (unif_uvm * vec4(attr_uv, 0.0, 1.0)).xy;"
+                        "   vary_color = attr_color;"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+        // uniforms
+                "uniform sampler2D unif_texture;"
+                // varyings
+                        "varying mediump vec2 vary_uv;"
+                        "varying lowp vec4 vary_color;"
+                        // main
+                        "void main() {"
+                        "   gl_FragColor = texture2D(unif_texture, vary_uv) * vary_color;"
+                        "}";
+
+        // コンパイルとリンクを行う
+        extension->shader_program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+    }
+
+    // attributeを取り出す
+    {
+        extension->attr_pos = glGetAttribLocation(extension->shader_program, "attr_pos");
+        assert(extension->attr_pos >= 0);
+
+        extension->attr_uv = glGetAttribLocation(extension->shader_program, "attr_uv");
+        assert(extension->attr_uv >= 0);
+
+        extension->attr_color = glGetAttribLocation(extension->shader_program, "attr_color");
+        assert(extension->attr_color >= 0);
+    }
+
+    // uniform変数のlocationを取得する
+    {
+        extension->unif_wlp = glGetUniformLocation(extension->shader_program, "unif_wlp");
+        assert(extension->unif_wlp >= 0);
+
+        extension->unif_uvm = glGetUniformLocation(extension->shader_program, "unif_uvm");
+        assert(extension->unif_uvm >= 0);
+
+        extension->unif_texture = glGetUniformLocation(extension->shader_program, "unif_texture");
+        assert(extension->unif_texture >= 0);
+    }
+
+    {
+        extension->textures[0] = Texture_load(app, "simple-atlas.png", TEXTURE_RAW_RGBA8);
+        assert(extension->textures[0]);
+        extension->textures[1] = Texture_load(app, "texture_rgb_512x512.png", TEXTURE_RAW_RGBA8);
+        assert(extension->textures[1]);
+    }
+
+    extension->batch = SpriteBatch_create(SPRITEBATCH_SAMPLE_SPRITES);
+    extension->frames = 0;
+    extension->sprite_time = 0;
+    extension->batch_time = 0;
+    extension->batch_draws = 0;
+
+    // シェーダーの利用を開始する
+    glUseProgram(extension->shader_program);
+    glUniform1i(extension->unif_texture, 0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 半透明を有効にする
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_SpriteBatch_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_SpriteBatch_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_SpriteBatch *extension = (Extension_SpriteBatch*) app->extension;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glEnableVertexAttribArray(extension->attr_pos);
+    glEnableVertexAttribArray(extension->attr_uv);
+
+    const double begin = util_getTime();
+    const bool batching = extension->frames >= SPRITEBATCH_SAMPLE_FRAMES;
+    int i = 0;
+
+    if (batching) {
+        // 変換済みの頂点を描画する
+        const mat4 identity = mat4_identity();
+        glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) identity.m);
+        glUniformMatrix4fv(extension->unif_uvm, 1, GL_FALSE, (GLfloat*) identity.m);
+        glEnableVertexAttribArray(extension->attr_color);
+
+        SpriteBatch_begin(extension->batch, app->surface_width, app->surface_height, extension->attr_pos, extension->attr_uv, extension->attr_color);
+    } else {
+        // 1枚ずつ行列を作って描画する
+        const GLfloat position[] = {
+        // v0(left top)
+                -0.5f, 0.5f,
+                // v1(left bottom)
+                -0.5f, -0.5f,
+                // v2(right top)
+                0.5f, 0.5f,
+                // v3(right bottom)
+                0.5f, -0.5f, };
+        const GLfloat uv[] = {
+        // v0(left top)
+                0, 0,
+                // v1(left bottom)
+                0, 1,
+                // v2(right top)
+                1, 0,
+                // v3(right bottom)
+                1, 1, };
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glDisableVertexAttribArray(extension->attr_color);
+        glVertexAttrib4f(extension->attr_color, 1.0f, 1.0f, 1.0f, 1.0f);
+        glVertexAttribPointer(extension->attr_pos, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*) position);
+        glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*) uv);
+    }
+
+    // 2枚のテクスチャを交互に使い、回転・拡大したスプライトを並べる
+    for (i = 0; i < SPRITEBATCH_SAMPLE_SPRITES; ++i) {
+        const Texture *texture = extension->textures[i % 2];
+        const GLint size = 32 + (i % 5) * 16;
+        const GLint x = (i * 97) % app->surface_width;
+        const GLint y = (i * 61 + extension->frames * 2) % app->surface_height;
+        const GLfloat rotate = (GLfloat) (i * 7 + extension->frames * 3);
+
+        if (batching) {
+            SpriteBatch_draw(extension->batch, texture, 0, 0, texture->width / 2, texture->height / 2, x, y, size, size, rotate, 0, 0xFFFFFFC0);
+        } else {
+            const mat4 matrix = Sprite_createPositionMatrix(app->surface_width, app->surface_height, x, y, size, size, rotate);
+            const mat4 uvMatrix = Sprite_createUvMatrix(texture->width, texture->height, 0, 0, texture->width / 2, texture->height / 2);
+            glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) matrix.m);
+            glUniformMatrix4fv(extension->unif_uvm, 1, GL_FALSE, (GLfloat*) uvMatrix.m);
+            glBindTexture(GL_TEXTURE_2D, texture->id);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            assert(glGetError() == GL_NO_ERROR);
+        }
+    }
+
+    if (batching) {
+        extension->batch_draws = SpriteBatch_end(extension->batch);
+    }
+
+    // 描画の完了までを計測する
+    glFinish();
+    if (batching) {
+        extension->batch_time += util_getTime() - begin;
+    } else {
+        extension->sprite_time += util_getTime() - begin;
+    }
+
+    // 両方の方式を計測したところでチェック
+    if (++extension->frames >= SPRITEBATCH_SAMPLE_FRAMES * 2) {
+        char message[256] = "";
+        sprintf(message, "描画回数 %d -> %d / %.2fms -> %.2fms", //
+                SPRITEBATCH_SAMPLE_SPRITES, extension->batch_draws, //
+                extension->sprite_time * 1000.0 / SPRITEBATCH_SAMPLE_FRAMES, extension->batch_time * 1000.0 / SPRITEBATCH_SAMPLE_FRAMES);
+        GLApplication_abortWithMessage(app, message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_SpriteBatch_destroy(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_SpriteBatch *extension = (Extension_SpriteBatch*) app->extension;
+
+    // シェーダーの利用を終了する
+    glUseProgram(0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // シェーダープログラムを廃棄する
+    glDeleteProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    SpriteBatch_free(extension->batch);
+
+    Texture_free(extension->textures[0]);
+    Texture_free(extension->textures[1]);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
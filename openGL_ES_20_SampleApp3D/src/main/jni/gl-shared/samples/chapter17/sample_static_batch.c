@@ -0,0 +1,368 @@
+#include "support.h"
+
+/**
+ * 背景として並べるモデル数（1辺）
+ */
+#define STATICBATCH_SAMPLE_MODELS   10
+
+/**
+ * 各方式で計測するフレーム数
+ */
+#define STATICBATCH_SAMPLE_FRAMES   180
+
+typedef struct {
+    // レンダリング用シェーダープログラム
+    GLuint shader_program;
+
+    // 位置情報属性
+    GLint attr_pos;
+
+    // UV座標属性
+    GLint attr_uv;
+
+    // フラグメントシェーダの描画色
+    GLint unif_color;
+
+    // Diffuseテクスチャ
+    GLint unif_tex_diffuse;
+
+    // 描画行列
+    GLint unif_wlp;
+
+    // サンプル用のPMDファイル
+    PmdFile *pmd;
+
+    // サンプルPMD用のテクスチャリスト
+    PmdTextureList *textureList;
+
+    // モデル単位で描画する場合の頂点バッファ
+    GLuint vertices_buffer;
+
+    // モデル単位で描画する場合のインデックスバッファ
+    GLuint indices_buffer;
+
+    // 背景をまとめたバッチ
+    StaticBatch *batch;
+
+    // 経過フレーム数
+    int frames;
+
+    // 方式ごとの描画時間の合計（秒）
+    double instance_time;
+    double batch_time;
+
+    // 方式ごとの1フレームの描画回数
+    int instance_draws;
+    int batch_draws;
+} Extension_StaticBatch;
+
+/**
+ * モデルのワールド行列を取得する
+ */
+static mat4 sample_StaticBatch_world(const PmdFile *pmd, const int x, const int z) {
+    const GLfloat offset = pmd->bounds.sphere_radius * 1.5f;
+    const mat4 pos = mat4_translate((x - STATICBATCH_SAMPLE_MODELS / 2) * offset, 0, (z - STATICBATCH_SAMPLE_MODELS / 2) * offset);
+    return mat4_multiply(pos, mat4_rotate(vec3_create(0, 1, 0), (GLfloat) (x * 37 + z * 11)));
+}
+
+/**
+ * 材質の描画情報を設定する
+ */
+static void sample_StaticBatch_bindMaterial(Extension_StaticBatch *extension, Texture *tex, const vec4 *diffuse) {
+    if (tex) {
+        // テクスチャがロードできている
+        glBindTexture(GL_TEXTURE_2D, tex->id);
+        glUniform1i(extension->unif_tex_diffuse, 0);
+        glUniform4f(extension->unif_color, 0, 0, 0, 0);
+    } else {
+        // カラー情報
+        glUniform4f(extension->unif_color, diffuse->x, diffuse->y, diffuse->z, diffuse->w);
+    }
+}
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_StaticBatch_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_StaticBatch*) malloc(sizeof(Extension_StaticBatch));
+    // サンプルアプリ用データを取り出す
+    Extension_StaticBatch *extension = (Extension_StaticBatch*) app->extension;
+
+    // シェーダーを用意する
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute mediump vec4 attr_pos;"
+                        "attribute mediump vec2 attr_uv;"
+
+                        // uniforms
+                        "uniform mediump mat4 unif_wlp;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = unif_wlp * attr_pos;"
+                        "   vary_uv = attr_uv;"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+
+        // uniforms
+                "uniform lowp vec4 unif_color;"
+                        "uniform sampler2D unif_tex_diffuse;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   if(unif_color.a == 0.0) {"
+                        "       gl_FragColor = texture2D(unif_tex_diffuse, vary_uv);"
+                        "   } else {"
+                        "       gl_FragColor = unif_color;"
+                        "   }"
+                        "}";
+
+        // コンパイルとリンクを行う
+        extension->shader_program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+    }
+
+    // attributeを取り出す
+    {
+        extension->attr_pos = glGetAttribLocation(extension->shader_program, "attr_pos");
+        assert(extension->attr_pos >= 0);
+
+        extension->attr_uv = glGetAttribLocation(extension->shader_program, "attr_uv");
+        assert(extension->attr_uv >= 0);
+    }
+
+    // uniform変数のlocationを取得する
+    {
+        extension->unif_wlp = glGetUniformLocation(extension->shader_program, "unif_wlp");
+        assert(extension->unif_wlp >= 0);
+
+        extension->unif_color = glGetUniformLocation(extension->shader_program, "unif_color");
+        assert(extension->unif_color >= 0);
+
+        extension->unif_tex_diffuse = glGetUniformLocation(extension->shader_program, "unif_tex_diffuse");
+        assert(extension->unif_tex_diffuse >= 0);
+    }
+
+    {
+        // PMDを読み込む
+        extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
+        assert(extension->pmd);
+
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
+        // 重複頂点をまとめておくとページ数が減る
+        {
+            PmdOptimizeReport report;
+            PmdFile_optimize(extension->pmd, &report);
+        }
+
+        // テクスチャを読み込む
+        // バッチは材質のテクスチャで描画をまとめるため、構築前に関連付けておく
+        extension->textureList = PmdFile_createTextureList(app, extension->pmd);
+        PmdFile_bindTextureList(extension->pmd, extension->textureList);
+    }
+
+    // モデル単位で描画するためのバッファを用意する
+    {
+        PmdFile *pmd = extension->pmd;
+
+        glGenBuffers(1, &extension->vertices_buffer);
+        glGenBuffers(1, &extension->indices_buffer);
+        assert(extension->vertices_buffer && extension->indices_buffer);
+
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * pmd->vertices_num, pmd->vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(pmd) * pmd->indices_num, PmdFile_getIndices(pmd, 0), GL_STATIC_DRAW);
+        assert(glGetError() == GL_NO_ERROR);
+
+        extension->instance_draws = STATICBATCH_SAMPLE_MODELS * STATICBATCH_SAMPLE_MODELS * pmd->materials_num;
+    }
+
+    // 全モデルをバッチへまとめる
+    {
+        int x = 0;
+        int z = 0;
+
+        extension->batch = StaticBatch_create();
+        for (x = 0; x < STATICBATCH_SAMPLE_MODELS; ++x) {
+            for (z = 0; z < STATICBATCH_SAMPLE_MODELS; ++z) {
+                StaticBatch_addPmd(extension->batch, extension->pmd, sample_StaticBatch_world(extension->pmd, x, z));
+            }
+        }
+        extension->batch_draws = StaticBatch_build(extension->batch, GL_STATIC_DRAW);
+        __logf("StaticBatch pages(%d) draws(%d -> %d)", extension->batch->pages_num, extension->instance_draws, extension->batch_draws);
+    }
+
+    extension->frames = 0;
+    extension->instance_time = 0;
+    extension->batch_time = 0;
+
+    // シェーダーの利用を開始する
+    glUseProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 深度テストを有効にする
+    glEnable(GL_DEPTH_TEST);
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_StaticBatch_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_StaticBatch_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_StaticBatch *extension = (Extension_StaticBatch*) app->extension;
+    PmdFile *pmd = extension->pmd;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    mat4 lp;
+
+    // 背景全体を見下ろすカメラ
+    {
+        const GLfloat radius = pmd->bounds.sphere_radius * STATICBATCH_SAMPLE_MODELS;
+        const GLfloat angle = degree2radian((GLfloat) extension->frames);
+
+        const vec3 camera_pos = vec3_create(sinf(angle) * radius, radius * 0.5f, cosf(angle) * radius); // カメラ位置
+        const vec3 camera_look = vec3_create(0, 0, 0); // カメラ注視
+        const vec3 camera_up = vec3_create(0, 1, 0); // カメラ上ベクトル
+
+        const GLfloat prj_near = 1.0f;
+        const GLfloat prj_far = radius * 4.0f;
+        const GLfloat prj_fovY = 45.0f;
+        const GLfloat prj_aspect = (GLfloat) (app->surface_width) / (GLfloat) (app->surface_height);
+
+        lp = mat4_multiply(mat4_perspective(prj_near, prj_far, prj_fovY, prj_aspect), mat4_lookAt(camera_pos, camera_look, camera_up));
+    }
+
+    glEnableVertexAttribArray(extension->attr_pos);
+    glEnableVertexAttribArray(extension->attr_uv);
+
+    const double begin = util_getTime();
+    if (extension->frames < STATICBATCH_SAMPLE_FRAMES) {
+        // モデルごと、材質ごとに描画する
+        int x = 0;
+        int z = 0;
+        int i = 0;
+
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+        glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
+        glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) sizeof(vec3));
+
+        for (x = 0; x < STATICBATCH_SAMPLE_MODELS; ++x) {
+            for (z = 0; z < STATICBATCH_SAMPLE_MODELS; ++z) {
+                const mat4 wlp = mat4_multiply(lp, sample_StaticBatch_world(pmd, x, z));
+                glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) wlp.m);
+
+                for (i = 0; i < pmd->materials_num; ++i) {
+                    const PmdDrawRange *range = &pmd->draw_ranges[i];
+                    sample_StaticBatch_bindMaterial(extension, pmd->diffuse_textures[i], &pmd->diffuse_colors[i]);
+                    glDrawElements(GL_TRIANGLES, range->indices_num, pmd->index_type, (GLvoid*) (PmdFile_getIndexSize(pmd) * range->indices_begin));
+                    assert(glGetError() == GL_NO_ERROR);
+                }
+            }
+        }
+    } else {
+        // ページごと、材質ごとに描画する
+        // 頂点は変換済みのため、行列はカメラのみとなる
+        StaticBatch *batch = extension->batch;
+        GLuint p = 0;
+        GLuint i = 0;
+
+        glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) lp.m);
+        for (p = 0; p < batch->pages_num; ++p) {
+            const StaticBatchPage *page = &batch->pages[p];
+
+            glBindBuffer(GL_ARRAY_BUFFER, page->vertices_buffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->indices_buffer);
+            glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
+            glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) sizeof(vec3));
+
+            for (i = 0; i < page->draws_num; ++i) {
+                const StaticBatchDraw *draw = &page->draws[i];
+                const StaticBatchMaterial *material = &batch->materials[draw->material];
+                sample_StaticBatch_bindMaterial(extension, material->texture, &material->diffuse_color);
+                glDrawElements(GL_TRIANGLES, draw->indices_num, GL_UNSIGNED_SHORT, (GLvoid*) (sizeof(GLushort) * draw->indices_begin));
+                assert(glGetError() == GL_NO_ERROR);
+            }
+        }
+    }
+
+    // 描画の完了までを計測する
+    glFinish();
+    if (extension->frames < STATICBATCH_SAMPLE_FRAMES) {
+        extension->instance_time += util_getTime() - begin;
+    } else {
+        extension->batch_time += util_getTime() - begin;
+    }
+
+    // 両方の方式を計測したところでチェック
+    if (++extension->frames >= STATICBATCH_SAMPLE_FRAMES * 2) {
+        char message[256] = "";
+        sprintf(message, "描画回数 %d -> %d / %.2fms -> %.2fms", //
+                extension->instance_draws, extension->batch_draws, //
+                extension->instance_time * 1000.0 / STATICBATCH_SAMPLE_FRAMES, extension->batch_time * 1000.0 / STATICBATCH_SAMPLE_FRAMES);
+        GLApplication_abortWithMessage(app, message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_StaticBatch_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
+    // サンプルアプリ用データを取り出す
+    Extension_StaticBatch *extension = (Extension_StaticBatch*) app->extension;
+
+    // シェーダーの利用を終了する
+    glUseProgram(0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // シェーダープログラムを廃棄する
+    glDeleteProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // バッファオブジェクトの解放
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &extension->vertices_buffer);
+    glDeleteBuffers(1, &extension->indices_buffer);
+    StaticBatch_free(extension->batch);
+
+    // PMDファイルを解放する
+    PmdFile_free(extension->pmd);
+    PmdFile_freeTextureList(extension->textureList);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
@@ -0,0 +1,383 @@
+#include "support.h"
+
+/**
+ * 並べるモデル数（1辺）
+ */
+#define TEXTUREATLAS_SAMPLE_MODELS  10
+
+/**
+ * 各方式で計測するフレーム数
+ */
+#define TEXTUREATLAS_SAMPLE_FRAMES  180
+
+/**
+ * アトラス1ページのサイズ
+ */
+#define TEXTUREATLAS_SAMPLE_PAGE    1024
+
+/**
+ * 描画するモデル
+ */
+typedef struct {
+    // PMDファイル
+    PmdFile *pmd;
+
+    // 頂点バッファ
+    GLuint vertices_buffer;
+
+    // インデックスバッファ
+    GLuint indices_buffer;
+
+    // 1フレームの描画回数とテクスチャの切り替え回数
+    int draws;
+    int binds;
+
+    // 描画時間の合計（秒）
+    double time;
+} Model_TextureAtlas;
+
+typedef struct {
+    // レンダリング用シェーダープログラム
+    GLuint shader_program;
+
+    // 位置情報属性
+    GLint attr_pos;
+
+    // UV座標属性
+    GLint attr_uv;
+
+    // フラグメントシェーダの描画色
+    GLint unif_color;
+
+    // Diffuseテクスチャ
+    GLint unif_tex_diffuse;
+
+    // 描画行列
+    GLint unif_wlp;
+
+    // 材質ごとのテクスチャで描画するモデル
+    Model_TextureAtlas textured;
+
+    // アトラスで描画するモデル
+    Model_TextureAtlas atlased;
+
+    // 材質ごとのテクスチャ
+    PmdTextureList *textureList;
+
+    // テクスチャアトラス
+    TextureAtlas *atlas;
+
+    // 経過フレーム数
+    int frames;
+} Extension_TextureAtlas;
+
+/**
+ * モデルのワールド行列を取得する
+ */
+static mat4 sample_TextureAtlas_world(const PmdFile *pmd, const int x, const int z) {
+    const GLfloat offset = pmd->bounds.sphere_radius * 1.5f;
+    return mat4_translate((x - TEXTUREATLAS_SAMPLE_MODELS / 2) * offset, 0, (z - TEXTUREATLAS_SAMPLE_MODELS / 2) * offset);
+}
+
+/**
+ * 描画用のバッファを用意する
+ */
+static void sample_TextureAtlas_createBuffers(Model_TextureAtlas *model) {
+    PmdFile *pmd = model->pmd;
+
+    glGenBuffers(1, &model->vertices_buffer);
+    glGenBuffers(1, &model->indices_buffer);
+    assert(model->vertices_buffer && model->indices_buffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, model->vertices_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * pmd->vertices_num, pmd->vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model->indices_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(pmd) * pmd->indices_num, PmdFile_getIndices(pmd, 0), GL_STATIC_DRAW);
+    assert(glGetError() == GL_NO_ERROR);
+
+    model->time = 0;
+}
+
+/**
+ * 材質が同じ描画情報となる場合はtrueを返す
+ */
+static bool sample_TextureAtlas_equalsMaterial(const PmdFile *pmd, const GLuint a, const GLuint b) {
+    if (pmd->diffuse_textures[a] != pmd->diffuse_textures[b]) {
+        return false;
+    }
+    // テクスチャを持つ場合は色を使わない
+    return pmd->diffuse_textures[a] || !memcmp(&pmd->diffuse_colors[a], &pmd->diffuse_colors[b], sizeof(vec4));
+}
+
+/**
+ * モデルを並べて描画する
+ * 描画範囲が連続し、描画情報が同じ材質は1回で描画する。
+ */
+static void sample_TextureAtlas_renderingModels(Extension_TextureAtlas *extension, Model_TextureAtlas *model, const mat4 *lp) {
+    const PmdFile *pmd = model->pmd;
+    GLuint bound = 0;
+    int x = 0;
+    int z = 0;
+
+    glBindBuffer(GL_ARRAY_BUFFER, model->vertices_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model->indices_buffer);
+    glVertexAttribPointer(extension->attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) 0);
+    glVertexAttribPointer(extension->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), (GLvoid*) sizeof(vec3));
+
+    model->draws = 0;
+    model->binds = 0;
+    for (x = 0; x < TEXTUREATLAS_SAMPLE_MODELS; ++x) {
+        for (z = 0; z < TEXTUREATLAS_SAMPLE_MODELS; ++z) {
+            const mat4 wlp = mat4_multiply(*lp, sample_TextureAtlas_world(pmd, x, z));
+            GLuint begin = 0;
+
+            glUniformMatrix4fv(extension->unif_wlp, 1, GL_FALSE, (GLfloat*) wlp.m);
+            while (begin < pmd->materials_num) {
+                const PmdDrawRange *range = &pmd->draw_ranges[begin];
+                const Texture *tex = pmd->diffuse_textures[begin];
+                const vec4 *diffuse = &pmd->diffuse_colors[begin];
+                GLuint indices_num = range->indices_num;
+                GLuint end = begin + 1;
+
+                while (end < pmd->materials_num && sample_TextureAtlas_equalsMaterial(pmd, begin, end) //
+                        && pmd->draw_ranges[end].indices_begin == range->indices_begin + indices_num) {
+                    indices_num += pmd->draw_ranges[end].indices_num;
+                    ++end;
+                }
+
+                if (tex) {
+                    // 同じテクスチャが続く場合は切り替えない
+                    if (tex->id != bound) {
+                        glBindTexture(GL_TEXTURE_2D, tex->id);
+                        bound = tex->id;
+                        ++model->binds;
+                    }
+                    glUniform4f(extension->unif_color, 0, 0, 0, 0);
+                } else {
+                    glUniform4f(extension->unif_color, diffuse->x, diffuse->y, diffuse->z, diffuse->w);
+                }
+
+                glDrawElements(GL_TRIANGLES, indices_num, pmd->index_type, (GLvoid*) (PmdFile_getIndexSize(pmd) * range->indices_begin));
+                assert(glGetError() == GL_NO_ERROR);
+                ++model->draws;
+                begin = end;
+            }
+        }
+    }
+}
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_TextureAtlas_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_TextureAtlas*) malloc(sizeof(Extension_TextureAtlas));
+    // サンプルアプリ用データを取り出す
+    Extension_TextureAtlas *extension = (Extension_TextureAtlas*) app->extension;
+
+    // シェーダーを用意する
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute mediump vec4 attr_pos;"
+                        "attribute mediump vec2 attr_uv;"
+
+                        // uniforms
+                        "uniform mediump mat4 unif_wlp;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = unif_wlp * attr_pos;"
+                        "   vary_uv = attr_uv;"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+
+        // uniforms
+                "uniform lowp vec4 unif_color;"
+                        "uniform sampler2D unif_tex_diffuse;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   if(unif_color.a == 0.0) {"
+                        "       gl_FragColor = texture2D(unif_tex_diffuse, vary_uv);"
+                        "   } else {"
+                        "       gl_FragColor = unif_color;"
+                        "   }"
+                        "}";
+
+        // コンパイルとリンクを行う
+        extension->shader_program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+    }
+
+    // attributeを取り出す
+    {
+        extension->attr_pos = glGetAttribLocation(extension->shader_program, "attr_pos");
+        assert(extension->attr_pos >= 0);
+
+        extension->attr_uv = glGetAttribLocation(extension->shader_program, "attr_uv");
+        assert(extension->attr_uv >= 0);
+    }
+
+    // uniform変数のlocationを取得する
+    {
+        extension->unif_wlp = glGetUniformLocation(extension->shader_program, "unif_wlp");
+        assert(extension->unif_wlp >= 0);
+
+        extension->unif_color = glGetUniformLocation(extension->shader_program, "unif_color");
+        assert(extension->unif_color >= 0);
+
+        extension->unif_tex_diffuse = glGetUniformLocation(extension->shader_program, "unif_tex_diffuse");
+        assert(extension->unif_tex_diffuse >= 0);
+    }
+
+    // 材質ごとのテクスチャで読み込む
+    {
+        extension->textured.pmd = PmdFile_load(app, "pmd-sample.pmd");
+        assert(extension->textured.pmd);
+
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->textured.pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->textured.pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
+        extension->textureList = PmdFile_createTextureList(app, extension->textured.pmd);
+        PmdFile_bindTextureList(extension->textured.pmd, extension->textureList);
+        sample_TextureAtlas_createBuffers(&extension->textured);
+    }
+
+    // アトラスで読み込む
+    // UVを書き換えるため、頂点バッファを作る前に関連付ける
+    {
+        extension->atlased.pmd = PmdFile_load(app, "pmd-sample.pmd");
+        assert(extension->atlased.pmd);
+
+        extension->atlas = TextureAtlas_create(TEXTUREATLAS_SAMPLE_PAGE, TEXTUREATLAS_SAMPLE_PAGE, 2);
+        TextureAtlas_addPmd(extension->atlas, app, extension->atlased.pmd);
+        TextureAtlas_build(extension->atlas, app);
+        const GLuint bound = TextureAtlas_bindPmd(extension->atlas, extension->atlased.pmd);
+        sample_TextureAtlas_createBuffers(&extension->atlased);
+
+        __logf("TextureAtlas images(%d) textures(%d) -> pages(%d) materials(%d)", //
+                extension->atlas->regions_num, extension->textureList->textures_num, extension->atlas->pages_num, bound);
+    }
+
+    extension->frames = 0;
+
+    // シェーダーの利用を開始する
+    glUseProgram(extension->shader_program);
+    glUniform1i(extension->unif_tex_diffuse, 0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 深度テストを有効にする
+    glEnable(GL_DEPTH_TEST);
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_TextureAtlas_resized(GLApplication *app) {
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_TextureAtlas_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_TextureAtlas *extension = (Extension_TextureAtlas*) app->extension;
+    const bool atlas = extension->frames >= TEXTUREATLAS_SAMPLE_FRAMES;
+    Model_TextureAtlas *model = atlas ? &extension->atlased : &extension->textured;
+
+    glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    mat4 lp;
+
+    // 全体を見下ろすカメラ
+    {
+        const GLfloat radius = model->pmd->bounds.sphere_radius * TEXTUREATLAS_SAMPLE_MODELS;
+        const GLfloat angle = degree2radian((GLfloat) extension->frames);
+
+        const vec3 camera_pos = vec3_create(sinf(angle) * radius, radius * 0.5f, cosf(angle) * radius); // カメラ位置
+        const vec3 camera_look = vec3_create(0, 0, 0); // カメラ注視
+        const vec3 camera_up = vec3_create(0, 1, 0); // カメラ上ベクトル
+
+        const GLfloat prj_near = 1.0f;
+        const GLfloat prj_far = radius * 4.0f;
+        const GLfloat prj_fovY = 45.0f;
+        const GLfloat prj_aspect = (GLfloat) (app->surface_width) / (GLfloat) (app->surface_height);
+
+        lp = mat4_multiply(mat4_perspective(prj_near, prj_far, prj_fovY, prj_aspect), mat4_lookAt(camera_pos, camera_look, camera_up));
+    }
+
+    glEnableVertexAttribArray(extension->attr_pos);
+    glEnableVertexAttribArray(extension->attr_uv);
+
+    const double begin = util_getTime();
+    sample_TextureAtlas_renderingModels(extension, model, &lp);
+
+    // 描画の完了までを計測する
+    glFinish();
+    model->time += util_getTime() - begin;
+
+    // 両方の方式を計測したところでチェック
+    if (++extension->frames >= TEXTUREATLAS_SAMPLE_FRAMES * 2) {
+        char message[256] = "";
+        sprintf(message, "描画回数 %d -> %d / テクスチャ切り替え %d -> %d / %.2fms -> %.2fms", //
+                extension->textured.draws, extension->atlased.draws, //
+                extension->textured.binds, extension->atlased.binds, //
+                extension->textured.time * 1000.0 / TEXTUREATLAS_SAMPLE_FRAMES, extension->atlased.time * 1000.0 / TEXTUREATLAS_SAMPLE_FRAMES);
+        GLApplication_abortWithMessage(app, message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_TextureAtlas_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
+    // サンプルアプリ用データを取り出す
+    Extension_TextureAtlas *extension = (Extension_TextureAtlas*) app->extension;
+
+    // シェーダーの利用を終了する
+    glUseProgram(0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // シェーダープログラムを廃棄する
+    glDeleteProgram(extension->shader_program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // バッファオブジェクトの解放
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &extension->textured.vertices_buffer);
+    glDeleteBuffers(1, &extension->textured.indices_buffer);
+    glDeleteBuffers(1, &extension->atlased.vertices_buffer);
+    glDeleteBuffers(1, &extension->atlased.indices_buffer);
+
+    // PMDファイルを解放する
+    PmdFile_free(extension->textured.pmd);
+    PmdFile_free(extension->atlased.pmd);
+    PmdFile_freeTextureList(extension->textureList);
+    TextureAtlas_free(extension->atlas, app);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
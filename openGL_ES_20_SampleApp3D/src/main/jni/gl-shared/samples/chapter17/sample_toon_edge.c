@@ -0,0 +1,556 @@
+#include "support.h"
+
+/**
+ * 並べるモデル数（1辺）
+ */
+#define TOONEDGE_SAMPLE_MODELS  8
+
+/**
+ * 各方式で計測するフレーム数
+ */
+#define TOONEDGE_SAMPLE_FRAMES  120
+
+/**
+ * 計測する方式の数
+ * 全メッシュを押し出し + 輪郭フラグの範囲だけ押し出し + 深度バッファからの輪郭検出
+ */
+#define TOONEDGE_SAMPLE_MODES   3
+
+/**
+ * 射影行列の設定
+ * 輪郭検出で奥行きを復元するため、描画と後処理で共有する
+ */
+#define TOONEDGE_SAMPLE_NEAR    10.0f
+#define TOONEDGE_SAMPLE_FAR     10000.0f
+
+typedef struct {
+
+    // 通常レンダリング用シェーダ
+    struct {
+        // レンダリング用シェーダープログラム
+        GLuint program;
+
+        // 位置情報属性
+        GLint attr_pos;
+
+        // UV座標属性
+        GLint attr_uv;
+
+        // フラグメントシェーダの描画色
+        GLint unif_color;
+
+        // Diffuseテクスチャ
+        GLint unif_tex_diffuse;
+
+        // 描画行列
+        GLint unif_wlp;
+
+        // 輪郭のマスク
+        GLint unif_edge_mask;
+    } main_shader;
+
+    // エッジ描画用シェーダー
+    struct {
+        // レンダリング用シェーダープログラム
+        GLuint program;
+
+        // 位置情報属性
+        GLint attr_pos;
+
+        // 法線
+        GLint attr_normal;
+
+        // 頂点ごとの押し出し倍率
+        GLint attr_edge_scale;
+
+        // エッジの描画サイズ
+        GLint unif_edgesize;
+
+        // 描画行列
+        GLint unif_wlp;
+
+        // フラグメントシェーダの描画色
+        GLint unif_color;
+    } edge_shader;
+
+    // サンプル用のPMDファイル
+    PmdFile *pmd;
+
+    // サンプルPMD用のテクスチャリスト
+    PmdTextureList *textureList;
+
+    // 輪郭を描画する三角形の一覧
+    PmdEdgeList *edges;
+
+    // 頂点バッファ
+    GLuint vertices_buffer;
+
+    // インデックスバッファ
+    GLuint indices_buffer;
+
+    // 輪郭のインデックスバッファ
+    GLuint edge_indices_buffer;
+
+    // 頂点ごとの押し出し倍率のバッファ
+    GLuint edge_scales_buffer;
+
+    // 描画パスごとの頂点属性の構成
+    VertexLayout *main_layout;
+    VertexLayout *edge_layout;
+    VertexLayout *edge_list_layout;
+
+    // 深度バッファからの輪郭検出
+    // GL_OES_depth_textureに対応していない場合はNULL
+    PmdEdgeOutline *outline;
+
+    // フィギュアの回転
+    GLfloat rotate;
+
+    // 経過フレーム数
+    int frames;
+
+    // 方式ごとの描画時間の合計（秒）
+    double times[TOONEDGE_SAMPLE_MODES];
+
+    // 方式ごとの1モデルあたりの頂点処理数（インデックス数）
+    GLuint indices[TOONEDGE_SAMPLE_MODES];
+} Extension_ToonEdge;
+
+/**
+ * アプリの初期化を行う
+ */
+void sample_ToonEdge_initialize(GLApplication *app) {
+    // サンプルアプリ用のメモリを確保する
+    app->extension = (Extension_ToonEdge*) calloc(1, sizeof(Extension_ToonEdge));
+    // サンプルアプリ用データを取り出す
+    Extension_ToonEdge *extension = (Extension_ToonEdge*) app->extension;
+
+    // メインシェーダーを用意する
+    // アルファ値へ輪郭のマスクを書き込む
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute highp vec4 attr_pos;"
+                        "attribute mediump vec2 attr_uv;"
+                        // uniforms
+                        "uniform highp mat4 unif_wlp;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = unif_wlp * attr_pos;"
+                        "   vary_uv = attr_uv;"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+        // uniforms
+                "uniform lowp vec4 unif_color;"
+                        "uniform sampler2D unif_tex_diffuse;"
+                        "uniform lowp float unif_edge_mask;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   if(unif_color.a == 0.0) {"
+                        "       gl_FragColor = vec4(texture2D(unif_tex_diffuse, vary_uv).rgb, unif_edge_mask);"
+                        "   } else {"
+                        "       gl_FragColor = vec4(unif_color.rgb, unif_edge_mask);"
+                        "   }"
+                        "}";
+
+        // コンパイルとリンクを行う
+        extension->main_shader.program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+
+        // attributeを取り出す
+        {
+            extension->main_shader.attr_pos = glGetAttribLocation(extension->main_shader.program, "attr_pos");
+            assert(extension->main_shader.attr_pos >= 0);
+
+            extension->main_shader.attr_uv = glGetAttribLocation(extension->main_shader.program, "attr_uv");
+            assert(extension->main_shader.attr_uv >= 0);
+        }
+
+        // uniform変数のlocationを取得する
+        {
+            extension->main_shader.unif_wlp = glGetUniformLocation(extension->main_shader.program, "unif_wlp");
+            assert(extension->main_shader.unif_wlp >= 0);
+
+            extension->main_shader.unif_color = glGetUniformLocation(extension->main_shader.program, "unif_color");
+            assert(extension->main_shader.unif_color >= 0);
+
+            extension->main_shader.unif_tex_diffuse = glGetUniformLocation(extension->main_shader.program, "unif_tex_diffuse");
+            assert(extension->main_shader.unif_tex_diffuse >= 0);
+
+            extension->main_shader.unif_edge_mask = glGetUniformLocation(extension->main_shader.program, "unif_edge_mask");
+            assert(extension->main_shader.unif_edge_mask >= 0);
+        }
+    }
+
+    // エッジシェーダーを用意する
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute highp vec3 attr_pos;"
+                        "attribute mediump vec3 attr_normal;"
+                        "attribute mediump float attr_edge_scale;"
+                        // uniforms
+                        "uniform mediump float unif_edgesize;"
+                        "uniform highp mat4 unif_wlp;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = unif_wlp * vec4( attr_pos + (attr_normal * unif_edgesize * attr_edge_scale), 1.0 );"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+        // uniforms
+                "uniform lowp vec4 unif_color;"
+                // main
+                        "void main() {"
+                        "   gl_FragColor = unif_color;"
+                        "}";
+
+        // コンパイルとリンクを行う
+        extension->edge_shader.program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+
+        // attributeを取り出す
+        {
+            extension->edge_shader.attr_pos = glGetAttribLocation(extension->edge_shader.program, "attr_pos");
+            assert(extension->edge_shader.attr_pos >= 0);
+
+            extension->edge_shader.attr_normal = glGetAttribLocation(extension->edge_shader.program, "attr_normal");
+            assert(extension->edge_shader.attr_normal >= 0);
+
+            extension->edge_shader.attr_edge_scale = glGetAttribLocation(extension->edge_shader.program, "attr_edge_scale");
+            assert(extension->edge_shader.attr_edge_scale >= 0);
+        }
+
+        // uniform変数のlocationを取得する
+        {
+            extension->edge_shader.unif_wlp = glGetUniformLocation(extension->edge_shader.program, "unif_wlp");
+            assert(extension->edge_shader.unif_wlp >= 0);
+
+            extension->edge_shader.unif_edgesize = glGetUniformLocation(extension->edge_shader.program, "unif_edgesize");
+            assert(extension->edge_shader.unif_edgesize >= 0);
+
+            extension->edge_shader.unif_color = glGetUniformLocation(extension->edge_shader.program, "unif_color");
+            assert(extension->edge_shader.unif_color >= 0);
+        }
+    }
+
+    {
+        // PMDを読み込む
+        extension->pmd = PmdFile_load(app, "pmd-sample.pmd");
+        assert(extension->pmd);
+
+        // 32bitインデックスを描画できない環境では実行を停止する
+        // 作成済みのGLオブジェクトはコンテキストと共に破棄される
+        if (!PmdFile_isIndexTypeSupported(extension->pmd)) {
+            GLApplication_abortWithMessage(app, "非対応の拡張機能です。\nGL_OES_element_index_uint");
+            PmdFile_free(extension->pmd);
+            free(app->extension);
+            app->extension = NULL;
+            return;
+        }
+
+        // テクスチャを読み込む
+        extension->textureList = PmdFile_createTextureList(app, extension->pmd);
+        PmdFile_bindTextureList(extension->pmd, extension->textureList);
+
+        // サンプルのPMDは輪郭フラグが設定されていないため、目と口（材質2, 3）以外へ輪郭を設定する
+        {
+            PmdFile *pmd = extension->pmd;
+            bool flagged = false;
+            int i = 0;
+
+            for (i = 0; i < pmd->materials_num; ++i) {
+                flagged = flagged || pmd->materials[i].extra.edge_flag;
+            }
+            for (i = 0; !flagged && i < pmd->materials_num; ++i) {
+                pmd->materials[i].extra.edge_flag = (i == 2 || i == 3) ? 0 : 1;
+            }
+        }
+
+        // 輪郭フラグを持つ材質の三角形だけを輪郭の描画対象とする
+        extension->edges = PmdEdgeList_create(extension->pmd);
+    }
+
+    // バッファオブジェクトを生成＆転送する
+    {
+        PmdFile *pmd = extension->pmd;
+
+        glGenBuffers(1, &extension->vertices_buffer);
+        glGenBuffers(1, &extension->indices_buffer);
+        assert(extension->vertices_buffer && extension->indices_buffer);
+
+        glBindBuffer(GL_ARRAY_BUFFER, extension->vertices_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * pmd->vertices_num, pmd->vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, extension->indices_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdFile_getIndexSize(pmd) * pmd->indices_num, PmdFile_getIndices(pmd, 0), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        assert(glGetError() == GL_NO_ERROR);
+
+        extension->edge_indices_buffer = PmdEdgeList_createIndexBuffer(extension->edges, GL_STATIC_DRAW);
+
+        // 輪郭の無効な頂点は押し出さない
+        extension->edge_scales_buffer = PmdEdge_createVertexScaleBuffer(pmd, GL_STATIC_DRAW);
+    }
+
+    // 描画パスごとの頂点属性を記述する
+    {
+        extension->main_layout = VertexLayout_create(extension->vertices_buffer, extension->indices_buffer);
+        VertexLayout_addAttribute(extension->main_layout, extension->main_shader.attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), 0);
+        VertexLayout_addAttribute(extension->main_layout, extension->main_shader.attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), sizeof(vec3));
+
+        // 全メッシュを押し出す構成と、輪郭の三角形だけを押し出す構成
+        extension->edge_layout = VertexLayout_create(extension->vertices_buffer, extension->indices_buffer);
+        extension->edge_list_layout = VertexLayout_create(extension->vertices_buffer, extension->edge_indices_buffer);
+        VertexLayout_addAttribute(extension->edge_layout, extension->edge_shader.attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), 0);
+        VertexLayout_addAttribute(extension->edge_layout, extension->edge_shader.attr_normal, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), sizeof(vec3) + sizeof(vec2));
+        VertexLayout_addAttribute(extension->edge_list_layout, extension->edge_shader.attr_pos, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), 0);
+        VertexLayout_addAttribute(extension->edge_list_layout, extension->edge_shader.attr_normal, 3, GL_FLOAT, GL_FALSE, sizeof(PmdVertex), sizeof(vec3) + sizeof(vec2));
+        VertexLayout_addBufferAttribute(extension->edge_layout, extension->edge_scales_buffer, extension->edge_shader.attr_edge_scale, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat), 0);
+        VertexLayout_addBufferAttribute(extension->edge_list_layout, extension->edge_scales_buffer, extension->edge_shader.attr_edge_scale, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat), 0);
+    }
+
+    // 1モデルあたりの頂点処理数
+    {
+        const GLuint indices_num = extension->pmd->indices_num;
+        extension->indices[0] = indices_num * 2;
+        extension->indices[1] = indices_num + extension->edges->indices_num;
+        extension->indices[2] = indices_num;
+    }
+
+    extension->outline = NULL;
+    extension->rotate = 0;
+    extension->frames = 0;
+
+    // 深度テストを有効にする
+    glEnable(GL_DEPTH_TEST);
+
+    // 片面レンダリングを有効にする
+    glEnable(GL_CULL_FACE);
+}
+
+/**
+ * レンダリングエリアが変更された
+ */
+void sample_ToonEdge_resized(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_ToonEdge *extension = (Extension_ToonEdge*) app->extension;
+
+    // 描画領域を設定する
+    glViewport(0, 0, app->surface_width, app->surface_height);
+
+    // 輪郭検出の描画先は画面と同じ解像度とする
+    PmdEdgeOutline_free(extension->outline);
+    extension->outline = PmdEdgeOutline_create(app->surface_width, app->surface_height);
+}
+
+/**
+ * PMDファイルのレンダリングを行う
+ */
+static void sample_ToonEdge_renderingPMD(Extension_ToonEdge *extension, const mat4 wlpMatrix, const int mode) {
+    PmdFile *pmd = extension->pmd;
+    const GLsizeiptr indexSize = PmdFile_getIndexSize(pmd);
+
+    // PMDのレンダリングを行う
+    {
+        int i = 0;
+
+        glUseProgram(extension->main_shader.program);
+        glCullFace(GL_BACK);
+        glUniformMatrix4fv(extension->main_shader.unif_wlp, 1, GL_FALSE, (GLfloat*) wlpMatrix.m);
+        VertexLayout_bind(extension->main_layout);
+
+        for (i = 0; i < pmd->materials_num; ++i) {
+            const PmdDrawRange *range = &pmd->draw_ranges[i];
+
+            // テクスチャを取り出す
+            Texture *tex = pmd->diffuse_textures[i];
+            if (tex) {
+                // テクスチャがロードできている
+                glBindTexture(GL_TEXTURE_2D, tex->id);
+                glUniform1i(extension->main_shader.unif_tex_diffuse, 0);
+                glUniform4f(extension->main_shader.unif_color, 0, 0, 0, 0);
+            } else {
+                // カラー情報
+                const vec4 *diffuse = &pmd->diffuse_colors[i];
+                glUniform4f(extension->main_shader.unif_color, diffuse->x, diffuse->y, diffuse->z, diffuse->w);
+            }
+
+            // 輪郭検出で参照するマスク
+            glUniform1f(extension->main_shader.unif_edge_mask, pmd->materials[i].extra.edge_flag ? 1.0f : 0.0f);
+
+            // インデックスバッファでレンダリング
+            glDrawElements(GL_TRIANGLES, range->indices_num, pmd->index_type, (GLvoid*) (indexSize * range->indices_begin));
+            assert(glGetError() == GL_NO_ERROR);
+        }
+    }
+
+    // 輪郭検出では押し出しによるエッジを描画しない
+    if (mode == 2) {
+        return;
+    }
+
+    // エッジのレンダリングを行う
+    {
+        glUseProgram(extension->edge_shader.program);
+        glCullFace(GL_FRONT);
+        glUniformMatrix4fv(extension->edge_shader.unif_wlp, 1, GL_FALSE, (GLfloat*) wlpMatrix.m);
+
+        // エッジ色情報
+        glUniform4f(extension->edge_shader.unif_color, 0.0f, 0.0f, 0.0f, 1.0f);
+        // エッジの太さを指定
+        glUniform1f(extension->edge_shader.unif_edgesize, 0.025f);
+
+        if (mode == 0) {
+            // 全メッシュを押し出す
+            VertexLayout_bind(extension->edge_layout);
+            glDrawElements(GL_TRIANGLES, pmd->indices_num, pmd->index_type, (GLvoid*) 0);
+        } else {
+            // 輪郭を持つ三角形は材質順に詰めてあるため、1回で描画できる
+            VertexLayout_bind(extension->edge_list_layout);
+            glDrawElements(GL_TRIANGLES, extension->edges->indices_num, extension->edges->index_type, (GLvoid*) 0);
+        }
+        assert(glGetError() == GL_NO_ERROR);
+    }
+}
+
+/**
+ * アプリのレンダリングを行う
+ * 毎秒60回前後呼び出される。
+ */
+void sample_ToonEdge_rendering(GLApplication *app) {
+    // サンプルアプリ用データを取り出す
+    Extension_ToonEdge *extension = (Extension_ToonEdge*) app->extension;
+    PmdFile *pmd = extension->pmd;
+
+    int mode = extension->frames / TOONEDGE_SAMPLE_FRAMES;
+
+    // 輪郭検出に対応していなければ計測しない
+    if (mode == 2 && !extension->outline) {
+        extension->frames = TOONEDGE_SAMPLE_FRAMES * TOONEDGE_SAMPLE_MODES;
+        mode = TOONEDGE_SAMPLE_MODES;
+    }
+
+    if (mode < TOONEDGE_SAMPLE_MODES) {
+        const double begin = util_getTime();
+
+        if (mode == 2) {
+            PmdEdgeOutline_begin(extension->outline);
+        }
+
+        // 輪郭のマスクとして背景のアルファ値を0とする
+        glClearColor(0.0f, 1.0f, 1.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // カメラを初期化する
+        mat4 lp;
+        {
+            const vec3 pmdMax = pmd->bounds.aabb_max;
+            const vec3 pmdMin = pmd->bounds.aabb_min;
+
+            const vec3 camera_pos = vec3_create(pmdMin.z * 10.0f, pmdMax.y * 2, pmdMin.z * 10.0f); // カメラ位置
+            const vec3 camera_look = vec3_create(0, pmdMax.y * 1.25f, 0); // カメラ注視
+            const vec3 camera_up = vec3_create(0, 1, 0); // カメラ上ベクトル
+
+            const GLfloat prj_fovY = 55.0f;
+            const GLfloat prj_aspect = (GLfloat) (app->surface_width) / (GLfloat) (app->surface_height);
+
+            lp = mat4_multiply(mat4_perspective(TOONEDGE_SAMPLE_NEAR, TOONEDGE_SAMPLE_FAR, prj_fovY, prj_aspect), mat4_lookAt(camera_pos, camera_look, camera_up));
+        }
+
+        // 大量のモデルを描画する
+        {
+            const GLfloat offset = 3.0f; // モデル同士の隙間距離
+            const mat4 rotate = mat4_rotate(vec3_create(0, 1, 0), extension->rotate);
+            int x = 0;
+            int z = 0;
+
+            for (x = 0; x < TOONEDGE_SAMPLE_MODELS; ++x) {
+                for (z = 0; z < TOONEDGE_SAMPLE_MODELS; ++z) {
+                    const mat4 world = mat4_multiply(mat4_translate(x * offset, 0, z * offset), rotate);
+                    sample_ToonEdge_renderingPMD(extension, mat4_multiply(lp, world), mode);
+                }
+            }
+        }
+
+        // 後処理は頂点属性を直接設定するため、構成のバインドを解除する
+        VertexLayout_unbind();
+
+        if (mode == 2) {
+            const vec4 edge_color = { 0.0f, 0.0f, 0.0f, 1.0f };
+            PmdEdgeOutline_end(extension->outline, TOONEDGE_SAMPLE_NEAR, TOONEDGE_SAMPLE_FAR, 0.05f, edge_color);
+        }
+
+        // 描画の完了までを計測する
+        glFinish();
+        extension->times[mode] += util_getTime() - begin;
+
+        // 回転を進める
+        extension->rotate += 1;
+        ++extension->frames;
+    } else {
+        const double frames = TOONEDGE_SAMPLE_FRAMES;
+        char message[256] = "";
+
+        __logf("edge indices(%d / %d) per model", extension->edges->indices_num, pmd->indices_num);
+        if (extension->outline) {
+            sprintf(message, "頂点処理 100%% -> %.0f%% -> %.0f%%\n%.2fms -> %.2fms -> %.2fms", //
+                    extension->indices[1] * 100.0 / extension->indices[0], extension->indices[2] * 100.0 / extension->indices[0], //
+                    extension->times[0] * 1000.0 / frames, extension->times[1] * 1000.0 / frames, extension->times[2] * 1000.0 / frames);
+        } else {
+            sprintf(message, "頂点処理 100%% -> %.0f%%\n%.2fms -> %.2fms\n深度テクスチャ非対応", //
+                    extension->indices[1] * 100.0 / extension->indices[0], //
+                    extension->times[0] * 1000.0 / frames, extension->times[1] * 1000.0 / frames);
+        }
+        GLApplication_abortWithMessage(app, message);
+    }
+
+    // バックバッファをフロントバッファへ転送する。プラットフォームごとに内部の実装が異なる。
+    ES20_postFrontBuffer(app);
+}
+
+/**
+ * アプリのデータ削除を行う
+ */
+void sample_ToonEdge_destroy(GLApplication *app) {
+    // 初期化を中断した場合は解放するものが無い
+    if (!app->extension) {
+        return;
+    }
+
+    // サンプルアプリ用データを取り出す
+    Extension_ToonEdge *extension = (Extension_ToonEdge*) app->extension;
+
+    // シェーダーの利用を終了する
+    glUseProgram(0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // シェーダープログラムを廃棄する
+    glDeleteProgram(extension->main_shader.program);
+    glDeleteProgram(extension->edge_shader.program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 頂点属性の構成とバッファオブジェクトを解放する
+    VertexLayout_free(extension->main_layout);
+    VertexLayout_free(extension->edge_layout);
+    VertexLayout_free(extension->edge_list_layout);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &extension->vertices_buffer);
+    glDeleteBuffers(1, &extension->indices_buffer);
+    glDeleteBuffers(1, &extension->edge_indices_buffer);
+    glDeleteBuffers(1, &extension->edge_scales_buffer);
+
+    PmdEdgeOutline_free(extension->outline);
+
+    // PMDファイルを解放する
+    PmdEdgeList_free(extension->edges);
+    PmdFile_free(extension->pmd);
+    PmdFile_freeTextureList(extension->textureList);
+
+    // サンプルアプリ用のメモリを解放する
+    free(app->extension);
+}
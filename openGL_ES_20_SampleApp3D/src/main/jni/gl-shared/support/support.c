@@ -1,4 +1,5 @@
 #include    "support.h"
+#include    <time.h>
 
 /**
  * ファイルのフルパス -> ファイル名に変換する
@@ -7,3 +8,40 @@ char* util_getFileName(char* __file__) {
     return strrchr(__file__, '/') + 1;
 }
 
+
+/**
+ * alignmentバイト境界に揃えたメモリを確保する。
+ * 確保した領域の直前に元のポインタを保存しておく。
+ */
+void* util_alignedAlloc(const size_t alignment, const size_t size) {
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    uint8_t *origin = malloc(size + alignment + sizeof(void*));
+    if (!origin) {
+        return NULL;
+    }
+
+    const uintptr_t head = (uintptr_t) (origin + sizeof(void*));
+    void **result = (void**) ((head + alignment - 1) & ~((uintptr_t) alignment - 1));
+    result[-1] = origin;
+    return result;
+}
+
+/**
+ * util_alignedAlloc()で確保したメモリを解放する
+ */
+void util_alignedFree(void *ptr) {
+    if (ptr) {
+        free(((void**) ptr)[-1]);
+    }
+}
+
+/**
+ * 単調増加する時刻を秒単位で取得する。
+ * 処理時間の計測に利用する。
+ */
+double util_getTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1000000000.0;
+}
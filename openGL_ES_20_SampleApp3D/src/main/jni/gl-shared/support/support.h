@@ -37,6 +37,8 @@
 
 struct GLApplication;
 
+struct MemoryArena;
+
 /**
  * アプリの初期化を行う
  */
@@ -120,6 +122,13 @@ typedef struct GLApplication {
      * XXX_destroy時に必ずfreeを行うこと。
      */
     void* extension;
+
+    /**
+     * フレーム単位の一時領域
+     * rendering呼び出しの直前に巻き戻されるため、次のフレームまで保持してはならない。
+     * 毎フレームのmalloc/freeを避けたい一時配列の確保に利用する。
+     */
+    struct MemoryArena *frame_arena;
 } GLApplication;
 
 /**
@@ -127,6 +136,24 @@ typedef struct GLApplication {
  */
 extern char* util_getFileName(char* __file__);
 
+/**
+ * alignmentバイト境界に揃えたメモリを確保する。
+ * alignmentは2のn乗でなければならない。
+ * 確保したメモリはutil_alignedFree()で解放する。
+ */
+extern void* util_alignedAlloc(const size_t alignment, const size_t size);
+
+/**
+ * util_alignedAlloc()で確保したメモリを解放する
+ */
+extern void util_alignedFree(void *ptr);
+
+/**
+ * 単調増加する時刻を秒単位で取得する。
+ * 処理時間の計測に利用する。
+ */
+extern double util_getTime(void);
+
 /**
  * ダイアログを出して実行を停止する
  */
@@ -137,6 +164,31 @@ extern void GLApplication_abortWithMessage(GLApplication *app, const char* messa
  */
 extern bool GLApplication_isAbort(GLApplication *app);
 
+/**
+ * SIMD演算サポート
+ */
+#include    "support_Simd.h"
+
+/**
+ * 三角関数・逆平方根の高速な近似
+ */
+#include    "support_FastMath.h"
+
+/**
+ * 線形アロケータ
+ */
+#include    "support_Arena.h"
+
+/**
+ * 世代番号付きハンドルの固定長プール
+ */
+#include    "support_HandlePool.h"
+
+/**
+ * スレッドサポート
+ */
+#include    "support_Thread.h"
+
 /**
  * ファイル系サポート関数
  */
@@ -0,0 +1,130 @@
+/*
+ * support_Arena.c
+ */
+
+#include    "support.h"
+
+/**
+ * ブロックを生成して先頭へ追加する
+ */
+static MemoryArenaBlock* MemoryArena_pushBlock(MemoryArena *arena, const size_t capacity) {
+    MemoryArenaBlock *block = malloc(sizeof(MemoryArenaBlock) + capacity);
+    assert(block);
+
+    block->prev = arena->block;
+    block->capacity = capacity;
+    block->used = 0;
+
+    arena->block = block;
+    arena->capacity += capacity;
+    return block;
+}
+
+/**
+ * アリーナを生成する
+ */
+MemoryArena* MemoryArena_create(const size_t block_size) {
+    MemoryArena *result = calloc(1, sizeof(MemoryArena));
+    result->block_size = block_size ? block_size : 4096;
+    MemoryArena_pushBlock(result, result->block_size);
+    return result;
+}
+
+/**
+ * MEMORYARENA_ALIGNMENT境界に揃えた領域を確保する
+ */
+void* MemoryArena_alloc(MemoryArena *arena, const size_t size) {
+    return MemoryArena_allocAligned(arena, size, MEMORYARENA_ALIGNMENT);
+}
+
+/**
+ * alignmentバイト境界に揃えた領域を確保する
+ */
+void* MemoryArena_allocAligned(MemoryArena *arena, const size_t size, const size_t alignment) {
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    MemoryArenaBlock *block = arena->block;
+
+    // 境界はブロック内の位置ではなく、実際のアドレスで揃える
+    uintptr_t head = (uintptr_t) (block->data + block->used);
+    uintptr_t aligned = (head + alignment - 1) & ~((uintptr_t) alignment - 1);
+
+    if (aligned + size > (uintptr_t) (block->data + block->capacity)) {
+        // 収まらない場合はブロックを追加する
+        // 残りの領域は次回のMemoryArena_reset()まで使わない
+        const size_t required = size + alignment;
+        block = MemoryArena_pushBlock(arena, required > arena->block_size ? required : arena->block_size);
+
+        head = (uintptr_t) block->data;
+        aligned = (head + alignment - 1) & ~((uintptr_t) alignment - 1);
+    }
+
+    const size_t consumed = (size_t) (aligned - head) + size;
+    block->used += consumed;
+    arena->used += consumed;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+
+    return (void*) aligned;
+}
+
+/**
+ * 0で初期化した領域を確保する
+ */
+void* MemoryArena_calloc(MemoryArena *arena, const size_t num, const size_t size) {
+    void *result = MemoryArena_alloc(arena, num * size);
+    memset(result, 0x00, num * size);
+    return result;
+}
+
+/**
+ * 文字列を複製する
+ */
+char* MemoryArena_strdup(MemoryArena *arena, const char *str) {
+    const size_t length = strlen(str) + 1;
+    char *result = MemoryArena_allocAligned(arena, length, 1);
+    memcpy(result, str, length);
+    return result;
+}
+
+/**
+ * 確保した全ての領域を破棄し、先頭から再利用する。
+ */
+void MemoryArena_reset(MemoryArena *arena) {
+    MemoryArenaBlock *block = arena->block;
+
+    if (block->prev) {
+        // 全ブロックの容量を持つ1ブロックへまとめ直す
+        const size_t capacity = arena->capacity;
+        while (block) {
+            MemoryArenaBlock *prev = block->prev;
+            free(block);
+            block = prev;
+        }
+
+        arena->block = NULL;
+        arena->capacity = 0;
+        block = MemoryArena_pushBlock(arena, capacity);
+    }
+
+    block->used = 0;
+    arena->used = 0;
+}
+
+/**
+ * アリーナと確保した全ての領域を解放する
+ */
+void MemoryArena_free(MemoryArena *arena) {
+    if (!arena) {
+        return;
+    }
+
+    MemoryArenaBlock *block = arena->block;
+    while (block) {
+        MemoryArenaBlock *prev = block->prev;
+        free(block);
+        block = prev;
+    }
+    free(arena);
+}
@@ -0,0 +1,117 @@
+/*
+ * support_Arena.h
+ *
+ * 線形アロケータ（アリーナ）
+ * 確保はポインタを進めるだけで行い、個別の解放は行わない。
+ * フレームごとの一時領域はMemoryArena_reset()で巻き戻し、
+ * 読み込み時の領域はMemoryArena_free()で一括して解放する。
+ * 複数スレッドから同時に確保してはならない。
+ */
+
+#ifndef SUPPORT_ARENA_H_
+#define SUPPORT_ARENA_H_
+
+#include    <stdint.h>
+
+/**
+ * 標準の確保境界
+ * SIMD演算で読み書きできるよう、SIMD4F_ALIGNMENTに揃える
+ */
+#define MEMORYARENA_ALIGNMENT   16
+
+/**
+ * アリーナの確保単位となるブロック
+ */
+typedef struct MemoryArenaBlock {
+    /**
+     * 前に確保したブロック
+     */
+    struct MemoryArenaBlock *prev;
+
+    /**
+     * dataのサイズ
+     */
+    size_t capacity;
+
+    /**
+     * dataの使用済みサイズ
+     */
+    size_t used;
+
+    /**
+     * 確保対象の領域
+     */
+    uint8_t data[];
+} MemoryArenaBlock;
+
+/**
+ * 線形アロケータ
+ */
+typedef struct MemoryArena {
+    /**
+     * 確保中のブロック
+     * 容量が足りなくなると新しいブロックを追加する。
+     * 既に返したアドレスは移動しない。
+     */
+    MemoryArenaBlock *block;
+
+    /**
+     * 新しいブロックの最小サイズ
+     */
+    size_t block_size;
+
+    /**
+     * 全ブロックの使用済みサイズ
+     */
+    size_t used;
+
+    /**
+     * 全ブロックの容量
+     */
+    size_t capacity;
+
+    /**
+     * usedの最大値
+     */
+    size_t peak;
+} MemoryArena;
+
+/**
+ * アリーナを生成する
+ * block_sizeは最初のブロックのサイズとなり、足りなくなると同じサイズ以上のブロックを追加する。
+ */
+extern MemoryArena* MemoryArena_create(const size_t block_size);
+
+/**
+ * MEMORYARENA_ALIGNMENT境界に揃えた領域を確保する
+ */
+extern void* MemoryArena_alloc(MemoryArena *arena, const size_t size);
+
+/**
+ * alignmentバイト境界に揃えた領域を確保する
+ * alignmentは2のn乗でなければならない。
+ */
+extern void* MemoryArena_allocAligned(MemoryArena *arena, const size_t size, const size_t alignment);
+
+/**
+ * 0で初期化した領域を確保する
+ */
+extern void* MemoryArena_calloc(MemoryArena *arena, const size_t num, const size_t size);
+
+/**
+ * 文字列を複製する
+ */
+extern char* MemoryArena_strdup(MemoryArena *arena, const char *str);
+
+/**
+ * 確保した全ての領域を破棄し、先頭から再利用する。
+ * 複数のブロックに分かれていた場合は1つのブロックへまとめ、次回以降の追加確保を無くす。
+ */
+extern void MemoryArena_reset(MemoryArena *arena);
+
+/**
+ * アリーナと確保した全ての領域を解放する
+ */
+extern void MemoryArena_free(MemoryArena *arena);
+
+#endif /* SUPPORT_ARENA_H_ */
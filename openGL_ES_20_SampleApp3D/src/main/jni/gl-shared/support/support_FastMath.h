@@ -0,0 +1,239 @@
+/*
+ * support_FastMath.h
+ *
+ * 単精度の三角関数と逆平方根の高速な近似
+ * libmのsin / cos / tanはdoubleで計算されるため、回転や正規化を大量に行う場合に負荷となる。
+ * 多項式近似とニュートン法で単精度に必要な精度のみを計算する。
+ *
+ * SUPPORT_MATH_PRECISEを1で定義した場合は全てlibmで計算する。
+ *
+ * 最大誤差（倍精度のlibmとの比較）
+ * fastmath_sincos / simd4f_sincos  : 絶対誤差 9.4e-8 (|x| <= 8192)
+ * fastmath_rsqrt / simd4f_rsqrt    : 相対誤差 SSE 2.6e-7 / スカラー 1.5e-7
+ * NEONの逆平方根は推定値を2回補正し、SSEと同程度の精度となる。
+ */
+
+#ifndef SUPPORT_FASTMATH_H_
+#define SUPPORT_FASTMATH_H_
+
+#ifndef SUPPORT_MATH_PRECISE
+#define SUPPORT_MATH_PRECISE    0
+#endif
+
+/**
+ * 360度系から単精度のラジアン角度に変換する
+ */
+#define degree2radianf(degree) ((float) (degree) * (float) (M_PI / 180.0))
+
+#if !SUPPORT_MATH_PRECISE
+
+/**
+ * π/2を3分割した値
+ * 上位の値は仮数部の下位ビットが0のため、整数倍しても丸め誤差が出ない。
+ */
+#define FASTMATH_PIO2_1     1.5703125f
+#define FASTMATH_PIO2_2     4.837512969970703125e-4f
+#define FASTMATH_PIO2_3     7.54978995489188216e-8f
+
+/**
+ * 2/π
+ */
+#define FASTMATH_2_PI       0.636619772367581343f
+
+/**
+ * [-π/4, π/4]でのsinの近似多項式
+ */
+#define FASTMATH_SIN_1      -1.6666654611e-1f
+#define FASTMATH_SIN_2      8.3321608736e-3f
+#define FASTMATH_SIN_3      -1.9515295891e-4f
+
+/**
+ * [-π/4, π/4]でのcosの近似多項式
+ */
+#define FASTMATH_COS_1      4.166664568298827e-2f
+#define FASTMATH_COS_2      -1.388731625493765e-3f
+#define FASTMATH_COS_3      2.443315711809948e-5f
+
+/**
+ * 加算して引き戻すことで、最近接の整数へ丸める値(1.5 * 2^23)
+ */
+#define FASTMATH_ROUND      12582912.0f
+
+#endif
+
+/**
+ * sinとcosを同時に計算する
+ * xはラジアン角度で、|x| <= 8192の範囲で精度を保証する。
+ */
+static inline void fastmath_sincos(const float x, float *s, float *c) {
+#if SUPPORT_MATH_PRECISE
+    *s = sinf(x);
+    *c = cosf(x);
+#else
+    // x = r + j * π/2 となるjを求め、rを[-π/4, π/4]へ収める
+    const float jf = x * FASTMATH_2_PI;
+    const int j = (int) (jf + (jf >= 0 ? 0.5f : -0.5f));
+    const float fj = (float) j;
+    const float r = ((x - fj * FASTMATH_PIO2_1) - fj * FASTMATH_PIO2_2) - fj * FASTMATH_PIO2_3;
+    const float z = r * r;
+
+    const float sr = r + r * z * (FASTMATH_SIN_1 + z * (FASTMATH_SIN_2 + z * FASTMATH_SIN_3));
+    const float cr = 1.0f - 0.5f * z + z * z * (FASTMATH_COS_1 + z * (FASTMATH_COS_2 + z * FASTMATH_COS_3));
+
+    // 象限に応じてsinとcosを入れ替え、符号を反転する
+    switch (j & 3) {
+    case 0:
+        *s = sr;
+        *c = cr;
+        break;
+    case 1:
+        *s = cr;
+        *c = -sr;
+        break;
+    case 2:
+        *s = -sr;
+        *c = -cr;
+        break;
+    default:
+        *s = -cr;
+        *c = sr;
+        break;
+    }
+#endif
+}
+
+/**
+ * sinを計算する
+ */
+static inline float fastmath_sin(const float x) {
+    float s;
+    float c;
+    fastmath_sincos(x, &s, &c);
+    return s;
+}
+
+/**
+ * 1 / sqrt(x)を計算する
+ * 0以下の値を渡した場合の結果は不定となる。
+ */
+static inline float fastmath_rsqrt(const float x) {
+#if SUPPORT_MATH_PRECISE
+    return 1.0f / sqrtf(x);
+#elif defined(SUPPORT_SIMD_NEON)
+    // 推定値は8bit精度のため、2回補正する
+    float32x2_t v = vdup_n_f32(x);
+    float32x2_t y = vrsqrte_f32(v);
+    y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+    y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+    return vget_lane_f32(y, 0);
+#elif defined(SUPPORT_SIMD_SSE)
+    // 推定値は12bit精度のため、1回補正する
+    const float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    return y * (1.5f - 0.5f * x * y * y);
+#else
+    // ビット表現から推定値を求め、3回補正する
+    union {
+        float f;
+        unsigned int u;
+    } bits;
+    bits.f = x;
+    bits.u = 0x5f375a86 - (bits.u >> 1);
+
+    float y = bits.f;
+    y = y * (1.5f - 0.5f * x * y * y);
+    y = y * (1.5f - 0.5f * x * y * y);
+    y = y * (1.5f - 0.5f * x * y * y);
+    return y;
+#endif
+}
+
+/**
+ * 4要素のsinとcosを同時に計算する
+ */
+static inline void simd4f_sincos(const simd4f x, simd4f *s, simd4f *c) {
+#if SUPPORT_MATH_PRECISE
+    float v[4];
+    float vs[4];
+    float vc[4];
+    simd4f_storeu(v, x);
+
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        vs[i] = sinf(v[i]);
+        vc[i] = cosf(v[i]);
+    }
+    *s = simd4f_loadu(vs);
+    *c = simd4f_loadu(vc);
+#else
+    const simd4f round = simd4f_splat(FASTMATH_ROUND);
+    const simd4f zero = simd4f_splat(0);
+    const simd4f one = simd4f_splat(1.0f);
+
+    // 整数への変換を使わず、浮動小数のまま象限を求める
+    const simd4f j = simd4f_sub(simd4f_add(simd4f_mul(x, simd4f_splat(FASTMATH_2_PI)), round), round);
+
+    simd4f r = simd4f_sub(x, simd4f_mul(j, simd4f_splat(FASTMATH_PIO2_1)));
+    r = simd4f_sub(r, simd4f_mul(j, simd4f_splat(FASTMATH_PIO2_2)));
+    r = simd4f_sub(r, simd4f_mul(j, simd4f_splat(FASTMATH_PIO2_3)));
+    const simd4f z = simd4f_mul(r, r);
+
+    simd4f sp = simd4f_madd(z, simd4f_splat(FASTMATH_SIN_3), simd4f_splat(FASTMATH_SIN_2));
+    sp = simd4f_madd(z, sp, simd4f_splat(FASTMATH_SIN_1));
+    const simd4f sr = simd4f_madd(simd4f_mul(r, z), sp, r);
+
+    simd4f cp = simd4f_madd(z, simd4f_splat(FASTMATH_COS_3), simd4f_splat(FASTMATH_COS_2));
+    cp = simd4f_madd(z, cp, simd4f_splat(FASTMATH_COS_1));
+    const simd4f cr = simd4f_madd(simd4f_mul(z, z), cp, simd4f_sub(one, simd4f_mul(z, simd4f_splat(0.5f))));
+
+    // j mod 4を[-2, 2]の値として求める
+    const simd4f quarter = simd4f_mul(j, simd4f_splat(0.25f));
+    const simd4f quadrant = simd4f_mul(simd4f_sub(quarter, simd4f_sub(simd4f_add(quarter, round), round)), simd4f_splat(4.0f));
+
+    // 奇数の象限ではsinとcosを入れ替える
+    const simd4f half = simd4f_mul(j, simd4f_splat(0.5f));
+    const simd4f halfFraction = simd4f_sub(half, simd4f_sub(simd4f_add(half, round), round));
+    const simd4f odd = simd4f_cmpge(simd4f_max(halfFraction, simd4f_sub(zero, halfFraction)), simd4f_splat(0.25f));
+    const simd4f vs = simd4f_select(odd, cr, sr);
+    const simd4f vc = simd4f_select(odd, sr, cr);
+
+    // sinは象限2, 3、cosは象限1, 2で符号を反転する
+    const simd4f sinPositive = simd4f_select(simd4f_cmpge(quadrant, simd4f_splat(1.5f)), zero, simd4f_cmpge(quadrant, simd4f_splat(-0.5f)));
+    const simd4f cosPositive = simd4f_select(simd4f_cmpge(quadrant, simd4f_splat(0.5f)), zero, simd4f_cmpge(quadrant, simd4f_splat(-1.5f)));
+    *s = simd4f_select(sinPositive, vs, simd4f_sub(zero, vs));
+    *c = simd4f_select(cosPositive, vc, simd4f_sub(zero, vc));
+#endif
+}
+
+/**
+ * 4要素の1 / sqrt(x)を計算する
+ */
+static inline simd4f simd4f_rsqrt(const simd4f x) {
+#if SUPPORT_MATH_PRECISE
+    float v[4];
+    simd4f_storeu(v, x);
+
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        v[i] = 1.0f / sqrtf(v[i]);
+    }
+    return simd4f_loadu(v);
+#elif defined(SUPPORT_SIMD_NEON)
+    float32x4_t y = vrsqrteq_f32(x);
+    y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+    y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+    return y;
+#elif defined(SUPPORT_SIMD_SSE)
+    const __m128 y = _mm_rsqrt_ps(x);
+    const __m128 xyy = _mm_mul_ps(_mm_mul_ps(x, y), y);
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_set1_ps(0.5f), xyy)));
+#else
+    simd4f result;
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        result.v[i] = fastmath_rsqrt(x.v[i]);
+    }
+    return result;
+#endif
+}
+
+#endif /* SUPPORT_FASTMATH_H_ */
@@ -0,0 +1,171 @@
+/*
+ * support_HandlePool.c
+ */
+
+#include    "support.h"
+
+/**
+ * 要素番号と世代番号からハンドルを生成する
+ */
+static Handle HandlePool_makeHandle(const uint32_t index, const uint16_t generation) {
+    return ((Handle) generation << 16) | (Handle) index;
+}
+
+/**
+ * ハンドルが生存中の要素を指していれば要素番号を返す
+ * 無効なハンドルの場合は-1を返す。
+ */
+static int32_t HandlePool_resolve(const HandlePool *pool, const Handle handle) {
+    const uint32_t index = handle & 0xFFFF;
+    const uint16_t generation = (uint16_t) (handle >> 16);
+
+    // 世代番号が奇数でなければ生存中の要素を指していない
+    if (!(generation & 0x01) || index >= pool->capacity || pool->generations[index] != generation) {
+        return -1;
+    }
+    return (int32_t) index;
+}
+
+/**
+ * プールを生成する
+ */
+HandlePool* HandlePool_create(const uint32_t element_size, const uint32_t capacity) {
+    assert(element_size > 0);
+    assert(capacity > 0 && capacity <= HANDLEPOOL_MAX_CAPACITY);
+
+    HandlePool *result = calloc(1, sizeof(HandlePool));
+    result->element_size = element_size;
+    result->capacity = capacity;
+    result->items = util_alignedAlloc(16, (size_t) element_size * capacity);
+    result->generations = calloc(capacity, sizeof(uint16_t));
+    result->next_free = malloc(sizeof(uint16_t) * capacity);
+
+    // 先頭から順に確保されるよう、空きリストを昇順に繋ぐ
+    uint32_t i = 0;
+    for (i = 0; i < capacity; ++i) {
+        result->next_free[i] = (uint16_t) (i + 1 < capacity ? i + 1 : HANDLEPOOL_MAX_CAPACITY);
+    }
+    result->free_head = 0;
+    return result;
+}
+
+/**
+ * 要素を確保し、0で初期化して返す。
+ */
+void* HandlePool_alloc(HandlePool *pool, Handle *handle) {
+    if (pool->free_head == HANDLEPOOL_MAX_CAPACITY) {
+        *handle = HANDLE_NULL;
+        return NULL;
+    }
+
+    const uint32_t index = pool->free_head;
+    pool->free_head = pool->next_free[index];
+
+    // 偶数 -> 奇数へ進め、生存中にする
+    const uint16_t generation = ++pool->generations[index];
+    assert(generation & 0x01);
+    ++pool->alive_num;
+
+    void *result = pool->items + (size_t) pool->element_size * index;
+    memset(result, 0x00, pool->element_size);
+
+    *handle = HandlePool_makeHandle(index, generation);
+    return result;
+}
+
+/**
+ * ハンドルが指す要素を取得する
+ */
+void* HandlePool_get(const HandlePool *pool, const Handle handle) {
+    const int32_t index = HandlePool_resolve(pool, handle);
+    if (index < 0) {
+        return NULL;
+    }
+    return pool->items + (size_t) pool->element_size * index;
+}
+
+/**
+ * ハンドルが生存中の要素を指していればtrueを返す
+ */
+bool HandlePool_isValid(const HandlePool *pool, const Handle handle) {
+    return HandlePool_resolve(pool, handle) >= 0;
+}
+
+/**
+ * アドレスがプールの要素を指していればtrueを返す
+ */
+bool HandlePool_contains(const HandlePool *pool, const void *item) {
+    const uint8_t *p = (const uint8_t*) item;
+    return p >= pool->items && p < pool->items + (size_t) pool->element_size * pool->capacity;
+}
+
+/**
+ * 要素のアドレスからハンドルを取得する
+ */
+Handle HandlePool_getHandle(const HandlePool *pool, const void *item) {
+    const uint8_t *p = (const uint8_t*) item;
+    if (!HandlePool_contains(pool, item)) {
+        return HANDLE_NULL;
+    }
+
+    const size_t offset = (size_t) (p - pool->items);
+    assert((offset % pool->element_size) == 0);
+
+    const uint32_t index = (uint32_t) (offset / pool->element_size);
+    const uint16_t generation = pool->generations[index];
+    if (!(generation & 0x01)) {
+        return HANDLE_NULL;
+    }
+    return HandlePool_makeHandle(index, generation);
+}
+
+/**
+ * 要素を解放する。
+ */
+bool HandlePool_release(HandlePool *pool, const Handle handle) {
+    const int32_t index = HandlePool_resolve(pool, handle);
+    if (index < 0) {
+        return false;
+    }
+
+    // 奇数 -> 偶数へ進め、以後このハンドルは無効になる
+    ++pool->generations[index];
+    pool->next_free[index] = pool->free_head;
+    pool->free_head = (uint16_t) index;
+    --pool->alive_num;
+    return true;
+}
+
+/**
+ * 生存中の要素を要素番号順に列挙する。
+ */
+void* HandlePool_next(const HandlePool *pool, uint32_t *cursor, Handle *handle) {
+    uint32_t index = *cursor;
+    for (; index < pool->capacity; ++index) {
+        const uint16_t generation = pool->generations[index];
+        if (generation & 0x01) {
+            *cursor = index + 1;
+            if (handle) {
+                *handle = HandlePool_makeHandle(index, generation);
+            }
+            return pool->items + (size_t) pool->element_size * index;
+        }
+    }
+
+    *cursor = pool->capacity;
+    return NULL;
+}
+
+/**
+ * プールを解放する
+ */
+void HandlePool_free(HandlePool *pool) {
+    if (!pool) {
+        return;
+    }
+
+    util_alignedFree(pool->items);
+    free(pool->generations);
+    free(pool->next_free);
+    free(pool);
+}
@@ -0,0 +1,130 @@
+/*
+ * support_HandlePool.h
+ *
+ * 世代番号付きハンドルで要素を参照する固定長プール
+ * 要素は生成時に決めた容量の連続領域へ格納され、確保・解放は空きリストによりO(1)で行う。
+ * ハンドルは要素番号と世代番号を32bitへ詰めたもので、解放済みの要素を指すハンドルは無効として検出できる。
+ * 複数スレッドから同時に操作してはならない。
+ */
+
+#ifndef SUPPORT_HANDLEPOOL_H_
+#define SUPPORT_HANDLEPOOL_H_
+
+#include    <stdint.h>
+
+/**
+ * 要素を参照するハンドル
+ * 下位16bitが要素番号、上位16bitが世代番号となる。
+ */
+typedef uint32_t Handle;
+
+/**
+ * どの要素も指さないハンドル
+ * 生存中の要素の世代番号は必ず奇数になるため、0が発行されることはない
+ */
+#define HANDLE_NULL     0
+
+/**
+ * プールに格納できる最大要素数
+ */
+#define HANDLEPOOL_MAX_CAPACITY 0xFFFF
+
+/**
+ * 固定長プール
+ */
+typedef struct HandlePool {
+    /**
+     * 要素本体
+     * element_size * capacityバイトの連続領域で、再確保されないため要素のアドレスは変化しない。
+     */
+    uint8_t *items;
+
+    /**
+     * 要素ごとの世代番号
+     * 確保と解放のたびに1進め、奇数であれば生存中となる。
+     */
+    uint16_t *generations;
+
+    /**
+     * 空き要素の連結リスト
+     */
+    uint16_t *next_free;
+
+    /**
+     * 次に確保する空き要素番号
+     * 空きが無い場合はHANDLEPOOL_MAX_CAPACITY
+     */
+    uint16_t free_head;
+
+    /**
+     * 1要素のバイト数
+     */
+    uint32_t element_size;
+
+    /**
+     * 格納できる要素数
+     */
+    uint32_t capacity;
+
+    /**
+     * 生存中の要素数
+     */
+    uint32_t alive_num;
+} HandlePool;
+
+/**
+ * プールを生成する
+ * capacityはHANDLEPOOL_MAX_CAPACITY以下でなければならない。
+ */
+extern HandlePool* HandlePool_create(const uint32_t element_size, const uint32_t capacity);
+
+/**
+ * 要素を確保し、0で初期化して返す。
+ * handleには確保した要素のハンドルが格納される。
+ * 空きが無い場合はNULLを返し、handleにはHANDLE_NULLが格納される。
+ */
+extern void* HandlePool_alloc(HandlePool *pool, Handle *handle);
+
+/**
+ * ハンドルが指す要素を取得する
+ * 解放済みの要素を指している場合はNULLを返す。
+ */
+extern void* HandlePool_get(const HandlePool *pool, const Handle handle);
+
+/**
+ * ハンドルが生存中の要素を指していればtrueを返す
+ */
+extern bool HandlePool_isValid(const HandlePool *pool, const Handle handle);
+
+/**
+ * 要素のアドレスからハンドルを取得する
+ * プール外のアドレスや解放済みの要素を指定した場合はHANDLE_NULLを返す。
+ */
+extern Handle HandlePool_getHandle(const HandlePool *pool, const void *item);
+
+/**
+ * アドレスがプールの要素を指していればtrueを返す
+ * 解放済みの要素であってもtrueとなる。
+ */
+extern bool HandlePool_contains(const HandlePool *pool, const void *item);
+
+/**
+ * 要素を解放する。
+ * 既に解放されていた場合は何もせずfalseを返す。
+ */
+extern bool HandlePool_release(HandlePool *pool, const Handle handle);
+
+/**
+ * 生存中の要素を要素番号順に列挙する。
+ * cursorは0で初期化して呼び出し、NULLが返るまで繰り返す。
+ * handleがNULLでなければ、返した要素のハンドルが格納される。
+ */
+extern void* HandlePool_next(const HandlePool *pool, uint32_t *cursor, Handle *handle);
+
+/**
+ * プールを解放する
+ * 生存中の要素が持つ資源は事前に解放しておくこと。
+ */
+extern void HandlePool_free(HandlePool *pool);
+
+#endif /* SUPPORT_HANDLEPOOL_H_ */
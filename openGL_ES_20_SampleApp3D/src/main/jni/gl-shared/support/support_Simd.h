@@ -0,0 +1,287 @@
+/*
+ * support_Simd.h
+ *
+ * 4要素floatのSIMD演算を抽象化する
+ * ARMではNEON、x86ではSSEを利用し、どちらも使えない環境ではスカラー演算で同じ結果を返す。
+ * simd4f_load / simd4f_storeは16byte境界に揃ったアドレスを渡す必要がある。
+ */
+
+#ifndef SUPPORT_SIMD_H_
+#define SUPPORT_SIMD_H_
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include    <arm_neon.h>
+#define SUPPORT_SIMD_NEON   1
+#elif defined(__SSE__) || defined(_M_X64)
+#include    <xmmintrin.h>
+#define SUPPORT_SIMD_SSE    1
+#endif
+
+/**
+ * SIMD演算のアライメント
+ */
+#define SIMD4F_ALIGNMENT    16
+
+#if defined(SUPPORT_SIMD_NEON)
+typedef float32x4_t simd4f;
+#elif defined(SUPPORT_SIMD_SSE)
+typedef __m128 simd4f;
+#else
+typedef struct simd4f {
+    float v[4];
+} simd4f;
+#endif
+
+/**
+ * 16byte境界に揃ったアドレスから読み込む
+ */
+static inline simd4f simd4f_load(const float *p) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vld1q_f32(p);
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_load_ps(p);
+#else
+    simd4f result = { { p[0], p[1], p[2], p[3] } };
+    return result;
+#endif
+}
+
+/**
+ * 任意のアドレスから読み込む
+ */
+static inline simd4f simd4f_loadu(const float *p) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vld1q_f32(p);
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_loadu_ps(p);
+#else
+    return simd4f_load(p);
+#endif
+}
+
+/**
+ * 16byte境界に揃ったアドレスへ書き込む
+ */
+static inline void simd4f_store(float *p, const simd4f a) {
+#if defined(SUPPORT_SIMD_NEON)
+    vst1q_f32(p, a);
+#elif defined(SUPPORT_SIMD_SSE)
+    _mm_store_ps(p, a);
+#else
+    p[0] = a.v[0];
+    p[1] = a.v[1];
+    p[2] = a.v[2];
+    p[3] = a.v[3];
+#endif
+}
+
+/**
+ * 任意のアドレスへ書き込む
+ */
+static inline void simd4f_storeu(float *p, const simd4f a) {
+#if defined(SUPPORT_SIMD_NEON)
+    vst1q_f32(p, a);
+#elif defined(SUPPORT_SIMD_SSE)
+    _mm_storeu_ps(p, a);
+#else
+    simd4f_store(p, a);
+#endif
+}
+
+/**
+ * 全要素に同じ値を設定する
+ */
+static inline simd4f simd4f_splat(const float value) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vdupq_n_f32(value);
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_set1_ps(value);
+#else
+    simd4f result = { { value, value, value, value } };
+    return result;
+#endif
+}
+
+/**
+ * 要素ごとの最小値
+ */
+static inline simd4f simd4f_min(const simd4f a, const simd4f b) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vminq_f32(a, b);
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_min_ps(a, b);
+#else
+    simd4f result;
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        result.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+    }
+    return result;
+#endif
+}
+
+/**
+ * 要素ごとの最大値
+ */
+static inline simd4f simd4f_max(const simd4f a, const simd4f b) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vmaxq_f32(a, b);
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_max_ps(a, b);
+#else
+    simd4f result;
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        result.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+    }
+    return result;
+#endif
+}
+
+/**
+ * 要素ごとの加算
+ */
+static inline simd4f simd4f_add(const simd4f a, const simd4f b) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vaddq_f32(a, b);
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_add_ps(a, b);
+#else
+    simd4f result;
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        result.v[i] = a.v[i] + b.v[i];
+    }
+    return result;
+#endif
+}
+
+/**
+ * 要素ごとの減算
+ */
+static inline simd4f simd4f_sub(const simd4f a, const simd4f b) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vsubq_f32(a, b);
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_sub_ps(a, b);
+#else
+    simd4f result;
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        result.v[i] = a.v[i] - b.v[i];
+    }
+    return result;
+#endif
+}
+
+/**
+ * 要素ごとの乗算
+ */
+static inline simd4f simd4f_mul(const simd4f a, const simd4f b) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vmulq_f32(a, b);
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_mul_ps(a, b);
+#else
+    simd4f result;
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        result.v[i] = a.v[i] * b.v[i];
+    }
+    return result;
+#endif
+}
+
+/**
+ * a * b + cを計算する
+ */
+static inline simd4f simd4f_madd(const simd4f a, const simd4f b, const simd4f c) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vmlaq_f32(c, a, b);
+#else
+    return simd4f_add(simd4f_mul(a, b), c);
+#endif
+}
+
+/**
+ * 要素を個別に設定する
+ */
+static inline simd4f simd4f_set(const float x, const float y, const float z, const float w) {
+#if defined(SUPPORT_SIMD_SSE)
+    return _mm_setr_ps(x, y, z, w);
+#else
+    const float v[4] = { x, y, z, w };
+    return simd4f_loadu(v);
+#endif
+}
+
+/**
+ * 要素ごとにa >= bを判定する
+ * 真の要素は全ビットが1、偽の要素は0となる
+ */
+static inline simd4f simd4f_cmpge(const simd4f a, const simd4f b) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vreinterpretq_f32_u32(vcgeq_f32(a, b));
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_cmpge_ps(a, b);
+#else
+    simd4f result;
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        union {
+            float f;
+            unsigned int u;
+        } mask;
+        mask.u = a.v[i] >= b.v[i] ? 0xFFFFFFFF : 0;
+        result.v[i] = mask.f;
+    }
+    return result;
+#endif
+}
+
+/**
+ * maskの真の要素はa、偽の要素はbを選択する
+ */
+static inline simd4f simd4f_select(const simd4f mask, const simd4f a, const simd4f b) {
+#if defined(SUPPORT_SIMD_NEON)
+    return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+#elif defined(SUPPORT_SIMD_SSE)
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#else
+    simd4f result;
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        union {
+            float f;
+            unsigned int u;
+        } m;
+        m.f = mask.v[i];
+        result.v[i] = m.u ? a.v[i] : b.v[i];
+    }
+    return result;
+#endif
+}
+
+/**
+ * 全要素の最小値を取得する
+ */
+static inline float simd4f_hmin(const simd4f a) {
+    float v[4];
+    simd4f_storeu(v, a);
+    const float m0 = v[0] < v[1] ? v[0] : v[1];
+    const float m1 = v[2] < v[3] ? v[2] : v[3];
+    return m0 < m1 ? m0 : m1;
+}
+
+/**
+ * 全要素の最大値を取得する
+ */
+static inline float simd4f_hmax(const simd4f a) {
+    float v[4];
+    simd4f_storeu(v, a);
+    const float m0 = v[0] > v[1] ? v[0] : v[1];
+    const float m1 = v[2] > v[3] ? v[2] : v[3];
+    return m0 > m1 ? m0 : m1;
+}
+
+#endif /* SUPPORT_SIMD_H_ */
@@ -0,0 +1,142 @@
+/*
+ * support_Thread.c
+ */
+
+#include    "support.h"
+#include    <unistd.h>
+
+/**
+ * チャンクを取り出して処理する
+ * 呼び出し元スレッドとワーカースレッドの両方から呼び出される
+ */
+static void ThreadPool_runChunks(ThreadPool *pool) {
+    unsigned int chunk = 0;
+    while ((chunk = __sync_fetch_and_add(&pool->next_chunk, 1)) < pool->chunks_num) {
+        const unsigned int begin = chunk * pool->chunk;
+        const unsigned int end = begin + pool->chunk < pool->count ? begin + pool->chunk : pool->count;
+        pool->task(pool->userdata, begin, end);
+    }
+}
+
+/**
+ * ワーカースレッドのメイン処理
+ */
+static void* ThreadPool_worker(void *arg) {
+    ThreadPool *pool = (ThreadPool*) arg;
+    unsigned int generation = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (true) {
+        // 新しい処理が依頼されるまで待つ
+        while (pool->generation == generation && !pool->quit) {
+            pthread_cond_wait(&pool->start_cond, &pool->mutex);
+        }
+        if (pool->quit) {
+            break;
+        }
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        ThreadPool_runChunks(pool);
+
+        // 全ワーカーが抜けたことを通知する
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->busy_num == 0) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+/**
+ * スレッドプールを生成する
+ */
+ThreadPool* ThreadPool_create(int threads_num) {
+    if (threads_num <= 0) {
+        const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads_num = cores > 1 ? (int) cores - 1 : 0;
+    }
+
+    ThreadPool *result = calloc(1, sizeof(ThreadPool));
+    pthread_mutex_init(&result->mutex, NULL);
+    pthread_cond_init(&result->start_cond, NULL);
+    pthread_cond_init(&result->done_cond, NULL);
+
+    result->threads = calloc(threads_num ? threads_num : 1, sizeof(pthread_t));
+    int i = 0;
+    for (i = 0; i < threads_num; ++i) {
+        if (pthread_create(&result->threads[i], NULL, ThreadPool_worker, result)) {
+            __logf("ThreadPool create fail(%d)", i);
+            break;
+        }
+    }
+    result->threads_num = i;
+
+    __logf("ThreadPool workers(%d)", result->threads_num);
+    return result;
+}
+
+/**
+ * [0, count)をchunk個ずつに分割し、並列で処理する。
+ */
+void ThreadPool_parallelFor(ThreadPool *pool, const unsigned int count, const unsigned int chunk, ThreadPool_task task, void *userdata) {
+    assert(chunk > 0);
+    if (!count) {
+        return;
+    }
+
+    const unsigned int chunks_num = (count + chunk - 1) / chunk;
+    if (!pool || !pool->threads_num || chunks_num <= 1) {
+        // 分割する必要が無い
+        task(userdata, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->task = task;
+    pool->userdata = userdata;
+    pool->count = count;
+    pool->chunk = chunk;
+    pool->chunks_num = chunks_num;
+    pool->next_chunk = 0;
+    pool->busy_num = pool->threads_num;
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    // 呼び出し元スレッドも処理に参加する
+    ThreadPool_runChunks(pool);
+
+    // ワーカーが全て処理を抜けるまで待つ
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busy_num) {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/**
+ * スレッドプールを解放する
+ */
+void ThreadPool_free(ThreadPool *pool) {
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    int i = 0;
+    for (i = 0; i < pool->threads_num; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->start_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    free(pool);
+}
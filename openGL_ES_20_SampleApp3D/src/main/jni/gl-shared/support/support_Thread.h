@@ -0,0 +1,96 @@
+/*
+ * support_Thread.h
+ *
+ * 配列処理を複数スレッドへ分割するためのスレッドプール
+ * ワーカースレッドは生成時に起動し、毎フレームの処理でスレッドを生成しないようにする。
+ */
+
+#ifndef SUPPORT_THREAD_H_
+#define SUPPORT_THREAD_H_
+
+#include    <pthread.h>
+
+/**
+ * 分割された範囲[begin, end)を処理する
+ */
+typedef void (*ThreadPool_task)(void *userdata, const unsigned int begin, const unsigned int end);
+
+/**
+ * スレッドプール
+ */
+typedef struct ThreadPool {
+    /**
+     * ワーカースレッド
+     */
+    pthread_t *threads;
+
+    /**
+     * ワーカースレッド数
+     * 呼び出し元スレッドも処理に参加するため、並列数はthreads_num + 1となる
+     */
+    int threads_num;
+
+    /**
+     * 状態の排他制御
+     */
+    pthread_mutex_t mutex;
+
+    /**
+     * 処理開始の通知
+     */
+    pthread_cond_t start_cond;
+
+    /**
+     * 処理完了の通知
+     */
+    pthread_cond_t done_cond;
+
+    /**
+     * 処理を依頼するたびに加算される
+     */
+    unsigned int generation;
+
+    /**
+     * 処理中のワーカースレッド数
+     */
+    int busy_num;
+
+    /**
+     * 終了要求
+     */
+    bool quit;
+
+    /**
+     * 処理内容
+     */
+    ThreadPool_task task;
+    void *userdata;
+    unsigned int count;
+    unsigned int chunk;
+    unsigned int chunks_num;
+
+    /**
+     * 次に処理するチャンク番号
+     */
+    volatile unsigned int next_chunk;
+} ThreadPool;
+
+/**
+ * スレッドプールを生成する
+ * threads_numが0以下の場合はCPUコア数 - 1のワーカーを生成する。
+ */
+extern ThreadPool* ThreadPool_create(int threads_num);
+
+/**
+ * [0, count)をchunk個ずつに分割し、並列で処理する。
+ * 全ての処理が完了するまで戻らない。
+ * 分割数が1以下の場合は呼び出し元スレッドで直接処理する。
+ */
+extern void ThreadPool_parallelFor(ThreadPool *pool, const unsigned int count, const unsigned int chunk, ThreadPool_task task, void *userdata);
+
+/**
+ * スレッドプールを解放する
+ */
+extern void ThreadPool_free(ThreadPool *pool);
+
+#endif /* SUPPORT_THREAD_H_ */
@@ -64,8 +64,28 @@ extern void ES20_sjis2utf8(GLchar *str, const int array_length);
 #include    "support_gl_Texture.h"
 #include    "support_gl_CompressedTexture.h"
 #include    "support_gl_Vector.h"
+#include    "support_gl_StreamBuffer.h"
 #include    "support_gl_Sprite.h"
+#include    "support_gl_SpriteBatch.h"
 #include    "support_gl_Shader.h"
 #include    "support_gl_Pmd.h"
+#include    "support_gl_PmdBounds.h"
+#include    "support_gl_Pmx.h"
+#include    "support_gl_PmdMorph.h"
+#include    "support_gl_PmdOptimize.h"
+#include    "support_gl_PmdCompact.h"
+#include    "support_gl_PmdDrawMesh.h"
+#include    "support_gl_PmdLod.h"
+#include    "support_gl_Frustum.h"
+#include    "support_gl_Bvh.h"
+#include    "support_gl_Occlusion.h"
+#include    "support_gl_PmdMeshlet.h"
+#include    "support_gl_StaticBatch.h"
+#include    "support_gl_TextureAtlas.h"
+#include    "support_gl_Transform.h"
+#include    "support_gl_SceneGraph.h"
+#include    "support_gl_Resource.h"
+#include    "support_gl_VertexLayout.h"
+#include    "support_gl_PmdEdge.h"
 
 #endif
@@ -0,0 +1,570 @@
+/*
+ * support_gl_Bvh.c
+ */
+
+#include    "support.h"
+#include    <float.h>
+
+/**
+ * SAHで評価する分割候補数
+ */
+#define BVH_SAH_BINS        12
+
+/**
+ * この深さを超えた場合は中央値で分割し、木の深さを抑える
+ */
+#define BVH_SAH_DEPTH_MAX   32
+
+/**
+ * 走査用スタックの大きさ
+ */
+#define BVH_STACK_MAX       64
+
+/**
+ * 構築中の作業情報
+ */
+typedef struct BvhBuilder {
+    Bvh *bvh;
+
+    /**
+     * インスタンスの中心位置
+     */
+    vec3 *centers;
+} BvhBuilder;
+
+/**
+ * AABBの表面積の半分を求める
+ */
+static GLfloat Bvh_halfArea(const vec3 *aabb_min, const vec3 *aabb_max) {
+    const GLfloat x = aabb_max->x - aabb_min->x;
+    const GLfloat y = aabb_max->y - aabb_min->y;
+    const GLfloat z = aabb_max->z - aabb_min->z;
+    return x * y + y * z + z * x;
+}
+
+/**
+ * AABBを広げる
+ */
+static void Bvh_expand(vec3 *aabb_min, vec3 *aabb_max, const vec3 *min, const vec3 *max) {
+    aabb_min->x = fminf(aabb_min->x, min->x);
+    aabb_min->y = fminf(aabb_min->y, min->y);
+    aabb_min->z = fminf(aabb_min->z, min->z);
+    aabb_max->x = fmaxf(aabb_max->x, max->x);
+    aabb_max->y = fmaxf(aabb_max->y, max->y);
+    aabb_max->z = fmaxf(aabb_max->z, max->z);
+}
+
+/**
+ * ベクトルの要素を番号で取り出す
+ */
+static GLfloat Bvh_axis(const vec3 *v, const int axis) {
+    return axis == 0 ? v->x : (axis == 1 ? v->y : v->z);
+}
+
+/**
+ * 葉ノードの境界をインスタンスから計算する
+ */
+static void Bvh_fitLeaf(Bvh *bvh, BvhNode *node) {
+    node->aabb_min = vec3_create(FLT_MAX, FLT_MAX, FLT_MAX);
+    node->aabb_max = vec3_create(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    GLuint i = 0;
+    for (i = 0; i < node->count; ++i) {
+        const GLuint item = bvh->items[node->first + i];
+        Bvh_expand(&node->aabb_min, &node->aabb_max, &bvh->item_min[item], &bvh->item_max[item]);
+    }
+}
+
+/**
+ * 内部ノードの境界を子から計算する
+ */
+static void Bvh_fitInner(Bvh *bvh, const GLuint index) {
+    BvhNode *node = &bvh->nodes[index];
+    const BvhNode *left = &bvh->nodes[index + 1];
+    const BvhNode *right = &bvh->nodes[node->first];
+
+    node->aabb_min = left->aabb_min;
+    node->aabb_max = left->aabb_max;
+    Bvh_expand(&node->aabb_min, &node->aabb_max, &right->aabb_min, &right->aabb_max);
+}
+
+/**
+ * items[begin, end)を軸の中央値で二分し、分割位置を返す
+ */
+static GLuint Bvh_partitionMedian(BvhBuilder *builder, GLuint begin, GLuint end, const int axis) {
+    GLuint *items = builder->bvh->items;
+    const GLuint middle = begin + (end - begin) / 2;
+
+    // middle番目の要素が確定するまで範囲を絞り込む
+    while (end - begin > 1) {
+        // 基準値未満 / 基準値と同じ / 基準値超過の3つに分ける
+        const GLfloat pivot = Bvh_axis(&builder->centers[items[begin + (end - begin) / 2]], axis);
+        GLuint less = begin;
+        GLuint greater = end;
+        GLuint i = begin;
+        while (i < greater) {
+            const GLfloat value = Bvh_axis(&builder->centers[items[i]], axis);
+            const GLuint temp = items[i];
+            if (value < pivot) {
+                items[i++] = items[less];
+                items[less++] = temp;
+            } else if (value > pivot) {
+                items[i] = items[--greater];
+                items[greater] = temp;
+            } else {
+                ++i;
+            }
+        }
+
+        if (middle < less) {
+            end = less;
+        } else if (middle >= greater) {
+            begin = greater;
+        } else {
+            break;
+        }
+    }
+    return middle;
+}
+
+/**
+ * items[begin, end)を中心位置で二分する位置を返す。
+ * 分割しないほうが効率が良い場合は0を返す。
+ */
+static GLuint Bvh_partition(BvhBuilder *builder, const GLuint begin, const GLuint end, const BvhNode *node, const int depth) {
+    Bvh *bvh = builder->bvh;
+    GLuint *items = bvh->items;
+    const GLuint count = end - begin;
+    GLuint i = 0;
+    int k = 0;
+
+    // 中心位置の範囲を求める
+    vec3 center_min = vec3_create(FLT_MAX, FLT_MAX, FLT_MAX);
+    vec3 center_max = vec3_create(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (i = begin; i < end; ++i) {
+        Bvh_expand(&center_min, &center_max, &builder->centers[items[i]], &builder->centers[items[i]]);
+    }
+
+    // 最も範囲の広い軸で分割する
+    int axis = 0;
+    {
+        const GLfloat x = center_max.x - center_min.x;
+        const GLfloat y = center_max.y - center_min.y;
+        const GLfloat z = center_max.z - center_min.z;
+        axis = (x >= y && x >= z) ? 0 : (y >= z ? 1 : 2);
+    }
+    const GLfloat axis_min = Bvh_axis(&center_min, axis);
+    const GLfloat axis_max = Bvh_axis(&center_max, axis);
+    if (axis_max <= axis_min) {
+        // 全て同じ位置にあるため分割できない
+        if (count <= BVH_LEAF_ITEMS_MAX) {
+            return 0;
+        }
+        return begin + count / 2;
+    }
+
+    if (depth >= BVH_SAH_DEPTH_MAX) {
+        if (count <= BVH_LEAF_ITEMS_MAX) {
+            return 0;
+        }
+        return Bvh_partitionMedian(builder, begin, end, axis);
+    }
+
+    GLfloat split = 0;
+    {
+        // 区間ごとにインスタンスを振り分ける
+        struct {
+            vec3 aabb_min;
+            vec3 aabb_max;
+            GLuint count;
+        } bins[BVH_SAH_BINS];
+        for (k = 0; k < BVH_SAH_BINS; ++k) {
+            bins[k].aabb_min = vec3_create(FLT_MAX, FLT_MAX, FLT_MAX);
+            bins[k].aabb_max = vec3_create(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            bins[k].count = 0;
+        }
+
+        const GLfloat scale = (GLfloat) BVH_SAH_BINS / (axis_max - axis_min);
+        for (i = begin; i < end; ++i) {
+            const GLuint item = items[i];
+            int bin = (int) ((Bvh_axis(&builder->centers[item], axis) - axis_min) * scale);
+            bin = bin < BVH_SAH_BINS ? bin : BVH_SAH_BINS - 1;
+
+            bins[bin].count++;
+            Bvh_expand(&bins[bin].aabb_min, &bins[bin].aabb_max, &bvh->item_min[item], &bvh->item_max[item]);
+        }
+
+        // 右側から累積した面積を求めておく
+        GLfloat right_costs[BVH_SAH_BINS];
+        {
+            vec3 aabb_min = vec3_create(FLT_MAX, FLT_MAX, FLT_MAX);
+            vec3 aabb_max = vec3_create(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            GLuint right_count = 0;
+            for (k = BVH_SAH_BINS - 1; k > 0; --k) {
+                Bvh_expand(&aabb_min, &aabb_max, &bins[k].aabb_min, &bins[k].aabb_max);
+                right_count += bins[k].count;
+                right_costs[k] = right_count ? Bvh_halfArea(&aabb_min, &aabb_max) * right_count : 0;
+            }
+        }
+
+        // 左側を累積しながら最小コストの分割位置を探す
+        GLfloat best_cost = FLT_MAX;
+        int best_bin = -1;
+        {
+            vec3 aabb_min = vec3_create(FLT_MAX, FLT_MAX, FLT_MAX);
+            vec3 aabb_max = vec3_create(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            GLuint left_count = 0;
+            for (k = 0; k < BVH_SAH_BINS - 1; ++k) {
+                Bvh_expand(&aabb_min, &aabb_max, &bins[k].aabb_min, &bins[k].aabb_max);
+                left_count += bins[k].count;
+                if (!left_count || left_count == count) {
+                    continue;
+                }
+
+                const GLfloat cost = Bvh_halfArea(&aabb_min, &aabb_max) * left_count + right_costs[k + 1];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_bin = k;
+                }
+            }
+        }
+
+        // 走査コスト1、インスタンス判定コスト1として葉のままの場合と比較する
+        const GLfloat node_area = Bvh_halfArea(&node->aabb_min, &node->aabb_max);
+        const GLfloat leaf_cost = (GLfloat) count;
+        best_cost = 1.0f + (node_area > 0 ? best_cost / node_area : 0);
+        if (best_bin < 0) {
+            if (count <= BVH_LEAF_ITEMS_MAX) {
+                return 0;
+            }
+            return Bvh_partitionMedian(builder, begin, end, axis);
+        }
+        if (best_cost >= leaf_cost && count <= BVH_LEAF_ITEMS_MAX) {
+            return 0;
+        }
+        split = axis_min + (GLfloat) (best_bin + 1) / scale;
+    }
+
+    // 分割位置の前後へ並べ替える
+    GLuint left = begin;
+    GLuint right = end;
+    while (left < right) {
+        if (Bvh_axis(&builder->centers[items[left]], axis) < split) {
+            ++left;
+        } else {
+            const GLuint temp = items[left];
+            items[left] = items[--right];
+            items[right] = temp;
+        }
+    }
+
+    // 片側に寄ってしまった場合は半分で分ける
+    if (left == begin || left == end) {
+        left = begin + count / 2;
+    }
+    return left;
+}
+
+/**
+ * items[begin, end)からノードを構築し、ノード番号を返す
+ */
+static GLuint Bvh_build(BvhBuilder *builder, const GLuint parent, const GLuint begin, const GLuint end, const int depth) {
+    Bvh *bvh = builder->bvh;
+    const GLuint index = bvh->nodes_num++;
+    BvhNode *node = &bvh->nodes[index];
+
+    node->first = begin;
+    node->count = end - begin;
+    bvh->node_parents[index] = parent;
+    Bvh_fitLeaf(bvh, node);
+
+    const GLuint middle = node->count > 1 ? Bvh_partition(builder, begin, end, node, depth) : 0;
+    if (!middle) {
+        // 葉ノード
+        GLuint i = 0;
+        for (i = begin; i < end; ++i) {
+            bvh->item_leaves[bvh->items[i]] = index;
+        }
+        return index;
+    }
+
+    // 左の子は直後に配置される
+    Bvh_build(builder, index, begin, middle, depth + 1);
+    const GLuint right = Bvh_build(builder, index, middle, end, depth + 1);
+
+    // 構築中にノード配列は移動しない
+    node->first = right;
+    node->count = 0;
+    return index;
+}
+
+/**
+ * インスタンスのAABBからBVHを構築する。
+ */
+Bvh* Bvh_create(const vec3 *aabb_mins, const vec3 *aabb_maxs, const GLuint num) {
+    Bvh *result = calloc(1, sizeof(Bvh));
+    const GLuint capacity = num ? num : 1;
+
+    result->items_num = num;
+    result->items = malloc(sizeof(GLuint) * capacity);
+    result->item_leaves = malloc(sizeof(GLuint) * capacity);
+    result->item_min = malloc(sizeof(vec3) * capacity);
+    result->item_max = malloc(sizeof(vec3) * capacity);
+
+    // N個のインスタンスから作られる二分木のノードは最大2N - 1個
+    result->nodes = util_alignedAlloc(32, sizeof(BvhNode) * (capacity * 2 - 1));
+    result->node_parents = malloc(sizeof(GLuint) * (capacity * 2 - 1));
+
+    if (num) {
+        memcpy(result->item_min, aabb_mins, sizeof(vec3) * num);
+        memcpy(result->item_max, aabb_maxs, sizeof(vec3) * num);
+    }
+
+    BvhBuilder builder = { result, malloc(sizeof(vec3) * capacity) };
+    GLuint i = 0;
+    for (i = 0; i < num; ++i) {
+        result->items[i] = i;
+        builder.centers[i] = vec3_create( //
+                (aabb_mins[i].x + aabb_maxs[i].x) * 0.5f, //
+                (aabb_mins[i].y + aabb_maxs[i].y) * 0.5f, //
+                (aabb_mins[i].z + aabb_maxs[i].z) * 0.5f);
+    }
+
+    if (num) {
+        Bvh_build(&builder, 0, 0, num, 0);
+    }
+    free(builder.centers);
+
+    __logf("Bvh items(%d) nodes(%d)", result->items_num, result->nodes_num);
+    return result;
+}
+
+/**
+ * インスタンスのAABBを更新し、所属する葉から親へ向かって境界を修正する。
+ */
+void Bvh_updateItem(Bvh *bvh, const GLuint item, const vec3 aabb_min, const vec3 aabb_max) {
+    assert(item < bvh->items_num);
+
+    bvh->item_min[item] = aabb_min;
+    bvh->item_max[item] = aabb_max;
+
+    GLuint index = bvh->item_leaves[item];
+    Bvh_fitLeaf(bvh, &bvh->nodes[index]);
+
+    while (index) {
+        index = bvh->node_parents[index];
+
+        BvhNode *node = &bvh->nodes[index];
+        const vec3 old_min = node->aabb_min;
+        const vec3 old_max = node->aabb_max;
+        Bvh_fitInner(bvh, index);
+
+        // 境界が変わらなければ、これより上も変わらない
+        if (!memcmp(&old_min, &node->aabb_min, sizeof(vec3)) && !memcmp(&old_max, &node->aabb_max, sizeof(vec3))) {
+            break;
+        }
+    }
+}
+
+/**
+ * 全ノードの境界をインスタンスのAABBから修正する。
+ */
+void Bvh_refit(Bvh *bvh) {
+    // 子は必ず親より後ろに配置されているため、末尾から修正すれば良い
+    GLint i = 0;
+    for (i = (GLint) bvh->nodes_num - 1; i >= 0; --i) {
+        BvhNode *node = &bvh->nodes[i];
+        if (node->count) {
+            Bvh_fitLeaf(bvh, node);
+        } else {
+            Bvh_fitInner(bvh, i);
+        }
+    }
+}
+
+/**
+ * AABBを判定が必要な平面で判定する。
+ * 外側ならfalseを返す。
+ * 平面の内側に完全に含まれる場合はその平面をmaskから外す。
+ */
+static bool Bvh_testPlanes(const Frustum *frustum, const vec3 *aabb_min, const vec3 *aabb_max, GLuint *mask) {
+    const GLfloat cx = (aabb_min->x + aabb_max->x) * 0.5f;
+    const GLfloat cy = (aabb_min->y + aabb_max->y) * 0.5f;
+    const GLfloat cz = (aabb_min->z + aabb_max->z) * 0.5f;
+    const GLfloat ex = (aabb_max->x - aabb_min->x) * 0.5f;
+    const GLfloat ey = (aabb_max->y - aabb_min->y) * 0.5f;
+    const GLfloat ez = (aabb_max->z - aabb_min->z) * 0.5f;
+
+    int i = 0;
+    for (i = 0; i < FRUSTUM_PLANES_NUM; ++i) {
+        if (!(*mask & (0x1 << i))) {
+            continue;
+        }
+
+        const vec4 *p = &frustum->planes[i];
+        const GLfloat distance = p->x * cx + p->y * cy + p->z * cz + p->w;
+        const GLfloat radius = fabsf(p->x) * ex + fabsf(p->y) * ey + fabsf(p->z) * ez;
+        if (distance + radius < 0) {
+            return false;
+        }
+        if (distance - radius >= 0) {
+            *mask &= ~(0x1 << i);
+        }
+    }
+    return true;
+}
+
+/**
+ * 視錐台と交差するインスタンス番号をresultへ格納し、件数を返す。
+ */
+GLuint Bvh_queryFrustum(const Bvh *bvh, const Frustum *frustum, GLuint *result) {
+    if (!bvh->nodes_num) {
+        return 0;
+    }
+
+    // 完全に内側と判明した平面は子で判定しない
+    struct {
+        GLuint node;
+        GLuint mask;
+    } stack[BVH_STACK_MAX];
+    int stack_num = 0;
+    GLuint result_num = 0;
+
+    stack[stack_num].node = 0;
+    stack[stack_num].mask = (0x1 << FRUSTUM_PLANES_NUM) - 1;
+    ++stack_num;
+
+    while (stack_num) {
+        --stack_num;
+        const BvhNode *node = &bvh->nodes[stack[stack_num].node];
+        GLuint mask = stack[stack_num].mask;
+
+        if (mask && !Bvh_testPlanes(frustum, &node->aabb_min, &node->aabb_max, &mask)) {
+            continue;
+        }
+
+        if (node->count) {
+            // 葉ノードはインスタンスごとに判定する
+            GLuint i = 0;
+            for (i = 0; i < node->count; ++i) {
+                const GLuint item = bvh->items[node->first + i];
+                GLuint item_mask = mask;
+                if (!mask || Bvh_testPlanes(frustum, &bvh->item_min[item], &bvh->item_max[item], &item_mask)) {
+                    result[result_num++] = item;
+                }
+            }
+        } else {
+            assert(stack_num + 2 <= BVH_STACK_MAX);
+
+            stack[stack_num].node = node->first;
+            stack[stack_num].mask = mask;
+            ++stack_num;
+            stack[stack_num].node = (GLuint) (node - bvh->nodes) + 1;
+            stack[stack_num].mask = mask;
+            ++stack_num;
+        }
+    }
+
+    return result_num;
+}
+
+/**
+ * レイとAABBの交差距離を求める。
+ * 交差しない場合は負の値を返す。
+ */
+static GLfloat Bvh_rayAABB(const vec3 *origin, const vec3 *inv_dir, const vec3 *aabb_min, const vec3 *aabb_max, const GLfloat max_distance) {
+    const GLfloat tx0 = (aabb_min->x - origin->x) * inv_dir->x;
+    const GLfloat tx1 = (aabb_max->x - origin->x) * inv_dir->x;
+    const GLfloat ty0 = (aabb_min->y - origin->y) * inv_dir->y;
+    const GLfloat ty1 = (aabb_max->y - origin->y) * inv_dir->y;
+    const GLfloat tz0 = (aabb_min->z - origin->z) * inv_dir->z;
+    const GLfloat tz1 = (aabb_max->z - origin->z) * inv_dir->z;
+
+    const GLfloat tmin = fmaxf(fmaxf(fminf(tx0, tx1), fminf(ty0, ty1)), fmaxf(fminf(tz0, tz1), 0.0f));
+    const GLfloat tmax = fminf(fminf(fmaxf(tx0, tx1), fmaxf(ty0, ty1)), fminf(fmaxf(tz0, tz1), max_distance));
+    return tmin <= tmax ? tmin : -1.0f;
+}
+
+/**
+ * レイと交差する最も近いインスタンスを探す。
+ */
+bool Bvh_raycast(const Bvh *bvh, const vec3 origin, const vec3 direction, const GLfloat max_distance, BvhRayHit *hit) {
+    if (!bvh->nodes_num) {
+        return false;
+    }
+
+    // 0除算はFLT_MAXで代用する
+    const vec3 inv_dir = vec3_create( //
+            direction.x != 0 ? 1.0f / direction.x : FLT_MAX, //
+            direction.y != 0 ? 1.0f / direction.y : FLT_MAX, //
+            direction.z != 0 ? 1.0f / direction.z : FLT_MAX);
+
+    GLuint stack[BVH_STACK_MAX];
+    int stack_num = 0;
+    GLfloat nearest = max_distance;
+    bool result = false;
+
+    if (Bvh_rayAABB(&origin, &inv_dir, &bvh->nodes[0].aabb_min, &bvh->nodes[0].aabb_max, nearest) < 0) {
+        return false;
+    }
+    stack[stack_num++] = 0;
+
+    while (stack_num) {
+        const BvhNode *node = &bvh->nodes[stack[--stack_num]];
+
+        if (node->count) {
+            GLuint i = 0;
+            for (i = 0; i < node->count; ++i) {
+                const GLuint item = bvh->items[node->first + i];
+                const GLfloat distance = Bvh_rayAABB(&origin, &inv_dir, &bvh->item_min[item], &bvh->item_max[item], nearest);
+                if (distance >= 0 && (!result || distance < nearest)) {
+                    nearest = distance;
+                    hit->item = item;
+                    hit->distance = distance;
+                    result = true;
+                }
+            }
+            continue;
+        }
+
+        // 近い子から先に処理されるよう、遠い子を先に積む
+        GLuint near_index = (GLuint) (node - bvh->nodes) + 1;
+        GLuint far_index = node->first;
+        GLfloat near_distance = Bvh_rayAABB(&origin, &inv_dir, &bvh->nodes[near_index].aabb_min, &bvh->nodes[near_index].aabb_max, nearest);
+        GLfloat far_distance = Bvh_rayAABB(&origin, &inv_dir, &bvh->nodes[far_index].aabb_min, &bvh->nodes[far_index].aabb_max, nearest);
+        if (far_distance >= 0 && (near_distance < 0 || far_distance < near_distance)) {
+            const GLuint temp_index = near_index;
+            const GLfloat temp_distance = near_distance;
+            near_index = far_index;
+            near_distance = far_distance;
+            far_index = temp_index;
+            far_distance = temp_distance;
+        }
+
+        assert(stack_num + 2 <= BVH_STACK_MAX);
+        if (far_distance >= 0) {
+            stack[stack_num++] = far_index;
+        }
+        if (near_distance >= 0) {
+            stack[stack_num++] = near_index;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * BVHを解放する
+ */
+void Bvh_free(Bvh *bvh) {
+    if (!bvh) {
+        return;
+    }
+    util_alignedFree(bvh->nodes);
+    free(bvh->node_parents);
+    free(bvh->items);
+    free(bvh->item_leaves);
+    free(bvh->item_min);
+    free(bvh->item_max);
+    free(bvh);
+}
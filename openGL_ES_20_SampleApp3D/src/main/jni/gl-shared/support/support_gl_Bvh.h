@@ -0,0 +1,140 @@
+/*
+ * support_gl_Bvh.h
+ *
+ * 静的なシーン向けのBounding Volume Hierarchy
+ * インスタンスのAABBから読み込み時に木を構築し、視錐台判定とレイ判定を同じ構造で行う。
+ */
+
+#ifndef SUPPORT_GL_BVH_H_
+#define SUPPORT_GL_BVH_H_
+
+/**
+ * 葉ノードが保持する最大インスタンス数
+ */
+#define BVH_LEAF_ITEMS_MAX  4
+
+/**
+ * BVHのノード
+ * キャッシュ効率のため32byteに収め、深さ優先順で1つの配列に格納する。
+ * 内部ノードの左の子は常に直後のノードとなる。
+ */
+typedef struct BvhNode {
+    /**
+     * AABB最小値
+     */
+    vec3 aabb_min;
+
+    /**
+     * 葉ノードの場合、Bvh::itemsの先頭位置
+     * 内部ノードの場合、右の子のノード番号
+     */
+    GLuint first;
+
+    /**
+     * AABB最大値
+     */
+    vec3 aabb_max;
+
+    /**
+     * 葉ノードの場合、インスタンス数
+     * 内部ノードの場合は0
+     */
+    GLuint count;
+} BvhNode;
+
+/**
+ * Bounding Volume Hierarchy
+ */
+typedef struct Bvh {
+    /**
+     * ノード配列
+     * 0番目がルートとなる
+     */
+    BvhNode *nodes;
+
+    /**
+     * ノード数
+     */
+    GLuint nodes_num;
+
+    /**
+     * 親ノード番号
+     * ルートは自身を指す
+     */
+    GLuint *node_parents;
+
+    /**
+     * 葉ノード順に並べたインスタンス番号
+     */
+    GLuint *items;
+
+    /**
+     * インスタンスが所属する葉ノード番号
+     */
+    GLuint *item_leaves;
+
+    /**
+     * インスタンスのAABB
+     */
+    vec3 *item_min;
+    vec3 *item_max;
+
+    /**
+     * インスタンス数
+     */
+    GLuint items_num;
+} Bvh;
+
+/**
+ * レイ判定の結果
+ */
+typedef struct BvhRayHit {
+    /**
+     * 最も近いインスタンス番号
+     */
+    GLuint item;
+
+    /**
+     * レイの始点からの距離
+     * directionの長さを1とした距離となる
+     */
+    GLfloat distance;
+} BvhRayHit;
+
+/**
+ * インスタンスのAABBからBVHを構築する。
+ * 分割位置はSurface Area Heuristicで選択する。
+ */
+extern Bvh* Bvh_create(const vec3 *aabb_mins, const vec3 *aabb_maxs, const GLuint num);
+
+/**
+ * インスタンスのAABBを更新し、所属する葉から親へ向かって境界を修正する。
+ * 境界が変化しなくなった時点で修正を打ち切る。
+ * 木の構造は変更しないため、大きく移動したインスタンスが多い場合は再構築したほうが効率が良い。
+ */
+extern void Bvh_updateItem(Bvh *bvh, const GLuint item, const vec3 aabb_min, const vec3 aabb_max);
+
+/**
+ * 全ノードの境界をインスタンスのAABBから修正する。
+ */
+extern void Bvh_refit(Bvh *bvh);
+
+/**
+ * 視錐台と交差するインスタンス番号をresultへ格納し、件数を返す。
+ * resultはインスタンス数以上の容量を持たなければならない。
+ */
+extern GLuint Bvh_queryFrustum(const Bvh *bvh, const Frustum *frustum, GLuint *result);
+
+/**
+ * レイと交差する最も近いインスタンスを探す。
+ * 判定はインスタンスのAABBで行う。
+ * 交差した場合はtrueを返し、hitへ結果を格納する。
+ */
+extern bool Bvh_raycast(const Bvh *bvh, const vec3 origin, const vec3 direction, const GLfloat max_distance, BvhRayHit *hit);
+
+/**
+ * BVHを解放する
+ */
+extern void Bvh_free(Bvh *bvh);
+
+#endif /* SUPPORT_GL_BVH_H_ */
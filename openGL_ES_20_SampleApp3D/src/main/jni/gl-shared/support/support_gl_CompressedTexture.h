@@ -25,6 +25,12 @@
  */
 #define TEXTURE_COMPRESS_KTX          12
 
+/**
+ * 圧縮画像の構造体とmipmapテーブルを確保する領域のブロックサイズ
+ * 構造体とテーブルを1ブロックに収め、解放時は1回で済ませる
+ */
+#define COMPRESSEDIMAGE_ARENA_BLOCK_SIZE    512
+
 
 /**
  * PKMフォーマット画像
@@ -76,6 +82,11 @@ typedef struct PkmImage {
      * 圧縮テクスチャ本体の長さ
      */
     int image_bytes;
+
+    /**
+     * 構造体とテーブルを確保した領域
+     */
+    MemoryArena *arena;
 } PkmImage;
 
 
@@ -149,6 +160,11 @@ typedef struct PvrtcImage {
      * mipmap数だけ格納されている
      */
     void** image_table;
+
+    /**
+     * 構造体とテーブルを確保した領域
+     */
+    MemoryArena *arena;
 } PvrtcImage;
 
 /**
@@ -215,6 +231,11 @@ typedef struct KtxImage {
      * mipmap数だけ格納されている
      */
     void** image_table;
+
+    /**
+     * 構造体とテーブルを確保した領域
+     */
+    MemoryArena *arena;
 } KtxImage;
 
 
@@ -53,7 +53,9 @@ KtxImage* KtxImage_load(GLApplication *app, const char* file_name) {
 
     // 読み込みできるデータだった
 
-    KtxImage *result = (KtxImage*) malloc(sizeof(KtxImage));
+    MemoryArena *arena = MemoryArena_create(COMPRESSEDIMAGE_ARENA_BLOCK_SIZE);
+    KtxImage *result = (KtxImage*) MemoryArena_calloc(arena, 1, sizeof(KtxImage));
+    result->arena = arena;
     result->raw = rawData;
 
     // ヘッダからデータを読み取る
@@ -86,8 +88,8 @@ KtxImage* KtxImage_load(GLApplication *app, const char* file_name) {
         result->height = pImageHeader->pixelHeight;
         result->mipmaps = pImageHeader->numberOfMipmapLevels;
 
-        result->image_length_table = (int*) malloc(sizeof(int) * pImageHeader->numberOfMipmapLevels);
-        result->image_table = (void**) malloc(sizeof(void*) * pImageHeader->numberOfMipmapLevels);
+        result->image_length_table = (int*) MemoryArena_alloc(arena, sizeof(int) * pImageHeader->numberOfMipmapLevels);
+        result->image_table = (void**) MemoryArena_alloc(arena, sizeof(void*) * pImageHeader->numberOfMipmapLevels);
     }
 
     // ヘッダ位置を動かす
@@ -114,9 +116,8 @@ KtxImage* KtxImage_load(GLApplication *app, const char* file_name) {
 void KtxImage_free(GLApplication *app, KtxImage *image) {
     if (image) {
         RawData_freeFile(app, image->raw);
-        free(image->image_table);
-        free(image->image_length_table);
-        free(image);
+        // 構造体自身もarenaに含まれる
+        MemoryArena_free(image->arena);
     }
 }
 
@@ -134,7 +135,13 @@ Texture* KtxImage_loadTexture(GLApplication *app, const char* file_name) {
         return NULL;
     }
 
-    Texture *texture = (Texture*) malloc(sizeof(Texture));
+    Texture *texture = Texture_alloc();
+
+    // プールが埋まっている場合は読み込み失敗として扱う
+    if (!texture) {
+        KtxImage_free(app, ktx);
+        return NULL;
+    }
 
     {
         // 元画像から必要情報をコピーする
@@ -17,7 +17,9 @@ PkmImage* PkmImage_load(GLApplication *app, const char* file_name) {
         return NULL;
     }
 
-    PkmImage *image = (PkmImage*) malloc(sizeof(PkmImage));
+    MemoryArena *arena = MemoryArena_create(COMPRESSEDIMAGE_ARENA_BLOCK_SIZE);
+    PkmImage *image = (PkmImage*) MemoryArena_calloc(arena, 1, sizeof(PkmImage));
+    image->arena = arena;
 
     image->raw = raw;
     image->image_bytes = RawData_getLength(raw);
@@ -69,7 +71,8 @@ PkmImage* PkmImage_load(GLApplication *app, const char* file_name) {
 void PkmImage_free(GLApplication *app, PkmImage *pkm) {
     if (pkm) {
         RawData_freeFile(app, pkm->raw);
-        free(pkm);
+        // 構造体自身もarenaに含まれる
+        MemoryArena_free(pkm->arena);
     }
 }
 
@@ -90,7 +93,13 @@ Texture* PkmImage_loadTexture(GLApplication *app, const char* file_name) {
         return NULL;
     }
 
-    Texture *texture = (Texture*) malloc(sizeof(Texture));
+    Texture *texture = Texture_alloc();
+
+    // プールが埋まっている場合は読み込み失敗として扱う
+    if (!texture) {
+        PkmImage_free(app, pkm);
+        return NULL;
+    }
 
     {
         // 元画像から必要情報をコピーする
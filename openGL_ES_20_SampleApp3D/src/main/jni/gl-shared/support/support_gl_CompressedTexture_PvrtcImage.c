@@ -56,7 +56,9 @@ PvrtcImage* PvrtcImage_load(GLApplication *app, const char *file_name) {
 
     __logf("pvrtc mipmaps(%d) surfs(%d)", header->numMipmaps, header->numSurfs);
 
-    PvrtcImage *result = (PvrtcImage*) malloc(sizeof(PvrtcImage));
+    MemoryArena *arena = MemoryArena_create(COMPRESSEDIMAGE_ARENA_BLOCK_SIZE);
+    PvrtcImage *result = (PvrtcImage*) MemoryArena_calloc(arena, 1, sizeof(PvrtcImage));
+    result->arena = arena;
 
     // データコピー
     result->raw = raw;
@@ -87,8 +89,8 @@ PvrtcImage* PvrtcImage_load(GLApplication *app, const char *file_name) {
         // 等倍テクスチャ+mipmap数を保持するため、例えば等倍テクスチャであればnumMpmapは0になる。
         // +1を行うことでfor文で回すことができる。
         result->mipmaps = header->numMipmaps + 1;
-        result->image_table = (void**) malloc(sizeof(void*) * result->mipmaps);
-        result->image_length_table = (int*) malloc(sizeof(void*) * result->mipmaps);
+        result->image_table = (void**) MemoryArena_alloc(arena, sizeof(void*) * result->mipmaps);
+        result->image_length_table = (int*) MemoryArena_alloc(arena, sizeof(int) * result->mipmaps);
 
         int miplevel = 0;
         int texWidth = result->width;
@@ -142,10 +144,8 @@ void PvrtcImage_free(GLApplication *app, PvrtcImage *pvrtc) {
     if (pvrtc) {
         RawData_freeFile(app, pvrtc->raw);
 
-        free(pvrtc->image_table);
-        free(pvrtc->image_length_table);
-
-        free(pvrtc);
+        // 構造体自身もarenaに含まれる
+        MemoryArena_free(pvrtc->arena);
     }
 }
 
@@ -162,7 +162,13 @@ Texture* PvrtcImage_loadTexture(GLApplication *app, const char* file_name) {
         return NULL;
     }
 
-    Texture *texture = (Texture*) malloc(sizeof(Texture));
+    Texture *texture = Texture_alloc();
+
+    // プールが埋まっている場合は読み込み失敗として扱う
+    if (!texture) {
+        PvrtcImage_free(app, pvrtc);
+        return NULL;
+    }
 
     {
         // 元画像から必要情報をコピーする
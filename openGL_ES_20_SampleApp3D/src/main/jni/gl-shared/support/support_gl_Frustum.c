@@ -0,0 +1,262 @@
+/*
+ * support_gl_Frustum.c
+ */
+
+#include    "support.h"
+#include    <float.h>
+
+/**
+ * 1スレッドが一度に判定する件数
+ * SIMDの幅(4)の倍数でなければならない
+ */
+#define CULLINGLIST_CHUNK   256
+
+/**
+ * SoA配列の数
+ */
+#define CULLINGLIST_ARRAYS  7
+
+/**
+ * 平面を正規化して格納する
+ */
+static vec4 Frustum_normalizePlane(const GLfloat a, const GLfloat b, const GLfloat c, const GLfloat d) {
+    const GLfloat length = sqrtf(a * a + b * b + c * c);
+    const GLfloat inv = length > 0 ? 1.0f / length : 0.0f;
+
+    vec4 result = { a * inv, b * inv, c * inv, d * inv };
+    return result;
+}
+
+/**
+ * ビュープロジェクション行列から視錐台を生成する。
+ */
+Frustum Frustum_create(const mat4 view_projection) {
+    Frustum result;
+
+    // mat4はm[列][行]で格納されている
+    const GLfloat (*m)[4] = view_projection.m;
+    int i = 0;
+    for (i = 0; i < 3; ++i) {
+        // row3 + row[i]
+        result.planes[i * 2 + 0] = Frustum_normalizePlane( //
+                m[0][3] + m[0][i], m[1][3] + m[1][i], m[2][3] + m[2][i], m[3][3] + m[3][i]);
+        // row3 - row[i]
+        result.planes[i * 2 + 1] = Frustum_normalizePlane( //
+                m[0][3] - m[0][i], m[1][3] - m[1][i], m[2][3] - m[2][i], m[3][3] - m[3][i]);
+    }
+
+    return result;
+}
+
+/**
+ * 境界球が視錐台と交差していればtrueを返す
+ */
+bool Frustum_testSphere(const Frustum *frustum, const vec3 center, const GLfloat radius) {
+    int i = 0;
+    for (i = 0; i < FRUSTUM_PLANES_NUM; ++i) {
+        const vec4 *p = &frustum->planes[i];
+        if (p->x * center.x + p->y * center.y + p->z * center.z + p->w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * AABBが視錐台と交差していればtrueを返す
+ */
+bool Frustum_testAABB(const Frustum *frustum, const vec3 aabb_min, const vec3 aabb_max) {
+    int i = 0;
+    for (i = 0; i < FRUSTUM_PLANES_NUM; ++i) {
+        const vec4 *p = &frustum->planes[i];
+
+        // 平面の法線方向に最も進んだ頂点で判定する
+        const GLfloat x = p->x >= 0 ? aabb_max.x : aabb_min.x;
+        const GLfloat y = p->y >= 0 ? aabb_max.y : aabb_min.y;
+        const GLfloat z = p->z >= 0 ? aabb_max.z : aabb_min.z;
+        if (p->x * x + p->y * y + p->z * z + p->w < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * SoA配列を指定の件数で確保し直す
+ */
+static void CullingList_reserve(CullingList *list, GLuint capacity) {
+    capacity = (capacity + 3) & ~3;
+    if (capacity <= list->capacity) {
+        return;
+    }
+
+    // 全ての配列を1ブロックで確保する
+    // center_xがブロックの先頭になる
+    GLfloat *old = list->center_x;
+    GLfloat *block = util_alignedAlloc(SIMD4F_ALIGNMENT, sizeof(GLfloat) * capacity * CULLINGLIST_ARRAYS);
+    GLfloat **arrays[CULLINGLIST_ARRAYS] = { &list->center_x, &list->center_y, &list->center_z, &list->extent_x, &list->extent_y, &list->extent_z, &list->radius };
+
+    int i = 0;
+    for (i = 0; i < CULLINGLIST_ARRAYS; ++i) {
+        GLfloat *array = block + capacity * i;
+        if (list->num) {
+            memcpy(array, *arrays[i], sizeof(GLfloat) * list->num);
+        }
+        *arrays[i] = array;
+    }
+    util_alignedFree(old);
+
+    list->visible_flags = realloc(list->visible_flags, sizeof(GLubyte) * capacity);
+    list->visible = realloc(list->visible, sizeof(GLuint) * capacity);
+    list->capacity = capacity;
+}
+
+/**
+ * カリング対象の配列を生成する
+ */
+CullingList* CullingList_create(const GLuint capacity) {
+    CullingList *result = calloc(1, sizeof(CullingList));
+    CullingList_reserve(result, capacity ? capacity : 4);
+    return result;
+}
+
+/**
+ * 登録を全て破棄する
+ */
+void CullingList_clear(CullingList *list) {
+    list->num = 0;
+    list->visible_num = 0;
+}
+
+/**
+ * 境界ボリュームをワールド行列で変換して登録する。
+ */
+GLuint CullingList_add(CullingList *list, const PmdBounds *bounds, const mat4 world) {
+    if (list->num == list->capacity) {
+        CullingList_reserve(list, list->capacity * 2);
+    }
+
+    const GLuint index = list->num++;
+    CullingList_set(list, index, bounds, world);
+    return index;
+}
+
+/**
+ * 登録済みの境界ボリュームを書き換える。
+ */
+void CullingList_set(CullingList *list, const GLuint index, const PmdBounds *bounds, const mat4 world) {
+    assert(index < list->num);
+
+    const GLfloat (*m)[4] = world.m;
+
+    // 中心はAABBと境界球で共通
+    const vec3 center = mat4_transformPoint(world, bounds->sphere_center);
+    list->center_x[index] = center.x;
+    list->center_y[index] = center.y;
+    list->center_z[index] = center.z;
+
+    // 回転後のAABBを包むAABBの半径
+    const GLfloat ex = (bounds->aabb_max.x - bounds->aabb_min.x) * 0.5f;
+    const GLfloat ey = (bounds->aabb_max.y - bounds->aabb_min.y) * 0.5f;
+    const GLfloat ez = (bounds->aabb_max.z - bounds->aabb_min.z) * 0.5f;
+    list->extent_x[index] = fabsf(m[0][0]) * ex + fabsf(m[1][0]) * ey + fabsf(m[2][0]) * ez;
+    list->extent_y[index] = fabsf(m[0][1]) * ex + fabsf(m[1][1]) * ey + fabsf(m[2][1]) * ez;
+    list->extent_z[index] = fabsf(m[0][2]) * ex + fabsf(m[1][2]) * ey + fabsf(m[2][2]) * ez;
+
+    // 境界球は最大の拡大率で拡大する
+    {
+        GLfloat scale = 0;
+        int i = 0;
+        for (i = 0; i < 3; ++i) {
+            const GLfloat length = m[i][0] * m[i][0] + m[i][1] * m[i][1] + m[i][2] * m[i][2];
+            scale = fmaxf(scale, length);
+        }
+        list->radius[index] = bounds->sphere_radius * sqrtf(scale);
+    }
+}
+
+/**
+ * カリング処理の作業情報
+ */
+typedef struct CullingTask {
+    CullingList *list;
+    const Frustum *frustum;
+} CullingTask;
+
+/**
+ * 範囲内の要素を4件ずつ判定する
+ */
+static void CullingList_cullRange(void *userdata, const unsigned int begin, const unsigned int end) {
+    const CullingTask *task = (const CullingTask*) userdata;
+    CullingList *list = task->list;
+    const Frustum *frustum = task->frustum;
+
+    GLfloat margins[4] __attribute__((aligned(SIMD4F_ALIGNMENT)));
+
+    unsigned int i = 0;
+    int k = 0;
+    for (i = begin; i < end; i += 4) {
+        const simd4f cx = simd4f_load(list->center_x + i);
+        const simd4f cy = simd4f_load(list->center_y + i);
+        const simd4f cz = simd4f_load(list->center_z + i);
+        const simd4f ex = simd4f_load(list->extent_x + i);
+        const simd4f ey = simd4f_load(list->extent_y + i);
+        const simd4f ez = simd4f_load(list->extent_z + i);
+        const simd4f r = simd4f_load(list->radius + i);
+
+        // 全平面に対する余裕の最小値が負なら視錐台の外側にある
+        simd4f margin = simd4f_splat(FLT_MAX);
+        for (k = 0; k < FRUSTUM_PLANES_NUM; ++k) {
+            const vec4 *p = &frustum->planes[k];
+            const simd4f distance = simd4f_madd(simd4f_splat(p->x), cx, simd4f_madd(simd4f_splat(p->y), cy, simd4f_madd(simd4f_splat(p->z), cz, simd4f_splat(p->w))));
+
+            // 境界球
+            const simd4f sphere = simd4f_add(distance, r);
+            // AABB
+            const simd4f box = simd4f_add(distance, simd4f_madd(simd4f_splat(fabsf(p->x)), ex, simd4f_madd(simd4f_splat(fabsf(p->y)), ey, simd4f_mul(simd4f_splat(fabsf(p->z)), ez))));
+
+            margin = simd4f_min(margin, simd4f_min(sphere, box));
+        }
+
+        simd4f_store(margins, margin);
+        for (k = 0; k < 4 && i + k < list->num; ++k) {
+            list->visible_flags[i + k] = margins[k] >= 0 ? 1 : 0;
+        }
+    }
+}
+
+/**
+ * 登録された全要素を判定し、可視な要素番号をlist->visibleへ格納する。
+ */
+GLuint CullingList_cull(CullingList *list, const Frustum *frustum, ThreadPool *pool) {
+    CullingTask task = { list, frustum };
+
+    // 4件単位で判定する
+    const GLuint count = (list->num + 3) & ~3;
+    ThreadPool_parallelFor(pool, count, CULLINGLIST_CHUNK, CullingList_cullRange, &task);
+
+    // 可視の要素だけを詰める
+    GLuint visible_num = 0;
+    GLuint i = 0;
+    for (i = 0; i < list->num; ++i) {
+        if (list->visible_flags[i]) {
+            list->visible[visible_num++] = i;
+        }
+    }
+    list->visible_num = visible_num;
+    return visible_num;
+}
+
+/**
+ * カリング対象の配列を解放する
+ */
+void CullingList_free(CullingList *list) {
+    if (!list) {
+        return;
+    }
+    // center_xが確保したブロックの先頭になる
+    util_alignedFree(list->center_x);
+    free(list->visible_flags);
+    free(list->visible);
+    free(list);
+}
@@ -0,0 +1,131 @@
+/*
+ * support_gl_Frustum.h
+ *
+ * 視錐台カリング
+ * 射影行列 × 視点変換行列（× ワールド行列）から6平面を取り出し、境界ボリュームと判定する。
+ */
+
+#ifndef SUPPORT_GL_FRUSTUM_H_
+#define SUPPORT_GL_FRUSTUM_H_
+
+/**
+ * 視錐台の平面数
+ */
+#define FRUSTUM_PLANES_NUM  6
+
+/**
+ * 視錐台
+ */
+typedef struct Frustum {
+    /**
+     * 正規化済みの平面(a, b, c, d)
+     * 内側の点はa * x + b * y + c * z + d >= 0となる
+     * left / right / bottom / top / near / farの順に格納される
+     */
+    vec4 planes[FRUSTUM_PLANES_NUM];
+} Frustum;
+
+/**
+ * カリング対象の境界ボリューム配列
+ * SIMDで4件ずつ判定できるよう、要素ごとの配列(SoA)として保持する。
+ */
+typedef struct CullingList {
+    /**
+     * ワールド座標系での中心位置
+     * AABBと境界球で共通となる
+     */
+    GLfloat *center_x;
+    GLfloat *center_y;
+    GLfloat *center_z;
+
+    /**
+     * AABBの半径
+     */
+    GLfloat *extent_x;
+    GLfloat *extent_y;
+    GLfloat *extent_z;
+
+    /**
+     * 境界球の半径
+     */
+    GLfloat *radius;
+
+    /**
+     * 登録されている件数
+     */
+    GLuint num;
+
+    /**
+     * 登録できる件数
+     */
+    GLuint capacity;
+
+    /**
+     * 判定結果
+     * 可視なら1
+     */
+    GLubyte *visible_flags;
+
+    /**
+     * 可視と判定された要素番号
+     * 登録順に格納される
+     */
+    GLuint *visible;
+
+    /**
+     * 可視と判定された件数
+     */
+    GLuint visible_num;
+} CullingList;
+
+/**
+ * ビュープロジェクション行列から視錐台を生成する。
+ * 射影行列 × 視点変換行列を渡すとワールド座標系の視錐台となる。
+ */
+extern Frustum Frustum_create(const mat4 view_projection);
+
+/**
+ * 境界球が視錐台と交差していればtrueを返す
+ */
+extern bool Frustum_testSphere(const Frustum *frustum, const vec3 center, const GLfloat radius);
+
+/**
+ * AABBが視錐台と交差していればtrueを返す
+ */
+extern bool Frustum_testAABB(const Frustum *frustum, const vec3 aabb_min, const vec3 aabb_max);
+
+/**
+ * カリング対象の配列を生成する
+ */
+extern CullingList* CullingList_create(const GLuint capacity);
+
+/**
+ * 登録を全て破棄する
+ */
+extern void CullingList_clear(CullingList *list);
+
+/**
+ * 境界ボリュームをワールド行列で変換して登録する。
+ * 登録した要素番号を返す。
+ */
+extern GLuint CullingList_add(CullingList *list, const PmdBounds *bounds, const mat4 world);
+
+/**
+ * 登録済みの境界ボリュームをワールド行列で変換して書き換える。
+ * 動いた要素だけを更新する場合に利用する。
+ */
+extern void CullingList_set(CullingList *list, const GLuint index, const PmdBounds *bounds, const mat4 world);
+
+/**
+ * 登録された全要素を判定し、可視な要素番号をlist->visibleへ格納する。
+ * poolがNULLでない場合、判定を複数スレッドで分割して行う。
+ * 可視となった件数を返す。
+ */
+extern GLuint CullingList_cull(CullingList *list, const Frustum *frustum, ThreadPool *pool);
+
+/**
+ * カリング対象の配列を解放する
+ */
+extern void CullingList_free(CullingList *list);
+
+#endif /* SUPPORT_GL_FRUSTUM_H_ */
@@ -0,0 +1,458 @@
+/*
+ * support_gl_Occlusion.c
+ */
+
+#include    "support.h"
+
+/**
+ * 1タイルのピクセル数
+ */
+#define OCCLUSION_TILE_PIXELS   (OCCLUSION_TILE_WIDTH * OCCLUSION_TILE_HEIGHT)
+
+/**
+ * この値よりwが小さい頂点は視点の手前にあるとみなす
+ */
+#define OCCLUSION_W_MIN         0.0001f
+
+/**
+ * 深度バッファの指定ピクセルを取得する
+ */
+static GLfloat OcclusionBuffer_depthAt(const OcclusionBuffer *buffer, const GLint x, const GLint y) {
+    const GLint tile = (y / OCCLUSION_TILE_HEIGHT) * buffer->tiles_x + (x / OCCLUSION_TILE_WIDTH);
+    const GLint local = (y % OCCLUSION_TILE_HEIGHT) * OCCLUSION_TILE_WIDTH + (x % OCCLUSION_TILE_WIDTH);
+    return buffer->depth[tile * OCCLUSION_TILE_PIXELS + local];
+}
+
+/**
+ * オクルージョンバッファを生成する。
+ */
+OcclusionBuffer* OcclusionBuffer_create(const GLint width, const GLint height) {
+    OcclusionBuffer *result = calloc(1, sizeof(OcclusionBuffer));
+
+    result->tiles_x = (width + OCCLUSION_TILE_WIDTH - 1) / OCCLUSION_TILE_WIDTH;
+    result->tiles_y = (height + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT;
+    result->tiles_x = result->tiles_x ? result->tiles_x : 1;
+    result->tiles_y = result->tiles_y ? result->tiles_y : 1;
+    result->width = result->tiles_x * OCCLUSION_TILE_WIDTH;
+    result->height = result->tiles_y * OCCLUSION_TILE_HEIGHT;
+
+    result->depth = util_alignedAlloc(SIMD4F_ALIGNMENT, sizeof(GLfloat) * result->width * result->height);
+    result->tile_offsets = malloc(sizeof(GLuint) * (result->tiles_x * result->tiles_y + 1));
+
+    // 深度ピラミッドは1x1になるまで半分にしていく
+    {
+        GLint w = result->width;
+        GLint h = result->height;
+        while ((w > 1 || h > 1) && result->levels_num < OCCLUSION_LEVELS_MAX) {
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+            result->level_widths[result->levels_num] = w;
+            result->level_heights[result->levels_num] = h;
+            result->levels[result->levels_num] = malloc(sizeof(GLfloat) * w * h);
+            ++result->levels_num;
+        }
+    }
+
+    OcclusionBuffer_begin(result, mat4_identity());
+    return result;
+}
+
+/**
+ * 遮蔽物の登録を開始する。
+ */
+void OcclusionBuffer_begin(OcclusionBuffer *buffer, const mat4 view_projection) {
+    buffer->view_projection = view_projection;
+    buffer->triangles_num = 0;
+}
+
+/**
+ * スクリーン座標の三角形をセットアップして登録する
+ */
+static void OcclusionBuffer_addTriangle(OcclusionBuffer *buffer, const vec4 *v0, const vec4 *v1, const vec4 *v2) {
+    // 手前にはみ出した三角形はクリップせずに諦める
+    // 遮蔽物が小さくなるだけなので、誤って隠れていると判定することはない
+    if (v0->w < OCCLUSION_W_MIN || v1->w < OCCLUSION_W_MIN || v2->w < OCCLUSION_W_MIN) {
+        return;
+    }
+
+    const GLfloat half_width = (GLfloat) buffer->width * 0.5f;
+    const GLfloat half_height = (GLfloat) buffer->height * 0.5f;
+    GLfloat xs[3];
+    GLfloat ys[3];
+    GLfloat zs[3];
+    {
+        const vec4 *vertices[3] = { v0, v1, v2 };
+        int i = 0;
+        for (i = 0; i < 3; ++i) {
+            const GLfloat inv_w = 1.0f / vertices[i]->w;
+            xs[i] = (vertices[i]->x * inv_w + 1.0f) * half_width;
+            ys[i] = (vertices[i]->y * inv_w + 1.0f) * half_height;
+            zs[i] = vertices[i]->z * inv_w * 0.5f + 0.5f;
+        }
+    }
+
+    // 反時計回りに揃える
+    GLfloat area = (xs[1] - xs[0]) * (ys[2] - ys[0]) - (ys[1] - ys[0]) * (xs[2] - xs[0]);
+    if (area < 0) {
+        GLfloat temp = xs[1];
+        xs[1] = xs[2];
+        xs[2] = temp;
+        temp = ys[1];
+        ys[1] = ys[2];
+        ys[2] = temp;
+        temp = zs[1];
+        zs[1] = zs[2];
+        zs[2] = temp;
+        area = -area;
+    }
+    if (area <= 0.0f) {
+        return;
+    }
+
+    // 画面内の範囲へ制限する
+    const GLint min_x = (GLint) fmaxf(floorf(fminf(xs[0], fminf(xs[1], xs[2]))), 0.0f);
+    const GLint min_y = (GLint) fmaxf(floorf(fminf(ys[0], fminf(ys[1], ys[2]))), 0.0f);
+    const GLint max_x = (GLint) fminf(ceilf(fmaxf(xs[0], fmaxf(xs[1], xs[2]))), (GLfloat) buffer->width);
+    const GLint max_y = (GLint) fminf(ceilf(fmaxf(ys[0], fmaxf(ys[1], ys[2]))), (GLfloat) buffer->height);
+    if (min_x >= max_x || min_y >= max_y) {
+        return;
+    }
+
+    if (buffer->triangles_num == buffer->triangles_capacity) {
+        buffer->triangles_capacity = buffer->triangles_capacity ? buffer->triangles_capacity * 2 : 256;
+        buffer->triangles = realloc(buffer->triangles, sizeof(OcclusionTriangle) * buffer->triangles_capacity);
+    }
+    OcclusionTriangle *triangle = &buffer->triangles[buffer->triangles_num++];
+
+    // 辺i→jの辺関数
+    // edge[0]はv2、edge[1]はv0、edge[2]はv1の重みとなる
+    int i = 0;
+    for (i = 0; i < 3; ++i) {
+        const int j = (i + 1) % 3;
+        triangle->edge_a[i] = ys[i] - ys[j];
+        triangle->edge_b[i] = xs[j] - xs[i];
+        triangle->edge_c[i] = xs[i] * ys[j] - xs[j] * ys[i];
+    }
+
+    // 深度は画面上で線形に補間できる
+    const GLfloat inv_area = 1.0f / area;
+    triangle->depth_a = (zs[0] * triangle->edge_a[1] + zs[1] * triangle->edge_a[2] + zs[2] * triangle->edge_a[0]) * inv_area;
+    triangle->depth_b = (zs[0] * triangle->edge_b[1] + zs[1] * triangle->edge_b[2] + zs[2] * triangle->edge_b[0]) * inv_area;
+    triangle->depth_c = (zs[0] * triangle->edge_c[1] + zs[1] * triangle->edge_c[2] + zs[2] * triangle->edge_c[0]) * inv_area;
+
+    triangle->min_x = min_x;
+    triangle->min_y = min_y;
+    triangle->max_x = max_x;
+    triangle->max_y = max_y;
+}
+
+/**
+ * 三角形リストを遮蔽物として登録する。
+ */
+void OcclusionBuffer_addMesh(OcclusionBuffer *buffer, const vec3 *positions, const GLsizei stride, const GLuint vertices_num, const GLvoid *indices, const GLenum index_type, const GLuint indices_num, const mat4 world) {
+    assert(index_type == GL_UNSIGNED_SHORT || index_type == GL_UNSIGNED_INT);
+
+    if (vertices_num > buffer->clip_positions_capacity) {
+        buffer->clip_positions_capacity = vertices_num;
+        buffer->clip_positions = realloc(buffer->clip_positions, sizeof(vec4) * vertices_num);
+    }
+
+    // 頂点を先に全て変換し、共有されている頂点を何度も変換しないようにする
+    const mat4 m = mat4_multiply(buffer->view_projection, world);
+    GLuint i = 0;
+    for (i = 0; i < vertices_num; ++i) {
+        const vec3 *p = (const vec3*) ((const GLubyte*) positions + stride * i);
+        vec4 *clip = &buffer->clip_positions[i];
+        clip->x = m.m[0][0] * p->x + m.m[1][0] * p->y + m.m[2][0] * p->z + m.m[3][0];
+        clip->y = m.m[0][1] * p->x + m.m[1][1] * p->y + m.m[2][1] * p->z + m.m[3][1];
+        clip->z = m.m[0][2] * p->x + m.m[1][2] * p->y + m.m[2][2] * p->z + m.m[3][2];
+        clip->w = m.m[0][3] * p->x + m.m[1][3] * p->y + m.m[2][3] * p->z + m.m[3][3];
+    }
+
+    for (i = 0; i + 2 < indices_num; i += 3) {
+        GLuint i0, i1, i2;
+        if (index_type == GL_UNSIGNED_SHORT) {
+            const GLushort *p = (const GLushort*) indices + i;
+            i0 = p[0];
+            i1 = p[1];
+            i2 = p[2];
+        } else {
+            const GLuint *p = (const GLuint*) indices + i;
+            i0 = p[0];
+            i1 = p[1];
+            i2 = p[2];
+        }
+        OcclusionBuffer_addTriangle(buffer, &buffer->clip_positions[i0], &buffer->clip_positions[i1], &buffer->clip_positions[i2]);
+    }
+}
+
+/**
+ * PMDを遮蔽物として登録する。
+ */
+void OcclusionBuffer_addPmd(OcclusionBuffer *buffer, const PmdFile *pmd, const mat4 world) {
+    const GLvoid *indices = pmd->index_type == GL_UNSIGNED_INT ? (const GLvoid*) pmd->indices32 : (const GLvoid*) pmd->indices;
+    OcclusionBuffer_addMesh(buffer, &pmd->vertices[0].position, sizeof(PmdVertex), pmd->vertices_num, indices, pmd->index_type, pmd->indices_num, world);
+}
+
+/**
+ * 三角形をタイルへ振り分ける
+ */
+static void OcclusionBuffer_binTriangles(OcclusionBuffer *buffer) {
+    const GLuint tiles_num = buffer->tiles_x * buffer->tiles_y;
+    GLuint i = 0;
+    GLint x = 0;
+    GLint y = 0;
+
+    // タイルごとの件数を数え、先頭位置を決める
+    memset(buffer->tile_offsets, 0x00, sizeof(GLuint) * (tiles_num + 1));
+    for (i = 0; i < buffer->triangles_num; ++i) {
+        const OcclusionTriangle *triangle = &buffer->triangles[i];
+        for (y = triangle->min_y / OCCLUSION_TILE_HEIGHT; y <= (triangle->max_y - 1) / OCCLUSION_TILE_HEIGHT; ++y) {
+            for (x = triangle->min_x / OCCLUSION_TILE_WIDTH; x <= (triangle->max_x - 1) / OCCLUSION_TILE_WIDTH; ++x) {
+                ++buffer->tile_offsets[y * buffer->tiles_x + x + 1];
+            }
+        }
+    }
+    for (i = 0; i < tiles_num; ++i) {
+        buffer->tile_offsets[i + 1] += buffer->tile_offsets[i];
+    }
+
+    if (buffer->tile_offsets[tiles_num] > buffer->tile_triangles_capacity) {
+        buffer->tile_triangles_capacity = buffer->tile_offsets[tiles_num];
+        buffer->tile_triangles = realloc(buffer->tile_triangles, sizeof(GLuint) * buffer->tile_triangles_capacity);
+    }
+
+    // 登録順を保ったまま格納する
+    for (i = 0; i < buffer->triangles_num; ++i) {
+        const OcclusionTriangle *triangle = &buffer->triangles[i];
+        for (y = triangle->min_y / OCCLUSION_TILE_HEIGHT; y <= (triangle->max_y - 1) / OCCLUSION_TILE_HEIGHT; ++y) {
+            for (x = triangle->min_x / OCCLUSION_TILE_WIDTH; x <= (triangle->max_x - 1) / OCCLUSION_TILE_WIDTH; ++x) {
+                buffer->tile_triangles[buffer->tile_offsets[y * buffer->tiles_x + x]++] = i;
+            }
+        }
+    }
+
+    // 格納で進めた先頭位置を戻す
+    for (i = tiles_num; i > 0; --i) {
+        buffer->tile_offsets[i] = buffer->tile_offsets[i - 1];
+    }
+    buffer->tile_offsets[0] = 0;
+}
+
+/**
+ * タイル[begin, end)をラスタライズする
+ */
+static void OcclusionBuffer_rasterizeTiles(void *userdata, const unsigned int begin, const unsigned int end) {
+    OcclusionBuffer *buffer = (OcclusionBuffer*) userdata;
+    const simd4f lane_offsets = simd4f_set(0.5f, 1.5f, 2.5f, 3.5f);
+    const simd4f zero = simd4f_splat(0);
+
+    unsigned int tile = 0;
+    for (tile = begin; tile < end; ++tile) {
+        GLfloat *depth = buffer->depth + tile * OCCLUSION_TILE_PIXELS;
+        const GLint origin_x = (tile % buffer->tiles_x) * OCCLUSION_TILE_WIDTH;
+        const GLint origin_y = (tile / buffer->tiles_x) * OCCLUSION_TILE_HEIGHT;
+        GLint x = 0;
+        GLint y = 0;
+        GLuint i = 0;
+        int k = 0;
+
+        // タイルを最も奥の深度で初期化する
+        {
+            const simd4f far = simd4f_splat(1.0f);
+            for (i = 0; i < OCCLUSION_TILE_PIXELS; i += 4) {
+                simd4f_store(depth + i, far);
+            }
+        }
+
+        for (i = buffer->tile_offsets[tile]; i < buffer->tile_offsets[tile + 1]; ++i) {
+            const OcclusionTriangle *triangle = &buffer->triangles[buffer->tile_triangles[i]];
+
+            // タイル内の範囲へ制限し、横方向は4ピクセル単位へ揃える
+            const GLint min_x = (triangle->min_x > origin_x ? triangle->min_x : origin_x) & ~3;
+            const GLint min_y = triangle->min_y > origin_y ? triangle->min_y : origin_y;
+            const GLint max_x = triangle->max_x < origin_x + OCCLUSION_TILE_WIDTH ? triangle->max_x : origin_x + OCCLUSION_TILE_WIDTH;
+            const GLint max_y = triangle->max_y < origin_y + OCCLUSION_TILE_HEIGHT ? triangle->max_y : origin_y + OCCLUSION_TILE_HEIGHT;
+
+            // 4ピクセル分の増分
+            simd4f edge_a[3];
+            simd4f edge_step[3];
+            for (k = 0; k < 3; ++k) {
+                edge_a[k] = simd4f_splat(triangle->edge_a[k]);
+                edge_step[k] = simd4f_splat(triangle->edge_a[k] * 4.0f);
+            }
+            const simd4f depth_step = simd4f_splat(triangle->depth_a * 4.0f);
+
+            for (y = min_y; y < max_y; ++y) {
+                const GLfloat py = (GLfloat) y + 0.5f;
+                const simd4f px = simd4f_add(simd4f_splat((GLfloat) min_x), lane_offsets);
+
+                // 行の先頭での値
+                simd4f edges[3];
+                for (k = 0; k < 3; ++k) {
+                    edges[k] = simd4f_madd(edge_a[k], px, simd4f_splat(triangle->edge_b[k] * py + triangle->edge_c[k]));
+                }
+                simd4f z = simd4f_madd(simd4f_splat(triangle->depth_a), px, simd4f_splat(triangle->depth_b * py + triangle->depth_c));
+
+                GLfloat *row = depth + (y - origin_y) * OCCLUSION_TILE_WIDTH - origin_x;
+                for (x = min_x; x < max_x; x += 4) {
+                    // 全ての辺関数が0以上なら三角形の内側
+                    const simd4f inside = simd4f_cmpge(simd4f_min(edges[0], simd4f_min(edges[1], edges[2])), zero);
+                    const simd4f old = simd4f_load(row + x);
+                    simd4f_store(row + x, simd4f_select(inside, simd4f_min(old, z), old));
+
+                    for (k = 0; k < 3; ++k) {
+                        edges[k] = simd4f_add(edges[k], edge_step[k]);
+                    }
+                    z = simd4f_add(z, depth_step);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * 深度ピラミッドを構築する
+ */
+static void OcclusionBuffer_buildLevels(OcclusionBuffer *buffer) {
+    GLint level = 0;
+    GLint x = 0;
+    GLint y = 0;
+
+    // 1段目は深度バッファから作る
+    {
+        GLfloat *dst = buffer->levels[0];
+        const GLint w = buffer->level_widths[0];
+        const GLint h = buffer->level_heights[0];
+        for (y = 0; y < h; ++y) {
+            for (x = 0; x < w; ++x) {
+                const GLint sx = x * 2;
+                const GLint sy = y * 2;
+                dst[y * w + x] = fmaxf( //
+                        fmaxf(OcclusionBuffer_depthAt(buffer, sx, sy), OcclusionBuffer_depthAt(buffer, sx + 1, sy)), //
+                        fmaxf(OcclusionBuffer_depthAt(buffer, sx, sy + 1), OcclusionBuffer_depthAt(buffer, sx + 1, sy + 1)));
+            }
+        }
+    }
+
+    // 2段目以降は前の段から作る
+    // 端数がある場合は範囲内の値だけを使う
+    for (level = 1; level < buffer->levels_num; ++level) {
+        const GLfloat *src = buffer->levels[level - 1];
+        const GLint src_w = buffer->level_widths[level - 1];
+        const GLint src_h = buffer->level_heights[level - 1];
+        GLfloat *dst = buffer->levels[level];
+        const GLint w = buffer->level_widths[level];
+        const GLint h = buffer->level_heights[level];
+
+        for (y = 0; y < h; ++y) {
+            const GLint sy0 = y * 2;
+            const GLint sy1 = sy0 + 1 < src_h ? sy0 + 1 : sy0;
+            for (x = 0; x < w; ++x) {
+                const GLint sx0 = x * 2;
+                const GLint sx1 = sx0 + 1 < src_w ? sx0 + 1 : sx0;
+                dst[y * w + x] = fmaxf( //
+                        fmaxf(src[sy0 * src_w + sx0], src[sy0 * src_w + sx1]), //
+                        fmaxf(src[sy1 * src_w + sx0], src[sy1 * src_w + sx1]));
+            }
+        }
+    }
+}
+
+/**
+ * 登録された遮蔽物をラスタライズし、深度ピラミッドを構築する。
+ */
+void OcclusionBuffer_rasterize(OcclusionBuffer *buffer, ThreadPool *pool) {
+    OcclusionBuffer_binTriangles(buffer);
+
+    // タイルは互いに独立しているため、排他制御なしで並列に処理できる
+    ThreadPool_parallelFor(pool, buffer->tiles_x * buffer->tiles_y, 1, OcclusionBuffer_rasterizeTiles, buffer);
+
+    OcclusionBuffer_buildLevels(buffer);
+}
+
+/**
+ * ワールド座標系のAABBが遮蔽物に隠れていなければtrueを返す。
+ */
+bool OcclusionBuffer_testAABB(const OcclusionBuffer *buffer, const vec3 aabb_min, const vec3 aabb_max) {
+    const mat4 *m = &buffer->view_projection;
+    GLfloat min_x = (GLfloat) buffer->width;
+    GLfloat min_y = (GLfloat) buffer->height;
+    GLfloat max_x = 0;
+    GLfloat max_y = 0;
+    GLfloat min_z = 1.0f;
+
+    // 8頂点を画面へ投影し、矩形と最も手前の深度を求める
+    int i = 0;
+    for (i = 0; i < 8; ++i) {
+        const GLfloat x = (i & 0x1) ? aabb_max.x : aabb_min.x;
+        const GLfloat y = (i & 0x2) ? aabb_max.y : aabb_min.y;
+        const GLfloat z = (i & 0x4) ? aabb_max.z : aabb_min.z;
+
+        const GLfloat cw = m->m[0][3] * x + m->m[1][3] * y + m->m[2][3] * z + m->m[3][3];
+        if (cw < OCCLUSION_W_MIN) {
+            // 視点の手前にはみ出している
+            return true;
+        }
+        const GLfloat inv_w = 1.0f / cw;
+        const GLfloat sx = ((m->m[0][0] * x + m->m[1][0] * y + m->m[2][0] * z + m->m[3][0]) * inv_w + 1.0f) * 0.5f * (GLfloat) buffer->width;
+        const GLfloat sy = ((m->m[0][1] * x + m->m[1][1] * y + m->m[2][1] * z + m->m[3][1]) * inv_w + 1.0f) * 0.5f * (GLfloat) buffer->height;
+        const GLfloat sz = (m->m[0][2] * x + m->m[1][2] * y + m->m[2][2] * z + m->m[3][2]) * inv_w * 0.5f + 0.5f;
+
+        min_x = fminf(min_x, sx);
+        min_y = fminf(min_y, sy);
+        max_x = fmaxf(max_x, sx);
+        max_y = fmaxf(max_y, sy);
+        min_z = fminf(min_z, sz);
+    }
+
+    // 画面内の範囲へ制限する
+    const GLint x0 = (GLint) fmaxf(floorf(min_x), 0.0f);
+    const GLint y0 = (GLint) fmaxf(floorf(min_y), 0.0f);
+    const GLint x1 = (GLint) fminf(ceilf(max_x), (GLfloat) buffer->width);
+    const GLint y1 = (GLint) fminf(ceilf(max_y), (GLfloat) buffer->height);
+    if (x0 >= x1 || y0 >= y1) {
+        // 画面外
+        return false;
+    }
+
+    // 矩形が数ピクセルに収まる段を選ぶ
+    const GLint size = (x1 - x0) > (y1 - y0) ? (x1 - x0) : (y1 - y0);
+    GLint level = 0;
+    while (level < buffer->levels_num && (size >> level) > 4) {
+        ++level;
+    }
+
+    GLint x = 0;
+    GLint y = 0;
+    for (y = y0 >> level; y <= (y1 - 1) >> level; ++y) {
+        for (x = x0 >> level; x <= (x1 - 1) >> level; ++x) {
+            // levelが0なら深度バッファ、それ以外はピラミッドの(level - 1)段目を参照する
+            const GLfloat depth = level ? buffer->levels[level - 1][y * buffer->level_widths[level - 1] + x] : OcclusionBuffer_depthAt(buffer, x, y);
+            if (min_z <= depth) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * オクルージョンバッファを解放する
+ */
+void OcclusionBuffer_free(OcclusionBuffer *buffer) {
+    if (!buffer) {
+        return;
+    }
+
+    int i = 0;
+    for (i = 0; i < buffer->levels_num; ++i) {
+        free(buffer->levels[i]);
+    }
+    util_alignedFree(buffer->depth);
+    free(buffer->triangles);
+    free(buffer->tile_triangles);
+    free(buffer->tile_offsets);
+    free(buffer->clip_positions);
+    free(buffer);
+}
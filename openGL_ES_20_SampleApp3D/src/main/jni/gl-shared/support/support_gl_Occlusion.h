@@ -0,0 +1,155 @@
+/*
+ * support_gl_Occlusion.h
+ *
+ * CPUによるソフトウェアオクルージョンカリング
+ * 遮蔽物として指定したメッシュを低解像度の深度バッファへラスタライズし、
+ * 階層化した深度(Hierarchical Z)とAABBを比較して描画前に遮蔽を判定する。
+ * オクルージョンクエリを持たないOpenGL ES 2.0でも動作する。
+ */
+
+#ifndef SUPPORT_GL_OCCLUSION_H_
+#define SUPPORT_GL_OCCLUSION_H_
+
+/**
+ * タイルの大きさ（ピクセル数）
+ * タイル単位でスレッドへ分配する
+ */
+#define OCCLUSION_TILE_WIDTH    32
+#define OCCLUSION_TILE_HEIGHT   32
+
+/**
+ * 深度ピラミッドの最大段数
+ */
+#define OCCLUSION_LEVELS_MAX    8
+
+/**
+ * セットアップ済みの遮蔽物三角形
+ */
+typedef struct OcclusionTriangle {
+    /**
+     * 辺関数 a * x + b * y + c の係数
+     * 三角形の内側で全ての辺関数が0以上となる
+     */
+    GLfloat edge_a[3];
+    GLfloat edge_b[3];
+    GLfloat edge_c[3];
+
+    /**
+     * 深度の平面方程式 a * x + b * y + c の係数
+     */
+    GLfloat depth_a;
+    GLfloat depth_b;
+    GLfloat depth_c;
+
+    /**
+     * 画面上の範囲（ピクセル）
+     * [min, max)
+     */
+    GLint min_x;
+    GLint min_y;
+    GLint max_x;
+    GLint max_y;
+} OcclusionTriangle;
+
+/**
+ * オクルージョンバッファ
+ */
+typedef struct OcclusionBuffer {
+    /**
+     * 深度バッファの大きさ
+     * タイルの大きさの倍数に揃えられる
+     */
+    GLint width;
+    GLint height;
+
+    /**
+     * 縦横のタイル数
+     */
+    GLint tiles_x;
+    GLint tiles_y;
+
+    /**
+     * 深度バッファ
+     * タイルごとに連続したメモリへ配置される。手前ほど小さい値となり、1.0で初期化される。
+     */
+    GLfloat *depth;
+
+    /**
+     * 深度ピラミッド
+     * levels[0]は深度バッファの半分の解像度で、上の段ほど半分になる。
+     * 各要素は対応する範囲の最も奥の深度を保持する。
+     */
+    GLfloat *levels[OCCLUSION_LEVELS_MAX];
+    GLint level_widths[OCCLUSION_LEVELS_MAX];
+    GLint level_heights[OCCLUSION_LEVELS_MAX];
+    GLint levels_num;
+
+    /**
+     * 射影行列 × 視点変換行列
+     */
+    mat4 view_projection;
+
+    /**
+     * 登録された遮蔽物三角形
+     */
+    OcclusionTriangle *triangles;
+    GLuint triangles_num;
+    GLuint triangles_capacity;
+
+    /**
+     * タイルごとの三角形番号
+     * タイルiの三角形はtile_triangles[tile_offsets[i]]からtile_offsets[i + 1]までとなる
+     */
+    GLuint *tile_triangles;
+    GLuint *tile_offsets;
+    GLuint tile_triangles_capacity;
+
+    /**
+     * 頂点変換の作業領域
+     */
+    vec4 *clip_positions;
+    GLuint clip_positions_capacity;
+} OcclusionBuffer;
+
+/**
+ * オクルージョンバッファを生成する。
+ * 大きさはタイルの倍数へ切り上げられる。
+ */
+extern OcclusionBuffer* OcclusionBuffer_create(const GLint width, const GLint height);
+
+/**
+ * 遮蔽物の登録を開始する。
+ * 前回登録した遮蔽物は破棄される。
+ */
+extern void OcclusionBuffer_begin(OcclusionBuffer *buffer, const mat4 view_projection);
+
+/**
+ * 三角形リストを遮蔽物として登録する。
+ * index_typeはGL_UNSIGNED_SHORTかGL_UNSIGNED_INTを指定する。
+ * 視点より手前へはみ出した三角形は遮蔽物として扱わない。
+ */
+extern void OcclusionBuffer_addMesh(OcclusionBuffer *buffer, const vec3 *positions, const GLsizei stride, const GLuint vertices_num, const GLvoid *indices, const GLenum index_type, const GLuint indices_num, const mat4 world);
+
+/**
+ * PMDを遮蔽物として登録する。
+ */
+extern void OcclusionBuffer_addPmd(OcclusionBuffer *buffer, const PmdFile *pmd, const mat4 world);
+
+/**
+ * 登録された遮蔽物をラスタライズし、深度ピラミッドを構築する。
+ * poolがNULLでない場合、タイル単位で複数スレッドへ分割する。
+ */
+extern void OcclusionBuffer_rasterize(OcclusionBuffer *buffer, ThreadPool *pool);
+
+/**
+ * ワールド座標系のAABBが遮蔽物に隠れていなければtrueを返す。
+ * 視点より手前へはみ出したAABBは常にtrue、画面外のAABBはfalseとなる。
+ */
+extern bool OcclusionBuffer_testAABB(const OcclusionBuffer *buffer, const vec3 aabb_min, const vec3 aabb_max);
+
+/**
+ * オクルージョンバッファを解放する
+ */
+extern void OcclusionBuffer_free(OcclusionBuffer *buffer);
+
+#endif /* SUPPORT_GL_OCCLUSION_H_ */
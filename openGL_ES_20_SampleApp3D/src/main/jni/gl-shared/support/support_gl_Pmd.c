@@ -30,6 +30,16 @@
  */
 #define PMDFILE_BONE_NAME_LENGTH 20
 
+/**
+ * 表情名
+ */
+#define PMDFILE_MORPH_NAME_LENGTH 20
+
+/**
+ * 描画ループで参照する配列のアライメント（キャッシュライン）
+ */
+#define PMDFILE_HOT_ALIGNMENT 64
+
 /**
  * ヘッダファイルを読み込む
  */
@@ -68,6 +78,52 @@ static bool PmdFile_loadHeader(PmdHeader *result, RawData *data) {
     return true;
 }
 
+/**
+ * 材質情報から描画ループで参照する配列を構築する
+ */
+void PmdFile_buildMaterialArrays(PmdFile *pmd) {
+    const GLuint numMaterials = pmd->materials_num;
+
+    // 描画ループで参照する情報を連続した領域へ配置する
+    // diffuse_colors -> draw_ranges -> diffuse_texturesの順に1ブロックで確保する
+    const size_t colorsBytes = sizeof(vec4) * numMaterials;
+    const size_t rangesBytes = sizeof(PmdDrawRange) * numMaterials;
+    const size_t texturesBytes = sizeof(Texture*) * numMaterials;
+
+    uint8_t *block = MemoryArena_allocAligned(pmd->arena, colorsBytes + rangesBytes + texturesBytes, PMDFILE_HOT_ALIGNMENT);
+    pmd->diffuse_colors = (vec4*) block;
+    pmd->draw_ranges = (PmdDrawRange*) (block + colorsBytes);
+    pmd->diffuse_textures = (Texture**) (block + colorsBytes + rangesBytes);
+
+    GLuint beginIndicesIndex = 0;
+    int i = 0;
+    for (i = 0; i < numMaterials; ++i) {
+        pmd->diffuse_colors[i] = pmd->materials[i].diffuse;
+        pmd->draw_ranges[i].indices_begin = beginIndicesIndex;
+        pmd->draw_ranges[i].indices_num = pmd->materials[i].indices_num;
+        pmd->diffuse_textures[i] = NULL;
+
+        beginIndicesIndex += pmd->materials[i].indices_num;
+    }
+}
+
+/**
+ * ボーン情報から連続配置した配列を構築する
+ */
+void PmdFile_buildBoneArrays(PmdFile *pmd) {
+    const GLuint numBones = pmd->bones_num;
+
+    // 親子関係と位置は連続した配列にも配置する
+    pmd->bone_parents = MemoryArena_alloc(pmd->arena, sizeof(GLshort) * numBones);
+    pmd->bone_positions = MemoryArena_alloc(pmd->arena, sizeof(vec3) * numBones);
+
+    int i = 0;
+    for (i = 0; i < numBones; ++i) {
+        pmd->bone_parents[i] = pmd->bones[i].parent_bone_index;
+        pmd->bone_positions[i] = pmd->bones[i].position;
+    }
+}
+
 /**
  * 頂点情報を取得する
  */
@@ -78,20 +134,25 @@ static void PmdFile_loadVertices(PmdFile *result, RawData *data) {
 
     // 頂点領域を確保
     result->vertices = malloc(sizeof(PmdVertex) * numVertices);
+    result->vertices_extra = malloc(sizeof(PmdVertexExtra) * numVertices);
     result->vertices_num = numVertices;
 
     // 頂点数分読み込む
     int i = 0;
     for (i = 0; i < numVertices; ++i) {
         PmdVertex *v = &result->vertices[i];
+        PmdVertexExtra *extra = &result->vertices_extra[i];
 
         // 頂点情報ロード
         RawData_readBytes(data, &v->position, sizeof(vec3)); // 位置
         RawData_readBytes(data, &v->normal, sizeof(vec3)); // 法線
         RawData_readBytes(data, &v->uv, sizeof(vec2)); // UV
-        RawData_readBytes(data, &v->extra.bone_num, sizeof(GLushort) * 2); // ボーン設定
-        RawData_readBytes(data, &v->extra.bone_weight, sizeof(GLbyte)); // ボーン重み
-        RawData_readBytes(data, &v->extra.edge_flag, sizeof(GLbyte)); // 輪郭フラグ
+        RawData_readBytes(data, &extra->bone_num, sizeof(GLushort) * 2); // ボーン設定
+        RawData_readBytes(data, &extra->bone_weight, sizeof(GLbyte)); // ボーン重み
+        RawData_readBytes(data, &extra->edge_flag, sizeof(GLbyte)); // 輪郭フラグ
+#if SUPPORT_PMD_VERTEX_EXTRA
+        v->extra = *extra; // 互換用
+#endif
 
 //        __logf("v[%d] p(%f, %f, %f), u(%f, %f)", i, v->position.x, v->position.y, v->position.z, v->uv.x, v->uv.y);
     }
@@ -106,8 +167,10 @@ static void PmdFile_loadIndices(PmdFile *result, RawData *data) {
     __logf("indices[%d]", numIndices);
 
     // インデックス領域を確保
-    result->indices = malloc(sizeof(GLuint) * numIndices);
+    // PMDのインデックスは常に16bitで格納されている
+    result->indices = malloc(sizeof(GLushort) * numIndices);
     result->indices_num = numIndices;
+    result->index_type = GL_UNSIGNED_SHORT;
 
     // インデックス読み込み
     RawData_readBytes(data, result->indices, sizeof(GLushort) * numIndices);
@@ -129,7 +192,7 @@ static void PmdFile_loadMaterial(PmdFile *result, RawData *data) {
     const GLuint numMaterials = RawData_readLE32(data);
 
     // マテリアル領域を確保
-    result->materials = malloc(sizeof(PmdMaterial) * numMaterials);
+    result->materials = MemoryArena_alloc(result->arena, sizeof(PmdMaterial) * numMaterials);
     result->materials_num = numMaterials;
 
     __logf("materials[%d]", numMaterials);
@@ -177,13 +240,15 @@ static void PmdFile_loadMaterial(PmdFile *result, RawData *data) {
 
     __logf("sum vert(%d) -> num(%d)", sumVert, result->indices_num);
     assert(sumVert == result->indices_num);
+
+    PmdFile_buildMaterialArrays(result);
 }
 
 static void PmdFile_loadBone(PmdFile *result, RawData *data) {
     const GLuint numBones = RawData_readLE16(data);
 
     // ボーン領域を確保
-    result->bones = malloc(sizeof(PmdBone) * numBones);
+    result->bones = MemoryArena_alloc(result->arena, sizeof(PmdBone) * numBones);
     result->bones_num = numBones;
     __logf("bones[%d]", numBones);
 
@@ -204,13 +269,97 @@ static void PmdFile_loadBone(PmdFile *result, RawData *data) {
 
 //        __logf("bone[%d] name(%s)", i, bone->name);
     }
+
+    PmdFile_buildBoneArrays(result);
+}
+
+/**
+ * IK情報を読み飛ばす
+ * サンプルではベイク済みもしくは手動制御を前提とするため保持しない
+ */
+static void PmdFile_skipIk(PmdFile *result, RawData *data) {
+    const GLuint numIk = RawData_readLE16(data);
+    __logf("ik[%d]", numIk);
+
+    int i;
+    for (i = 0; i < numIk; ++i) {
+        // IKボーン番号(2) + ターゲットボーン番号(2)
+        RawData_offsetHeader(data, sizeof(GLushort) * 2);
+        // 影響ボーン数
+        const GLuint chainLength = (GLubyte) RawData_read8(data);
+        // 再帰回数(2) + 制限角度(4) + 影響ボーン番号配列
+        RawData_offsetHeader(data, sizeof(GLushort) + sizeof(GLfloat) + sizeof(GLushort) * chainLength);
+    }
+}
+
+/**
+ * 表情情報を取得する
+ */
+static void PmdFile_loadMorph(PmdFile *result, RawData *data) {
+    const GLuint numMorphs = (GLushort) RawData_readLE16(data);
+    __logf("morphs[%d]", numMorphs);
+
+    if (!numMorphs) {
+        return;
+    }
+
+    // 表情領域を確保
+    result->morphs = MemoryArena_calloc(result->arena, numMorphs, sizeof(PmdMorph));
+    result->morphs_num = numMorphs;
+
+    int i;
+    for (i = 0; i < numMorphs; ++i) {
+        PmdMorph *morph = &result->morphs[i];
+
+        RawData_readBytes(data, morph->name, PMDFILE_MORPH_NAME_LENGTH);
+        // SJISで文字列が格納されているため、UTF-8に変換をかける
+        ES20_sjis2utf8(morph->name, sizeof(morph->name));
+
+        morph->vertices_num = RawData_readLE32(data);
+        morph->type = RawData_read8(data);
+
+        morph->indices = MemoryArena_alloc(result->arena, sizeof(GLuint) * morph->vertices_num);
+        morph->offsets = MemoryArena_alloc(result->arena, sizeof(vec3) * morph->vertices_num);
+
+        int k;
+        for (k = 0; k < morph->vertices_num; ++k) {
+            morph->indices[k] = RawData_readLE32(data);
+            RawData_readBytes(data, &morph->offsets[k], sizeof(vec3));
+        }
+    }
+
+    // base以外の頂点番号はbase表情内の番号で格納されているため、頂点番号へ解決する
+    {
+        const PmdMorph *base = &result->morphs[0];
+        assert(base->type == PMDMORPH_TYPE_BASE);
+
+        for (i = 1; i < numMorphs; ++i) {
+            PmdMorph *morph = &result->morphs[i];
+            int k;
+            for (k = 0; k < morph->vertices_num; ++k) {
+                assert(morph->indices[k] < base->vertices_num);
+                morph->indices[k] = base->indices[morph->indices[k]];
+            }
+        }
+
+        // 整合性チェック
+        for (i = 0; i < base->vertices_num; ++i) {
+            assert(base->indices[i] < result->vertices_num);
+        }
+    }
 }
 
 /**
  * PMDファイルを生成する
  */
 PmdFile* PmdFile_create(RawData *data) {
+    // PMXファイルであればPMXとして読み込む
+    if (PmxFile_isPmx(data)) {
+        return PmxFile_create(data);
+    }
+
     PmdFile *result = calloc(1, sizeof(PmdFile));
+    result->arena = MemoryArena_create(PMDFILE_ARENA_BLOCK_SIZE);
 
     // ファイルヘッダを読み込む
     if (!PmdFile_loadHeader(&result->header, data)) {
@@ -227,6 +376,13 @@ PmdFile* PmdFile_create(RawData *data) {
     PmdFile_loadMaterial(result, data);
     // ボーン情報を読み込み
     PmdFile_loadBone(result, data);
+    // IK情報を読み飛ばす
+    PmdFile_skipIk(result, data);
+    // 表情情報を読み込み
+    PmdFile_loadMorph(result, data);
+
+    // 境界ボリュームを計算する
+    PmdFile_calcBounds(result);
 
     return result;
 }
@@ -240,7 +396,11 @@ PmdFile* PmdFile_load(GLApplication *app, const char* file_name) {
         return NULL;
     }
 
+    const double startTime = util_getTime();
     PmdFile* result = PmdFile_create(data);
+    const double elapsed = util_getTime() - startTime;
+
+    __logf("%s decode %.3f ms (%.1f MB/s)", file_name, elapsed * 1000.0, elapsed > 0 ? ((double) RawData_getLength(data) / (1024.0 * 1024.0)) / elapsed : 0.0);
 
     RawData_freeFile(app, data);
 
@@ -256,19 +416,60 @@ void PmdFile_free(PmdFile *pmd) {
     }
 
     free(pmd->vertices);
+    free(pmd->vertices_extra);
     free(pmd->indices);
-    free(pmd->materials);
-    free(pmd->bones);
+    free(pmd->indices32);
+    free(pmd->material_bounds);
+    // 材質・描画用配列・ボーン・表情はまとめて解放する
+    MemoryArena_free(pmd->arena);
     free(pmd);
 }
 
+/**
+ * 指定位置の頂点インデックスを取得する。
+ */
+GLuint PmdFile_getIndex(PmdFile *pmd, const GLuint index) {
+    assert(index < pmd->indices_num);
+    if (pmd->index_type == GL_UNSIGNED_INT) {
+        return pmd->indices32[index];
+    } else {
+        return pmd->indices[index];
+    }
+}
+
+/**
+ * 頂点インデックス1つのbyte数を取得する。
+ */
+GLsizeiptr PmdFile_getIndexSize(const PmdFile *pmd) {
+    return pmd->index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+}
+
+/**
+ * 指定位置からの頂点インデックス配列を取得する。
+ */
+const GLvoid* PmdFile_getIndices(const PmdFile *pmd, const GLuint index) {
+    assert(index <= pmd->indices_num);
+    if (pmd->index_type == GL_UNSIGNED_INT) {
+        return pmd->indices32 + index;
+    } else {
+        return pmd->indices + index;
+    }
+}
+
+/**
+ * 現在のコンテキストでindex_typeのままglDrawElementsが行えるかを確認する。
+ */
+bool PmdFile_isIndexTypeSupported(const PmdFile *pmd) {
+    if (pmd->index_type == GL_UNSIGNED_SHORT) {
+        return true;
+    }
+    return ES20_hasExtension("GL_OES_element_index_uint");
+}
+
 /**
  * 最小最大地点を求める
  */
 void PmdFile_calcAABB(PmdFile *pmd, vec3 *minPoint, vec3 *maxPoint) {
-    *minPoint = vec3_create(10000, 10000, 10000);
-    *maxPoint = vec3_create(-10000, -10000, -10000);
-
     if (!pmd) {
         // PMDが無いため、適当な位置を指定する
         *minPoint = vec3_create(-10, -10, -10);
@@ -276,16 +477,22 @@ void PmdFile_calcAABB(PmdFile *pmd, vec3 *minPoint, vec3 *maxPoint) {
         return;
     }
 
+    *minPoint = pmd->bounds.aabb_min;
+    *maxPoint = pmd->bounds.aabb_max;
+}
+
+/**
+ * 指定した名前の表情番号を取得する。
+ * 見つからない場合は-1を返す。
+ */
+int PmdFile_findMorph(PmdFile *pmd, const GLchar *name) {
     int i = 0;
-    for (i = 0; i < pmd->vertices_num; ++i) {
-        minPoint->x = (GLfloat) fmin(minPoint->x, pmd->vertices[i].position.x);
-        minPoint->y = (GLfloat) fmin(minPoint->y, pmd->vertices[i].position.y);
-        minPoint->z = (GLfloat) fmin(minPoint->z, pmd->vertices[i].position.z);
-
-        maxPoint->x = (GLfloat) fmax(maxPoint->x, pmd->vertices[i].position.x);
-        maxPoint->y = (GLfloat) fmax(maxPoint->y, pmd->vertices[i].position.y);
-        maxPoint->z = (GLfloat) fmax(maxPoint->z, pmd->vertices[i].position.z);
+    for (i = 0; i < pmd->morphs_num; ++i) {
+        if (strcmp(pmd->morphs[i].name, name) == 0) {
+            return i;
+        }
     }
+    return -1;
 }
 
 /**
@@ -294,8 +501,23 @@ void PmdFile_calcAABB(PmdFile *pmd, vec3 *minPoint, vec3 *maxPoint) {
 PmdTextureList* PmdFile_createTextureList(GLApplication *app, PmdFile *pmd) {
     PmdTextureList *result = calloc(1, sizeof(PmdTextureList));
 
+    // テクスチャ数は材質数を超えないため、配列は最初に1度だけ確保する
+    // 名前の領域は実際の文字列長から見積もり、ブロックが追加されないようにする
+    const GLuint capacity = pmd->materials_num ? pmd->materials_num : 1;
+    size_t arena_size = capacity * (sizeof(Texture*) + sizeof(GLchar*)) + MEMORYARENA_ALIGNMENT * 2;
+    {
+        int i;
+        for (i = 0; i < pmd->materials_num; ++i) {
+            arena_size += strlen(pmd->materials[i].diffuse_texture_name) + 1;
+        }
+    }
+    result->arena = MemoryArena_create(arena_size);
+    result->textures = MemoryArena_alloc(result->arena, sizeof(Texture*) * capacity);
+    result->texture_names = MemoryArena_alloc(result->arena, sizeof(GLchar*) * capacity);
+
     // 読み込み時の一時ファイル名
-    GLchar load_name[32] = { };
+    // テクスチャ名 + ".png"が収まるサイズを確保する
+    GLchar load_name[sizeof(((PmdMaterial*) NULL)->diffuse_texture_name) + 8] = { };
 
     // マテリアル数だけチェックする
     int i;
@@ -316,22 +538,12 @@ PmdTextureList* PmdFile_createTextureList(GLApplication *app, PmdFile *pmd) {
 
                 // テクスチャの読み込みに成功したら末尾へ登録する
                 if (t) {
-                    // メモリを確保する
-                    if (result->textures) {
-                        result->textures = realloc(result->textures, sizeof(Texture*) * result->textures_num + 1);
-                        result->texture_names = realloc(result->texture_names, sizeof(GLchar*) * result->textures_num + 1);
-                    } else {
-                        result->textures = malloc(sizeof(Texture*));
-                        result->texture_names = malloc(sizeof(GLchar*));
-                    }
-
                     const int index = result->textures_num;
                     result->textures_num++;
 
                     result->textures[index] = t;
-                    result->texture_names[index] = malloc(strlen(material->diffuse_texture_name) + 1);
                     // ファイル名をコピーする
-                    strcpy(result->texture_names[index], material->diffuse_texture_name);
+                    result->texture_names[index] = MemoryArena_strdup(result->arena, material->diffuse_texture_name);
                 }else {
                     __logf("Texture load fail(%s)", material->diffuse_texture_name);
                 }
@@ -362,6 +574,24 @@ Texture* PmdFile_getTexture(PmdTextureList *texList, const GLchar *name) {
     return NULL;
 }
 
+/**
+ * 材質ごとのテクスチャをPmdFile.diffuse_texturesへ解決する。
+ */
+void PmdFile_bindTextureList(PmdFile *pmd, PmdTextureList *texList) {
+    int i = 0;
+    for (i = 0; i < pmd->materials_num; ++i) {
+        pmd->diffuse_textures[i] = PmdFile_getTexture(texList, pmd->materials[i].diffuse_texture_name);
+    }
+}
+
+/**
+ * 描画で利用しない頂点情報を取得する
+ */
+PmdVertexExtra* PmdFile_getVertexExtra(PmdFile *pmd, const GLuint vertex_index) {
+    assert(vertex_index < pmd->vertices_num);
+    return &pmd->vertices_extra[vertex_index];
+}
+
 /**
  * 管理しているテクスチャを解放する
  */
@@ -374,13 +604,11 @@ void PmdFile_freeTextureList(PmdTextureList* texList) {
     {
         int i = 0;
         for (i = 0; i < texList->textures_num; ++i) {
-            free(texList->texture_names[i]);
             Texture_free(texList->textures[i]);
         }
 
-        // 配列をクリアする
-        free(texList->texture_names);
-        free(texList->textures);
+        // 名前と配列をまとめて解放する
+        MemoryArena_free(texList->arena);
     }
     free(texList);
 }
@@ -8,6 +8,12 @@
 #ifndef SUPPORT_GL_PMD_H_
 #define SUPPORT_GL_PMD_H_
 
+/**
+ * PmdFile.arenaのブロックサイズ
+ * 材質・ボーン・表情の合計が収まらない場合は追加のブロックを確保する
+ */
+#define PMDFILE_ARENA_BLOCK_SIZE (64 * 1024)
+
 /**
  * PMDファイルのヘッダ情報
  */
@@ -28,8 +34,43 @@ typedef struct PmdHeader {
     GLchar comment[256 + 128];
 } PmdHeader;
 
+/**
+ * PmdVertexへPmdVertexExtraを含める場合は1で定義する
+ * 頂点の転送量が増えるため、PmdVertex.extraを参照する既存コードの移行用に限って利用する。
+ */
+#ifndef SUPPORT_PMD_VERTEX_EXTRA
+#define SUPPORT_PMD_VERTEX_EXTRA    0
+#endif
+
+/**
+ * サンプルでは使用しないが、PMDファイル仕様的に含まれている頂点情報
+ */
+typedef struct PmdVertexExtra {
+
+    /**
+     * 関連付けられたボーン番号
+     */
+    GLshort bone_num[2];
+
+    /**
+     * ボーンの重み情報（最大100）
+     * bone_num[0]の影響度がbone_weight、bone_num[1]の影響度が100 - bone_weightで表される
+     */
+    GLbyte bone_weight;
+
+    /**
+     * エッジ表示フラグ
+     * 0=有効
+     * 1=無効
+     */
+    GLbyte edge_flag;
+} PmdVertexExtra;
+
 /**
  * PMDファイルが格納する頂点情報
+ * 描画に必要な情報だけを持ち、32byte/頂点で詰めて配置される。
+ * 描画で利用しない情報はPmdVertexExtraとして別配列に保持する。
+ * SUPPORT_PMD_VERTEX_EXTRAを1で定義した場合は、従来通りextraも保持する（40byte/頂点）。
  */
 typedef struct PmdVertex {
     /**
@@ -47,33 +88,59 @@ typedef struct PmdVertex {
      */
     vec3 normal;
 
+#if SUPPORT_PMD_VERTEX_EXTRA
     /**
-     * サンプルでは使用しないが、PMDファイル仕様的に含まれている情報
+     * 従来のコードとの互換用
+     * 読み込み時にPmdFile.vertices_extraと同じ値を格納する。書き換えてもvertices_extraへは反映されない。
      */
-    struct {
+    PmdVertexExtra extra;
+#endif
+} PmdVertex;
 
-        /**
-         * 関連付けられたボーン番号
-         */
-        GLshort bone_num[2];
+/**
+ * 材質の描画範囲
+ */
+typedef struct PmdDrawRange {
+    /**
+     * 描画を開始するインデックス位置
+     */
+    GLuint indices_begin;
 
-        /**
-         * ボーンの重み情報（最大100）
-         * bone_num[0]の影響度がbone_weight、bone_num[1]の影響度が100 - bone_weightで表される
-         */
-        GLbyte bone_weight;
+    /**
+     * 描画するインデックス数
+     */
+    GLuint indices_num;
+} PmdDrawRange;
 
-        /**
-         * エッジ表示フラグ
-         * 0=無効
-         * 1=有効
-         */
-        GLbyte edge_flag;
-    } extra;
-} PmdVertex;
+/**
+ * 境界ボリューム
+ */
+typedef struct PmdBounds {
+    /**
+     * AABBの最小位置
+     */
+    vec3 aabb_min;
+
+    /**
+     * AABBの最大位置
+     */
+    vec3 aabb_max;
+
+    /**
+     * 境界球の中心（AABBの中心）
+     */
+    vec3 sphere_center;
+
+    /**
+     * 境界球の半径
+     */
+    GLfloat sphere_radius;
+} PmdBounds;
 
 /**
  * PMD材質情報
+ * 描画ループではPmdFile.draw_ranges / diffuse_colors / diffuse_texturesを参照する。
+ * diffuse / indices_numは互換性のために残している。
  */
 typedef struct PmdMaterial {
     /**
@@ -88,6 +155,7 @@ typedef struct PmdMaterial {
 
     /**
      * テクスチャファイル名
+     * PMXのパスが収まらない場合は文字単位で切り詰められる。
      */
     GLchar diffuse_texture_name[20 + 12];
 
@@ -98,6 +166,8 @@ typedef struct PmdMaterial {
 
         /**
          * 輪郭フラグ
+         * 0=輪郭を描画しない
+         * 1=輪郭を描画する
          */
         GLbyte edge_flag;
 
@@ -171,6 +241,50 @@ typedef struct PmdBone {
     } extra;
 } PmdBone;
 
+/**
+ * 表情の種類
+ * 基準表情
+ */
+#define PMDMORPH_TYPE_BASE  0
+
+/**
+ * 表情（モーフ）情報
+ * 影響する頂点だけを疎な配列として保持する。
+ */
+typedef struct PmdMorph {
+    /**
+     * 表情名
+     */
+    GLchar name[20 + 12];
+
+    /**
+     * 表情の種類
+     * 0=base
+     * 1=眉
+     * 2=目
+     * 3=リップ
+     * 4=その他
+     */
+    GLbyte type;
+
+    /**
+     * 影響する頂点数
+     */
+    GLuint vertices_num;
+
+    /**
+     * 影響する頂点番号
+     * 読み込み時にPmdFile.verticesのインデックスへ解決済み
+     */
+    GLuint *indices;
+
+    /**
+     * 頂点位置の差分
+     * baseの場合は基準位置が格納される
+     */
+    vec3 *offsets;
+} PmdMorph;
+
 /**
  * PMDファイルコンテナ
  */
@@ -185,6 +299,12 @@ typedef struct PmdFile {
      */
     PmdVertex *vertices;
 
+    /**
+     * 描画で利用しない頂点情報配列
+     * verticesと同じ並び順で格納される
+     */
+    PmdVertexExtra *vertices_extra;
+
     /**
      * 頂点数
      */
@@ -192,9 +312,22 @@ typedef struct PmdFile {
 
     /**
      * 頂点インデックス
+     * index_typeがGL_UNSIGNED_INTの場合はNULLとなる
      */
     GLushort *indices;
 
+    /**
+     * 32bit頂点インデックス
+     * 65536頂点を超えるモデルの場合に利用され、index_typeがGL_UNSIGNED_INTとなる
+     */
+    GLuint *indices32;
+
+    /**
+     * 頂点インデックスの型
+     * GL_UNSIGNED_SHORT / GL_UNSIGNED_INT
+     */
+    GLenum index_type;
+
     /**
      * 頂点インデックス数
      */
@@ -210,6 +343,35 @@ typedef struct PmdFile {
      */
     GLuint materials_num;
 
+    /**
+     * 材質ごとの描画範囲
+     * 描画ループで参照する情報は材質ごとの配列として連続配置する
+     */
+    PmdDrawRange *draw_ranges;
+
+    /**
+     * 材質ごとの拡散反射光
+     */
+    vec4 *diffuse_colors;
+
+    /**
+     * 材質ごとのテクスチャ
+     * PmdFile_bindTextureList()で解決される。テクスチャが無い場合はNULL。
+     */
+    Texture **diffuse_textures;
+
+    /**
+     * 材質ごとの境界ボリューム
+     * 材質の描画範囲が参照する頂点から計算される
+     */
+    PmdBounds *material_bounds;
+
+    /**
+     * モデル全体の境界ボリューム
+     * 読み込み時に計算される。頂点を書き換えた場合はPmdFile_calcBounds()で再計算する。
+     */
+    PmdBounds bounds;
+
     /**
      * ボーン情報
      */
@@ -219,6 +381,36 @@ typedef struct PmdFile {
      * ボーン数
      */
     GLuint bones_num;
+
+    /**
+     * ボーンごとの親ボーン番号
+     * bones[n].parent_bone_indexと同じ値を連続配置したもの
+     */
+    GLshort *bone_parents;
+
+    /**
+     * ボーンごとの位置
+     * bones[n].positionと同じ値を連続配置したもの
+     */
+    vec3 *bone_positions;
+
+    /**
+     * 表情情報
+     * 先頭はbase表情になる
+     */
+    PmdMorph *morphs;
+
+    /**
+     * 表情数
+     */
+    GLuint morphs_num;
+
+    /**
+     * 読み込み時に確保する領域
+     * 材質・描画用配列・ボーン・表情はここから確保され、PmdFile_free()で一括して解放される。
+     * 頂点・インデックス・材質ごとの境界ボリュームは読み込み後に差し替えられるため、個別に確保する。
+     */
+    MemoryArena *arena;
 } PmdFile;
 
 /**
@@ -239,10 +431,16 @@ typedef struct PmdTextureList {
      * 管理しているテクスチャ数
      */
     int textures_num;
+
+    /**
+     * テクスチャ名と配列を確保する領域
+     */
+    MemoryArena *arena;
 } PmdTextureList;
 
 /**
  * PMDファイルを生成する
+ * PMXファイルが渡された場合はPmxFile_create()で読み込む。
  */
 extern PmdFile* PmdFile_create(RawData *data);
 
@@ -251,16 +449,60 @@ extern PmdFile* PmdFile_create(RawData *data);
  */
 extern PmdFile* PmdFile_load(GLApplication *app, const char* file_name);
 
+/**
+ * 材質情報から描画ループで参照する配列を構築する
+ * ローダーがPmdFile.materialsを読み込んだ後に呼び出す。
+ */
+extern void PmdFile_buildMaterialArrays(PmdFile *pmd);
+
+/**
+ * ボーン情報から連続配置した配列を構築する
+ * ローダーがPmdFile.bonesを読み込んだ後に呼び出す。
+ */
+extern void PmdFile_buildBoneArrays(PmdFile *pmd);
+
 /**
  * PMDファイルを解放する
  */
 extern void PmdFile_free(PmdFile *pmd);
 
+/**
+ * 指定位置の頂点インデックスを取得する。
+ * index_typeに関わらず利用できる。
+ */
+extern GLuint PmdFile_getIndex(PmdFile *pmd, const GLuint index);
+
+/**
+ * 頂点インデックス1つのbyte数を取得する。
+ * index_typeに応じてsizeof(GLushort) / sizeof(GLuint)となる。
+ */
+extern GLsizeiptr PmdFile_getIndexSize(const PmdFile *pmd);
+
+/**
+ * 指定位置からの頂点インデックス配列を取得する。
+ * glBufferData・glDrawElementsへそのまま渡せる。GL_UNSIGNED_INTの描画にはGL_OES_element_index_uintが必要となる。
+ */
+extern const GLvoid* PmdFile_getIndices(const PmdFile *pmd, const GLuint index);
+
+/**
+ * 現在のコンテキストでindex_typeのままglDrawElementsが行えるかを確認する。
+ * GL_UNSIGNED_INTはGL_OES_element_index_uintに対応している場合のみtrueを返す。
+ * 対応していない場合はPmdDrawMesh_create(pmd, false)で分割して描画する。
+ */
+extern bool PmdFile_isIndexTypeSupported(const PmdFile *pmd);
+
 /**
  * 最小最大地点を求める
+ * 読み込み時に計算済みのPmdFile.boundsを返す。
  */
 extern void PmdFile_calcAABB(PmdFile *pmd, vec3 *minPoint, vec3 *maxPoint);
 
+/**
+ * 指定した名前の表情番号を取得する。
+ * 見つからない場合は-1を返す。
+ */
+extern int PmdFile_findMorph(PmdFile *pmd, const GLchar *name);
+
 /**
  * PMDファイル内のテクスチャを列挙する
  *
@@ -276,6 +518,17 @@ extern PmdTextureList* PmdFile_createTextureList(GLApplication *app, PmdFile *pm
  */
 extern Texture* PmdFile_getTexture(PmdTextureList *texList, const GLchar *name);
 
+/**
+ * 材質ごとのテクスチャをPmdFile.diffuse_texturesへ解決する。
+ * 描画ループ内で名前からテクスチャを検索する必要がなくなる。
+ */
+extern void PmdFile_bindTextureList(PmdFile *pmd, PmdTextureList *texList);
+
+/**
+ * 描画で利用しない頂点情報を取得する
+ */
+extern PmdVertexExtra* PmdFile_getVertexExtra(PmdFile *pmd, const GLuint vertex_index);
+
 /**
  * 管理しているテクスチャを解放する
  */
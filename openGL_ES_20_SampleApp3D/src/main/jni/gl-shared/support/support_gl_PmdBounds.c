@@ -0,0 +1,164 @@
+/*
+ * support_gl_PmdBounds.c
+ */
+
+#include    "support.h"
+
+/**
+ * SoA形式の位置から境界ボリュームを計算する。
+ */
+void PmdBounds_calcSoA(const GLfloat *xs, const GLfloat *ys, const GLfloat *zs, const GLuint num, PmdBounds *result) {
+    assert((num % 4) == 0);
+
+    if (!num) {
+        memset(result, 0x00, sizeof(PmdBounds));
+        return;
+    }
+
+    int i = 0;
+
+    // AABBを求める
+    simd4f minX = simd4f_load(xs);
+    simd4f minY = simd4f_load(ys);
+    simd4f minZ = simd4f_load(zs);
+    simd4f maxX = minX;
+    simd4f maxY = minY;
+    simd4f maxZ = minZ;
+    for (i = 4; i < num; i += 4) {
+        const simd4f x = simd4f_load(xs + i);
+        const simd4f y = simd4f_load(ys + i);
+        const simd4f z = simd4f_load(zs + i);
+
+        minX = simd4f_min(minX, x);
+        minY = simd4f_min(minY, y);
+        minZ = simd4f_min(minZ, z);
+        maxX = simd4f_max(maxX, x);
+        maxY = simd4f_max(maxY, y);
+        maxZ = simd4f_max(maxZ, z);
+    }
+
+    result->aabb_min = vec3_create(simd4f_hmin(minX), simd4f_hmin(minY), simd4f_hmin(minZ));
+    result->aabb_max = vec3_create(simd4f_hmax(maxX), simd4f_hmax(maxY), simd4f_hmax(maxZ));
+    result->sphere_center = vec3_create( //
+            (result->aabb_min.x + result->aabb_max.x) * 0.5f, //
+            (result->aabb_min.y + result->aabb_max.y) * 0.5f, //
+            (result->aabb_min.z + result->aabb_max.z) * 0.5f);
+
+    // 中心から最も遠い頂点までの距離を半径とする
+    {
+        const simd4f cx = simd4f_splat(result->sphere_center.x);
+        const simd4f cy = simd4f_splat(result->sphere_center.y);
+        const simd4f cz = simd4f_splat(result->sphere_center.z);
+        simd4f maxDistance = simd4f_splat(0);
+
+        for (i = 0; i < num; i += 4) {
+            const simd4f dx = simd4f_sub(simd4f_load(xs + i), cx);
+            const simd4f dy = simd4f_sub(simd4f_load(ys + i), cy);
+            const simd4f dz = simd4f_sub(simd4f_load(zs + i), cz);
+
+            const simd4f distance = simd4f_madd(dz, dz, simd4f_madd(dy, dy, simd4f_mul(dx, dx)));
+            maxDistance = simd4f_max(maxDistance, distance);
+        }
+
+        result->sphere_radius = sqrtf(simd4f_hmax(maxDistance));
+    }
+}
+
+/**
+ * AABBをワールド行列で変換し、変換後のAABBを包むAABBを求める。
+ */
+void PmdBounds_transformAABB(const PmdBounds *bounds, const mat4 world, vec3 *result_min, vec3 *result_max) {
+    const GLfloat (*m)[4] = world.m;
+
+    // 中心を変換し、半径は行列の絶対値で広げる
+    const vec3 center = mat4_transformPoint(world, vec3_create( //
+            (bounds->aabb_min.x + bounds->aabb_max.x) * 0.5f, //
+            (bounds->aabb_min.y + bounds->aabb_max.y) * 0.5f, //
+            (bounds->aabb_min.z + bounds->aabb_max.z) * 0.5f));
+    const GLfloat ex = (bounds->aabb_max.x - bounds->aabb_min.x) * 0.5f;
+    const GLfloat ey = (bounds->aabb_max.y - bounds->aabb_min.y) * 0.5f;
+    const GLfloat ez = (bounds->aabb_max.z - bounds->aabb_min.z) * 0.5f;
+    const vec3 extent = vec3_create( //
+            fabsf(m[0][0]) * ex + fabsf(m[1][0]) * ey + fabsf(m[2][0]) * ez, //
+            fabsf(m[0][1]) * ex + fabsf(m[1][1]) * ey + fabsf(m[2][1]) * ez, //
+            fabsf(m[0][2]) * ex + fabsf(m[1][2]) * ey + fabsf(m[2][2]) * ez);
+
+    *result_min = vec3_create(center.x - extent.x, center.y - extent.y, center.z - extent.z);
+    *result_max = vec3_create(center.x + extent.x, center.y + extent.y, center.z + extent.z);
+}
+
+/**
+ * SoA配列の端数を最後の位置で埋め、4の倍数の要素数を返す
+ */
+static GLuint PmdBounds_padSoA(GLfloat *xs, GLfloat *ys, GLfloat *zs, GLuint num) {
+    if (!num) {
+        return 0;
+    }
+
+    while (num % 4) {
+        xs[num] = xs[num - 1];
+        ys[num] = ys[num - 1];
+        zs[num] = zs[num - 1];
+        ++num;
+    }
+    return num;
+}
+
+/**
+ * モデル全体と材質ごとの境界ボリュームを計算し、PmdFileへ格納する。
+ */
+void PmdFile_calcBounds(PmdFile *pmd) {
+    int i = 0;
+    int k = 0;
+
+    // SoA作業領域は頂点数と最大の材質インデックス数の大きい方に合わせる
+    GLuint capacity = pmd->vertices_num;
+    for (i = 0; i < pmd->materials_num; ++i) {
+        if (pmd->draw_ranges[i].indices_num > capacity) {
+            capacity = pmd->draw_ranges[i].indices_num;
+        }
+    }
+    capacity = (capacity + 3) & ~3;
+
+    GLfloat *xs = util_alignedAlloc(SIMD4F_ALIGNMENT, sizeof(GLfloat) * (capacity ? capacity : 4) * 3);
+    GLfloat *ys = xs + capacity;
+    GLfloat *zs = ys + capacity;
+
+    // モデル全体
+    {
+        for (i = 0; i < pmd->vertices_num; ++i) {
+            const vec3 *p = &pmd->vertices[i].position;
+            xs[i] = p->x;
+            ys[i] = p->y;
+            zs[i] = p->z;
+        }
+
+        const GLuint num = PmdBounds_padSoA(xs, ys, zs, pmd->vertices_num);
+        PmdBounds_calcSoA(xs, ys, zs, num, &pmd->bounds);
+    }
+
+    // 材質ごと
+    // 描画範囲のインデックスが指す頂点を集める
+    free(pmd->material_bounds);
+    pmd->material_bounds = calloc(pmd->materials_num ? pmd->materials_num : 1, sizeof(PmdBounds));
+    for (i = 0; i < pmd->materials_num; ++i) {
+        const PmdDrawRange *range = &pmd->draw_ranges[i];
+
+        for (k = 0; k < range->indices_num; ++k) {
+            const vec3 *p = &pmd->vertices[PmdFile_getIndex(pmd, range->indices_begin + k)].position;
+            xs[k] = p->x;
+            ys[k] = p->y;
+            zs[k] = p->z;
+        }
+
+        const GLuint num = PmdBounds_padSoA(xs, ys, zs, range->indices_num);
+        PmdBounds_calcSoA(xs, ys, zs, num, &pmd->material_bounds[i]);
+    }
+
+    util_alignedFree(xs);
+
+    __logf("PmdFile bounds min(%.2f, %.2f, %.2f) max(%.2f, %.2f, %.2f) radius(%.2f)", //
+            pmd->bounds.aabb_min.x, pmd->bounds.aabb_min.y, pmd->bounds.aabb_min.z, //
+            pmd->bounds.aabb_max.x, pmd->bounds.aabb_max.y, pmd->bounds.aabb_max.z, //
+            pmd->bounds.sphere_radius);
+}
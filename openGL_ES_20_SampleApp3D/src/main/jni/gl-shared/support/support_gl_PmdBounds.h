@@ -0,0 +1,29 @@
+/*
+ * support_gl_PmdBounds.h
+ *
+ * PMDの境界ボリューム（AABB / 境界球）を計算する
+ * 位置をSoA(x配列 / y配列 / z配列)に並べ替え、SIMDで4頂点ずつ処理する。
+ */
+
+#ifndef SUPPORT_GL_PMDBOUNDS_H_
+#define SUPPORT_GL_PMDBOUNDS_H_
+
+/**
+ * SoA形式の位置から境界ボリュームを計算する。
+ * xs / ys / zsはSIMD4F_ALIGNMENTに揃っていなければならない。
+ * numは4の倍数でなければならず、端数は有効な位置で埋めておく。
+ */
+extern void PmdBounds_calcSoA(const GLfloat *xs, const GLfloat *ys, const GLfloat *zs, const GLuint num, PmdBounds *result);
+
+/**
+ * AABBをワールド行列で変換し、変換後のAABBを包むAABBを求める。
+ */
+extern void PmdBounds_transformAABB(const PmdBounds *bounds, const mat4 world, vec3 *result_min, vec3 *result_max);
+
+/**
+ * モデル全体と材質ごとの境界ボリュームを計算し、PmdFileへ格納する。
+ * ローダーから呼び出されるため、通常は呼び出す必要はない。
+ */
+extern void PmdFile_calcBounds(PmdFile *pmd);
+
+#endif /* SUPPORT_GL_PMDBOUNDS_H_ */
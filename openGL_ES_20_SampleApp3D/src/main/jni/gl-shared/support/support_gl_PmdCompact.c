@@ -0,0 +1,157 @@
+/*
+ * support_gl_PmdCompact.c
+ */
+
+#include    "support.h"
+
+/**
+ * [-1.0, 1.0]の値を正規化shortへ変換する
+ * OpenGL ES 2.0の正規化は f = (2c + 1) / (2^16 - 1) で行われるため、その逆変換を行う
+ */
+static GLshort PmdCompact_toSnorm16(const GLfloat value) {
+    const GLfloat v = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    const GLfloat c = floorf((v * 65535.0f - 1.0f) * 0.5f + 0.5f);
+    return (GLshort) (c < -32768.0f ? -32768.0f : (c > 32767.0f ? 32767.0f : c));
+}
+
+/**
+ * [-1.0, 1.0]の値を正規化byteへ変換する
+ * f = (2c + 1) / (2^8 - 1) の逆変換を行う
+ */
+static GLbyte PmdCompact_toSnorm8(const GLfloat value) {
+    const GLfloat v = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    const GLfloat c = floorf((v * 255.0f - 1.0f) * 0.5f + 0.5f);
+    return (GLbyte) (c < -128.0f ? -128.0f : (c > 127.0f ? 127.0f : c));
+}
+
+/**
+ * [0.0, 1.0]の値を正規化unsigned shortへ変換する
+ */
+static GLushort PmdCompact_toUnorm16(const GLfloat value) {
+    const GLfloat v = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (GLushort) floorf(v * 65535.0f + 0.5f);
+}
+
+/**
+ * 法線を八面体エンコードする
+ */
+static void PmdCompact_encodeNormal(const vec3 normal, GLbyte *result) {
+    const GLfloat sum = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+    GLfloat x = 0;
+    GLfloat y = 0;
+
+    if (sum > 0) {
+        x = normal.x / sum;
+        y = normal.y / sum;
+
+        // 下半球は外側へ折り返す
+        if (normal.z < 0) {
+            const GLfloat fx = (1.0f - fabsf(y)) * (x >= 0 ? 1.0f : -1.0f);
+            const GLfloat fy = (1.0f - fabsf(x)) * (y >= 0 ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+    }
+
+    result[0] = PmdCompact_toSnorm8(x);
+    result[1] = PmdCompact_toSnorm8(y);
+    result[2] = 0;
+    result[3] = 0;
+}
+
+/**
+ * PMDの頂点を量子化する
+ */
+PmdCompactMesh* PmdCompactMesh_create(PmdFile *pmd) {
+    PmdCompactMesh *result = calloc(1, sizeof(PmdCompactMesh));
+    result->vertices_num = pmd->vertices_num;
+    result->vertices = malloc(sizeof(PmdCompactVertex) * pmd->vertices_num);
+
+    int i = 0;
+
+    // 位置とUVの範囲を求める
+    vec3 minPos = vec3_create(0, 0, 0);
+    vec3 maxPos = vec3_create(0, 0, 0);
+    vec2 minUv = vec2_create(0, 0);
+    vec2 maxUv = vec2_create(1, 1);
+    PmdFile_calcAABB(pmd, &minPos, &maxPos);
+    for (i = 0; i < pmd->vertices_num; ++i) {
+        const vec2 uv = pmd->vertices[i].uv;
+        minUv.x = fminf(minUv.x, uv.x);
+        minUv.y = fminf(minUv.y, uv.y);
+        maxUv.x = fmaxf(maxUv.x, uv.x);
+        maxUv.y = fmaxf(maxUv.y, uv.y);
+    }
+
+    result->position_offset = vec3_create((minPos.x + maxPos.x) * 0.5f, (minPos.y + maxPos.y) * 0.5f, (minPos.z + maxPos.z) * 0.5f);
+    result->position_scale = vec3_create(fmaxf((maxPos.x - minPos.x) * 0.5f, 1e-6f), fmaxf((maxPos.y - minPos.y) * 0.5f, 1e-6f), fmaxf((maxPos.z - minPos.z) * 0.5f, 1e-6f));
+    result->uv_offset = minUv;
+    result->uv_scale = vec2_create(maxUv.x - minUv.x, maxUv.y - minUv.y);
+
+    // 量子化する
+    for (i = 0; i < pmd->vertices_num; ++i) {
+        const PmdVertex *src = &pmd->vertices[i];
+        PmdCompactVertex *dst = &result->vertices[i];
+
+        dst->position[0] = PmdCompact_toSnorm16((src->position.x - result->position_offset.x) / result->position_scale.x);
+        dst->position[1] = PmdCompact_toSnorm16((src->position.y - result->position_offset.y) / result->position_scale.y);
+        dst->position[2] = PmdCompact_toSnorm16((src->position.z - result->position_offset.z) / result->position_scale.z);
+        dst->position[3] = 0;
+
+        dst->uv[0] = PmdCompact_toUnorm16((src->uv.x - result->uv_offset.x) / result->uv_scale.x);
+        dst->uv[1] = PmdCompact_toUnorm16((src->uv.y - result->uv_offset.y) / result->uv_scale.y);
+
+        PmdCompact_encodeNormal(src->normal, dst->normal);
+
+        // 空いている法線の要素へ輪郭の押し出し倍率を格納する
+        dst->normal[2] = PmdEdge_isVertexEdge(pmd, i) ? 127 : 0;
+    }
+
+    __logf("PmdCompactMesh vertices(%d) bytes(%d -> %d)", result->vertices_num, (int) (sizeof(PmdVertex) * pmd->vertices_num), (int) (sizeof(PmdCompactVertex) * result->vertices_num));
+    return result;
+}
+
+/**
+ * 量子化済みの頂点をGL_ARRAY_BUFFERへ転送する。
+ * 生成したバッファオブジェクトを返す。
+ */
+GLuint PmdCompactMesh_createVertexBuffer(PmdCompactMesh *mesh, const GLenum usage) {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    assert(glGetError() == GL_NO_ERROR);
+    assert(buffer != 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(PmdCompactVertex) * mesh->vertices_num, mesh->vertices, usage);
+    assert(glGetError() == GL_NO_ERROR);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return buffer;
+}
+
+/**
+ * 位置を復元するためのuniformを設定する。
+ */
+void PmdCompactMesh_uniformPosition(PmdCompactMesh *mesh, const GLint unif_offset, const GLint unif_scale) {
+    glUniform3f(unif_offset, mesh->position_offset.x, mesh->position_offset.y, mesh->position_offset.z);
+    glUniform3f(unif_scale, mesh->position_scale.x, mesh->position_scale.y, mesh->position_scale.z);
+}
+
+/**
+ * UVを復元するためのuniformを設定する。
+ */
+void PmdCompactMesh_uniformUv(PmdCompactMesh *mesh, const GLint unif_offset, const GLint unif_scale) {
+    glUniform2f(unif_offset, mesh->uv_offset.x, mesh->uv_offset.y);
+    glUniform2f(unif_scale, mesh->uv_scale.x, mesh->uv_scale.y);
+}
+
+/**
+ * 量子化済みのメッシュを解放する
+ */
+void PmdCompactMesh_free(PmdCompactMesh *mesh) {
+    if (!mesh) {
+        return;
+    }
+    free(mesh->vertices);
+    free(mesh);
+}
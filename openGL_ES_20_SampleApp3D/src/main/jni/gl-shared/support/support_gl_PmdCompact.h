@@ -0,0 +1,115 @@
+/*
+ * support_gl_PmdCompact.h
+ *
+ * GPU転送用にPMD頂点を量子化した頂点形式
+ * 位置はモデルのAABBで正規化したshort、UVは範囲で正規化したushort、法線は八面体エンコードしたbyteで格納する。
+ * 32byte/頂点のPmdVertexに対し、16byte/頂点で転送できる。
+ */
+
+#ifndef SUPPORT_GL_PMDCOMPACT_H_
+#define SUPPORT_GL_PMDCOMPACT_H_
+
+/**
+ * 量子化済み頂点
+ */
+typedef struct PmdCompactVertex {
+    /**
+     * 位置
+     * AABBの中心を原点、半径を1.0とした正規化short値
+     * position[3]は4byteアライメント用の未使用領域
+     */
+    GLshort position[4];
+
+    /**
+     * テクスチャUV
+     * UV範囲で正規化したunsigned short値
+     */
+    GLushort uv[2];
+
+    /**
+     * 法線
+     * normal[0], normal[1]は八面体エンコードした正規化byte値
+     * normal[2]は輪郭の押し出し倍率（頂点の輪郭が有効なら127、無効なら0）
+     * normal[3]は4byteアライメント用の未使用領域
+     */
+    GLbyte normal[4];
+} PmdCompactVertex;
+
+/**
+ * 量子化済みのメッシュ
+ */
+typedef struct PmdCompactMesh {
+    /**
+     * 頂点配列
+     */
+    PmdCompactVertex *vertices;
+
+    /**
+     * 頂点数
+     */
+    GLuint vertices_num;
+
+    /**
+     * 位置の復元用オフセット（AABB中心）
+     * position = position_offset + attr_pos * position_scale
+     */
+    vec3 position_offset;
+
+    /**
+     * 位置の復元用スケール（AABB半径）
+     */
+    vec3 position_scale;
+
+    /**
+     * UVの復元用オフセット
+     * uv = uv_offset + attr_uv * uv_scale
+     */
+    vec2 uv_offset;
+
+    /**
+     * UVの復元用スケール
+     */
+    vec2 uv_scale;
+} PmdCompactMesh;
+
+/**
+ * 八面体エンコードされた法線を復元するGLSL関数
+ * 頂点シェーダーのソースへ連結して利用する。
+ */
+#define PMDCOMPACT_GLSL_DECODE_NORMAL \
+        "mediump vec3 PmdCompact_decodeNormal(mediump vec2 e) {" \
+        "   mediump vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));" \
+        "   mediump float t = max(-n.z, 0.0);" \
+        "   n.xy += (1.0 - 2.0 * step(0.0, n.xy)) * t;" \
+        "   return normalize(n);" \
+        "}"
+
+/**
+ * PMDの頂点を量子化する
+ */
+extern PmdCompactMesh* PmdCompactMesh_create(PmdFile *pmd);
+
+/**
+ * 量子化済みの頂点をGL_ARRAY_BUFFERへ転送する。
+ * 生成したバッファオブジェクトを返す。
+ */
+extern GLuint PmdCompactMesh_createVertexBuffer(PmdCompactMesh *mesh, const GLenum usage);
+
+/**
+ * 位置を復元するためのuniformを設定する。
+ * unif_offset/unif_scaleはvec3のuniform。
+ */
+extern void PmdCompactMesh_uniformPosition(PmdCompactMesh *mesh, const GLint unif_offset, const GLint unif_scale);
+
+/**
+ * UVを復元するためのuniformを設定する。
+ * unif_offset/unif_scaleはvec2のuniform。
+ */
+extern void PmdCompactMesh_uniformUv(PmdCompactMesh *mesh, const GLint unif_offset, const GLint unif_scale);
+
+/**
+ * 量子化済みのメッシュを解放する
+ */
+extern void PmdCompactMesh_free(PmdCompactMesh *mesh);
+
+#endif /* SUPPORT_GL_PMDCOMPACT_H_ */
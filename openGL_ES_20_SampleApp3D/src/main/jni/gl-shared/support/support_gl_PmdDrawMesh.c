@@ -0,0 +1,205 @@
+/*
+ * support_gl_PmdDrawMesh.c
+ */
+
+#include    "support.h"
+
+/**
+ * インデックスの型ごとのバイト数を取得する
+ */
+static GLsizei PmdDrawMesh_getIndexBytes(const GLenum index_type) {
+    return index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+}
+
+/**
+ * 材質ごとに1サブメッシュを割り当てる
+ */
+static void PmdDrawMesh_createMaterialSubMeshes(PmdDrawMesh *result, PmdFile *pmd) {
+    result->submeshes_num = pmd->materials_num;
+    result->submeshes = calloc(pmd->materials_num, sizeof(PmdSubMesh));
+
+    int i = 0;
+    for (i = 0; i < pmd->materials_num; ++i) {
+        PmdSubMesh *submesh = &result->submeshes[i];
+        submesh->material_index = i;
+        submesh->vertex_begin = 0;
+        submesh->vertices_num = pmd->vertices_num;
+        submesh->indices_begin = pmd->draw_ranges[i].indices_begin;
+        submesh->indices_num = pmd->draw_ranges[i].indices_num;
+    }
+}
+
+/**
+ * 16bitインデックスで描画できるよう、材質ごとに三角形を頂点数の上限で分割する
+ */
+static void PmdDrawMesh_split(PmdDrawMesh *result, PmdFile *pmd) {
+    GLushort *indices = malloc(sizeof(GLushort) * pmd->indices_num);
+
+    // 分割後の頂点数は最大でもインデックス数に収まる
+    GLuint *vertex_sources = malloc(sizeof(GLuint) * pmd->indices_num);
+
+    // 元頂点 -> サブメッシュ内の頂点番号
+    // stampが現在のサブメッシュ番号 + 1と一致する場合のみ有効
+    GLuint *local = malloc(sizeof(GLuint) * pmd->vertices_num);
+    GLuint *stamp = calloc(pmd->vertices_num, sizeof(GLuint));
+
+    GLuint submeshesCapacity = pmd->materials_num * 2 + 1;
+    PmdSubMesh *submeshes = malloc(sizeof(PmdSubMesh) * submeshesCapacity);
+    GLuint submeshes_num = 0;
+    GLuint vertices_num = 0;
+
+    PmdSubMesh *current = NULL;
+    int i = 0;
+    int k = 0;
+    int t = 0;
+    for (i = 0; i < pmd->materials_num; ++i) {
+        const PmdDrawRange *range = &pmd->draw_ranges[i];
+        current = NULL;
+
+        for (t = 0; t < range->indices_num; t += 3) {
+            // 三角形を追加すると上限を超える場合は新しいサブメッシュを開始する
+            if (current) {
+                GLuint newVertices = 0;
+                for (k = 0; k < 3; ++k) {
+                    const GLuint v = PmdFile_getIndex(pmd, range->indices_begin + t + k);
+                    if (stamp[v] != submeshes_num) {
+                        ++newVertices;
+                    }
+                }
+
+                if (current->vertices_num + newVertices > PMDDRAWMESH_VERTICES_MAX) {
+                    current = NULL;
+                }
+            }
+
+            if (!current) {
+                if (submeshes_num == submeshesCapacity) {
+                    submeshesCapacity *= 2;
+                    submeshes = realloc(submeshes, sizeof(PmdSubMesh) * submeshesCapacity);
+                }
+
+                current = &submeshes[submeshes_num++];
+                current->material_index = i;
+                current->vertex_begin = vertices_num;
+                current->vertices_num = 0;
+                current->indices_begin = range->indices_begin + t;
+                current->indices_num = 0;
+            }
+
+            for (k = 0; k < 3; ++k) {
+                const GLuint v = PmdFile_getIndex(pmd, range->indices_begin + t + k);
+                if (stamp[v] != submeshes_num) {
+                    stamp[v] = submeshes_num;
+                    local[v] = current->vertices_num++;
+                    vertex_sources[vertices_num++] = v;
+                }
+
+                indices[current->indices_begin + current->indices_num++] = (GLushort) local[v];
+            }
+        }
+    }
+
+    free(local);
+    free(stamp);
+
+    result->index_type = GL_UNSIGNED_SHORT;
+    result->indices = indices;
+    result->vertex_sources = realloc(vertex_sources, sizeof(GLuint) * (vertices_num ? vertices_num : 1));
+    result->vertices_num = vertices_num;
+    result->submeshes = submeshes;
+    result->submeshes_num = submeshes_num;
+}
+
+/**
+ * PMDから描画用のインデックス構成を生成する。
+ */
+PmdDrawMesh* PmdDrawMesh_create(PmdFile *pmd, const bool uint_supported) {
+    PmdDrawMesh *result = calloc(1, sizeof(PmdDrawMesh));
+    result->indices_num = pmd->indices_num;
+    result->vertices_num = pmd->vertices_num;
+
+    int i = 0;
+    if (pmd->vertices_num <= PMDDRAWMESH_VERTICES_MAX) {
+        // 16bitインデックスで描画できる
+        GLushort *indices = malloc(sizeof(GLushort) * pmd->indices_num);
+        for (i = 0; i < pmd->indices_num; ++i) {
+            indices[i] = (GLushort) PmdFile_getIndex(pmd, i);
+        }
+
+        result->index_type = GL_UNSIGNED_SHORT;
+        result->indices = indices;
+        PmdDrawMesh_createMaterialSubMeshes(result, pmd);
+    } else if (uint_supported) {
+        // GL_OES_element_index_uintを利用する
+        GLuint *indices = malloc(sizeof(GLuint) * pmd->indices_num);
+        for (i = 0; i < pmd->indices_num; ++i) {
+            indices[i] = PmdFile_getIndex(pmd, i);
+        }
+
+        result->index_type = GL_UNSIGNED_INT;
+        result->indices = indices;
+        PmdDrawMesh_createMaterialSubMeshes(result, pmd);
+    } else {
+        // 16bitで描画できる単位に分割する
+        PmdDrawMesh_split(result, pmd);
+    }
+
+    __logf("PmdDrawMesh vertices(%d -> %d) submeshes(%d) index(%s)", pmd->vertices_num, result->vertices_num, result->submeshes_num, result->index_type == GL_UNSIGNED_INT ? "uint" : "ushort");
+    return result;
+}
+
+/**
+ * 分割に合わせて頂点を並べ替えた配列を生成する。
+ */
+GLvoid* PmdDrawMesh_gatherVertices(PmdDrawMesh *mesh, const GLvoid *vertices, const GLsizei stride) {
+    if (!mesh->vertex_sources) {
+        return NULL;
+    }
+
+    const GLbyte *src = (const GLbyte*) vertices;
+    GLbyte *result = malloc(stride * mesh->vertices_num);
+
+    int i = 0;
+    for (i = 0; i < mesh->vertices_num; ++i) {
+        memcpy(result + stride * i, src + stride * mesh->vertex_sources[i], stride);
+    }
+    return result;
+}
+
+/**
+ * インデックスをGL_ELEMENT_ARRAY_BUFFERへ転送する。
+ */
+GLuint PmdDrawMesh_createIndexBuffer(PmdDrawMesh *mesh, const GLenum usage) {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    assert(glGetError() == GL_NO_ERROR);
+    assert(buffer != 0);
+
+    VertexLayout_invalidateBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdDrawMesh_getIndexBytes(mesh->index_type) * mesh->indices_num, mesh->indices, usage);
+    assert(glGetError() == GL_NO_ERROR);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    return buffer;
+}
+
+/**
+ * サブメッシュのインデックス開始位置をバイト単位で取得する
+ */
+GLsizeiptr PmdDrawMesh_getIndexOffset(PmdDrawMesh *mesh, const PmdSubMesh *submesh) {
+    return (GLsizeiptr) PmdDrawMesh_getIndexBytes(mesh->index_type) * submesh->indices_begin;
+}
+
+/**
+ * 描画用のインデックス構成を解放する
+ */
+void PmdDrawMesh_free(PmdDrawMesh *mesh) {
+    if (!mesh) {
+        return;
+    }
+    free(mesh->indices);
+    free(mesh->vertex_sources);
+    free(mesh->submeshes);
+    free(mesh);
+}
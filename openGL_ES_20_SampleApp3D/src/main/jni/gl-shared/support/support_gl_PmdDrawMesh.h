@@ -0,0 +1,122 @@
+/*
+ * support_gl_PmdDrawMesh.h
+ *
+ * PMDをGPUで描画するためのインデックス構成
+ * OpenGL ES 2.0の標準ではglDrawElementsにGL_UNSIGNED_INTを指定できないため、
+ * 65536頂点を超えるモデルはGL_OES_element_index_uintを利用するか、16bitインデックスで描画できる単位に分割する。
+ */
+
+#ifndef SUPPORT_GL_PMDDRAWMESH_H_
+#define SUPPORT_GL_PMDDRAWMESH_H_
+
+/**
+ * 16bitインデックスで描画できる最大頂点数
+ */
+#define PMDDRAWMESH_VERTICES_MAX    0x10000
+
+/**
+ * 1回のglDrawElementsで描画する単位
+ */
+typedef struct PmdSubMesh {
+    /**
+     * 描画する材質番号
+     */
+    GLuint material_index;
+
+    /**
+     * 描画用頂点配列内の開始位置
+     * 頂点属性のオフセットへ sizeof(頂点) * vertex_begin を加算して描画する
+     */
+    GLuint vertex_begin;
+
+    /**
+     * 利用する頂点数
+     */
+    GLuint vertices_num;
+
+    /**
+     * インデックスの開始位置
+     */
+    GLuint indices_begin;
+
+    /**
+     * インデックス数
+     */
+    GLuint indices_num;
+} PmdSubMesh;
+
+/**
+ * 描画用のインデックス構成
+ */
+typedef struct PmdDrawMesh {
+    /**
+     * インデックスの型
+     * GL_UNSIGNED_SHORT / GL_UNSIGNED_INT
+     */
+    GLenum index_type;
+
+    /**
+     * 描画用インデックス
+     * index_typeに応じてGLushort / GLuintの配列となる。
+     * 分割した場合、各サブメッシュのvertex_beginからの相対値が格納される。
+     */
+    GLvoid *indices;
+
+    /**
+     * インデックス数
+     */
+    GLuint indices_num;
+
+    /**
+     * 描画用頂点番号 -> PmdFile.verticesの頂点番号
+     * 分割を行わなかった場合はNULL
+     */
+    GLuint *vertex_sources;
+
+    /**
+     * 描画用頂点数
+     */
+    GLuint vertices_num;
+
+    /**
+     * サブメッシュ配列
+     */
+    PmdSubMesh *submeshes;
+
+    /**
+     * サブメッシュ数
+     */
+    GLuint submeshes_num;
+} PmdDrawMesh;
+
+/**
+ * PMDから描画用のインデックス構成を生成する。
+ * 65536頂点以下のモデルは16bitインデックスで材質ごとに1サブメッシュとなる。
+ * それを超える場合、uint_supportedがtrueなら32bitインデックス、falseなら16bitインデックスで描画できるよう分割する。
+ */
+extern PmdDrawMesh* PmdDrawMesh_create(PmdFile *pmd, const bool uint_supported);
+
+/**
+ * 分割に合わせて頂点を並べ替えた配列を生成する。
+ * verticesはPmdFile.verticesと同じ並びの頂点配列で、strideは1頂点のバイト数。
+ * 分割を行わなかった場合は並べ替えが不要なためNULLを返す。
+ */
+extern GLvoid* PmdDrawMesh_gatherVertices(PmdDrawMesh *mesh, const GLvoid *vertices, const GLsizei stride);
+
+/**
+ * インデックスをGL_ELEMENT_ARRAY_BUFFERへ転送する。
+ * 生成したバッファオブジェクトを返す。
+ */
+extern GLuint PmdDrawMesh_createIndexBuffer(PmdDrawMesh *mesh, const GLenum usage);
+
+/**
+ * サブメッシュのインデックス開始位置をバイト単位で取得する
+ */
+extern GLsizeiptr PmdDrawMesh_getIndexOffset(PmdDrawMesh *mesh, const PmdSubMesh *submesh);
+
+/**
+ * 描画用のインデックス構成を解放する
+ */
+extern void PmdDrawMesh_free(PmdDrawMesh *mesh);
+
+#endif /* SUPPORT_GL_PMDDRAWMESH_H_ */
@@ -0,0 +1,406 @@
+/*
+ * support_gl_PmdEdge.c
+ */
+
+#include    "support.h"
+
+/**
+ * インデックス1つのbyte数を取得する
+ */
+static GLsizeiptr PmdEdge_indexSize(const GLenum index_type) {
+    return index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+}
+
+/**
+ * インデックスを取り出す
+ */
+static GLuint PmdEdge_getIndex(const GLenum index_type, const GLvoid *indices, const GLuint index) {
+    return index_type == GL_UNSIGNED_INT ? ((const GLuint*) indices)[index] : ((const GLushort*) indices)[index];
+}
+
+/**
+ * 頂点の輪郭が有効であればtrueを返す
+ * 頂点の輪郭フラグは0が有効、1が無効となる
+ */
+bool PmdEdge_isVertexEdge(const PmdFile *pmd, const GLuint vertex) {
+    return !pmd->vertices_extra || pmd->vertices_extra[vertex].edge_flag == 0;
+}
+
+/**
+ * 空の一覧を確保する
+ */
+static PmdEdgeList* PmdEdgeList_alloc(const GLenum index_type, const GLuint ranges_num, const GLuint source_indices_num) {
+    PmdEdgeList *result = calloc(1, sizeof(PmdEdgeList));
+
+    result->index_type = index_type;
+    result->materials_num = ranges_num;
+    result->source_indices_num = source_indices_num;
+    result->indices = malloc(PmdEdge_indexSize(index_type) * (source_indices_num ? source_indices_num : 1));
+    result->draw_ranges = calloc(ranges_num ? ranges_num : 1, sizeof(PmdDrawRange));
+    return result;
+}
+
+/**
+ * 1つの描画範囲から、輪郭を描画する三角形を一覧の末尾へ追加する
+ * 頂点の判定には、インデックスへvertex_beginを加えた頂点（vertex_sourcesがあれば変換後の頂点）を用いる。
+ */
+static void PmdEdgeList_addRange(PmdEdgeList *list, const PmdFile *pmd, const GLuint range_index, const GLuint material, const GLvoid *indices, const GLuint indices_begin, const GLuint indices_num, const GLuint *vertex_sources, const GLuint vertex_begin) {
+    PmdDrawRange *range = &list->draw_ranges[range_index];
+    GLuint t = 0;
+
+    range->indices_begin = list->indices_num;
+
+    // 輪郭を描画しない材質は丸ごと取り除く
+    if (!pmd->materials[material].extra.edge_flag) {
+        return;
+    }
+
+    for (t = 0; t + 2 < indices_num; t += 3) {
+        GLuint v[3];
+        bool edge = false;
+        int k = 0;
+
+        for (k = 0; k < 3; ++k) {
+            GLuint vertex = 0;
+
+            v[k] = PmdEdge_getIndex(list->index_type, indices, indices_begin + t + k);
+            vertex = vertex_begin + v[k];
+            if (vertex_sources) {
+                vertex = vertex_sources[vertex];
+            }
+            edge = edge || PmdEdge_isVertexEdge(pmd, vertex);
+        }
+
+        // 3頂点とも輪郭が無効であれば押し出しても描画されないため取り除く
+        if (!edge) {
+            continue;
+        }
+
+        for (k = 0; k < 3; ++k) {
+            if (list->index_type == GL_UNSIGNED_INT) {
+                ((GLuint*) list->indices)[list->indices_num + k] = v[k];
+            } else {
+                ((GLushort*) list->indices)[list->indices_num + k] = (GLushort) v[k];
+            }
+        }
+        list->indices_num += 3;
+    }
+
+    range->indices_num = list->indices_num - range->indices_begin;
+    if (range->indices_num) {
+        ++list->edge_materials_num;
+    }
+}
+
+/**
+ * 材質・頂点の輪郭フラグから、輪郭を描画する三角形の一覧を生成する。
+ */
+PmdEdgeList* PmdEdgeList_create(const PmdFile *pmd) {
+    return PmdEdgeList_createFromRanges(pmd, pmd->index_type, PmdFile_getIndices(pmd, 0), pmd->draw_ranges);
+}
+
+/**
+ * 材質ごとの描画範囲とインデックスから、輪郭を描画する三角形の一覧を生成する。
+ */
+PmdEdgeList* PmdEdgeList_createFromRanges(const PmdFile *pmd, const GLenum index_type, const GLvoid *indices, const PmdDrawRange *draw_ranges) {
+    GLuint source_indices_num = 0;
+    GLuint i = 0;
+
+    for (i = 0; i < pmd->materials_num; ++i) {
+        source_indices_num += draw_ranges[i].indices_num;
+    }
+
+    PmdEdgeList *result = PmdEdgeList_alloc(index_type, pmd->materials_num, source_indices_num);
+    for (i = 0; i < pmd->materials_num; ++i) {
+        PmdEdgeList_addRange(result, pmd, i, i, indices, draw_ranges[i].indices_begin, draw_ranges[i].indices_num, NULL, 0);
+    }
+
+    __logf("PmdEdgeList materials(%d / %d) indices(%d / %d)", result->edge_materials_num, result->materials_num, result->indices_num, result->source_indices_num);
+    return result;
+}
+
+/**
+ * 分割したメッシュのサブメッシュごとに、輪郭を描画する三角形の一覧を生成する。
+ */
+PmdEdgeList* PmdEdgeList_createFromDrawMesh(const PmdFile *pmd, const PmdDrawMesh *mesh) {
+    PmdEdgeList *result = PmdEdgeList_alloc(mesh->index_type, mesh->submeshes_num, mesh->indices_num);
+    GLuint i = 0;
+
+    for (i = 0; i < mesh->submeshes_num; ++i) {
+        const PmdSubMesh *submesh = &mesh->submeshes[i];
+        PmdEdgeList_addRange(result, pmd, i, submesh->material_index, mesh->indices, submesh->indices_begin, submesh->indices_num, mesh->vertex_sources, mesh->vertex_sources ? submesh->vertex_begin : 0);
+    }
+
+    __logf("PmdEdgeList submeshes(%d / %d) indices(%d / %d)", result->edge_materials_num, result->materials_num, result->indices_num, result->source_indices_num);
+    return result;
+}
+
+/**
+ * 輪郭のインデックスバッファを生成する
+ */
+GLuint PmdEdgeList_createIndexBuffer(const PmdEdgeList *list, const GLenum usage) {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    assert(glGetError() == GL_NO_ERROR);
+    assert(buffer != 0);
+
+    VertexLayout_invalidateBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, PmdEdge_indexSize(list->index_type) * (list->indices_num ? list->indices_num : 1), list->indices, usage);
+    assert(glGetError() == GL_NO_ERROR);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    return buffer;
+}
+
+/**
+ * 描画範囲のインデックスバッファ内の位置（byte）を取得する
+ */
+GLsizeiptr PmdEdgeList_getIndexOffset(const PmdEdgeList *list, const PmdDrawRange *range) {
+    return PmdEdge_indexSize(list->index_type) * range->indices_begin;
+}
+
+/**
+ * 輪郭を描画する三角形の一覧を解放する
+ */
+void PmdEdgeList_free(PmdEdgeList *list) {
+    if (!list) {
+        return;
+    }
+
+    free(list->indices);
+    free(list->draw_ranges);
+    free(list);
+}
+
+/**
+ * 頂点ごとの押し出し倍率をGL_ARRAY_BUFFERへ転送する。
+ */
+GLuint PmdEdge_createVertexScaleBuffer(const PmdFile *pmd, const GLenum usage) {
+    GLfloat *scales = malloc(sizeof(GLfloat) * (pmd->vertices_num ? pmd->vertices_num : 1));
+    GLuint buffer = 0;
+    GLuint i = 0;
+
+    for (i = 0; i < pmd->vertices_num; ++i) {
+        scales[i] = PmdEdge_isVertexEdge(pmd, i) ? 1.0f : 0.0f;
+    }
+
+    glGenBuffers(1, &buffer);
+    assert(glGetError() == GL_NO_ERROR);
+    assert(buffer != 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * (pmd->vertices_num ? pmd->vertices_num : 1), scales, usage);
+    assert(glGetError() == GL_NO_ERROR);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    free(scales);
+    return buffer;
+}
+
+/**
+ * 輪郭検出の後処理を生成する
+ */
+PmdEdgeOutline* PmdEdgeOutline_create(const GLint width, const GLint height) {
+    if (!ES20_hasExtension("GL_OES_depth_texture")) {
+        __log("PmdEdgeOutline not support depth texture");
+        return NULL;
+    }
+
+    PmdEdgeOutline *result = calloc(1, sizeof(PmdEdgeOutline));
+    result->width = width;
+    result->height = height;
+    result->thickness = 1.5f;
+
+    // 後処理用シェーダーを用意する
+    // 隣接する画素が奥行きの変化率以上に手前にあり、輪郭のマスクを持っていれば輪郭色で塗る
+    // 押し出しによる輪郭と同様に、シルエットの外側へ描画される
+    {
+        const GLchar *vertex_shader_source =
+        // attributes
+                "attribute mediump vec2 attr_pos;"
+                // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // main
+                        "void main() {"
+                        "   gl_Position = vec4(attr_pos, 0.0, 1.0);"
+                        "   vary_uv = attr_pos * 0.5 + 0.5;"
+                        "}";
+
+        const GLchar *fragment_shader_source =
+        // uniforms
+                "uniform sampler2D unif_tex_color;"
+                        "uniform sampler2D unif_tex_depth;"
+                        "uniform mediump vec2 unif_texel;"
+                        "uniform highp vec2 unif_near_far;"
+                        "uniform mediump float unif_threshold;"
+                        "uniform lowp vec4 unif_edge_color;"
+                        // varyings
+                        "varying mediump vec2 vary_uv;"
+                        // functions
+                        "highp float linearDepth(mediump vec2 uv) {"
+                        "   highp float z = texture2D(unif_tex_depth, uv).r * 2.0 - 1.0;"
+                        "   return (2.0 * unif_near_far.x * unif_near_far.y) / (unif_near_far.y + unif_near_far.x - z * (unif_near_far.y - unif_near_far.x));"
+                        "}"
+                        "lowp float edge(highp float center, mediump vec2 uv) {"
+                        "   highp float neighbor = linearDepth(uv);"
+                        "   return step(unif_threshold, (center - neighbor) / neighbor) * texture2D(unif_tex_color, uv).a;"
+                        "}"
+                        // main
+                        "void main() {"
+                        "   lowp vec4 color = texture2D(unif_tex_color, vary_uv);"
+                        "   highp float center = linearDepth(vary_uv);"
+                        "   lowp float e = max(max(edge(center, vary_uv + vec2(unif_texel.x, 0.0)), edge(center, vary_uv - vec2(unif_texel.x, 0.0))),"
+                        "                      max(edge(center, vary_uv + vec2(0.0, unif_texel.y)), edge(center, vary_uv - vec2(0.0, unif_texel.y))));"
+                        "   gl_FragColor = mix(vec4(color.rgb, 1.0), unif_edge_color, e);"
+                        "}";
+
+        result->program = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+
+        result->attr_pos = glGetAttribLocation(result->program, "attr_pos");
+        assert(result->attr_pos >= 0);
+
+        result->unif_tex_color = glGetUniformLocation(result->program, "unif_tex_color");
+        result->unif_tex_depth = glGetUniformLocation(result->program, "unif_tex_depth");
+        result->unif_texel = glGetUniformLocation(result->program, "unif_texel");
+        result->unif_near_far = glGetUniformLocation(result->program, "unif_near_far");
+        result->unif_threshold = glGetUniformLocation(result->program, "unif_threshold");
+        result->unif_edge_color = glGetUniformLocation(result->program, "unif_edge_color");
+        assert(result->unif_tex_color >= 0 && result->unif_tex_depth >= 0);
+        assert(result->unif_texel >= 0 && result->unif_near_far >= 0);
+        assert(result->unif_threshold >= 0 && result->unif_edge_color >= 0);
+    }
+
+    // 全画面を覆う四角形
+    {
+        const GLfloat positions[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+        glGenBuffers(1, &result->quad_buffer);
+        assert(result->quad_buffer != 0);
+        glBindBuffer(GL_ARRAY_BUFFER, result->quad_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+
+    // カラーバッファと深度バッファをテクスチャとして生成する
+    // 同じ解像度で読み出すため、フィルタはGL_NEARESTとする
+    {
+        GLuint textures[2] = { 0 };
+        int i = 0;
+
+        glGenTextures(2, textures);
+        result->color_texture = textures[0];
+        result->depth_texture = textures[1];
+
+        for (i = 0; i < 2; ++i) {
+            glBindTexture(GL_TEXTURE_2D, textures[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, result->color_texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindTexture(GL_TEXTURE_2D, result->depth_texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+
+    // テクスチャをフレームバッファへアタッチする
+    {
+        GLint bindFramebuffer = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bindFramebuffer);
+
+        glGenFramebuffers(1, &result->framebuffer);
+        assert(result->framebuffer != 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, result->framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, result->color_texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, result->depth_texture, 0);
+        assert(glGetError() == GL_NO_ERROR);
+
+        // フレームバッファとして有効な状態になっていることを確認する
+        assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint) bindFramebuffer);
+    }
+
+    return result;
+}
+
+/**
+ * 描画先を後処理用のフレームバッファへ切り替える
+ */
+void PmdEdgeOutline_begin(PmdEdgeOutline *outline) {
+    // iOS互換のため、元のフレームバッファを保存する
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &outline->default_framebuffer);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, outline->framebuffer);
+    glViewport(0, 0, outline->width, outline->height);
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+/**
+ * 描画先を元のフレームバッファへ戻し、輪郭を合成して全画面へ描画する
+ */
+void PmdEdgeOutline_end(PmdEdgeOutline *outline, const GLfloat near, const GLfloat far, const GLfloat threshold, const vec4 edge_color) {
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint) outline->default_framebuffer);
+    glViewport(0, 0, outline->width, outline->height);
+
+    // 全画面の四角形は深度テスト・カリングを行わずに描画する
+    const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    const GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    glUseProgram(outline->program);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, outline->depth_texture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, outline->color_texture);
+    glUniform1i(outline->unif_tex_color, 0);
+    glUniform1i(outline->unif_tex_depth, 1);
+
+    glUniform2f(outline->unif_texel, outline->thickness / (GLfloat) outline->width, outline->thickness / (GLfloat) outline->height);
+    glUniform2f(outline->unif_near_far, near, far);
+    glUniform1f(outline->unif_threshold, threshold);
+    glUniform4f(outline->unif_edge_color, edge_color.x, edge_color.y, edge_color.z, edge_color.w);
+
+    // 属性を直接設定するため、VertexLayoutのバインドを解除する
+    VertexLayout_unbind();
+    glBindBuffer(GL_ARRAY_BUFFER, outline->quad_buffer);
+    glEnableVertexAttribArray(outline->attr_pos);
+    glVertexAttribPointer(outline->attr_pos, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 2, (GLvoid*) 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    if (depthTest) {
+        glEnable(GL_DEPTH_TEST);
+    }
+    if (cullFace) {
+        glEnable(GL_CULL_FACE);
+    }
+}
+
+/**
+ * 輪郭検出の後処理を解放する
+ */
+void PmdEdgeOutline_free(PmdEdgeOutline *outline) {
+    if (!outline) {
+        return;
+    }
+
+    const GLuint textures[2] = { outline->color_texture, outline->depth_texture };
+    glDeleteFramebuffers(1, &outline->framebuffer);
+    glDeleteTextures(2, textures);
+    glDeleteBuffers(1, &outline->quad_buffer);
+    glDeleteProgram(outline->program);
+    assert(glGetError() == GL_NO_ERROR);
+
+    free(outline);
+}
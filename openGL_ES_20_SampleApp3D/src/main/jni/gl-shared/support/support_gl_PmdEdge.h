@@ -0,0 +1,181 @@
+/*
+ * support_gl_PmdEdge.h
+ *
+ * PMDのトゥーン輪郭
+ * 材質・頂点の輪郭フラグを読み込み時に反映し、輪郭を描画する三角形だけのインデックスを材質ごとの範囲として生成する。
+ * 輪郭を描画しない材質の三角形は、法線方向へ押し出す2パス目の描画から取り除かれる。
+ * 輪郭の無効な頂点は押し出し量を0とするため、頂点ごとの倍率を輪郭のシェーダーへ渡す。
+ * 2パス目を行わない代替として、深度バッファの不連続を検出して輪郭を描く後処理も提供する。
+ */
+
+#ifndef SUPPORT_GL_PMDEDGE_H_
+#define SUPPORT_GL_PMDEDGE_H_
+
+/**
+ * 輪郭を描画する三角形の一覧
+ */
+typedef struct PmdEdgeList {
+    /**
+     * GL_UNSIGNED_SHORT / GL_UNSIGNED_INT
+     * PmdFile.index_typeと同じ型となる
+     */
+    GLenum index_type;
+
+    /**
+     * 輪郭を描画する三角形のインデックス
+     * 材質順に詰めて格納し、PmdFileと同じ頂点を参照する
+     */
+    GLvoid *indices;
+
+    /**
+     * インデックス数
+     */
+    GLuint indices_num;
+
+    /**
+     * 材質ごとの描画範囲
+     * PmdEdgeList_createFromDrawMeshで生成した場合はサブメッシュごとの範囲となる
+     * 輪郭を描画しない材質はindices_numが0となる
+     */
+    PmdDrawRange *draw_ranges;
+
+    /**
+     * 材質数（サブメッシュごとの場合はサブメッシュ数）
+     */
+    GLuint materials_num;
+
+    /**
+     * 輪郭を描画する材質数
+     */
+    GLuint edge_materials_num;
+
+    /**
+     * 元のPMDのインデックス数
+     */
+    GLuint source_indices_num;
+} PmdEdgeList;
+
+/**
+ * 深度バッファから輪郭を検出する後処理
+ * 描画先のカラーバッファのアルファ値を輪郭のマスクとして扱い、
+ * アルファ値が0の画素同士の境界には輪郭を描かない。
+ */
+typedef struct PmdEdgeOutline {
+    /**
+     * 描画先のフレームバッファ
+     */
+    GLuint framebuffer;
+
+    /**
+     * カラーバッファ
+     */
+    GLuint color_texture;
+
+    /**
+     * 深度バッファ
+     */
+    GLuint depth_texture;
+
+    /**
+     * フレームバッファの大きさ
+     */
+    GLint width;
+    GLint height;
+
+    /**
+     * 輪郭の太さ（ピクセル）
+     */
+    GLfloat thickness;
+
+    /**
+     * 全画面を覆う四角形の頂点バッファ
+     */
+    GLuint quad_buffer;
+
+    /**
+     * 後処理用シェーダー
+     */
+    GLuint program;
+    GLint attr_pos;
+    GLint unif_tex_color;
+    GLint unif_tex_depth;
+    GLint unif_texel;
+    GLint unif_near_far;
+    GLint unif_threshold;
+    GLint unif_edge_color;
+
+    /**
+     * PmdEdgeOutline_begin呼び出し時のフレームバッファ
+     */
+    GLint default_framebuffer;
+} PmdEdgeOutline;
+
+/**
+ * 材質・頂点の輪郭フラグから、輪郭を描画する三角形の一覧を生成する。
+ * 輪郭の無効な頂点だけで構成される三角形も取り除く。
+ */
+extern PmdEdgeList* PmdEdgeList_create(const PmdFile *pmd);
+
+/**
+ * 材質ごとの描画範囲とインデックスから、輪郭を描画する三角形の一覧を生成する。
+ * LODチェーンの段のように、PMDの頂点を参照する別のインデックスへ同じ判定を行う。
+ */
+extern PmdEdgeList* PmdEdgeList_createFromRanges(const PmdFile *pmd, const GLenum index_type, const GLvoid *indices, const PmdDrawRange *draw_ranges);
+
+/**
+ * 分割したメッシュのサブメッシュごとに、輪郭を描画する三角形の一覧を生成する。
+ * インデックスはサブメッシュ内の頂点番号のまま格納する。
+ */
+extern PmdEdgeList* PmdEdgeList_createFromDrawMesh(const PmdFile *pmd, const PmdDrawMesh *mesh);
+
+/**
+ * 輪郭のインデックスバッファを生成する
+ */
+extern GLuint PmdEdgeList_createIndexBuffer(const PmdEdgeList *list, const GLenum usage);
+
+/**
+ * 描画範囲のインデックスバッファ内の位置（byte）を取得する
+ */
+extern GLsizeiptr PmdEdgeList_getIndexOffset(const PmdEdgeList *list, const PmdDrawRange *range);
+
+/**
+ * 輪郭を描画する三角形の一覧を解放する
+ */
+extern void PmdEdgeList_free(PmdEdgeList *list);
+
+/**
+ * 頂点の輪郭が有効であればtrueを返す
+ */
+extern bool PmdEdge_isVertexEdge(const PmdFile *pmd, const GLuint vertex);
+
+/**
+ * 頂点ごとの押し出し倍率（輪郭が有効なら1.0、無効なら0.0）をGL_ARRAY_BUFFERへ転送する。
+ * 1頂点あたりGLfloat1つで、PmdFileの頂点と同じ順に並ぶ。
+ */
+extern GLuint PmdEdge_createVertexScaleBuffer(const PmdFile *pmd, const GLenum usage);
+
+/**
+ * 輪郭検出の後処理を生成する
+ * GL_OES_depth_textureに対応していない場合はNULLを返す。
+ */
+extern PmdEdgeOutline* PmdEdgeOutline_create(const GLint width, const GLint height);
+
+/**
+ * 描画先を後処理用のフレームバッファへ切り替える
+ * 以降の描画はアルファ値へ輪郭のマスク（0.0 or 1.0）を書き込み、背景はアルファ値0でクリアする。
+ */
+extern void PmdEdgeOutline_begin(PmdEdgeOutline *outline);
+
+/**
+ * 描画先を元のフレームバッファへ戻し、輪郭を合成して全画面へ描画する
+ * near・farには描画時の射影行列と同じ値を指定する。
+ * thresholdは輪郭とみなす奥行きの変化率となる。
+ */
+extern void PmdEdgeOutline_end(PmdEdgeOutline *outline, const GLfloat near, const GLfloat far, const GLfloat threshold, const vec4 edge_color);
+
+/**
+ * 輪郭検出の後処理を解放する
+ */
+extern void PmdEdgeOutline_free(PmdEdgeOutline *outline);
+
+#endif /* SUPPORT_GL_PMDEDGE_H_ */
@@ -0,0 +1,796 @@
+/*
+ * support_gl_PmdLod.c
+ */
+
+#include    "support.h"
+
+/**
+ * 開いた境界とUVの継ぎ目を保持するための重み
+ */
+#define PMDLOD_BOUNDARY_WEIGHT  10.0
+
+/**
+ * 誤差の二次形式
+ * 対称行列の上三角と重みの合計を保持する
+ */
+typedef struct PmdLodQuadric {
+    double a2, ab, ac, ad;
+    double b2, bc, bd;
+    double c2, cd;
+    double d2;
+    double weight;
+} PmdLodQuadric;
+
+/**
+ * 縮約の候補
+ */
+typedef struct PmdLodCollapse {
+    /**
+     * 縮約後の誤差
+     */
+    GLfloat cost;
+
+    /**
+     * 位置fromを位置toへ寄せる
+     */
+    GLuint from;
+    GLuint to;
+} PmdLodCollapse;
+
+/**
+ * 境界判定用の辺
+ */
+typedef struct PmdLodEdge {
+    GLuint v0;
+    GLuint v1;
+    GLuint triangle;
+} PmdLodEdge;
+
+/**
+ * 簡略化の作業情報
+ * 縮約は位置単位で行い、同じ位置にある頂点（UVの継ぎ目の両側など）はそれぞれ辺の反対側の頂点へ寄せる。
+ */
+typedef struct PmdLodContext {
+    const PmdFile *pmd;
+
+    /**
+     * 完全に一致する頂点をまとめた代表頂点
+     */
+    GLuint *canonical;
+
+    /**
+     * 頂点の位置番号（同じ位置にある代表頂点のうち最初の頂点番号）
+     */
+    GLuint *positions;
+
+    /**
+     * 位置 -> 代表頂点の一覧
+     */
+    GLuint *position_offsets;
+    GLuint *position_vertices;
+
+    /**
+     * 移動できない位置
+     */
+    GLubyte *locked;
+
+    /**
+     * 位置ごとの誤差
+     */
+    PmdLodQuadric *quadrics;
+
+    /**
+     * 縮約先の頂点
+     */
+    GLuint *remap;
+
+    /**
+     * 縮約を行ったパス番号
+     * 同じパスで周囲の位置を続けて縮約しないようにする
+     */
+    GLuint *touched;
+    GLuint pass;
+
+    /**
+     * 頂点 -> 三角形の隣接情報
+     */
+    GLuint *adjacency_offsets;
+    GLuint *adjacency;
+
+    /**
+     * 縮約候補
+     */
+    PmdLodCollapse *collapses;
+
+    /**
+     * 1回の縮約で寄せる頂点の組
+     */
+    GLuint *pending;
+} PmdLodContext;
+
+/**
+ * 平面を二次形式へ加える
+ */
+static void PmdLodQuadric_addPlane(PmdLodQuadric *q, const double a, const double b, const double c, const double d, const double weight) {
+    q->a2 += a * a * weight;
+    q->ab += a * b * weight;
+    q->ac += a * c * weight;
+    q->ad += a * d * weight;
+    q->b2 += b * b * weight;
+    q->bc += b * c * weight;
+    q->bd += b * d * weight;
+    q->c2 += c * c * weight;
+    q->cd += c * d * weight;
+    q->d2 += d * d * weight;
+    q->weight += weight;
+}
+
+/**
+ * 二次形式を加える
+ */
+static void PmdLodQuadric_add(PmdLodQuadric *q, const PmdLodQuadric *r) {
+    q->a2 += r->a2;
+    q->ab += r->ab;
+    q->ac += r->ac;
+    q->ad += r->ad;
+    q->b2 += r->b2;
+    q->bc += r->bc;
+    q->bd += r->bd;
+    q->c2 += r->c2;
+    q->cd += r->cd;
+    q->d2 += r->d2;
+    q->weight += r->weight;
+}
+
+/**
+ * 位置での誤差（平面からの距離の二乗和）を求める
+ */
+static double PmdLodQuadric_eval(const PmdLodQuadric *q, const vec3 *p) {
+    const double x = p->x;
+    const double y = p->y;
+    const double z = p->z;
+    return q->a2 * x * x + 2.0 * q->ab * x * y + 2.0 * q->ac * x * z + 2.0 * q->ad * x //
+    + q->b2 * y * y + 2.0 * q->bc * y * z + 2.0 * q->bd * y //
+    + q->c2 * z * z + 2.0 * q->cd * z //
+    + q->d2;
+}
+
+/**
+ * 縮約候補をコストの小さい順に並べる
+ */
+static int PmdLod_compareCollapse(const void *a, const void *b) {
+    const GLfloat ca = ((const PmdLodCollapse*) a)->cost;
+    const GLfloat cb = ((const PmdLodCollapse*) b)->cost;
+    return ca < cb ? -1 : (ca > cb ? 1 : 0);
+}
+
+/**
+ * 辺を頂点番号順に並べる
+ */
+static int PmdLod_compareEdge(const void *a, const void *b) {
+    const PmdLodEdge *ea = (const PmdLodEdge*) a;
+    const PmdLodEdge *eb = (const PmdLodEdge*) b;
+    if (ea->v0 != eb->v0) {
+        return ea->v0 < eb->v0 ? -1 : 1;
+    }
+    if (ea->v1 != eb->v1) {
+        return ea->v1 < eb->v1 ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * 頂点の位置を取得する
+ */
+static const vec3* PmdLod_position(const PmdLodContext *context, const GLuint vertex) {
+    return &context->pmd->vertices[vertex].position;
+}
+
+/**
+ * 位置のハッシュ値を求める
+ */
+static GLuint PmdLod_hashPosition(const vec3 *position) {
+    const GLuint *bits = (const GLuint*) position;
+    GLuint hash = 2166136261u;
+    int i = 0;
+    for (i = 0; i < 3; ++i) {
+        hash = (hash ^ bits[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * 代表頂点と位置番号を求め、移動できない位置を決める
+ */
+static void PmdLod_classifyVertices(PmdLodContext *context) {
+    const PmdFile *pmd = context->pmd;
+    const GLuint vertices_num = pmd->vertices_num;
+    GLuint i = 0;
+    GLuint k = 0;
+
+    GLuint tableSize = 1;
+    while (tableSize < vertices_num * 2) {
+        tableSize <<= 1;
+    }
+    GLint *vertexTable = malloc(sizeof(GLint) * tableSize);
+    GLint *positionTable = malloc(sizeof(GLint) * tableSize);
+    memset(vertexTable, 0xFF, sizeof(GLint) * tableSize);
+    memset(positionTable, 0xFF, sizeof(GLint) * tableSize);
+
+    for (i = 0; i < vertices_num; ++i) {
+        const PmdVertex *v = &pmd->vertices[i];
+        const GLuint positionHash = PmdLod_hashPosition(&v->position);
+
+        // 完全に一致する頂点をまとめる
+        GLuint hash = positionHash;
+        const GLuint *bits = (const GLuint*) &v->uv;
+        for (k = 0; k < 2; ++k) {
+            hash = (hash ^ bits[k]) * 16777619u;
+        }
+        GLuint slot = hash & (tableSize - 1);
+        while (vertexTable[slot] >= 0 && memcmp(&pmd->vertices[vertexTable[slot]], v, sizeof(PmdVertex))) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (vertexTable[slot] >= 0) {
+            context->canonical[i] = vertexTable[slot];
+            context->positions[i] = context->positions[vertexTable[slot]];
+            continue;
+        }
+        vertexTable[slot] = i;
+        context->canonical[i] = i;
+
+        // 同じ位置の代表頂点をまとめる
+        slot = positionHash & (tableSize - 1);
+        while (positionTable[slot] >= 0 && memcmp(PmdLod_position(context, positionTable[slot]), &v->position, sizeof(vec3))) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (positionTable[slot] < 0) {
+            positionTable[slot] = i;
+        }
+        context->positions[i] = positionTable[slot];
+    }
+
+    free(vertexTable);
+    free(positionTable);
+
+    // 位置ごとの代表頂点の一覧を作る
+    memset(context->position_offsets, 0x00, sizeof(GLuint) * (vertices_num + 1));
+    for (i = 0; i < vertices_num; ++i) {
+        if (context->canonical[i] == i) {
+            ++context->position_offsets[context->positions[i] + 1];
+        }
+    }
+    for (i = 0; i < vertices_num; ++i) {
+        context->position_offsets[i + 1] += context->position_offsets[i];
+    }
+    for (i = 0; i < vertices_num; ++i) {
+        if (context->canonical[i] == i) {
+            context->position_vertices[context->position_offsets[context->positions[i]]++] = i;
+        }
+    }
+    for (i = vertices_num; i > 0; --i) {
+        context->position_offsets[i] = context->position_offsets[i - 1];
+    }
+    context->position_offsets[0] = 0;
+
+    // 複数の材質から参照される位置は材質の境界となる
+    {
+        GLuint *materials = malloc(sizeof(GLuint) * vertices_num);
+        memset(materials, 0xFF, sizeof(GLuint) * vertices_num);
+        for (i = 0; i < pmd->materials_num; ++i) {
+            const PmdDrawRange *range = &pmd->draw_ranges[i];
+            for (k = 0; k < range->indices_num; ++k) {
+                const GLuint position = context->positions[PmdFile_getIndex((PmdFile*) pmd, range->indices_begin + k)];
+                if (materials[position] == 0xFFFFFFFF) {
+                    materials[position] = i;
+                } else if (materials[position] != i) {
+                    context->locked[position] = 1;
+                }
+            }
+        }
+        free(materials);
+    }
+
+    // 表情で動く頂点は形状が変わるため移動しない
+    if (pmd->morphs_num) {
+        const PmdMorph *base = &pmd->morphs[0];
+        for (i = 0; i < base->vertices_num; ++i) {
+            context->locked[context->positions[base->indices[i]]] = 1;
+        }
+    }
+}
+
+/**
+ * 材質の三角形から誤差の二次形式を初期化する
+ */
+static void PmdLod_initQuadrics(PmdLodContext *context, const GLuint *indices, const GLuint indices_num) {
+    const GLuint triangles_num = indices_num / 3;
+    GLuint i = 0;
+
+    for (i = 0; i < indices_num; ++i) {
+        memset(&context->quadrics[context->positions[indices[i]]], 0x00, sizeof(PmdLodQuadric));
+    }
+
+    // 三角形の平面を面積で重み付けして加える
+    for (i = 0; i < triangles_num; ++i) {
+        const vec3 *p0 = PmdLod_position(context, indices[i * 3 + 0]);
+        const vec3 *p1 = PmdLod_position(context, indices[i * 3 + 1]);
+        const vec3 *p2 = PmdLod_position(context, indices[i * 3 + 2]);
+
+        const vec3 n = vec3_cross(vec3_create(p1->x - p0->x, p1->y - p0->y, p1->z - p0->z), vec3_create(p2->x - p0->x, p2->y - p0->y, p2->z - p0->z));
+        const double length = sqrt((double) n.x * n.x + (double) n.y * n.y + (double) n.z * n.z);
+        if (length <= 0) {
+            continue;
+        }
+
+        const double a = n.x / length;
+        const double b = n.y / length;
+        const double c = n.z / length;
+        const double d = -(a * p0->x + b * p0->y + c * p0->z);
+        const double area = length * 0.5;
+
+        int k = 0;
+        for (k = 0; k < 3; ++k) {
+            PmdLodQuadric_addPlane(&context->quadrics[context->positions[indices[i * 3 + k]]], a, b, c, d, area);
+        }
+    }
+
+    // 頂点番号で1つの三角形からしか参照されない辺は開いた境界かUVの継ぎ目となる
+    // 辺に沿って面と垂直な平面を加え、輪郭や継ぎ目が崩れないようにする
+    {
+        PmdLodEdge *edges = malloc(sizeof(PmdLodEdge) * (indices_num ? indices_num : 1));
+        for (i = 0; i < indices_num; ++i) {
+            const GLuint a = indices[i];
+            const GLuint b = indices[(i % 3) == 2 ? i - 2 : i + 1];
+            edges[i].v0 = a < b ? a : b;
+            edges[i].v1 = a < b ? b : a;
+            edges[i].triangle = i / 3;
+        }
+        qsort(edges, indices_num, sizeof(PmdLodEdge), PmdLod_compareEdge);
+
+        GLuint begin = 0;
+        while (begin < indices_num) {
+            GLuint end = begin + 1;
+            while (end < indices_num && !PmdLod_compareEdge(&edges[begin], &edges[end])) {
+                ++end;
+            }
+
+            if (end - begin == 1) {
+                const PmdLodEdge *edge = &edges[begin];
+                const GLuint *triangle = indices + edge->triangle * 3;
+                const vec3 *p0 = PmdLod_position(context, edge->v0);
+                const vec3 *p1 = PmdLod_position(context, edge->v1);
+                const vec3 *t0 = PmdLod_position(context, triangle[0]);
+                const vec3 *t1 = PmdLod_position(context, triangle[1]);
+                const vec3 *t2 = PmdLod_position(context, triangle[2]);
+
+                const vec3 e = vec3_create(p1->x - p0->x, p1->y - p0->y, p1->z - p0->z);
+                const vec3 face = vec3_cross(vec3_create(t1->x - t0->x, t1->y - t0->y, t1->z - t0->z), vec3_create(t2->x - t0->x, t2->y - t0->y, t2->z - t0->z));
+                const vec3 n = vec3_cross(e, face);
+                const double length = sqrt((double) n.x * n.x + (double) n.y * n.y + (double) n.z * n.z);
+                if (length > 0) {
+                    const double a = n.x / length;
+                    const double b = n.y / length;
+                    const double c = n.z / length;
+                    const double d = -(a * p0->x + b * p0->y + c * p0->z);
+                    const double weight = ((double) e.x * e.x + (double) e.y * e.y + (double) e.z * e.z) * PMDLOD_BOUNDARY_WEIGHT;
+
+                    PmdLodQuadric_addPlane(&context->quadrics[context->positions[edge->v0]], a, b, c, d, weight);
+                    PmdLodQuadric_addPlane(&context->quadrics[context->positions[edge->v1]], a, b, c, d, weight);
+                }
+            }
+            begin = end;
+        }
+
+        free(edges);
+    }
+}
+
+/**
+ * 頂点から三角形への隣接情報を構築する
+ */
+static void PmdLod_buildAdjacency(PmdLodContext *context, const GLuint *indices, const GLuint indices_num) {
+    const GLuint vertices_num = context->pmd->vertices_num;
+    GLuint i = 0;
+
+    memset(context->adjacency_offsets, 0x00, sizeof(GLuint) * (vertices_num + 1));
+    for (i = 0; i < indices_num; ++i) {
+        ++context->adjacency_offsets[indices[i] + 1];
+    }
+    for (i = 0; i < vertices_num; ++i) {
+        context->adjacency_offsets[i + 1] += context->adjacency_offsets[i];
+    }
+    for (i = 0; i < indices_num; ++i) {
+        context->adjacency[context->adjacency_offsets[indices[i]]++] = i / 3;
+    }
+
+    // 格納で進めた先頭位置を戻す
+    for (i = vertices_num; i > 0; --i) {
+        context->adjacency_offsets[i] = context->adjacency_offsets[i - 1];
+    }
+    context->adjacency_offsets[0] = 0;
+}
+
+/**
+ * 頂点fromをtoへ寄せた場合に裏返るか潰れる三角形があればtrueを返す。
+ * removedには縮約で消える三角形の数を加える。
+ */
+static bool PmdLod_checkFlip(const PmdLodContext *context, const GLuint *indices, const GLuint from, const GLuint to, GLuint *removed) {
+    const vec3 *target = PmdLod_position(context, to);
+    GLuint i = 0;
+    int k = 0;
+
+    for (i = context->adjacency_offsets[from]; i < context->adjacency_offsets[from + 1]; ++i) {
+        const GLuint *triangle = indices + context->adjacency[i] * 3;
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+            ++(*removed);
+            continue;
+        }
+
+        // fromを先頭にして他の2頂点を取り出す
+        for (k = 0; k < 3 && triangle[k] != from; ++k) {
+        }
+        const vec3 *p0 = PmdLod_position(context, from);
+        const vec3 *p1 = PmdLod_position(context, triangle[(k + 1) % 3]);
+        const vec3 *p2 = PmdLod_position(context, triangle[(k + 2) % 3]);
+
+        const vec3 before = vec3_cross(vec3_create(p1->x - p0->x, p1->y - p0->y, p1->z - p0->z), vec3_create(p2->x - p0->x, p2->y - p0->y, p2->z - p0->z));
+        const vec3 after = vec3_cross(vec3_create(p1->x - target->x, p1->y - target->y, p1->z - target->z), vec3_create(p2->x - target->x, p2->y - target->y, p2->z - target->z));
+        if (vec3_dot(before, after) <= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 位置fromの各頂点について、位置toにある辺の反対側の頂点を探す。
+ * 見つからない頂点がある場合（UVの継ぎ目を横切る縮約など）はfalseを返す。
+ * 寄せる頂点の組はcontext->pendingへ格納し、組の数をpending_numへ格納する。
+ */
+static bool PmdLod_findPartners(PmdLodContext *context, const GLuint *indices, const GLuint from, const GLuint to, GLuint *pending_num) {
+    GLuint i = 0;
+    GLuint t = 0;
+    int k = 0;
+
+    *pending_num = 0;
+    for (i = context->position_offsets[from]; i < context->position_offsets[from + 1]; ++i) {
+        const GLuint vertex = context->position_vertices[i];
+        if (context->adjacency_offsets[vertex] == context->adjacency_offsets[vertex + 1]) {
+            // 既に縮約された頂点か、この材質で使われない頂点
+            continue;
+        }
+
+        GLuint partner = 0xFFFFFFFF;
+        for (t = context->adjacency_offsets[vertex]; t < context->adjacency_offsets[vertex + 1] && partner == 0xFFFFFFFF; ++t) {
+            const GLuint *triangle = indices + context->adjacency[t] * 3;
+            for (k = 0; k < 3; ++k) {
+                if (context->positions[triangle[k]] == to) {
+                    partner = triangle[k];
+                    break;
+                }
+            }
+        }
+        if (partner == 0xFFFFFFFF) {
+            return false;
+        }
+
+        context->pending[(*pending_num) * 2 + 0] = vertex;
+        context->pending[(*pending_num) * 2 + 1] = partner;
+        ++(*pending_num);
+    }
+    return (*pending_num) > 0;
+}
+
+/**
+ * 三角形数がtarget以下になるまで縮約を繰り返す。
+ * 簡略化後のインデックス数を返し、errorを最大誤差で更新する。
+ */
+static GLuint PmdLod_simplify(PmdLodContext *context, GLuint *indices, GLuint indices_num, const GLuint target_triangles, GLfloat *error) {
+    GLuint triangles_num = indices_num / 3;
+    GLuint i = 0;
+    GLuint p = 0;
+    int k = 0;
+
+    while (triangles_num > target_triangles) {
+        PmdLod_buildAdjacency(context, indices, indices_num);
+
+        // 辺の両方向を縮約候補とする
+        GLuint collapses_num = 0;
+        for (i = 0; i < indices_num; ++i) {
+            const GLuint a = context->positions[indices[i]];
+            const GLuint b = context->positions[indices[(i % 3) == 2 ? i - 2 : i + 1]];
+            const GLuint pairs[2][2] = { { a, b }, { b, a } };
+            if (a == b) {
+                continue;
+            }
+
+            for (k = 0; k < 2; ++k) {
+                const GLuint from = pairs[k][0];
+                const GLuint to = pairs[k][1];
+                if (context->locked[from]) {
+                    continue;
+                }
+
+                PmdLodQuadric q = context->quadrics[from];
+                PmdLodQuadric_add(&q, &context->quadrics[to]);
+
+                PmdLodCollapse *collapse = &context->collapses[collapses_num++];
+                collapse->from = from;
+                collapse->to = to;
+                collapse->cost = (GLfloat) (fmax(PmdLodQuadric_eval(&q, PmdLod_position(context, to)), 0.0) / (q.weight > 0 ? q.weight : 1.0));
+            }
+        }
+        if (!collapses_num) {
+            break;
+        }
+        qsort(context->collapses, collapses_num, sizeof(PmdLodCollapse), PmdLod_compareCollapse);
+
+        // 誤差の小さい順に、互いに干渉しない縮約だけを適用する
+        ++context->pass;
+        GLuint applied = 0;
+        for (i = 0; i < collapses_num && triangles_num > target_triangles; ++i) {
+            const PmdLodCollapse *collapse = &context->collapses[i];
+            if (context->touched[collapse->from] == context->pass || context->touched[collapse->to] == context->pass) {
+                continue;
+            }
+
+            GLuint pending_num = 0;
+            if (!PmdLod_findPartners(context, indices, collapse->from, collapse->to, &pending_num)) {
+                continue;
+            }
+
+            GLuint removed = 0;
+            bool flipped = false;
+            for (p = 0; p < pending_num && !flipped; ++p) {
+                flipped = PmdLod_checkFlip(context, indices, context->pending[p * 2 + 0], context->pending[p * 2 + 1], &removed);
+            }
+            if (flipped) {
+                continue;
+            }
+
+            for (p = 0; p < pending_num; ++p) {
+                const GLuint from = context->pending[p * 2 + 0];
+                context->remap[from] = context->pending[p * 2 + 1];
+
+                // 周囲の位置はこのパスでは縮約しない
+                GLuint t = 0;
+                for (t = context->adjacency_offsets[from]; t < context->adjacency_offsets[from + 1]; ++t) {
+                    const GLuint *triangle = indices + context->adjacency[t] * 3;
+                    for (k = 0; k < 3; ++k) {
+                        context->touched[context->positions[triangle[k]]] = context->pass;
+                    }
+                }
+            }
+            PmdLodQuadric_add(&context->quadrics[collapse->to], &context->quadrics[collapse->from]);
+
+            triangles_num -= removed;
+            *error = fmaxf(*error, sqrtf(collapse->cost));
+            ++applied;
+        }
+        if (!applied) {
+            break;
+        }
+
+        // 縮約先へ付け替え、潰れた三角形を取り除く
+        GLuint result_num = 0;
+        for (i = 0; i < indices_num; i += 3) {
+            const GLuint a = context->remap[indices[i + 0]];
+            const GLuint b = context->remap[indices[i + 1]];
+            const GLuint c = context->remap[indices[i + 2]];
+            if (a == b || b == c || c == a) {
+                continue;
+            }
+            indices[result_num++] = a;
+            indices[result_num++] = b;
+            indices[result_num++] = c;
+        }
+        indices_num = result_num;
+        triangles_num = indices_num / 3;
+    }
+
+    return indices_num;
+}
+
+/**
+ * PMDを簡略化してLODチェーンを生成する。
+ */
+PmdLodChain* PmdLodChain_create(const PmdFile *pmd, const int levels_num, const GLfloat ratio) {
+    assert(levels_num > 0 && levels_num <= PMDLOD_LEVELS_MAX);
+
+    const GLuint vertices_num = pmd->vertices_num;
+    const GLuint buffer_num = vertices_num ? vertices_num : 1;
+    const GLuint indices_buffer_num = pmd->indices_num ? pmd->indices_num : 1;
+    PmdLodChain *result = calloc(1, sizeof(PmdLodChain));
+    result->index_type = pmd->index_type;
+    result->levels_num = levels_num;
+    result->materials_num = pmd->materials_num;
+
+    PmdLodContext context = { 0 };
+    context.pmd = pmd;
+    context.canonical = malloc(sizeof(GLuint) * buffer_num);
+    context.positions = malloc(sizeof(GLuint) * buffer_num);
+    context.position_offsets = malloc(sizeof(GLuint) * (vertices_num + 1));
+    context.position_vertices = malloc(sizeof(GLuint) * buffer_num);
+    context.locked = calloc(buffer_num, sizeof(GLubyte));
+    context.quadrics = malloc(sizeof(PmdLodQuadric) * buffer_num);
+    context.remap = malloc(sizeof(GLuint) * buffer_num);
+    context.touched = calloc(buffer_num, sizeof(GLuint));
+    context.adjacency_offsets = malloc(sizeof(GLuint) * (vertices_num + 1));
+    context.adjacency = malloc(sizeof(GLuint) * indices_buffer_num);
+    context.collapses = malloc(sizeof(PmdLodCollapse) * indices_buffer_num * 2);
+    context.pending = malloc(sizeof(GLuint) * buffer_num * 2);
+
+    GLuint i = 0;
+    GLuint m = 0;
+    int level = 0;
+
+    PmdLod_classifyVertices(&context);
+    for (i = 0; i < vertices_num; ++i) {
+        context.remap[i] = i;
+    }
+
+    for (level = 0; level < levels_num; ++level) {
+        result->levels[level].draw_ranges = calloc(pmd->materials_num ? pmd->materials_num : 1, sizeof(PmdDrawRange));
+    }
+
+    // 全段のインデックスは元のインデックス数 × 段数に収まる
+    GLuint *indices = malloc(sizeof(GLuint) * indices_buffer_num * levels_num);
+    GLuint *work = malloc(sizeof(GLuint) * indices_buffer_num);
+    GLuint **levelBuffers = calloc(levels_num, sizeof(GLuint*));
+    GLuint levelIndices[PMDLOD_LEVELS_MAX] = { 0 };
+    GLfloat errors[PMDLOD_LEVELS_MAX] = { 0 };
+    for (level = 1; level < levels_num; ++level) {
+        levelBuffers[level] = malloc(sizeof(GLuint) * indices_buffer_num);
+    }
+
+    // 0段目は元のメッシュをそのまま使う
+    GLuint indices_num = 0;
+    for (i = 0; i < pmd->indices_num; ++i) {
+        indices[indices_num++] = PmdFile_getIndex((PmdFile*) pmd, i);
+    }
+    result->levels[0].indices_num = pmd->indices_num;
+    memcpy(result->levels[0].draw_ranges, pmd->draw_ranges, sizeof(PmdDrawRange) * pmd->materials_num);
+
+    // 材質ごとに段階的に簡略化し、各段の結果を書き出す
+    for (m = 0; m < pmd->materials_num; ++m) {
+        const PmdDrawRange *range = &pmd->draw_ranges[m];
+        GLuint work_num = range->indices_num;
+        GLfloat error = 0;
+
+        for (i = 0; i < work_num; ++i) {
+            work[i] = context.canonical[PmdFile_getIndex((PmdFile*) pmd, range->indices_begin + i)];
+        }
+        PmdLod_initQuadrics(&context, work, work_num);
+
+        GLuint target = work_num / 3;
+        for (level = 1; level < levels_num; ++level) {
+            target = (GLuint) ((GLfloat) target * ratio);
+            work_num = PmdLod_simplify(&context, work, work_num, target, &error);
+
+            PmdDrawRange *dst = &result->levels[level].draw_ranges[m];
+            dst->indices_begin = levelIndices[level];
+            dst->indices_num = work_num;
+            memcpy(levelBuffers[level] + levelIndices[level], work, sizeof(GLuint) * work_num);
+            levelIndices[level] += work_num;
+
+            errors[level] = fmaxf(errors[level], error);
+        }
+    }
+
+    // 各段を連結する
+    for (level = 1; level < levels_num; ++level) {
+        PmdLodLevel *dst = &result->levels[level];
+        dst->indices_begin = indices_num;
+        dst->indices_num = levelIndices[level];
+        dst->error = fmaxf(errors[level], result->levels[level - 1].error);
+        for (m = 0; m < pmd->materials_num; ++m) {
+            dst->draw_ranges[m].indices_begin += indices_num;
+        }
+
+        memcpy(indices + indices_num, levelBuffers[level], sizeof(GLuint) * levelIndices[level]);
+        indices_num += levelIndices[level];
+        free(levelBuffers[level]);
+
+        __logf("PmdLod level(%d) triangles(%d) error(%f)", level, dst->indices_num / 3, dst->error);
+    }
+    free(levelBuffers);
+
+    // 元のPMDと同じ型で格納する
+    result->indices_num = indices_num;
+    if (result->index_type == GL_UNSIGNED_INT) {
+        result->indices = realloc(indices, sizeof(GLuint) * (indices_num ? indices_num : 1));
+    } else {
+        GLushort *shortIndices = malloc(sizeof(GLushort) * (indices_num ? indices_num : 1));
+        for (i = 0; i < indices_num; ++i) {
+            shortIndices[i] = (GLushort) indices[i];
+        }
+        result->indices = shortIndices;
+        free(indices);
+    }
+
+    free(work);
+    free(context.canonical);
+    free(context.positions);
+    free(context.position_offsets);
+    free(context.position_vertices);
+    free(context.locked);
+    free(context.quadrics);
+    free(context.remap);
+    free(context.touched);
+    free(context.adjacency_offsets);
+    free(context.adjacency);
+    free(context.collapses);
+    free(context.pending);
+
+    return result;
+}
+
+/**
+ * 全段のインデックスを1つのバッファオブジェクトへ転送する。
+ */
+GLuint PmdLodChain_createIndexBuffer(const PmdLodChain *chain, const GLenum usage) {
+    const GLsizeiptr size = (chain->index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort)) * chain->indices_num;
+
+    GLuint result = 0;
+    glGenBuffers(1, &result);
+    assert(result != 0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    VertexLayout_invalidateBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, result);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, chain->indices, usage);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    return result;
+}
+
+/**
+ * glDrawElementsへ渡すインデックスバッファ上のオフセットを取得する。
+ */
+GLsizeiptr PmdLodChain_getIndexOffset(const PmdLodChain *chain, const PmdDrawRange *range) {
+    return (chain->index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort)) * range->indices_begin;
+}
+
+/**
+ * 視点からdistanceだけ離れた位置で、1単位が画面上で何ピクセルになるかを計算する。
+ */
+GLfloat PmdLod_calcPixelsPerUnit(const mat4 projection, const GLfloat distance, const GLint viewport_height) {
+    if (distance <= 0) {
+        return 1000000.0f;
+    }
+    // m[1][1]はY方向の焦点距離となる
+    return projection.m[1][1] * (GLfloat) viewport_height * 0.5f / distance;
+}
+
+/**
+ * 画面上の誤差がtolerance_pixels以下となる最も粗い段を選択する。
+ */
+int PmdLodChain_select(const PmdLodChain *chain, const int current_level, const GLfloat pixels_per_unit, const GLfloat tolerance_pixels) {
+    int level = 0;
+    for (level = chain->levels_num - 1; level > 0; --level) {
+        // 粗い段へ移るときは厳しく、留まるときは緩く判定する
+        const GLfloat limit = tolerance_pixels * (level <= current_level ? (1.0f + PMDLOD_HYSTERESIS) : (1.0f - PMDLOD_HYSTERESIS));
+        if (chain->levels[level].error * pixels_per_unit <= limit) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+/**
+ * LODチェーンを解放する
+ */
+void PmdLodChain_free(PmdLodChain *chain) {
+    if (!chain) {
+        return;
+    }
+
+    int i = 0;
+    for (i = 0; i < chain->levels_num; ++i) {
+        free(chain->levels[i].draw_ranges);
+    }
+    free(chain->indices);
+    free(chain);
+}
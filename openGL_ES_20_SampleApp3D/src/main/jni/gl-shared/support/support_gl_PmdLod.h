@@ -0,0 +1,117 @@
+/*
+ * support_gl_PmdLod.h
+ *
+ * PMDの詳細度(LOD)チェーン
+ * Quadric Error Metricsによる辺の縮約でメッシュを段階的に簡略化し、
+ * 画面上の大きさに応じて描画する段を選択する。
+ * 縮約は既存の頂点へ寄せる（Half-Edge Collapse）ため、頂点バッファは全ての段で共有できる。
+ */
+
+#ifndef SUPPORT_GL_PMDLOD_H_
+#define SUPPORT_GL_PMDLOD_H_
+
+/**
+ * LODの最大段数（元のメッシュを含む）
+ */
+#define PMDLOD_LEVELS_MAX       4
+
+/**
+ * 段を切り替える際の許容誤差の幅
+ * 許容誤差の前後この割合の間は現在の段を維持し、境界付近でのちらつきを防ぐ
+ */
+#define PMDLOD_HYSTERESIS       0.25f
+
+/**
+ * LODの1段
+ */
+typedef struct PmdLodLevel {
+    /**
+     * 材質ごとの描画範囲
+     * indices_beginはPmdLodChain::indicesの先頭からの位置となる
+     */
+    PmdDrawRange *draw_ranges;
+
+    /**
+     * この段のインデックス範囲
+     */
+    GLuint indices_begin;
+    GLuint indices_num;
+
+    /**
+     * 元のメッシュからの最大誤差（モデル座標系での距離）
+     */
+    GLfloat error;
+} PmdLodLevel;
+
+/**
+ * LODチェーン
+ */
+typedef struct PmdLodChain {
+    /**
+     * インデックスの型
+     * 元のPMDと同じ型となる
+     */
+    GLenum index_type;
+
+    /**
+     * 全段のインデックスを連結した配列
+     */
+    GLvoid *indices;
+
+    /**
+     * 全段のインデックス数
+     */
+    GLuint indices_num;
+
+    /**
+     * 各段の情報
+     * levels[0]は元のメッシュとなる
+     */
+    PmdLodLevel levels[PMDLOD_LEVELS_MAX];
+
+    /**
+     * 段数
+     */
+    int levels_num;
+
+    /**
+     * 材質数
+     */
+    GLuint materials_num;
+} PmdLodChain;
+
+/**
+ * PMDを簡略化してLODチェーンを生成する。
+ * 段ごとに前の段の三角形数 × ratioを目標として材質ごとに簡略化する。
+ * 材質の境界、UVや法線の継ぎ目、表情の影響を受ける頂点は移動しない。
+ */
+extern PmdLodChain* PmdLodChain_create(const PmdFile *pmd, const int levels_num, const GLfloat ratio);
+
+/**
+ * 全段のインデックスを1つのバッファオブジェクトへ転送する。
+ */
+extern GLuint PmdLodChain_createIndexBuffer(const PmdLodChain *chain, const GLenum usage);
+
+/**
+ * glDrawElementsへ渡すインデックスバッファ上のオフセットを取得する。
+ */
+extern GLsizeiptr PmdLodChain_getIndexOffset(const PmdLodChain *chain, const PmdDrawRange *range);
+
+/**
+ * 視点からdistanceだけ離れた位置で、1単位が画面上で何ピクセルになるかを計算する。
+ * projectionには射影行列を渡す。
+ */
+extern GLfloat PmdLod_calcPixelsPerUnit(const mat4 projection, const GLfloat distance, const GLint viewport_height);
+
+/**
+ * 画面上の誤差がtolerance_pixels以下となる最も粗い段を選択する。
+ * current_levelは前回選択した段で、切り替えにヒステリシスを持たせるために利用する。
+ */
+extern int PmdLodChain_select(const PmdLodChain *chain, const int current_level, const GLfloat pixels_per_unit, const GLfloat tolerance_pixels);
+
+/**
+ * LODチェーンを解放する
+ */
+extern void PmdLodChain_free(PmdLodChain *chain);
+
+#endif /* SUPPORT_GL_PMDLOD_H_ */
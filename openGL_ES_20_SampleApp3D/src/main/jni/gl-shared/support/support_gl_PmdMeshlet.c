@@ -0,0 +1,657 @@
+/*
+ * support_gl_PmdMeshlet.c
+ */
+
+#include    "support.h"
+
+/**
+ * クラスタへ追加する三角形の法線が満たすべき、クラスタの平均法線との内積の下限
+ * 向きの揃った三角形だけをまとめ、法線コーンを狭く保つ（約25度）
+ * 隣接しない三角形も取り込んで大きさを確保するため、隣接だけで成長させる場合より厳しくしている
+ */
+#define PMDMESHLET_NORMAL_LIMIT     0.9f
+
+/**
+ * 隣接しない三角形を探す格子の1辺の最大分割数
+ */
+#define PMDMESHLET_GRID_MAX         32
+
+/**
+ * 格子の1セルに入る平均三角形数の目安
+ */
+#define PMDMESHLET_GRID_DENSITY     4
+
+/**
+ * 隣接しない三角形を探す際、中心のセルから広げる最大の範囲（セル数）
+ * 範囲内に見つからなければクラスタの成長を打ち切る
+ */
+#define PMDMESHLET_GRID_RANGE       4
+
+/**
+ * クラスタ構築の作業情報
+ */
+typedef struct PmdMeshletBuilder {
+    /**
+     * 材質内の三角形（頂点番号）
+     */
+    const GLuint *triangles;
+    GLuint triangles_num;
+
+    /**
+     * 頂点の位置番号
+     * UVの継ぎ目で分かれた頂点も隣接として扱うため、同じ位置の頂点は同じ番号となる
+     */
+    GLuint *positions;
+
+    /**
+     * 三角形の面法線
+     */
+    vec3 *normals;
+
+    /**
+     * 割り当て済みの三角形
+     */
+    GLubyte *assigned;
+
+    /**
+     * 位置 -> 三角形の隣接情報
+     */
+    GLuint *adjacency_offsets;
+    GLuint *adjacency;
+
+    /**
+     * 位置が所属するクラスタ番号 + 1
+     */
+    GLuint *vertex_stamps;
+
+    /**
+     * 追加候補の三角形
+     */
+    GLuint *candidates;
+    GLuint candidates_num;
+    GLuint candidates_capacity;
+
+    /**
+     * 三角形の重心
+     */
+    vec3 *centroids;
+
+    /**
+     * 重心 -> 三角形の格子
+     * セルごとの三角形はcell_items[cell_offsets[c]]からcell_counts[c]個並び、割り当て済みの三角形は探索時に取り除く。
+     */
+    GLuint *cell_offsets;
+    GLuint *cell_counts;
+    GLuint *cell_items;
+    GLint grid_size;
+    vec3 grid_min;
+    vec3 cell_size;
+} PmdMeshletBuilder;
+
+/**
+ * インデックス1つのbyte数を取得する
+ */
+static GLsizeiptr PmdMeshlet_indexSize(const GLenum index_type) {
+    return index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+}
+
+/**
+ * 同じ位置の頂点に同じ位置番号を割り当てる
+ */
+static void PmdMeshletBuilder_weldPositions(PmdMeshletBuilder *builder, const PmdFile *pmd) {
+    GLuint tableSize = 1;
+    while (tableSize < pmd->vertices_num * 2) {
+        tableSize <<= 1;
+    }
+    GLint *table = malloc(sizeof(GLint) * tableSize);
+    memset(table, 0xFF, sizeof(GLint) * tableSize);
+
+    GLuint i = 0;
+    int k = 0;
+    for (i = 0; i < pmd->vertices_num; ++i) {
+        const vec3 *position = &pmd->vertices[i].position;
+        const GLuint *bits = (const GLuint*) position;
+        GLuint hash = 2166136261u;
+        for (k = 0; k < 3; ++k) {
+            hash = (hash ^ bits[k]) * 16777619u;
+        }
+
+        GLuint slot = hash & (tableSize - 1);
+        while (table[slot] >= 0 && memcmp(&pmd->vertices[table[slot]].position, position, sizeof(vec3))) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (table[slot] < 0) {
+            table[slot] = i;
+        }
+        builder->positions[i] = table[slot];
+    }
+
+    free(table);
+}
+
+/**
+ * 三角形の頂点を追加候補へ加える
+ */
+static void PmdMeshletBuilder_addCandidates(PmdMeshletBuilder *builder, const GLuint triangle) {
+    int k = 0;
+    GLuint i = 0;
+    for (k = 0; k < 3; ++k) {
+        const GLuint vertex = builder->positions[builder->triangles[triangle * 3 + k]];
+        for (i = builder->adjacency_offsets[vertex]; i < builder->adjacency_offsets[vertex + 1]; ++i) {
+            const GLuint candidate = builder->adjacency[i];
+            if (builder->assigned[candidate]) {
+                continue;
+            }
+            if (builder->candidates_num == builder->candidates_capacity) {
+                builder->candidates_capacity *= 2;
+                builder->candidates = realloc(builder->candidates, sizeof(GLuint) * builder->candidates_capacity);
+            }
+            builder->candidates[builder->candidates_num++] = candidate;
+        }
+    }
+}
+
+/**
+ * 三角形の重心を取得する
+ */
+static vec3 PmdMeshletBuilder_getCentroid(const PmdMeshletBuilder *builder, const PmdFile *pmd, const GLuint triangle) {
+    const vec3 p0 = pmd->vertices[builder->triangles[triangle * 3 + 0]].position;
+    const vec3 p1 = pmd->vertices[builder->triangles[triangle * 3 + 1]].position;
+    const vec3 p2 = pmd->vertices[builder->triangles[triangle * 3 + 2]].position;
+    return vec3_create((p0.x + p1.x + p2.x) / 3.0f, (p0.y + p1.y + p2.y) / 3.0f, (p0.z + p1.z + p2.z) / 3.0f);
+}
+
+/**
+ * 座標が入るセルの位置を取得する
+ */
+static GLint PmdMeshletBuilder_getCellCoord(const PmdMeshletBuilder *builder, const GLfloat value, const GLfloat min, const GLfloat size) {
+    const GLint result = (GLint) ((value - min) / size);
+    return result < 0 ? 0 : (result >= builder->grid_size ? builder->grid_size - 1 : result);
+}
+
+/**
+ * 重心が入るセル番号を取得する
+ */
+static GLuint PmdMeshletBuilder_getCell(const PmdMeshletBuilder *builder, const vec3 p) {
+    const GLint x = PmdMeshletBuilder_getCellCoord(builder, p.x, builder->grid_min.x, builder->cell_size.x);
+    const GLint y = PmdMeshletBuilder_getCellCoord(builder, p.y, builder->grid_min.y, builder->cell_size.y);
+    const GLint z = PmdMeshletBuilder_getCellCoord(builder, p.z, builder->grid_min.z, builder->cell_size.z);
+    return (GLuint) ((z * builder->grid_size + y) * builder->grid_size + x);
+}
+
+/**
+ * 材質内の三角形の重心を格子へ振り分ける
+ * 1セルに平均PMDMESHLET_GRID_DENSITY個入るよう分割数を決める。
+ */
+static void PmdMeshletBuilder_buildGrid(PmdMeshletBuilder *builder, const PmdFile *pmd) {
+    const GLuint triangles_num = builder->triangles_num;
+    GLuint i = 0;
+
+    vec3 minPoint = vec3_create(0, 0, 0);
+    vec3 maxPoint = vec3_create(0, 0, 0);
+    for (i = 0; i < triangles_num; ++i) {
+        const vec3 c = PmdMeshletBuilder_getCentroid(builder, pmd, i);
+        builder->centroids[i] = c;
+        if (i == 0) {
+            minPoint = maxPoint = c;
+        } else {
+            minPoint = vec3_create(c.x < minPoint.x ? c.x : minPoint.x, c.y < minPoint.y ? c.y : minPoint.y, c.z < minPoint.z ? c.z : minPoint.z);
+            maxPoint = vec3_create(c.x > maxPoint.x ? c.x : maxPoint.x, c.y > maxPoint.y ? c.y : maxPoint.y, c.z > maxPoint.z ? c.z : maxPoint.z);
+        }
+    }
+
+    GLint grid_size = 1;
+    while (grid_size < PMDMESHLET_GRID_MAX && (GLuint) (grid_size * grid_size * grid_size * PMDMESHLET_GRID_DENSITY) < triangles_num) {
+        ++grid_size;
+    }
+    builder->grid_size = grid_size;
+    builder->grid_min = minPoint;
+    {
+        // 厚みの無い軸でも0除算とならないよう、最小のセル幅を設ける
+        const GLfloat x = (maxPoint.x - minPoint.x) / grid_size;
+        const GLfloat y = (maxPoint.y - minPoint.y) / grid_size;
+        const GLfloat z = (maxPoint.z - minPoint.z) / grid_size;
+        builder->cell_size = vec3_create(x > 1e-6f ? x : 1e-6f, y > 1e-6f ? y : 1e-6f, z > 1e-6f ? z : 1e-6f);
+    }
+
+    // セルごとの三角形数を数え、連続した領域へ並べる
+    const GLuint cells_num = (GLuint) (grid_size * grid_size * grid_size);
+    memset(builder->cell_counts, 0x00, sizeof(GLuint) * cells_num);
+    for (i = 0; i < triangles_num; ++i) {
+        ++builder->cell_counts[PmdMeshletBuilder_getCell(builder, builder->centroids[i])];
+    }
+    builder->cell_offsets[0] = 0;
+    for (i = 0; i < cells_num; ++i) {
+        builder->cell_offsets[i + 1] = builder->cell_offsets[i] + builder->cell_counts[i];
+        builder->cell_counts[i] = 0;
+    }
+    for (i = 0; i < triangles_num; ++i) {
+        const GLuint cell = PmdMeshletBuilder_getCell(builder, builder->centroids[i]);
+        builder->cell_items[builder->cell_offsets[cell] + builder->cell_counts[cell]++] = i;
+    }
+}
+
+/**
+ * 格子から、centerに最も近い未割り当ての三角形を探す
+ * 法線がaxisと揃った三角形で最も近いものを返し、nearestには向きを問わず最も近いものを格納する。
+ * 中心のセルからPMDMESHLET_GRID_RANGEまでの範囲で見つからなければ0xFFFFFFFFとなる。
+ */
+static GLuint PmdMeshletBuilder_findNearest(PmdMeshletBuilder *builder, const vec3 center, const vec3 axis, GLuint *nearest) {
+    const GLint grid_size = builder->grid_size;
+    const GLint cx = PmdMeshletBuilder_getCellCoord(builder, center.x, builder->grid_min.x, builder->cell_size.x);
+    const GLint cy = PmdMeshletBuilder_getCellCoord(builder, center.y, builder->grid_min.y, builder->cell_size.y);
+    const GLint cz = PmdMeshletBuilder_getCellCoord(builder, center.z, builder->grid_min.z, builder->cell_size.z);
+    GLfloat cell_min = builder->cell_size.x;
+    cell_min = builder->cell_size.y < cell_min ? builder->cell_size.y : cell_min;
+    cell_min = builder->cell_size.z < cell_min ? builder->cell_size.z : cell_min;
+
+    GLuint result = 0xFFFFFFFF;
+    GLfloat resultDistance = 0;
+    GLfloat nearestDistance = 0;
+    GLint range = 0;
+    *nearest = 0xFFFFFFFF;
+
+    for (range = 0; range <= PMDMESHLET_GRID_RANGE && range < grid_size; ++range) {
+        GLint x = 0;
+        GLint y = 0;
+        GLint z = 0;
+
+        // 中心からrange離れた殻のセルだけを調べる
+        for (z = cz - range; z <= cz + range; ++z) {
+            for (y = cy - range; y <= cy + range; ++y) {
+                for (x = cx - range; x <= cx + range; ++x) {
+                    if (x < 0 || y < 0 || z < 0 || x >= grid_size || y >= grid_size || z >= grid_size) {
+                        continue;
+                    }
+                    if (abs(x - cx) != range && abs(y - cy) != range && abs(z - cz) != range) {
+                        continue;
+                    }
+
+                    const GLuint cell = (GLuint) ((z * grid_size + y) * grid_size + x);
+                    GLuint *items = builder->cell_items + builder->cell_offsets[cell];
+                    GLuint i = 0;
+                    while (i < builder->cell_counts[cell]) {
+                        const GLuint triangle = items[i];
+
+                        // 割り当て済みの三角形は末尾と入れ替えて取り除く
+                        if (builder->assigned[triangle]) {
+                            items[i] = items[--builder->cell_counts[cell]];
+                            continue;
+                        }
+                        ++i;
+
+                        const vec3 c = builder->centroids[triangle];
+                        const GLfloat distance = vec3_length(vec3_create(c.x - center.x, c.y - center.y, c.z - center.z));
+                        if (*nearest == 0xFFFFFFFF || distance < nearestDistance) {
+                            *nearest = triangle;
+                            nearestDistance = distance;
+                        }
+                        if (vec3_dot(axis, builder->normals[triangle]) >= PMDMESHLET_NORMAL_LIMIT && (result == 0xFFFFFFFF || distance < resultDistance)) {
+                            result = triangle;
+                            resultDistance = distance;
+                        }
+                    }
+                }
+            }
+        }
+
+        // 外側の殻はrange * cell_minより遠いため、それより近ければ確定する
+        if (result != 0xFFFFFFFF && resultDistance <= range * cell_min) {
+            break;
+        }
+    }
+    return result;
+}
+
+/**
+ * クラスタの境界球と法線コーンを計算する
+ */
+static void PmdMeshlet_calcBounds(PmdMeshlet *meshlet, const PmdFile *pmd, const GLuint *triangles, const vec3 *normals, const GLuint *members, const GLuint members_num) {
+    GLuint i = 0;
+    int k = 0;
+
+    // AABBの中心を境界球の中心とする
+    vec3 aabb_min = pmd->vertices[triangles[members[0] * 3]].position;
+    vec3 aabb_max = aabb_min;
+    vec3 normal = vec3_create(0, 0, 0);
+    for (i = 0; i < members_num; ++i) {
+        for (k = 0; k < 3; ++k) {
+            const vec3 p = pmd->vertices[triangles[members[i] * 3 + k]].position;
+            aabb_min = vec3_create(fminf(aabb_min.x, p.x), fminf(aabb_min.y, p.y), fminf(aabb_min.z, p.z));
+            aabb_max = vec3_create(fmaxf(aabb_max.x, p.x), fmaxf(aabb_max.y, p.y), fmaxf(aabb_max.z, p.z));
+        }
+        const vec3 n = normals[members[i]];
+        normal = vec3_create(normal.x + n.x, normal.y + n.y, normal.z + n.z);
+    }
+
+    meshlet->center = vec3_create((aabb_min.x + aabb_max.x) * 0.5f, (aabb_min.y + aabb_max.y) * 0.5f, (aabb_min.z + aabb_max.z) * 0.5f);
+    meshlet->radius = 0;
+    for (i = 0; i < members_num; ++i) {
+        for (k = 0; k < 3; ++k) {
+            const vec3 p = pmd->vertices[triangles[members[i] * 3 + k]].position;
+            const vec3 d = vec3_create(p.x - meshlet->center.x, p.y - meshlet->center.y, p.z - meshlet->center.z);
+            meshlet->radius = fmaxf(meshlet->radius, vec3_length(d));
+        }
+    }
+
+    // 面法線の平均を軸とし、軸から最も離れた法線でコーンの広さを決める
+    meshlet->cone_cutoff = 1.0f;
+    meshlet->cone_axis = vec3_create(0, 0, 0);
+    meshlet->cone_apex = meshlet->center;
+    const GLfloat length = vec3_length(normal);
+    if (length <= 0) {
+        return;
+    }
+    meshlet->cone_axis = vec3_create(normal.x / length, normal.y / length, normal.z / length);
+
+    GLfloat min_dot = 1.0f;
+    for (i = 0; i < members_num; ++i) {
+        const vec3 n = normals[members[i]];
+        if (n.x == 0 && n.y == 0 && n.z == 0) {
+            continue;
+        }
+        min_dot = fminf(min_dot, vec3_dot(meshlet->cone_axis, n));
+    }
+
+    // 半球を超えて広がるクラスタは裏向きの判定を行わない
+    if (min_dot <= 0) {
+        meshlet->cone_apex = meshlet->center;
+        return;
+    }
+    meshlet->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+
+    // 全ての面の平面より裏側となるよう、中心から軸の逆方向へコーンの頂点を下げる
+    GLfloat max_t = 0;
+    for (i = 0; i < members_num; ++i) {
+        const vec3 n = normals[members[i]];
+        const GLfloat dn = vec3_dot(meshlet->cone_axis, n);
+        if (dn <= 0) {
+            continue;
+        }
+        const vec3 p = pmd->vertices[triangles[members[i] * 3]].position;
+        const vec3 d = vec3_create(meshlet->center.x - p.x, meshlet->center.y - p.y, meshlet->center.z - p.z);
+        max_t = fmaxf(max_t, vec3_dot(d, n) / dn);
+    }
+    meshlet->cone_apex = vec3_create(meshlet->center.x - meshlet->cone_axis.x * max_t, meshlet->center.y - meshlet->cone_axis.y * max_t, meshlet->center.z - meshlet->cone_axis.z * max_t);
+}
+
+/**
+ * PMDの三角形をクラスタへ分割する。
+ */
+PmdMeshletList* PmdMeshletList_create(const PmdFile *pmd) {
+    PmdMeshletList *result = calloc(1, sizeof(PmdMeshletList));
+    const GLsizeiptr indexSize = PmdMeshlet_indexSize(pmd->index_type);
+    const GLuint triangles_num = pmd->indices_num / 3;
+    const GLuint buffer_num = triangles_num ? triangles_num : 1;
+
+    result->index_type = pmd->index_type;
+    result->materials_num = pmd->materials_num;
+    result->indices_num = pmd->indices_num;
+    result->indices = malloc(indexSize * (pmd->indices_num ? pmd->indices_num : 1));
+    result->visible_indices = malloc(indexSize * (pmd->indices_num ? pmd->indices_num : 1));
+    result->visible_ranges = calloc(pmd->materials_num ? pmd->materials_num : 1, sizeof(PmdDrawRange));
+    result->material_offsets = calloc(pmd->materials_num + 1, sizeof(GLuint));
+
+    // 1クラスタに最低1三角形が入るため、クラスタ数は三角形数を超えない
+    result->meshlets = malloc(sizeof(PmdMeshlet) * buffer_num);
+
+    PmdMeshletBuilder builder = { 0 };
+    GLuint *triangles = malloc(sizeof(GLuint) * buffer_num * 3);
+    GLuint *members = malloc(sizeof(GLuint) * PMDMESHLET_TRIANGLES_MAX);
+    GLuint *last_members = malloc(sizeof(GLuint) * PMDMESHLET_TRIANGLES_MAX);
+    GLuint last_members_num = 0;
+    GLuint clusters_num = 0;
+    builder.normals = malloc(sizeof(vec3) * buffer_num);
+    builder.assigned = malloc(sizeof(GLubyte) * buffer_num);
+    builder.adjacency_offsets = malloc(sizeof(GLuint) * (pmd->vertices_num + 1));
+    builder.adjacency = malloc(sizeof(GLuint) * buffer_num * 3);
+    builder.vertex_stamps = calloc(pmd->vertices_num ? pmd->vertices_num : 1, sizeof(GLuint));
+    builder.positions = malloc(sizeof(GLuint) * (pmd->vertices_num ? pmd->vertices_num : 1));
+    PmdMeshletBuilder_weldPositions(&builder, pmd);
+    builder.candidates_capacity = 256;
+    builder.candidates = malloc(sizeof(GLuint) * builder.candidates_capacity);
+    builder.centroids = malloc(sizeof(vec3) * buffer_num);
+    builder.cell_offsets = malloc(sizeof(GLuint) * (PMDMESHLET_GRID_MAX * PMDMESHLET_GRID_MAX * PMDMESHLET_GRID_MAX + 1));
+    builder.cell_counts = malloc(sizeof(GLuint) * PMDMESHLET_GRID_MAX * PMDMESHLET_GRID_MAX * PMDMESHLET_GRID_MAX);
+    builder.cell_items = malloc(sizeof(GLuint) * buffer_num);
+
+    GLuint output_num = 0;
+    GLuint m = 0;
+    GLuint i = 0;
+    int k = 0;
+
+    for (m = 0; m < pmd->materials_num; ++m) {
+        const PmdDrawRange *range = &pmd->draw_ranges[m];
+        const GLuint material_triangles = range->indices_num / 3;
+        result->material_offsets[m] = result->meshlets_num;
+
+        // 材質内の三角形と面法線を取り出す
+        for (i = 0; i < material_triangles * 3; ++i) {
+            triangles[i] = PmdFile_getIndex((PmdFile*) pmd, range->indices_begin + i);
+        }
+        for (i = 0; i < material_triangles; ++i) {
+            const vec3 p0 = pmd->vertices[triangles[i * 3 + 0]].position;
+            const vec3 p1 = pmd->vertices[triangles[i * 3 + 1]].position;
+            const vec3 p2 = pmd->vertices[triangles[i * 3 + 2]].position;
+            const vec3 n = vec3_cross(vec3_create(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z), vec3_create(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z));
+            const GLfloat length = vec3_length(n);
+            builder.normals[i] = length > 0 ? vec3_create(n.x / length, n.y / length, n.z / length) : vec3_create(0, 0, 0);
+        }
+        builder.triangles = triangles;
+        builder.triangles_num = material_triangles;
+        memset(builder.assigned, 0x00, sizeof(GLubyte) * buffer_num);
+
+        // 位置 -> 三角形の隣接情報を構築する
+        memset(builder.adjacency_offsets, 0x00, sizeof(GLuint) * (pmd->vertices_num + 1));
+        for (i = 0; i < material_triangles * 3; ++i) {
+            ++builder.adjacency_offsets[builder.positions[triangles[i]] + 1];
+        }
+        for (i = 0; i < pmd->vertices_num; ++i) {
+            builder.adjacency_offsets[i + 1] += builder.adjacency_offsets[i];
+        }
+        for (i = 0; i < material_triangles * 3; ++i) {
+            builder.adjacency[builder.adjacency_offsets[builder.positions[triangles[i]]]++] = i / 3;
+        }
+        for (i = pmd->vertices_num; i > 0; --i) {
+            builder.adjacency_offsets[i] = builder.adjacency_offsets[i - 1];
+        }
+        builder.adjacency_offsets[0] = 0;
+
+        // 隣接しない三角形を探すため、重心を格子へ振り分ける
+        PmdMeshletBuilder_buildGrid(&builder, pmd);
+
+        // 最適化済みの順序で未割り当ての三角形を種とし、隣接する三角形を取り込んでいく
+        GLuint seed = 0;
+        while (true) {
+            while (seed < material_triangles && builder.assigned[seed]) {
+                ++seed;
+            }
+            if (seed >= material_triangles) {
+                break;
+            }
+
+            const GLuint stamp = ++clusters_num;
+            GLuint members_num = 0;
+            vec3 normal = vec3_create(0, 0, 0);
+            vec3 centroid = vec3_create(0, 0, 0);
+            GLuint triangle = seed;
+            builder.candidates_num = 0;
+
+            while (true) {
+                builder.assigned[triangle] = 1;
+                members[members_num++] = triangle;
+                for (k = 0; k < 3; ++k) {
+                    builder.vertex_stamps[builder.positions[triangles[triangle * 3 + k]]] = stamp;
+                }
+                normal = vec3_create(normal.x + builder.normals[triangle].x, normal.y + builder.normals[triangle].y, normal.z + builder.normals[triangle].z);
+                {
+                    const vec3 c = builder.centroids[triangle];
+                    centroid = vec3_create(centroid.x + c.x, centroid.y + c.y, centroid.z + c.z);
+                }
+                PmdMeshletBuilder_addCandidates(&builder, triangle);
+
+                if (members_num >= PMDMESHLET_TRIANGLES_MAX) {
+                    break;
+                }
+
+                // 向きの揃った三角形から、新しく増える頂点が最も少ないものを選ぶ
+                // 向きが揃わない三角形は、法線が最も近いものを予備として覚えておく
+                GLuint best = 0xFFFFFFFF;
+                int bestScore = 4;
+                GLuint fallback = 0xFFFFFFFF;
+                GLfloat fallbackDot = -2.0f;
+                GLuint write = 0;
+                const GLfloat normal_length = vec3_length(normal);
+                const vec3 axis = normal_length > 0 ? vec3_create(normal.x / normal_length, normal.y / normal_length, normal.z / normal_length) : normal;
+                for (i = 0; i < builder.candidates_num; ++i) {
+                    const GLuint candidate = builder.candidates[i];
+                    if (builder.assigned[candidate]) {
+                        continue;
+                    }
+                    builder.candidates[write++] = candidate;
+
+                    const GLfloat dot = vec3_dot(axis, builder.normals[candidate]);
+                    if (dot < PMDMESHLET_NORMAL_LIMIT) {
+                        if (dot > fallbackDot) {
+                            fallback = candidate;
+                            fallbackDot = dot;
+                        }
+                        continue;
+                    }
+
+                    int score = 0;
+                    for (k = 0; k < 3; ++k) {
+                        score += builder.vertex_stamps[builder.positions[triangles[candidate * 3 + k]]] != stamp;
+                    }
+                    if (score < bestScore) {
+                        best = candidate;
+                        bestScore = score;
+                    }
+                }
+                builder.candidates_num = write;
+
+                // 目標の大きさに満たない場合は、隣接しなくとも向きの揃った三角形のうち、クラスタの中心に最も近いものを取り込む
+                // 向きの揃った三角形が残っていなければ、向きの揃わない隣接三角形、最も近い三角形の順に取り込む
+                // 材質全体を調べると三角形数の2乗に比例するため、格子で中心の周囲だけを調べる
+                if (best == 0xFFFFFFFF && members_num < PMDMESHLET_TRIANGLES_MIN) {
+                    const vec3 center = vec3_create(centroid.x / members_num, centroid.y / members_num, centroid.z / members_num);
+                    GLuint nearest = 0xFFFFFFFF;
+                    best = PmdMeshletBuilder_findNearest(&builder, center, axis, &nearest);
+                    if (best == 0xFFFFFFFF) {
+                        best = fallback != 0xFFFFFFFF ? fallback : nearest;
+                    }
+                }
+
+                if (best == 0xFFFFFFFF) {
+                    break;
+                }
+                triangle = best;
+            }
+
+            // 材質の末尾に残った小さなクラスタは、収まる場合は直前のクラスタへ結合する
+            // インデックスはクラスタ順に書き出しているため、直前のクラスタの範囲を延ばすだけでよい
+            PmdMeshlet *meshlet = NULL;
+            if (members_num < PMDMESHLET_TRIANGLES_MIN && result->meshlets_num > result->material_offsets[m] && last_members_num + members_num <= PMDMESHLET_TRIANGLES_MAX) {
+                meshlet = &result->meshlets[result->meshlets_num - 1];
+            } else {
+                meshlet = &result->meshlets[result->meshlets_num++];
+                meshlet->indices_begin = output_num;
+                meshlet->indices_num = 0;
+                last_members_num = 0;
+            }
+            memcpy(last_members + last_members_num, members, sizeof(GLuint) * members_num);
+            last_members_num += members_num;
+
+            // クラスタ順にインデックスを書き出す
+            meshlet->indices_num += members_num * 3;
+            for (i = 0; i < members_num; ++i) {
+                for (k = 0; k < 3; ++k) {
+                    const GLuint index = triangles[members[i] * 3 + k];
+                    if (result->index_type == GL_UNSIGNED_INT) {
+                        ((GLuint*) result->indices)[output_num++] = index;
+                    } else {
+                        ((GLushort*) result->indices)[output_num++] = (GLushort) index;
+                    }
+                }
+            }
+            PmdMeshlet_calcBounds(meshlet, pmd, triangles, builder.normals, last_members, last_members_num);
+        }
+    }
+    result->material_offsets[pmd->materials_num] = result->meshlets_num;
+
+    __logf("PmdMeshlet triangles(%d) meshlets(%d)", triangles_num, result->meshlets_num);
+
+    free(triangles);
+    free(members);
+    free(last_members);
+    free(builder.normals);
+    free(builder.assigned);
+    free(builder.adjacency_offsets);
+    free(builder.adjacency);
+    free(builder.vertex_stamps);
+    free(builder.positions);
+    free(builder.candidates);
+    free(builder.centroids);
+    free(builder.cell_offsets);
+    free(builder.cell_counts);
+    free(builder.cell_items);
+
+    return result;
+}
+
+/**
+ * 視錐台の外にあるクラスタと裏向きのクラスタを取り除き、visible_indicesを生成する。
+ */
+GLuint PmdMeshletList_cull(PmdMeshletList *list, const Frustum *frustum, const vec3 eye) {
+    const GLsizeiptr indexSize = PmdMeshlet_indexSize(list->index_type);
+    GLubyte *dst = (GLubyte*) list->visible_indices;
+    const GLubyte *src = (const GLubyte*) list->indices;
+    GLuint m = 0;
+    GLuint i = 0;
+
+    list->visible_indices_num = 0;
+    list->visible_meshlets_num = 0;
+    for (m = 0; m < list->materials_num; ++m) {
+        PmdDrawRange *range = &list->visible_ranges[m];
+        range->indices_begin = list->visible_indices_num;
+
+        for (i = list->material_offsets[m]; i < list->material_offsets[m + 1]; ++i) {
+            const PmdMeshlet *meshlet = &list->meshlets[i];
+
+            // 全ての面が視点から見て裏を向いている
+            const vec3 d = vec3_create(meshlet->cone_apex.x - eye.x, meshlet->cone_apex.y - eye.y, meshlet->cone_apex.z - eye.z);
+            if (vec3_dot(d, meshlet->cone_axis) > meshlet->cone_cutoff * vec3_length(d)) {
+                continue;
+            }
+
+            // 視錐台の外にある
+            if (!Frustum_testSphere(frustum, meshlet->center, meshlet->radius)) {
+                continue;
+            }
+
+            memcpy(dst + indexSize * list->visible_indices_num, src + indexSize * meshlet->indices_begin, indexSize * meshlet->indices_num);
+            list->visible_indices_num += meshlet->indices_num;
+            ++list->visible_meshlets_num;
+        }
+
+        range->indices_num = list->visible_indices_num - range->indices_begin;
+    }
+
+    return list->visible_indices_num / 3;
+}
+
+/**
+ * クラスタ一覧を解放する
+ */
+void PmdMeshletList_free(PmdMeshletList *list) {
+    if (!list) {
+        return;
+    }
+
+    free(list->meshlets);
+    free(list->material_offsets);
+    free(list->indices);
+    free(list->visible_indices);
+    free(list->visible_ranges);
+    free(list);
+}
@@ -0,0 +1,114 @@
+/*
+ * support_gl_PmdMeshlet.h
+ *
+ * PMDのクラスタ（Meshlet）単位のカリング
+ * 材質ごとの三角形を隣接する数十個ずつのクラスタへまとめ、境界球と法線コーンで
+ * 画面外や裏向きのクラスタを取り除いたインデックスを毎フレーム生成する。
+ */
+
+#ifndef SUPPORT_GL_PMDMESHLET_H_
+#define SUPPORT_GL_PMDMESHLET_H_
+
+/**
+ * 1クラスタの最大三角形数
+ */
+#define PMDMESHLET_TRIANGLES_MAX        128
+
+/**
+ * 1クラスタの目標とする最小三角形数
+ * これに満たない間は、法線の向きが揃わない三角形や隣接しない三角形も取り込んで成長させる
+ */
+#define PMDMESHLET_TRIANGLES_MIN        64
+
+/**
+ * 1クラスタ
+ */
+typedef struct PmdMeshlet {
+    /**
+     * 境界球
+     */
+    vec3 center;
+    GLfloat radius;
+
+    /**
+     * 法線コーンの軸
+     */
+    vec3 cone_axis;
+
+    /**
+     * 法線コーンの頂点
+     * 全ての面の平面より裏側にあり、ここから見て全ての面が裏向きとなる方向がコーンで表される
+     */
+    vec3 cone_apex;
+
+    /**
+     * 法線コーンの判定値
+     * 軸と各面の法線がなす最大角のsinとなる。裏向きの判定ができないクラスタは1.0となる。
+     */
+    GLfloat cone_cutoff;
+
+    /**
+     * PmdMeshletList::indices上の範囲
+     */
+    GLuint indices_begin;
+    GLuint indices_num;
+} PmdMeshlet;
+
+/**
+ * PMD全体のクラスタ一覧
+ */
+typedef struct PmdMeshletList {
+    /**
+     * クラスタ
+     * 材質順に並ぶ
+     */
+    PmdMeshlet *meshlets;
+    GLuint meshlets_num;
+
+    /**
+     * 材質iのクラスタはmeshlets[material_offsets[i]]からmaterial_offsets[i + 1]までとなる
+     */
+    GLuint *material_offsets;
+    GLuint materials_num;
+
+    /**
+     * クラスタ順に並べ替えたインデックス
+     * 型は元のPMDと同じとなる
+     */
+    GLenum index_type;
+    GLvoid *indices;
+    GLuint indices_num;
+
+    /**
+     * 判定後に残ったインデックス
+     * visible_ranges[i]は材質iの描画範囲となる
+     */
+    GLvoid *visible_indices;
+    GLuint visible_indices_num;
+    PmdDrawRange *visible_ranges;
+
+    /**
+     * 判定後に残ったクラスタ数
+     */
+    GLuint visible_meshlets_num;
+} PmdMeshletList;
+
+/**
+ * PMDの三角形をクラスタへ分割する。
+ * 事前にPmdFile_optimizeで並べ替えておくと、クラスタがまとまりやすくなる。
+ */
+extern PmdMeshletList* PmdMeshletList_create(const PmdFile *pmd);
+
+/**
+ * 視錐台の外にあるクラスタと裏向きのクラスタを取り除き、visible_indicesを生成する。
+ * frustumとeyeはモデル座標系で指定する。
+ * 残った三角形数を返す。
+ */
+extern GLuint PmdMeshletList_cull(PmdMeshletList *list, const Frustum *frustum, const vec3 eye);
+
+/**
+ * クラスタ一覧を解放する
+ */
+extern void PmdMeshletList_free(PmdMeshletList *list);
+
+#endif /* SUPPORT_GL_PMDMESHLET_H_ */
@@ -0,0 +1,230 @@
+/*
+ * support_gl_PmdMorph.c
+ */
+
+#include    "support.h"
+
+/**
+ * 頂点番号の昇順ソート用
+ */
+static int PmdMorph_compareIndex(const void *a, const void *b) {
+    const GLuint ia = *((const GLuint*) a);
+    const GLuint ib = *((const GLuint*) b);
+    return ia < ib ? -1 : (ia > ib ? 1 : 0);
+}
+
+/**
+ * 表情コントローラーを生成する
+ */
+PmdMorphController* PmdMorphController_create(PmdFile *pmd) {
+    PmdMorphController *result = calloc(1, sizeof(PmdMorphController));
+    result->pmd = pmd;
+
+    if (!pmd->morphs_num) {
+        // 表情が無い場合は何もしない
+        return result;
+    }
+
+    const PmdMorph *base = &pmd->morphs[0];
+    assert(base->type == PMDMORPH_TYPE_BASE);
+
+    result->weights = calloc(pmd->morphs_num, sizeof(GLfloat));
+    result->applied_weights = calloc(pmd->morphs_num, sizeof(GLfloat));
+
+    // base表情の頂点を頂点番号順に並べてスロットとする
+    result->slots_num = base->vertices_num;
+    result->slot_vertices = malloc(sizeof(GLuint) * result->slots_num);
+    result->slot_positions = malloc(sizeof(vec3) * result->slots_num);
+    result->slot_dirty = calloc(result->slots_num, sizeof(GLubyte));
+    memcpy(result->slot_vertices, base->indices, sizeof(GLuint) * result->slots_num);
+    qsort(result->slot_vertices, result->slots_num, sizeof(GLuint), PmdMorph_compareIndex);
+
+    // 頂点番号 -> スロット番号の一時テーブルを作る
+    GLuint *vertexToSlot = malloc(sizeof(GLuint) * pmd->vertices_num);
+    int i = 0;
+    for (i = 0; i < result->slots_num; ++i) {
+        const GLuint vertex = result->slot_vertices[i];
+        vertexToSlot[vertex] = i;
+        result->slot_positions[i] = pmd->vertices[vertex].position;
+    }
+
+    // 表情ごとのスロット番号を解決する
+    result->morph_slots = calloc(pmd->morphs_num, sizeof(GLuint*));
+    for (i = 1; i < pmd->morphs_num; ++i) {
+        const PmdMorph *morph = &pmd->morphs[i];
+        GLuint *slots = malloc(sizeof(GLuint) * morph->vertices_num);
+
+        int k = 0;
+        for (k = 0; k < morph->vertices_num; ++k) {
+            slots[k] = vertexToSlot[morph->indices[k]];
+            assert(result->slot_vertices[slots[k]] == morph->indices[k]);
+        }
+        result->morph_slots[i] = slots;
+    }
+    free(vertexToSlot);
+
+    // 近接したスロットをまとめて転送範囲を作る
+    {
+        result->ranges = malloc(sizeof(PmdMorphRange) * result->slots_num);
+        result->ranges_num = 0;
+
+        for (i = 0; i < result->slots_num; ++i) {
+            const GLuint vertex = result->slot_vertices[i];
+            PmdMorphRange *last = result->ranges_num ? &result->ranges[result->ranges_num - 1] : NULL;
+
+            if (last && (vertex - (last->vertex_end - 1)) <= PMDMORPH_RANGE_MERGE_GAP) {
+                // 直前の範囲を延長する
+                last->slot_end = i + 1;
+                last->vertex_end = vertex + 1;
+            } else {
+                // 新しい範囲を追加する
+                PmdMorphRange *range = &result->ranges[result->ranges_num++];
+                range->slot_begin = i;
+                range->slot_end = i + 1;
+                range->vertex_begin = vertex;
+                range->vertex_end = vertex + 1;
+            }
+        }
+
+        result->ranges = realloc(result->ranges, sizeof(PmdMorphRange) * result->ranges_num);
+        result->range_dirty = calloc(result->ranges_num, sizeof(GLubyte));
+    }
+
+    __logf("morph slots(%d) ranges(%d)", result->slots_num, result->ranges_num);
+    return result;
+}
+
+/**
+ * 表情のウェイトを設定する。
+ * 反映はPmdMorphController_update()で行われる。
+ */
+void PmdMorphController_setWeight(PmdMorphController *controller, const int morph_index, const GLfloat weight) {
+    // base表情はウェイトを持たない
+    if (morph_index <= 0 || morph_index >= controller->pmd->morphs_num) {
+        return;
+    }
+    controller->weights[morph_index] = weight;
+}
+
+/**
+ * 変化した表情をPmdFile.verticesへ反映する。
+ * 頂点に変化があった場合trueを返す。
+ */
+bool PmdMorphController_update(PmdMorphController *controller) {
+    PmdFile *pmd = controller->pmd;
+    bool changed = false;
+    int i = 0;
+    int k = 0;
+
+    // ウェイトが変化した表情の影響スロットに印をつける
+    for (i = 1; i < pmd->morphs_num; ++i) {
+        if (controller->weights[i] == controller->applied_weights[i]) {
+            continue;
+        }
+
+        const GLuint *slots = controller->morph_slots[i];
+        const GLuint num = pmd->morphs[i].vertices_num;
+        for (k = 0; k < num; ++k) {
+            controller->slot_dirty[slots[k]] = 1;
+        }
+        controller->applied_weights[i] = controller->weights[i];
+        changed = true;
+    }
+
+    if (!changed) {
+        return false;
+    }
+
+    // 印のついたスロットだけ基準位置に戻す
+    for (i = 0; i < controller->slots_num; ++i) {
+        if (controller->slot_dirty[i]) {
+            pmd->vertices[controller->slot_vertices[i]].position = controller->slot_positions[i];
+        }
+    }
+
+    // 有効な表情を印のついたスロットへ加算する
+    for (i = 1; i < pmd->morphs_num; ++i) {
+        const GLfloat weight = controller->weights[i];
+        if (weight == 0.0f) {
+            continue;
+        }
+
+        const PmdMorph *morph = &pmd->morphs[i];
+        const GLuint *slots = controller->morph_slots[i];
+        for (k = 0; k < morph->vertices_num; ++k) {
+            const GLuint slot = slots[k];
+            if (!controller->slot_dirty[slot]) {
+                continue;
+            }
+
+            vec3 *position = &pmd->vertices[morph->indices[k]].position;
+            position->x += morph->offsets[k].x * weight;
+            position->y += morph->offsets[k].y * weight;
+            position->z += morph->offsets[k].z * weight;
+        }
+    }
+
+    // 転送範囲に反映し、スロットの印を消す
+    for (i = 0; i < controller->ranges_num; ++i) {
+        const PmdMorphRange *range = &controller->ranges[i];
+        for (k = range->slot_begin; k < range->slot_end; ++k) {
+            if (controller->slot_dirty[k]) {
+                controller->range_dirty[i] = 1;
+                controller->slot_dirty[k] = 0;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * 変化した頂点範囲だけをglBufferSubDataで転送する。
+ * verticesをそのまま転送したGL_ARRAY_BUFFERを指定する。
+ */
+void PmdMorphController_upload(PmdMorphController *controller, const GLuint vertices_buffer) {
+    const PmdVertex *vertices = controller->pmd->vertices;
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertices_buffer);
+
+    int i = 0;
+    for (i = 0; i < controller->ranges_num; ++i) {
+        if (!controller->range_dirty[i]) {
+            continue;
+        }
+
+        const PmdMorphRange *range = &controller->ranges[i];
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * range->vertex_begin, sizeof(PmdVertex) * (range->vertex_end - range->vertex_begin), vertices + range->vertex_begin);
+        assert(glGetError() == GL_NO_ERROR);
+
+        controller->range_dirty[i] = 0;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * 表情コントローラーを解放する
+ */
+void PmdMorphController_free(PmdMorphController *controller) {
+    if (!controller) {
+        return;
+    }
+
+    if (controller->morph_slots) {
+        int i = 0;
+        for (i = 0; i < controller->pmd->morphs_num; ++i) {
+            free(controller->morph_slots[i]);
+        }
+        free(controller->morph_slots);
+    }
+
+    free(controller->weights);
+    free(controller->applied_weights);
+    free(controller->slot_vertices);
+    free(controller->slot_positions);
+    free(controller->slot_dirty);
+    free(controller->ranges);
+    free(controller->range_dirty);
+    free(controller);
+}
@@ -0,0 +1,134 @@
+/*
+ * support_gl_PmdMorph.h
+ *
+ * PMD表情（モーフ）のブレンドを行う
+ * 変化した表情が影響する頂点だけを更新し、VBOへは変更のあった範囲だけを転送する。
+ */
+
+#ifndef SUPPORT_GL_PMDMORPH_H_
+#define SUPPORT_GL_PMDMORPH_H_
+
+/**
+ * 転送範囲を結合する頂点の隙間
+ * これ以下の隙間であれば1回のglBufferSubDataにまとめる
+ */
+#define PMDMORPH_RANGE_MERGE_GAP 8
+
+/**
+ * VBOへ転送する頂点範囲
+ */
+typedef struct PmdMorphRange {
+    /**
+     * 範囲に含まれる最初のスロット
+     */
+    GLuint slot_begin;
+
+    /**
+     * 範囲に含まれる最後のスロット + 1
+     */
+    GLuint slot_end;
+
+    /**
+     * 先頭の頂点番号
+     */
+    GLuint vertex_begin;
+
+    /**
+     * 末尾の頂点番号 + 1
+     */
+    GLuint vertex_end;
+} PmdMorphRange;
+
+/**
+ * 表情のブレンド状態を管理する
+ *
+ * base表情に含まれる頂点を頂点番号順に並べ、その並び順を「スロット」として扱う。
+ * 各表情は影響するスロット番号を保持しているため、頂点全体を走査する必要はない。
+ */
+typedef struct PmdMorphController {
+    /**
+     * 対象のPMDファイル
+     */
+    PmdFile *pmd;
+
+    /**
+     * 要求されている表情ウェイト
+     */
+    GLfloat *weights;
+
+    /**
+     * 頂点へ反映済みの表情ウェイト
+     */
+    GLfloat *applied_weights;
+
+    /**
+     * スロットの数（base表情の頂点数）
+     */
+    GLuint slots_num;
+
+    /**
+     * スロットに対応する頂点番号（昇順）
+     */
+    GLuint *slot_vertices;
+
+    /**
+     * スロットの基準位置
+     */
+    vec3 *slot_positions;
+
+    /**
+     * 表情ごとのスロット番号配列
+     * morph_slots[表情番号][表情内の頂点番号]
+     */
+    GLuint **morph_slots;
+
+    /**
+     * 更新が必要なスロット
+     */
+    GLubyte *slot_dirty;
+
+    /**
+     * 転送範囲
+     */
+    PmdMorphRange *ranges;
+
+    /**
+     * 転送範囲数
+     */
+    GLuint ranges_num;
+
+    /**
+     * 転送が必要な範囲
+     */
+    GLubyte *range_dirty;
+} PmdMorphController;
+
+/**
+ * 表情コントローラーを生成する
+ */
+extern PmdMorphController* PmdMorphController_create(PmdFile *pmd);
+
+/**
+ * 表情のウェイトを設定する。
+ * 反映はPmdMorphController_update()で行われる。
+ */
+extern void PmdMorphController_setWeight(PmdMorphController *controller, const int morph_index, const GLfloat weight);
+
+/**
+ * 変化した表情をPmdFile.verticesへ反映する。
+ * 頂点に変化があった場合trueを返す。
+ */
+extern bool PmdMorphController_update(PmdMorphController *controller);
+
+/**
+ * 変化した頂点範囲だけをglBufferSubDataで転送する。
+ * verticesをそのまま転送したGL_ARRAY_BUFFERを指定する。
+ */
+extern void PmdMorphController_upload(PmdMorphController *controller, const GLuint vertices_buffer);
+
+/**
+ * 表情コントローラーを解放する
+ */
+extern void PmdMorphController_free(PmdMorphController *controller);
+
+#endif /* SUPPORT_GL_PMDMORPH_H_ */
@@ -0,0 +1,557 @@
+/*
+ * support_gl_PmdOptimize.c
+ */
+
+#include    "support.h"
+
+/**
+ * 頂点が完全に一致していればtrueを返す
+ * 構造体のパディングを比較しないよう、メンバごとに比較する
+ */
+static bool PmdOptimize_equalsVertex(const PmdFile *pmd, const GLuint a, const GLuint b) {
+    const PmdVertex *va = &pmd->vertices[a];
+    const PmdVertex *vb = &pmd->vertices[b];
+    const PmdVertexExtra *ea = &pmd->vertices_extra[a];
+    const PmdVertexExtra *eb = &pmd->vertices_extra[b];
+
+    return !memcmp(&va->position, &vb->position, sizeof(vec3)) //
+    && !memcmp(&va->uv, &vb->uv, sizeof(vec2)) //
+    && !memcmp(&va->normal, &vb->normal, sizeof(vec3)) //
+    && ea->bone_num[0] == eb->bone_num[0] //
+    && ea->bone_num[1] == eb->bone_num[1] //
+    && ea->bone_weight == eb->bone_weight //
+    && ea->edge_flag == eb->edge_flag;
+}
+
+/**
+ * 頂点のハッシュ値を計算する
+ */
+static GLuint PmdOptimize_hashVertex(const PmdVertex *v) {
+    const GLuint *bits[3] = { (const GLuint*) &v->position, (const GLuint*) &v->normal, (const GLuint*) &v->uv };
+    const int counts[3] = { 3, 3, 2 };
+    GLuint hash = 2166136261u;
+
+    int i = 0;
+    int k = 0;
+    for (i = 0; i < 3; ++i) {
+        for (k = 0; k < counts[i]; ++k) {
+            hash = (hash ^ bits[i][k]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+/**
+ * 完全に一致する頂点を統合する。
+ * remapには旧頂点番号 -> 新頂点番号が格納される。
+ */
+static GLuint PmdOptimize_weldVertices(PmdFile *pmd, GLuint *remap) {
+    const GLuint MORPH_VERTEX = 0xFFFFFFFF;
+
+    // 表情の影響を受ける頂点は個別に動くため、統合の対象から外す
+    memset(remap, 0x00, sizeof(GLuint) * pmd->vertices_num);
+    if (pmd->morphs_num) {
+        int i = 0;
+        for (i = 0; i < pmd->morphs[0].vertices_num; ++i) {
+            remap[pmd->morphs[0].indices[i]] = MORPH_VERTEX;
+        }
+    }
+
+    // オープンアドレス法のハッシュテーブルを用意する
+    GLuint tableSize = 1;
+    while (tableSize < pmd->vertices_num * 2) {
+        tableSize <<= 1;
+    }
+    GLint *table = malloc(sizeof(GLint) * tableSize);
+    memset(table, 0xFF, sizeof(GLint) * tableSize);
+
+    GLuint result = 0;
+    int i = 0;
+    for (i = 0; i < pmd->vertices_num; ++i) {
+        const PmdVertex *v = &pmd->vertices[i];
+
+        if (remap[i] == MORPH_VERTEX) {
+            remap[i] = result;
+            pmd->vertices[result] = *v;
+            pmd->vertices_extra[result] = pmd->vertices_extra[i];
+            ++result;
+            continue;
+        }
+
+        GLuint slot = PmdOptimize_hashVertex(v) & (tableSize - 1);
+        while (table[slot] >= 0 && !PmdOptimize_equalsVertex(pmd, table[slot], i)) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] >= 0) {
+            // 既に同じ頂点がある
+            remap[i] = table[slot];
+        } else {
+            // 新しい頂点として前詰めする
+            table[slot] = result;
+            remap[i] = result;
+            pmd->vertices[result] = *v;
+            pmd->vertices_extra[result] = pmd->vertices_extra[i];
+            ++result;
+        }
+    }
+
+    free(table);
+    return result;
+}
+
+/**
+ * FIFOキャッシュを想定してACMRを計算する
+ */
+GLfloat PmdFile_calcACMR(const GLushort *indices, const GLuint indices_num, const GLuint cache_size) {
+    if (indices_num < 3) {
+        return 0;
+    }
+
+    GLint cache[64];
+    assert(cache_size <= 64);
+    memset(cache, 0xFF, sizeof(cache));
+
+    int head = 0;
+    int misses = 0;
+    int i = 0;
+    int k = 0;
+    for (i = 0; i < indices_num; ++i) {
+        bool hit = false;
+        for (k = 0; k < cache_size; ++k) {
+            if (cache[k] == indices[i]) {
+                hit = true;
+                break;
+            }
+        }
+
+        if (!hit) {
+            cache[head] = indices[i];
+            head = (head + 1) % cache_size;
+            ++misses;
+        }
+    }
+
+    return (GLfloat) misses / (GLfloat) (indices_num / 3);
+}
+
+/**
+ * Tipsifyの作業領域
+ */
+typedef struct PmdTipsify {
+    /**
+     * 頂点 -> 三角形の隣接リスト開始位置
+     */
+    GLuint *adjacency_offsets;
+
+    /**
+     * 隣接している三角形番号
+     */
+    GLuint *adjacency;
+
+    /**
+     * 頂点ごとの未出力の三角形数
+     */
+    GLint *live;
+
+    /**
+     * 頂点がキャッシュに入った時刻
+     */
+    GLint *cache_time;
+
+    /**
+     * 出力済みの三角形
+     */
+    GLubyte *emitted;
+
+    /**
+     * デッドエンドスタック
+     */
+    GLuint *dead_end;
+
+    /**
+     * デッドエンドスタックの深さ
+     */
+    GLuint dead_end_num;
+
+    /**
+     * 頂点走査カーソル
+     */
+    GLuint cursor;
+} PmdTipsify;
+
+/**
+ * 次に処理すべき頂点が見つからなかった場合、デッドエンドスタックか未処理の頂点から次を探す
+ */
+static GLint PmdTipsify_skipDeadEnd(PmdTipsify *work, const GLuint vertices_num) {
+    while (work->dead_end_num) {
+        const GLuint v = work->dead_end[--work->dead_end_num];
+        if (work->live[v] > 0) {
+            return v;
+        }
+    }
+
+    while (work->cursor < vertices_num) {
+        if (work->live[work->cursor] > 0) {
+            return work->cursor;
+        }
+        ++work->cursor;
+    }
+    return -1;
+}
+
+/**
+ * 1材質分のインデックスをTipsifyで並べ替える。
+ * clustersにはクラスタの開始三角形番号が格納され、クラスタ数を返す。
+ */
+static GLuint PmdOptimize_tipsify(const GLushort *indices, const GLuint triangles_num, const GLuint vertices_num, const GLuint cache_size, GLushort *result, GLuint *clusters) {
+    PmdTipsify work = { };
+    int i = 0;
+    int k = 0;
+
+    // 隣接リストを作る
+    work.live = calloc(vertices_num, sizeof(GLint));
+    work.adjacency_offsets = calloc(vertices_num + 1, sizeof(GLuint));
+    work.adjacency = malloc(sizeof(GLuint) * triangles_num * 3);
+    for (i = 0; i < triangles_num * 3; ++i) {
+        ++work.live[indices[i]];
+    }
+    for (i = 0; i < vertices_num; ++i) {
+        work.adjacency_offsets[i + 1] = work.adjacency_offsets[i] + work.live[i];
+    }
+    {
+        GLuint *fill = malloc(sizeof(GLuint) * vertices_num);
+        memcpy(fill, work.adjacency_offsets, sizeof(GLuint) * vertices_num);
+        for (i = 0; i < triangles_num * 3; ++i) {
+            work.adjacency[fill[indices[i]]++] = i / 3;
+        }
+        free(fill);
+    }
+
+    work.cache_time = calloc(vertices_num, sizeof(GLint));
+    work.emitted = calloc(triangles_num, sizeof(GLubyte));
+    work.dead_end = malloc(sizeof(GLuint) * triangles_num * 3);
+
+    GLuint outputTriangles = 0;
+    GLuint clustersNum = 0;
+    GLint timestamp = cache_size + 1;
+    GLint fanning = PmdTipsify_skipDeadEnd(&work, vertices_num);
+
+    // 三角形の先頭はクラスタの開始位置になる
+    if (fanning >= 0) {
+        clusters[clustersNum++] = 0;
+    }
+
+    while (fanning >= 0) {
+        // 候補頂点は直前に出力した三角形の頂点から選ぶ
+        const GLuint candidateBegin = work.dead_end_num;
+
+        // fanning頂点に隣接している三角形をすべて出力する
+        for (i = work.adjacency_offsets[fanning]; i < work.adjacency_offsets[fanning + 1]; ++i) {
+            const GLuint triangle = work.adjacency[i];
+            if (work.emitted[triangle]) {
+                continue;
+            }
+
+            for (k = 0; k < 3; ++k) {
+                const GLushort v = indices[triangle * 3 + k];
+                result[outputTriangles * 3 + k] = v;
+                work.dead_end[work.dead_end_num++] = v;
+                --work.live[v];
+
+                if (timestamp - work.cache_time[v] > cache_size) {
+                    work.cache_time[v] = timestamp++;
+                }
+            }
+
+            work.emitted[triangle] = 1;
+            ++outputTriangles;
+        }
+
+        // キャッシュに残っている候補のうち、最も古く、かつ確実にキャッシュ内にある頂点を選ぶ
+        GLint next = -1;
+        GLint priority = -1;
+        for (i = candidateBegin; i < work.dead_end_num; ++i) {
+            const GLuint v = work.dead_end[i];
+            if (work.live[v] <= 0) {
+                continue;
+            }
+
+            GLint p = 0;
+            if (timestamp - work.cache_time[v] + 2 * work.live[v] <= cache_size) {
+                p = timestamp - work.cache_time[v];
+            }
+            if (p > priority) {
+                priority = p;
+                next = v;
+            }
+        }
+
+        if (next < 0) {
+            // デッドエンドに到達したため、新しいクラスタとして開始する
+            next = PmdTipsify_skipDeadEnd(&work, vertices_num);
+            if (next >= 0 && outputTriangles < triangles_num) {
+                clusters[clustersNum++] = outputTriangles;
+            }
+        }
+        fanning = next;
+    }
+
+    assert(outputTriangles == triangles_num);
+
+    free(work.live);
+    free(work.adjacency_offsets);
+    free(work.adjacency);
+    free(work.cache_time);
+    free(work.emitted);
+    free(work.dead_end);
+
+    return clustersNum;
+}
+
+/**
+ * オーバードロー最適化用のクラスタ情報
+ */
+typedef struct PmdCluster {
+    /**
+     * 開始三角形
+     */
+    GLuint begin;
+
+    /**
+     * 三角形数
+     */
+    GLuint triangles_num;
+
+    /**
+     * ソートキー
+     * メッシュ中心から外側を向いているクラスタほど大きくなる
+     */
+    GLfloat key;
+} PmdCluster;
+
+/**
+ * ソートキーの降順で並べる
+ */
+static int PmdOptimize_compareCluster(const void *a, const void *b) {
+    const GLfloat ka = ((const PmdCluster*) a)->key;
+    const GLfloat kb = ((const PmdCluster*) b)->key;
+    return ka > kb ? -1 : (ka < kb ? 1 : 0);
+}
+
+/**
+ * クラスタを外向き順に並べ替えてオーバードローを減らす。
+ * ACMRの悪化が閾値を超える場合は並べ替えない。
+ */
+static void PmdOptimize_sortClusters(const PmdVertex *vertices, GLushort *indices, const GLuint triangles_num, const GLuint *clusterBegins, const GLuint clusters_num) {
+    if (clusters_num < 2) {
+        return;
+    }
+
+    PmdCluster *clusters = malloc(sizeof(PmdCluster) * clusters_num);
+    vec3 meshCenter = vec3_create(0, 0, 0);
+    GLfloat meshArea = 0;
+
+    int i = 0;
+    int t = 0;
+
+    // クラスタごとの中心と法線を求める
+    vec3 *centers = malloc(sizeof(vec3) * clusters_num);
+    vec3 *normals = malloc(sizeof(vec3) * clusters_num);
+    for (i = 0; i < clusters_num; ++i) {
+        PmdCluster *cluster = &clusters[i];
+        cluster->begin = clusterBegins[i];
+        cluster->triangles_num = (i + 1 < clusters_num ? clusterBegins[i + 1] : triangles_num) - cluster->begin;
+
+        vec3 center = vec3_create(0, 0, 0);
+        vec3 normal = vec3_create(0, 0, 0);
+        GLfloat area = 0;
+
+        for (t = cluster->begin; t < cluster->begin + cluster->triangles_num; ++t) {
+            const vec3 p0 = vertices[indices[t * 3 + 0]].position;
+            const vec3 p1 = vertices[indices[t * 3 + 1]].position;
+            const vec3 p2 = vertices[indices[t * 3 + 2]].position;
+
+            // 外積の長さは面積の2倍になる
+            const vec3 n = vec3_cross(vec3_create(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z), vec3_create(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z));
+            const GLfloat a = vec3_length(n);
+
+            center.x += (p0.x + p1.x + p2.x) * a / 3.0f;
+            center.y += (p0.y + p1.y + p2.y) * a / 3.0f;
+            center.z += (p0.z + p1.z + p2.z) * a / 3.0f;
+            normal.x += n.x;
+            normal.y += n.y;
+            normal.z += n.z;
+            area += a;
+        }
+
+        meshCenter.x += center.x;
+        meshCenter.y += center.y;
+        meshCenter.z += center.z;
+        meshArea += area;
+
+        if (area > 0) {
+            centers[i] = vec3_create(center.x / area, center.y / area, center.z / area);
+        } else {
+            centers[i] = center;
+        }
+        const GLfloat len = vec3_length(normal);
+        normals[i] = len > 0 ? vec3_create(normal.x / len, normal.y / len, normal.z / len) : normal;
+    }
+
+    if (meshArea > 0) {
+        meshCenter = vec3_create(meshCenter.x / meshArea, meshCenter.y / meshArea, meshCenter.z / meshArea);
+    }
+
+    for (i = 0; i < clusters_num; ++i) {
+        clusters[i].key = vec3_dot(vec3_create(centers[i].x - meshCenter.x, centers[i].y - meshCenter.y, centers[i].z - meshCenter.z), normals[i]);
+    }
+    free(centers);
+    free(normals);
+
+    qsort(clusters, clusters_num, sizeof(PmdCluster), PmdOptimize_compareCluster);
+
+    // 並べ替えた結果を作る
+    GLushort *sorted = malloc(sizeof(GLushort) * triangles_num * 3);
+    {
+        GLuint write = 0;
+        for (i = 0; i < clusters_num; ++i) {
+            memcpy(sorted + write * 3, indices + clusters[i].begin * 3, sizeof(GLushort) * clusters[i].triangles_num * 3);
+            write += clusters[i].triangles_num;
+        }
+    }
+
+    // キャッシュ効率が悪化しすぎていなければ採用する
+    const GLfloat acmrCache = PmdFile_calcACMR(indices, triangles_num * 3, PMDOPTIMIZE_CACHE_SIZE);
+    const GLfloat acmrSorted = PmdFile_calcACMR(sorted, triangles_num * 3, PMDOPTIMIZE_CACHE_SIZE);
+    if (acmrSorted <= acmrCache * PMDOPTIMIZE_OVERDRAW_THRESHOLD) {
+        memcpy(indices, sorted, sizeof(GLushort) * triangles_num * 3);
+    }
+
+    free(sorted);
+    free(clusters);
+}
+
+/**
+ * インデックスの参照順に頂点を並べ替える
+ */
+static void PmdOptimize_reorderVertices(PmdFile *pmd) {
+    const GLuint UNUSED = 0xFFFFFFFF;
+    GLuint *remap = malloc(sizeof(GLuint) * pmd->vertices_num);
+    memset(remap, 0xFF, sizeof(GLuint) * pmd->vertices_num);
+
+    GLuint next = 0;
+    int i = 0;
+    for (i = 0; i < pmd->indices_num; ++i) {
+        const GLushort v = pmd->indices[i];
+        if (remap[v] == UNUSED) {
+            remap[v] = next++;
+        }
+        pmd->indices[i] = remap[v];
+    }
+
+    // 参照されていない頂点は末尾へ回す
+    for (i = 0; i < pmd->vertices_num; ++i) {
+        if (remap[i] == UNUSED) {
+            remap[i] = next++;
+        }
+    }
+
+    PmdVertex *vertices = malloc(sizeof(PmdVertex) * pmd->vertices_num);
+    PmdVertexExtra *vertices_extra = malloc(sizeof(PmdVertexExtra) * pmd->vertices_num);
+    for (i = 0; i < pmd->vertices_num; ++i) {
+        vertices[remap[i]] = pmd->vertices[i];
+        vertices_extra[remap[i]] = pmd->vertices_extra[i];
+    }
+    free(pmd->vertices);
+    free(pmd->vertices_extra);
+    pmd->vertices = vertices;
+    pmd->vertices_extra = vertices_extra;
+
+    // 表情の頂点番号を付け替える
+    for (i = 0; i < pmd->morphs_num; ++i) {
+        PmdMorph *morph = &pmd->morphs[i];
+        int k = 0;
+        for (k = 0; k < morph->vertices_num; ++k) {
+            morph->indices[k] = remap[morph->indices[k]];
+        }
+    }
+
+    free(remap);
+}
+
+/**
+ * PMDメッシュの最適化を行う。
+ */
+void PmdFile_optimize(PmdFile *pmd, PmdOptimizeReport *report) {
+    PmdOptimizeReport dummy;
+    if (!report) {
+        report = &dummy;
+    }
+
+    // 最適化は16bitインデックスのメッシュのみを対象とする
+    if (pmd->index_type != GL_UNSIGNED_SHORT) {
+        report->acmr_before = report->acmr_after = 0;
+        report->vertices_before = report->vertices_after = pmd->vertices_num;
+        __logf("PmdFile_optimize skip 32bit indices(%d)", pmd->indices_num);
+        return;
+    }
+
+    report->acmr_before = PmdFile_calcACMR(pmd->indices, pmd->indices_num, PMDOPTIMIZE_CACHE_SIZE);
+    report->vertices_before = pmd->vertices_num;
+
+    int i = 0;
+
+    // 一致する頂点を統合する
+    {
+        GLuint *remap = malloc(sizeof(GLuint) * pmd->vertices_num);
+        const GLuint welded = PmdOptimize_weldVertices(pmd, remap);
+
+        for (i = 0; i < pmd->indices_num; ++i) {
+            pmd->indices[i] = remap[pmd->indices[i]];
+        }
+        for (i = 0; i < pmd->morphs_num; ++i) {
+            PmdMorph *morph = &pmd->morphs[i];
+            int k = 0;
+            for (k = 0; k < morph->vertices_num; ++k) {
+                morph->indices[k] = remap[morph->indices[k]];
+            }
+        }
+
+        pmd->vertices_num = welded;
+        free(remap);
+    }
+
+    // 材質ごとに三角形を並べ替える
+    {
+        GLushort *sorted = malloc(sizeof(GLushort) * pmd->indices_num);
+        GLuint *clusters = malloc(sizeof(GLuint) * (pmd->indices_num / 3 + 1));
+        GLuint beginIndicesIndex = 0;
+
+        for (i = 0; i < pmd->materials_num; ++i) {
+            const GLuint indices_num = pmd->materials[i].indices_num;
+            const GLuint triangles_num = indices_num / 3;
+            GLushort *range = pmd->indices + beginIndicesIndex;
+
+            if (triangles_num) {
+                const GLuint clusters_num = PmdOptimize_tipsify(range, triangles_num, pmd->vertices_num, PMDOPTIMIZE_CACHE_SIZE, sorted, clusters);
+                memcpy(range, sorted, sizeof(GLushort) * triangles_num * 3);
+
+                PmdOptimize_sortClusters(pmd->vertices, range, triangles_num, clusters, clusters_num);
+            }
+
+            beginIndicesIndex += indices_num;
+        }
+
+        free(sorted);
+        free(clusters);
+    }
+
+    // 頂点フェッチの局所性を高める
+    PmdOptimize_reorderVertices(pmd);
+
+    report->acmr_after = PmdFile_calcACMR(pmd->indices, pmd->indices_num, PMDOPTIMIZE_CACHE_SIZE);
+    report->vertices_after = pmd->vertices_num;
+
+    __logf("PmdFile_optimize ACMR(%.3f -> %.3f) vertices(%d -> %d)", report->acmr_before, report->acmr_after, report->vertices_before, report->vertices_after);
+}
@@ -0,0 +1,65 @@
+/*
+ * support_gl_PmdOptimize.h
+ *
+ * PMDメッシュを頂点キャッシュ・オーバードロー・頂点フェッチの観点で並べ替える
+ * 材質の描画範囲は変更しないため、描画処理側の変更は必要ない。
+ */
+
+#ifndef SUPPORT_GL_PMDOPTIMIZE_H_
+#define SUPPORT_GL_PMDOPTIMIZE_H_
+
+/**
+ * 最適化で想定する頂点キャッシュ（Post Transform Cache）のサイズ
+ */
+#define PMDOPTIMIZE_CACHE_SIZE 16
+
+/**
+ * オーバードロー最適化で許容するACMRの悪化率
+ * 並べ替え後のACMRがこの倍率を超える場合はキャッシュ最適化の結果を採用する
+ */
+#define PMDOPTIMIZE_OVERDRAW_THRESHOLD 1.05f
+
+/**
+ * 最適化結果
+ */
+typedef struct PmdOptimizeReport {
+    /**
+     * 最適化前のACMR（三角形あたりの頂点キャッシュミス数）
+     */
+    GLfloat acmr_before;
+
+    /**
+     * 最適化後のACMR
+     */
+    GLfloat acmr_after;
+
+    /**
+     * 最適化前の頂点数
+     */
+    GLuint vertices_before;
+
+    /**
+     * 最適化後の頂点数
+     * 完全に一致する頂点は統合される
+     */
+    GLuint vertices_after;
+} PmdOptimizeReport;
+
+/**
+ * FIFOキャッシュを想定してACMRを計算する
+ */
+extern GLfloat PmdFile_calcACMR(const GLushort *indices, const GLuint indices_num, const GLuint cache_size);
+
+/**
+ * PMDメッシュの最適化を行う。
+ * 1. 完全に一致する頂点を統合する（表情の影響を受ける頂点は除く）
+ * 2. 材質ごとにTipsifyで頂点キャッシュ向けに三角形を並べ替える
+ * 3. キャッシュミスで区切ったクラスタを外向き順に並べ替え、オーバードローを減らす
+ * 4. インデックスの参照順に頂点を並べ替える
+ *
+ * VBOへ転送する前に呼び出す。reportはNULLでも構わない。
+ * 32bitインデックスのメッシュは対象外となり、何もしない。
+ */
+extern void PmdFile_optimize(PmdFile *pmd, PmdOptimizeReport *report);
+
+#endif /* SUPPORT_GL_PMDOPTIMIZE_H_ */
@@ -0,0 +1,1016 @@
+/*
+ * support_gl_Pmx.c
+ */
+
+#include    "support.h"
+
+/**
+ * 文字列のエンコード
+ */
+#define PMXFILE_ENCODING_UTF16  0
+#define PMXFILE_ENCODING_UTF8   1
+
+/**
+ * 材質の描画フラグ
+ * エッジ描画
+ */
+#define PMXMATERIAL_FLAG_EDGE   0x10
+
+/**
+ * ボーンフラグ
+ */
+#define PMXBONE_FLAG_TAIL_INDEX     0x0001
+#define PMXBONE_FLAG_MOVABLE        0x0004
+#define PMXBONE_FLAG_IK             0x0020
+#define PMXBONE_FLAG_INHERIT_ROTATE 0x0100
+#define PMXBONE_FLAG_INHERIT_MOVE   0x0200
+#define PMXBONE_FLAG_FIXED_AXIS     0x0400
+#define PMXBONE_FLAG_LOCAL_AXIS     0x0800
+#define PMXBONE_FLAG_EXTERNAL       0x2000
+
+/**
+ * PMXヘッダ情報
+ */
+typedef struct PmxHeader {
+    /**
+     * 文字列のエンコード
+     */
+    GLubyte encoding;
+
+    /**
+     * 追加UV数
+     */
+    GLubyte additional_uv_num;
+
+    /**
+     * 各インデックスのバイト数
+     */
+    GLubyte vertex_index_size;
+    GLubyte texture_index_size;
+    GLubyte material_index_size;
+    GLubyte bone_index_size;
+    GLubyte morph_index_size;
+    GLubyte rigidbody_index_size;
+} PmxHeader;
+
+/**
+ * ファイル内の文字列を指す
+ * 必要になるまで変換やコピーを行わない。
+ */
+typedef struct PmxText {
+    /**
+     * 文字列の先頭
+     */
+    const uint8_t *data;
+
+    /**
+     * 文字列のバイト数
+     */
+    GLuint bytes;
+} PmxText;
+
+/**
+ * count件 × strideバイトのレコードを読み込めればtrueを返す
+ * 足りない場合はファイルが壊れているものとして扱う。
+ */
+static bool PmxFile_hasRecords(RawData *data, const GLuint count, const size_t stride) {
+    const int available = RawData_getAvailableBytes(data);
+    if (available < 0 || (stride && count > (size_t) available / stride)) {
+        __logf("PMX Truncated records(%u x %d) available(%d)", count, (int) stride, available);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 指定バイト数を読み込めればtrueを返す
+ */
+static bool PmxFile_hasBytes(RawData *data, const size_t bytes) {
+    return PmxFile_hasRecords(data, 1, bytes);
+}
+
+/**
+ * 文字列を読み込む
+ * 文字列はファイル内を直接指す。
+ * 長さがファイルの残りを超える場合はfalseを返す。
+ */
+static bool PmxFile_readText(RawData *data, PmxText *result) {
+    if (!PmxFile_hasBytes(data, sizeof(GLint))) {
+        return false;
+    }
+    result->bytes = RawData_readLE32(data);
+    if (!PmxFile_hasBytes(data, result->bytes)) {
+        return false;
+    }
+    result->data = RawData_getReadHeader(data);
+    RawData_offsetHeader(data, result->bytes);
+    return true;
+}
+
+/**
+ * 文字列を読み飛ばす
+ */
+static bool PmxFile_skipText(RawData *data) {
+    PmxText text;
+    return PmxFile_readText(data, &text);
+}
+
+/**
+ * UTF-8の1文字を書き込む
+ * 書き込めない場合は0を返す
+ */
+static int PmxFile_writeUtf8(GLchar *result, const size_t available, const GLuint code) {
+    if (code < 0x80) {
+        if (available < 1) {
+            return 0;
+        }
+        result[0] = (GLchar) code;
+        return 1;
+    } else if (code < 0x800) {
+        if (available < 2) {
+            return 0;
+        }
+        result[0] = (GLchar) (0xC0 | (code >> 6));
+        result[1] = (GLchar) (0x80 | (code & 0x3F));
+        return 2;
+    } else if (code < 0x10000) {
+        if (available < 3) {
+            return 0;
+        }
+        result[0] = (GLchar) (0xE0 | (code >> 12));
+        result[1] = (GLchar) (0x80 | ((code >> 6) & 0x3F));
+        result[2] = (GLchar) (0x80 | (code & 0x3F));
+        return 3;
+    } else {
+        if (available < 4) {
+            return 0;
+        }
+        result[0] = (GLchar) (0xF0 | (code >> 18));
+        result[1] = (GLchar) (0x80 | ((code >> 12) & 0x3F));
+        result[2] = (GLchar) (0x80 | ((code >> 6) & 0x3F));
+        result[3] = (GLchar) (0x80 | (code & 0x3F));
+        return 4;
+    }
+}
+
+/**
+ * 文字列をUTF-8に変換してresultへ格納する
+ * 格納しきれない場合は文字単位で切り詰め、falseを返す。
+ */
+static bool PmxFile_decodeText(const PmxHeader *header, const PmxText *text, GLchar *result, const size_t result_length) {
+    assert(result_length > 0);
+    size_t written = 0;
+    bool truncated = false;
+
+    if (header->encoding == PMXFILE_ENCODING_UTF8) {
+        // UTF-8はそのままコピーし、文字の途中で切れないようにする
+        written = text->bytes < result_length - 1 ? text->bytes : result_length - 1;
+        if (written < text->bytes) {
+            truncated = true;
+            while (written && (text->data[written] & 0xC0) == 0x80) {
+                --written;
+            }
+        }
+        memcpy(result, text->data, written);
+    } else {
+        // UTF-16LEをUTF-8に変換する
+        GLuint i = 0;
+        while (i + 1 < text->bytes) {
+            GLuint code = text->data[i] | (text->data[i + 1] << 8);
+            i += 2;
+
+            // サロゲートペア
+            if (code >= 0xD800 && code < 0xDC00 && i + 1 < text->bytes) {
+                const GLuint low = text->data[i] | (text->data[i + 1] << 8);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    i += 2;
+                }
+            }
+
+            const int bytes = PmxFile_writeUtf8(result + written, result_length - 1 - written, code);
+            if (!bytes) {
+                truncated = true;
+                break;
+            }
+            written += bytes;
+        }
+    }
+
+    result[written] = '\0';
+    return !truncated;
+}
+
+/**
+ * 符号付きインデックスを読み込む
+ * 未指定の場合は-1となる
+ */
+static GLint PmxFile_readIndex(const uint8_t **p, const GLubyte size) {
+    GLint result = 0;
+    switch (size) {
+        case 1:
+            result = (int8_t) (*p)[0];
+            break;
+        case 2: {
+            int16_t value;
+            memcpy(&value, *p, sizeof(value));
+            result = value;
+        }
+            break;
+        default: {
+            int32_t value;
+            memcpy(&value, *p, sizeof(value));
+            result = value;
+        }
+            break;
+    }
+    *p += size;
+    return result;
+}
+
+/**
+ * RawDataから符号付きインデックスを読み込む
+ */
+static GLint PmxFile_readDataIndex(RawData *data, const GLubyte size) {
+    const uint8_t *p = RawData_getReadHeader(data);
+    const GLint result = PmxFile_readIndex(&p, size);
+    RawData_offsetHeader(data, size);
+    return result;
+}
+
+/**
+ * 頂点インデックスを読み込む
+ * 1byte/2byteの場合は符号なしとして扱う
+ */
+static GLuint PmxFile_readVertexIndex(const uint8_t **p, const GLubyte size) {
+    GLuint result = 0;
+    switch (size) {
+        case 1:
+            result = (*p)[0];
+            break;
+        case 2: {
+            uint16_t value;
+            memcpy(&value, *p, sizeof(value));
+            result = value;
+        }
+            break;
+        default: {
+            uint32_t value;
+            memcpy(&value, *p, sizeof(value));
+            result = value;
+        }
+            break;
+    }
+    *p += size;
+    return result;
+}
+
+/**
+ * インデックスのバイト数として正しければtrueを返す
+ */
+static bool PmxFile_isIndexSize(const GLubyte size) {
+    return size == 1 || size == 2 || size == 4;
+}
+
+/**
+ * 範囲外のボーン・材質等を指すインデックスであればtrueを返す
+ * 未指定(-1)は範囲内として扱う。
+ */
+static bool PmxFile_isIndexOutOfRange(const GLint index, const GLuint num) {
+    return index < -1 || (index >= 0 && (GLuint) index >= num);
+}
+
+/**
+ * 読み込み位置がPMXファイルの先頭であればtrueを返す。
+ */
+bool PmxFile_isPmx(RawData *data) {
+    if (RawData_getAvailableBytes(data) < 4) {
+        return false;
+    }
+    return memcmp(RawData_getReadHeader(data), "PMX ", 4) == 0;
+}
+
+/**
+ * ヘッダを読み込む
+ */
+static bool PmxFile_loadHeader(PmdFile *result, PmxHeader *header, RawData *data) {
+    if (!PmxFile_isPmx(data)) {
+        return false;
+    }
+    RawData_offsetHeader(data, 4);
+
+    if (!PmxFile_hasBytes(data, sizeof(GLfloat) + 1)) {
+        return false;
+    }
+
+    // version check
+    RawData_readBytes(data, &result->header.version, sizeof(GLfloat));
+    if (result->header.version < 2.0f || result->header.version > 2.1f) {
+        __logf("PMX Version Error(%f)", result->header.version);
+        return false;
+    }
+
+    // 各種設定
+    {
+        const GLuint globals_num = (GLubyte) RawData_read8(data);
+        if (globals_num < 8 || !PmxFile_hasBytes(data, globals_num)) {
+            __logf("PMX Globals Error(%d)", globals_num);
+            return false;
+        }
+
+        const uint8_t *globals = RawData_getReadHeader(data);
+        header->encoding = globals[0];
+        header->additional_uv_num = globals[1];
+        header->vertex_index_size = globals[2];
+        header->texture_index_size = globals[3];
+        header->material_index_size = globals[4];
+        header->bone_index_size = globals[5];
+        header->morph_index_size = globals[6];
+        header->rigidbody_index_size = globals[7];
+        RawData_offsetHeader(data, globals_num);
+
+        if (!PmxFile_isIndexSize(header->vertex_index_size) || !PmxFile_isIndexSize(header->texture_index_size) || !PmxFile_isIndexSize(header->material_index_size) || //
+                !PmxFile_isIndexSize(header->bone_index_size) || !PmxFile_isIndexSize(header->morph_index_size) || !PmxFile_isIndexSize(header->rigidbody_index_size)) {
+            __log("PMX Index size Error");
+            return false;
+        }
+    }
+
+    // モデル名
+    {
+        PmxText name;
+        PmxText comment;
+        // 英語名・英語コメントは読み飛ばす
+        if (!PmxFile_readText(data, &name) || !PmxFile_skipText(data) || !PmxFile_readText(data, &comment) || !PmxFile_skipText(data)) {
+            return false;
+        }
+
+        PmxFile_decodeText(header, &name, result->header.name, sizeof(result->header.name));
+        PmxFile_decodeText(header, &comment, result->header.comment, sizeof(result->header.comment));
+    }
+
+    __logf("PMX Version(%.1f) encoding(%d) uv(%d)", result->header.version, (int) header->encoding, (int) header->additional_uv_num);
+    __logf("Name(%s)", result->header.name);
+    return true;
+}
+
+/**
+ * ウェイト情報のバイト数を取得する
+ * 未知の変形方式の場合は0を返す。
+ */
+static size_t PmxFile_getDeformBytes(const GLubyte deform, const GLubyte boneSize) {
+    switch (deform) {
+        case PMXVERTEX_DEFORM_BDEF1:
+            return boneSize;
+        case PMXVERTEX_DEFORM_BDEF2:
+            return boneSize * 2 + sizeof(GLfloat);
+        case PMXVERTEX_DEFORM_SDEF:
+            return boneSize * 2 + sizeof(GLfloat) + sizeof(vec3) * 3;
+        case PMXVERTEX_DEFORM_BDEF4:
+        case PMXVERTEX_DEFORM_QDEF:
+            return boneSize * 4 + sizeof(GLfloat) * 4;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * 頂点情報を取得する
+ * 可変長の頂点レコードをファイル上から直接デコードする。
+ */
+static bool PmxFile_loadVertices(PmdFile *result, const PmxHeader *header, RawData *data) {
+    if (!PmxFile_hasBytes(data, sizeof(GLint))) {
+        return false;
+    }
+    const GLuint numVertices = RawData_readLE32(data);
+    __logf("vertices[%d]", numVertices);
+
+    const size_t uvBytes = sizeof(vec4) * header->additional_uv_num;
+    const GLubyte boneSize = header->bone_index_size;
+
+    // 位置・法線・UV・追加UV・変形方式・エッジ倍率の固定長部分
+    // 全頂点がBDEF1であっても収まらない頂点数は読み込まない
+    const size_t fixedBytes = sizeof(vec3) * 2 + sizeof(vec2) + uvBytes + 1 + sizeof(GLfloat);
+    if (!PmxFile_hasRecords(data, numVertices, fixedBytes + boneSize)) {
+        return false;
+    }
+
+    result->vertices = malloc(sizeof(PmdVertex) * (numVertices ? numVertices : 1));
+    result->vertices_extra = malloc(sizeof(PmdVertexExtra) * (numVertices ? numVertices : 1));
+    result->vertices_num = numVertices;
+
+    const uint8_t *head = RawData_getReadHeader(data);
+    const uint8_t *end = head + RawData_getAvailableBytes(data);
+    const uint8_t *p = head;
+
+    int i = 0;
+    for (i = 0; i < numVertices; ++i) {
+        PmdVertex *v = &result->vertices[i];
+        PmdVertexExtra *extra = &result->vertices_extra[i];
+
+        // 変形方式によってレコード長が変わるため、ウェイト情報の前後で残量を確認する
+        if ((size_t) (end - p) < fixedBytes) {
+            __logf("PMX Truncated vertex(%d)", i);
+            return false;
+        }
+
+        // 位置・法線・UVは固定長のため一括で読み込む
+        memcpy(&v->position, p, sizeof(vec3));
+        memcpy(&v->normal, p + sizeof(vec3), sizeof(vec3));
+        memcpy(&v->uv, p + sizeof(vec3) * 2, sizeof(vec2));
+        // 追加UVは利用しない
+        p += sizeof(vec3) * 2 + sizeof(vec2) + uvBytes;
+
+        // ウェイト情報
+        GLint bone0 = 0;
+        GLint bone1 = -1;
+        GLfloat weight0 = 1.0f;
+        const GLubyte deform = *p++;
+        const size_t deformBytes = PmxFile_getDeformBytes(deform, boneSize);
+        if (!deformBytes) {
+            __logf("PMX Unknown deform(%d) vertex(%d)", (int) deform, i);
+            return false;
+        }
+        if ((size_t) (end - p) < deformBytes + sizeof(GLfloat)) {
+            __logf("PMX Truncated vertex(%d)", i);
+            return false;
+        }
+
+        switch (deform) {
+            case PMXVERTEX_DEFORM_BDEF1:
+                bone0 = PmxFile_readIndex(&p, boneSize);
+                break;
+            case PMXVERTEX_DEFORM_BDEF2:
+            case PMXVERTEX_DEFORM_SDEF:
+                bone0 = PmxFile_readIndex(&p, boneSize);
+                bone1 = PmxFile_readIndex(&p, boneSize);
+                memcpy(&weight0, p, sizeof(GLfloat));
+                p += sizeof(GLfloat);
+
+                // SDEFのパラメータ(C, R0, R1)は利用しない
+                if (deform == PMXVERTEX_DEFORM_SDEF) {
+                    p += sizeof(vec3) * 3;
+                }
+                break;
+            default: {
+                // BDEF4 / QDEF
+                // PmdVertexExtraは2ボーンまでのため、先頭2つの比率で近似する
+                GLfloat weights[4];
+                bone0 = PmxFile_readIndex(&p, boneSize);
+                bone1 = PmxFile_readIndex(&p, boneSize);
+                p += boneSize * 2;
+                memcpy(weights, p, sizeof(weights));
+                p += sizeof(weights);
+
+                const GLfloat sum = weights[0] + weights[1];
+                weight0 = sum > 0 ? weights[0] / sum : 1.0f;
+            }
+                break;
+        }
+
+        // エッジ倍率
+        GLfloat edgeScale;
+        memcpy(&edgeScale, p, sizeof(GLfloat));
+        p += sizeof(GLfloat);
+
+        extra->bone_num[0] = (GLshort) bone0;
+        extra->bone_num[1] = (GLshort) (bone1 >= 0 ? bone1 : bone0);
+        extra->bone_weight = (GLbyte) (weight0 * 100.0f + 0.5f);
+        // PMDと同じく、エッジを表示しない頂点を1とする
+        extra->edge_flag = edgeScale > 0 ? 0 : 1;
+#if SUPPORT_PMD_VERTEX_EXTRA
+        v->extra = *extra;
+#endif
+    }
+
+    RawData_offsetHeader(data, (int) (p - head));
+    return true;
+}
+
+/**
+ * インデックス情報を取得する
+ * 65536頂点を超える場合は32bitインデックスとして格納する。
+ */
+static bool PmxFile_loadIndices(PmdFile *result, const PmxHeader *header, RawData *data) {
+    if (!PmxFile_hasBytes(data, sizeof(GLint))) {
+        return false;
+    }
+    const GLuint numIndices = RawData_readLE32(data);
+    const GLubyte size = header->vertex_index_size;
+    __logf("indices[%d]", numIndices);
+
+    if (!PmxFile_hasRecords(data, numIndices, size)) {
+        return false;
+    }
+
+    const uint8_t *p = RawData_getReadHeader(data);
+    result->indices_num = numIndices;
+
+    int i = 0;
+    if (result->vertices_num <= PMDDRAWMESH_VERTICES_MAX) {
+        result->index_type = GL_UNSIGNED_SHORT;
+        result->indices = malloc(sizeof(GLushort) * (numIndices ? numIndices : 1));
+
+        if (size == sizeof(GLushort)) {
+            // 同じ形式のためそのままコピーできる
+            memcpy(result->indices, p, sizeof(GLushort) * numIndices);
+        } else {
+            const uint8_t *read = p;
+            for (i = 0; i < numIndices; ++i) {
+                const GLuint index = PmxFile_readVertexIndex(&read, size);
+                // 16bitへ切り詰める前に範囲を確認する
+                if (index >= result->vertices_num) {
+                    __logf("PMX Index out of range(%u) index(%d)", index, i);
+                    return false;
+                }
+                result->indices[i] = (GLushort) index;
+            }
+        }
+    } else {
+        result->index_type = GL_UNSIGNED_INT;
+        result->indices32 = malloc(sizeof(GLuint) * (numIndices ? numIndices : 1));
+
+        if (size == sizeof(GLuint)) {
+            memcpy(result->indices32, p, sizeof(GLuint) * numIndices);
+        } else {
+            const uint8_t *read = p;
+            for (i = 0; i < numIndices; ++i) {
+                result->indices32[i] = PmxFile_readVertexIndex(&read, size);
+            }
+        }
+    }
+    RawData_offsetHeader(data, size * numIndices);
+
+    // 整合性チェック
+    for (i = 0; i < numIndices; ++i) {
+        if (PmdFile_getIndex(result, i) >= result->vertices_num) {
+            __logf("PMX Index out of range(%d) index(%d)", (int) PmdFile_getIndex(result, i), i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * テクスチャパスをPMDと同じ形式で格納する
+ */
+static void PmxFile_decodeTexturePath(const PmxHeader *header, const PmxText *textures, const GLuint textures_num, const GLint index, GLchar *result, const size_t result_length) {
+    if (index < 0 || index >= textures_num) {
+        result[0] = '\0';
+        return;
+    }
+
+    // PMDと同じ固定長に収まらないパスは切り詰め、読み込みは切り詰めた名前 + ".png"で行う
+    const bool complete = PmxFile_decodeText(header, &textures[index], result, result_length);
+
+    // Windowsのパス区切りを変換する
+    GLchar *p = result;
+    while ((p = strchr(p, '\\'))) {
+        *p = '/';
+    }
+
+    if (!complete) {
+        __logf("texture path truncated(%s)", result);
+    }
+}
+
+/**
+ * 材質1件を読み込む
+ */
+static bool PmxFile_loadMaterialRecord(PmdMaterial *m, const PmxHeader *header, const PmxText *textures, const GLuint textures_num, RawData *data) {
+    const GLubyte textureSize = header->texture_index_size;
+
+    // 材質名は保持しない
+    if (!PmxFile_skipText(data) || !PmxFile_skipText(data)) {
+        return false;
+    }
+
+    // 色・フラグ・エッジ・テクスチャ・スフィアモード・共有トゥーンフラグ
+    if (!PmxFile_hasBytes(data, sizeof(vec4) + sizeof(vec3) + sizeof(GLfloat) + sizeof(vec3) + 1 + sizeof(vec4) + sizeof(GLfloat) + textureSize * 2 + 1 + 1)) {
+        return false;
+    }
+
+    RawData_readBytes(data, &m->diffuse, sizeof(vec4));
+    RawData_readBytes(data, &m->extra.specular_color, sizeof(vec3));
+    RawData_readBytes(data, &m->extra.shininess, sizeof(GLfloat));
+    RawData_readBytes(data, &m->extra.ambient_color, sizeof(vec3));
+
+    const GLubyte flags = (GLubyte) RawData_read8(data);
+    m->extra.edge_flag = (flags & PMXMATERIAL_FLAG_EDGE) ? 1 : 0;
+
+    // エッジ色(vec4) + エッジサイズ(float)
+    RawData_offsetHeader(data, sizeof(vec4) + sizeof(GLfloat));
+
+    const GLint diffuseTexture = PmxFile_readDataIndex(data, textureSize);
+    const GLint effectTexture = PmxFile_readDataIndex(data, textureSize);
+    // スフィアモード
+    RawData_read8(data);
+
+    // トゥーン
+    {
+        const GLubyte sharedToon = (GLubyte) RawData_read8(data);
+        if (!PmxFile_hasBytes(data, sharedToon ? 1 : textureSize)) {
+            return false;
+        }
+        if (sharedToon) {
+            m->extra.toon_index = RawData_read8(data);
+        } else {
+            PmxFile_readDataIndex(data, textureSize);
+            m->extra.toon_index = -1;
+        }
+    }
+
+    // メモ
+    if (!PmxFile_skipText(data) || !PmxFile_hasBytes(data, sizeof(GLint))) {
+        return false;
+    }
+
+    m->indices_num = RawData_readLE32(data);
+
+    // 範囲外のテクスチャはテクスチャ無しとして扱う
+    PmxFile_decodeTexturePath(header, textures, textures_num, diffuseTexture, m->diffuse_texture_name, sizeof(m->diffuse_texture_name));
+    PmxFile_decodeTexturePath(header, textures, textures_num, effectTexture, m->extra.effect_texture_name, sizeof(m->extra.effect_texture_name));
+    return true;
+}
+
+/**
+ * 材質情報を取得する
+ */
+static bool PmxFile_loadMaterial(PmdFile *result, const PmxHeader *header, RawData *data) {
+    int i = 0;
+
+    // テクスチャパスは材質から参照されるまで変換しない
+    if (!PmxFile_hasBytes(data, sizeof(GLint))) {
+        return false;
+    }
+    const GLuint numTextures = RawData_readLE32(data);
+    if (!PmxFile_hasRecords(data, numTextures, sizeof(GLint))) {
+        return false;
+    }
+    PmxText *textures = malloc(sizeof(PmxText) * (numTextures ? numTextures : 1));
+    for (i = 0; i < numTextures; ++i) {
+        if (!PmxFile_readText(data, &textures[i])) {
+            free(textures);
+            return false;
+        }
+    }
+
+    // 材質名2つ・メモ・面数と固定長部分を合わせた最小のレコード長
+    const size_t minMaterialBytes = sizeof(GLint) * 4 + sizeof(vec4) * 2 + sizeof(vec3) * 2 + sizeof(GLfloat) * 2 + header->texture_index_size * 2 + 4;
+    if (!PmxFile_hasBytes(data, sizeof(GLint))) {
+        free(textures);
+        return false;
+    }
+    const GLuint numMaterials = RawData_readLE32(data);
+    if (!PmxFile_hasRecords(data, numMaterials, minMaterialBytes)) {
+        free(textures);
+        return false;
+    }
+
+    result->materials = MemoryArena_calloc(result->arena, numMaterials ? numMaterials : 1, sizeof(PmdMaterial));
+    result->materials_num = numMaterials;
+    __logf("textures[%d] materials[%d]", numTextures, numMaterials);
+
+    GLuint sumVert = 0;
+    for (i = 0; i < numMaterials; ++i) {
+        PmdMaterial *m = &result->materials[i];
+
+        if (!PmxFile_loadMaterialRecord(m, header, textures, numTextures, data)) {
+            __logf("PMX Truncated material(%d)", i);
+            free(textures);
+            return false;
+        }
+
+        __logf("material[%d] tex(%s) effect(%s) vert(%d) face(%d)", i, m->diffuse_texture_name, m->extra.effect_texture_name, m->indices_num, m->indices_num / 3);
+
+        // 材質の範囲がインデックスを超えていれば読み込まない
+        if (m->indices_num > result->indices_num - sumVert) {
+            __logf("PMX Material indices out of range(%d)", i);
+            free(textures);
+            return false;
+        }
+        sumVert += m->indices_num;
+    }
+    free(textures);
+
+    __logf("sum vert(%d) -> num(%d)", sumVert, result->indices_num);
+    if (sumVert != result->indices_num) {
+        return false;
+    }
+
+    PmdFile_buildMaterialArrays(result);
+    return true;
+}
+
+/**
+ * ボーン1件を読み込む
+ */
+static bool PmxFile_loadBoneRecord(PmdBone *bone, const PmxHeader *header, const GLuint bones_num, RawData *data) {
+    const GLubyte boneSize = header->bone_index_size;
+    PmxText name;
+
+    if (!PmxFile_readText(data, &name) || !PmxFile_skipText(data)) {
+        return false;
+    }
+    PmxFile_decodeText(header, &name, bone->name, sizeof(bone->name));
+
+    // 位置・親ボーン・変形階層・フラグ
+    if (!PmxFile_hasBytes(data, sizeof(vec3) + boneSize + sizeof(GLint) + sizeof(GLushort))) {
+        return false;
+    }
+
+    RawData_readBytes(data, &bone->position, sizeof(vec3));
+    const GLint parent = PmxFile_readDataIndex(data, boneSize);
+
+    // 変形階層
+    RawData_offsetHeader(data, sizeof(GLint));
+
+    const GLushort flags = (GLushort) RawData_readLE16(data);
+
+    // 接続先
+    GLint tail = -1;
+    if (!PmxFile_hasBytes(data, (flags & PMXBONE_FLAG_TAIL_INDEX) ? boneSize : sizeof(vec3))) {
+        return false;
+    }
+    if (flags & PMXBONE_FLAG_TAIL_INDEX) {
+        tail = PmxFile_readDataIndex(data, boneSize);
+    } else {
+        RawData_offsetHeader(data, sizeof(vec3));
+    }
+
+    // 付与親・軸固定・ローカル軸・外部親
+    {
+        size_t bytes = 0;
+        if (flags & (PMXBONE_FLAG_INHERIT_ROTATE | PMXBONE_FLAG_INHERIT_MOVE)) {
+            bytes += boneSize + sizeof(GLfloat);
+        }
+        if (flags & PMXBONE_FLAG_FIXED_AXIS) {
+            bytes += sizeof(vec3);
+        }
+        if (flags & PMXBONE_FLAG_LOCAL_AXIS) {
+            bytes += sizeof(vec3) * 2;
+        }
+        if (flags & PMXBONE_FLAG_EXTERNAL) {
+            bytes += sizeof(GLint);
+        }
+        if (!PmxFile_hasBytes(data, bytes)) {
+            return false;
+        }
+        RawData_offsetHeader(data, (int) bytes);
+    }
+
+    bone->extra.type = (flags & PMXBONE_FLAG_MOVABLE) ? 1 : 0;
+
+    // IK
+    GLint target = 0;
+    if (flags & PMXBONE_FLAG_IK) {
+        // ターゲット + ループ回数(4) + 制限角度(4) + リンク数(4)
+        if (!PmxFile_hasBytes(data, boneSize + sizeof(GLint) + sizeof(GLfloat) + sizeof(GLint))) {
+            return false;
+        }
+
+        bone->extra.type = 2;
+        target = PmxFile_readDataIndex(data, boneSize);
+        RawData_offsetHeader(data, sizeof(GLint) + sizeof(GLfloat));
+
+        const GLuint links = RawData_readLE32(data);
+        if (!PmxFile_hasRecords(data, links, boneSize + 1)) {
+            return false;
+        }
+
+        int k = 0;
+        for (k = 0; k < links; ++k) {
+            if (!PmxFile_hasBytes(data, boneSize + 1)) {
+                return false;
+            }
+            RawData_offsetHeader(data, boneSize);
+            if (RawData_read8(data)) {
+                // 角度制限の下限・上限
+                if (!PmxFile_hasBytes(data, sizeof(vec3) * 2)) {
+                    return false;
+                }
+                RawData_offsetHeader(data, sizeof(vec3) * 2);
+            }
+        }
+    }
+
+    // GLshortへ格納する前に範囲を確認する
+    if (PmxFile_isIndexOutOfRange(parent, bones_num) || PmxFile_isIndexOutOfRange(tail, bones_num) || PmxFile_isIndexOutOfRange(target, bones_num)) {
+        __logf("PMX Bone index out of range(%d, %d, %d)", parent, tail, target);
+        return false;
+    }
+    bone->parent_bone_index = (GLshort) parent;
+    bone->extra.tail_pos_bone_index = (GLshort) tail;
+    bone->extra.ik_parent_bone_index = (GLshort) target;
+    return true;
+}
+
+/**
+ * ボーン情報を取得する
+ */
+static bool PmxFile_loadBone(PmdFile *result, const PmxHeader *header, RawData *data) {
+    if (!PmxFile_hasBytes(data, sizeof(GLint))) {
+        return false;
+    }
+    const GLuint numBones = RawData_readLE32(data);
+
+    // 名前2つ・位置・親ボーン・変形階層・フラグ・接続先の最小のレコード長
+    const size_t minBoneBytes = sizeof(GLint) * 2 + sizeof(vec3) + header->bone_index_size * 2 + sizeof(GLint) + sizeof(GLushort);
+    if (numBones > 0x8000 || !PmxFile_hasRecords(data, numBones, minBoneBytes)) {
+        __logf("PMX Bones Error(%u)", numBones);
+        return false;
+    }
+
+    result->bones = MemoryArena_calloc(result->arena, numBones ? numBones : 1, sizeof(PmdBone));
+    result->bones_num = numBones;
+    __logf("bones[%d]", numBones);
+
+    int i = 0;
+    for (i = 0; i < numBones; ++i) {
+        if (!PmxFile_loadBoneRecord(&result->bones[i], header, numBones, data)) {
+            __logf("PMX Truncated bone(%d)", i);
+            return false;
+        }
+    }
+
+    PmdFile_buildBoneArrays(result);
+    return true;
+}
+
+/**
+ * 表情オフセット1件のバイト数を取得する
+ * 頂点モーフ以外は読み飛ばすために利用する
+ * 未知の種類の場合は0を返す。
+ */
+static GLuint PmxFile_getMorphOffsetBytes(const PmxHeader *header, const GLubyte type) {
+    switch (type) {
+        case PMXMORPH_TYPE_GROUP:
+        case PMXMORPH_TYPE_FLIP:
+            return header->morph_index_size + sizeof(GLfloat);
+        case PMXMORPH_TYPE_VERTEX:
+            return header->vertex_index_size + sizeof(vec3);
+        case PMXMORPH_TYPE_BONE:
+            return header->bone_index_size + sizeof(vec3) + sizeof(vec4);
+        case PMXMORPH_TYPE_MATERIAL:
+            // 演算形式(1) + diffuse, specular, shininess, ambient, edge color, edge size, texture, sphere, toon
+            return header->material_index_size + 1 + sizeof(vec4) + sizeof(vec3) + sizeof(GLfloat) + sizeof(vec3) + sizeof(vec4) + sizeof(GLfloat) + sizeof(vec4) * 3;
+        case PMXMORPH_TYPE_IMPULSE:
+            return header->rigidbody_index_size + 1 + sizeof(vec3) * 2;
+        default:
+            // 追加UVを含むUVモーフ
+            if (type >= PMXMORPH_TYPE_UV && type <= PMXMORPH_TYPE_UV4) {
+                return header->vertex_index_size + sizeof(vec4);
+            }
+            return 0;
+    }
+}
+
+/**
+ * 表情情報を取得する
+ * 頂点モーフのみを読み込み、PMDと同じくbase表情を先頭に生成する。
+ */
+static bool PmxFile_loadMorph(PmdFile *result, const PmxHeader *header, RawData *data) {
+    if (!PmxFile_hasBytes(data, sizeof(GLint))) {
+        return false;
+    }
+    const GLuint numMorphs = RawData_readLE32(data);
+    __logf("morphs[%d]", numMorphs);
+
+    if (!numMorphs) {
+        return true;
+    }
+
+    // 名前2つ・操作パネル・種類・オフセット数の最小のレコード長
+    if (!PmxFile_hasRecords(data, numMorphs, sizeof(GLint) * 2 + 1 + 1 + sizeof(GLint))) {
+        return false;
+    }
+
+    // 先頭はbase表情のために空けておく
+    PmdMorph *morphs = MemoryArena_calloc(result->arena, numMorphs + 1, sizeof(PmdMorph));
+    GLuint morphs_num = 1;
+
+    int i = 0;
+    int k = 0;
+    for (i = 0; i < numMorphs; ++i) {
+        PmxText name;
+        if (!PmxFile_readText(data, &name) || !PmxFile_skipText(data) || !PmxFile_hasBytes(data, 1 + 1 + sizeof(GLint))) {
+            __logf("PMX Truncated morph(%d)", i);
+            return false;
+        }
+
+        // 操作パネルはPMDの表情種類と同じ番号になっている
+        // 0(システム予約)はbase表情と区別するため、その他として扱う
+        const GLbyte panel = RawData_read8(data);
+        const GLubyte type = (GLubyte) RawData_read8(data);
+        const GLuint offsets_num = RawData_readLE32(data);
+
+        const GLuint offsetBytes = PmxFile_getMorphOffsetBytes(header, type);
+        if (!offsetBytes) {
+            __logf("PMX Unknown morph type(%d) morph(%d)", (int) type, i);
+            return false;
+        }
+        if (!PmxFile_hasRecords(data, offsets_num, offsetBytes)) {
+            __logf("PMX Truncated morph(%d)", i);
+            return false;
+        }
+
+        if (type != PMXMORPH_TYPE_VERTEX) {
+            RawData_offsetHeader(data, offsetBytes * offsets_num);
+            continue;
+        }
+
+        PmdMorph *morph = &morphs[morphs_num++];
+        PmxFile_decodeText(header, &name, morph->name, sizeof(morph->name));
+        morph->type = panel != PMDMORPH_TYPE_BASE ? panel : 4;
+        morph->vertices_num = offsets_num;
+        morph->indices = MemoryArena_alloc(result->arena, sizeof(GLuint) * (offsets_num ? offsets_num : 1));
+        morph->offsets = MemoryArena_alloc(result->arena, sizeof(vec3) * (offsets_num ? offsets_num : 1));
+
+        const uint8_t *head = RawData_getReadHeader(data);
+        const uint8_t *p = head;
+        for (k = 0; k < offsets_num; ++k) {
+            morph->indices[k] = PmxFile_readVertexIndex(&p, header->vertex_index_size);
+            memcpy(&morph->offsets[k], p, sizeof(vec3));
+            p += sizeof(vec3);
+
+            if (morph->indices[k] >= result->vertices_num) {
+                __logf("PMX Morph vertex out of range(%u) morph(%d)", morph->indices[k], i);
+                return false;
+            }
+        }
+        RawData_offsetHeader(data, (int) (p - head));
+    }
+
+    if (morphs_num == 1) {
+        // 頂点モーフが無い
+        // 確保した配列はPmdFile_free()でまとめて解放される
+        return true;
+    }
+
+    // いずれかの表情で動く頂点を集めてbase表情とする
+    {
+        GLubyte *used = calloc(result->vertices_num, sizeof(GLubyte));
+        GLuint used_num = 0;
+        for (i = 1; i < morphs_num; ++i) {
+            for (k = 0; k < morphs[i].vertices_num; ++k) {
+                const GLuint v = morphs[i].indices[k];
+                if (!used[v]) {
+                    used[v] = 1;
+                    ++used_num;
+                }
+            }
+        }
+
+        PmdMorph *base = &morphs[0];
+        strcpy(base->name, "base");
+        base->type = PMDMORPH_TYPE_BASE;
+        base->vertices_num = used_num;
+        base->indices = MemoryArena_alloc(result->arena, sizeof(GLuint) * used_num);
+        base->offsets = MemoryArena_alloc(result->arena, sizeof(vec3) * used_num);
+
+        GLuint write = 0;
+        for (i = 0; i < result->vertices_num; ++i) {
+            if (used[i]) {
+                base->indices[write] = i;
+                base->offsets[write] = result->vertices[i].position;
+                ++write;
+            }
+        }
+        free(used);
+    }
+
+    result->morphs = morphs;
+    result->morphs_num = morphs_num;
+    return true;
+}
+
+/**
+ * PMXファイルからPmdFileを生成する
+ */
+PmdFile* PmxFile_create(RawData *data) {
+    PmdFile *result = calloc(1, sizeof(PmdFile));
+    result->arena = MemoryArena_create(PMDFILE_ARENA_BLOCK_SIZE);
+    PmxHeader header = { };
+
+    // ファイルヘッダを読み込む
+    if (!PmxFile_loadHeader(result, &header, data)) {
+        // 読み込み失敗
+        PmdFile_free(result);
+        return NULL;
+    }
+
+    // 頂点・インデックス・テクスチャと材質・ボーン・表情を読み込む
+    // ファイルが途中で切れている場合や、範囲外を指すインデックスがある場合は読み込みに失敗する
+    if (!PmxFile_loadVertices(result, &header, data) || !PmxFile_loadIndices(result, &header, data) || !PmxFile_loadMaterial(result, &header, data) || //
+            !PmxFile_loadBone(result, &header, data) || !PmxFile_loadMorph(result, &header, data)) {
+        __log("PMX Load Error");
+        PmdFile_free(result);
+        return NULL;
+    }
+
+    // 境界ボリュームを計算する
+    PmdFile_calcBounds(result);
+
+    // 表示枠・剛体・ジョイントは利用しない
+    return result;
+}
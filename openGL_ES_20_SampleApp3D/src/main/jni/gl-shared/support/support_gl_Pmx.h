@@ -0,0 +1,44 @@
+/*
+ * support_gl_Pmx.h
+ *
+ * 簡易PMX(2.0/2.1)ファイル読み込みライブラリ
+ * 読み込んだ結果はPMDと同じPmdFileとして扱う。
+ * PmdFileに対応する情報が無いもの（追加UV、SDEFパラメータ、剛体、ジョイント等）は読み飛ばす。
+ */
+
+#ifndef SUPPORT_GL_PMX_H_
+#define SUPPORT_GL_PMX_H_
+
+/**
+ * 頂点のウェイト変形方式
+ */
+#define PMXVERTEX_DEFORM_BDEF1  0
+#define PMXVERTEX_DEFORM_BDEF2  1
+#define PMXVERTEX_DEFORM_BDEF4  2
+#define PMXVERTEX_DEFORM_SDEF   3
+#define PMXVERTEX_DEFORM_QDEF   4
+
+/**
+ * 表情オフセットの種類
+ */
+#define PMXMORPH_TYPE_GROUP     0
+#define PMXMORPH_TYPE_VERTEX    1
+#define PMXMORPH_TYPE_BONE      2
+#define PMXMORPH_TYPE_UV        3
+#define PMXMORPH_TYPE_UV4       7
+#define PMXMORPH_TYPE_MATERIAL  8
+#define PMXMORPH_TYPE_FLIP      9
+#define PMXMORPH_TYPE_IMPULSE   10
+
+/**
+ * 読み込み位置がPMXファイルの先頭であればtrueを返す。
+ * 読み込み位置は移動しない。
+ */
+extern bool PmxFile_isPmx(RawData *data);
+
+/**
+ * PMXファイルからPmdFileを生成する
+ */
+extern PmdFile* PmxFile_create(RawData *data);
+
+#endif /* SUPPORT_GL_PMX_H_ */
@@ -0,0 +1,272 @@
+/*
+ * support_gl_Resource.c
+ */
+
+#include    "support.h"
+
+/**
+ * 資源の種類ごとのプール
+ * 最初の生成時に確保し、プロセス終了まで保持する。
+ */
+static HandlePool *g_buffer_pool = NULL;
+static HandlePool *g_program_pool = NULL;
+static HandlePool *g_framebuffer_pool = NULL;
+
+/**
+ * 非同期読み込みスレッドからも生成されるため、確保と解放は排他する
+ */
+static pthread_mutex_t g_resource_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * プールから要素を確保する
+ * プールが無ければ生成する。容量を超えた場合はNULLを返し、handleはHANDLE_NULLとなる。
+ */
+static void* Resource_alloc(HandlePool **pool, const uint32_t element_size, const uint32_t capacity, Handle *handle) {
+    pthread_mutex_lock(&g_resource_mutex);
+    if (!(*pool)) {
+        *pool = HandlePool_create(element_size, capacity);
+    }
+    void *result = HandlePool_alloc(*pool, handle);
+    pthread_mutex_unlock(&g_resource_mutex);
+
+    if (!result) {
+        __log("Resource pool is full");
+    }
+    return result;
+}
+
+/**
+ * ハンドルが指す要素を取得する
+ * 参照は描画ループから頻繁に行われるため排他しない。
+ */
+static void* Resource_get(const HandlePool *pool, const Handle handle) {
+    if (handle == HANDLE_NULL || !pool) {
+        return NULL;
+    }
+    return HandlePool_get(pool, handle);
+}
+
+/**
+ * プールへ要素を返却する
+ * 返却に成功した場合のみ、返却前の内容をcopyへ書き出してtrueを返す。
+ * 解決と返却を同じロック内で行うため、同じハンドルを複数スレッドが解放してもGL側の削除は1度のみとなる。
+ */
+static bool Resource_release(HandlePool *pool, const Handle handle, void *copy) {
+    bool result = false;
+
+    pthread_mutex_lock(&g_resource_mutex);
+    const void *item = Resource_get(pool, handle);
+    if (item) {
+        // 返却後は他のスレッドが再確保して書き換えるため、先に取り出す
+        memcpy(copy, item, pool->element_size);
+        result = HandlePool_release(pool, handle);
+    }
+    pthread_mutex_unlock(&g_resource_mutex);
+    return result;
+}
+
+/**
+ * バッファを生成する
+ */
+BufferHandle BufferObject_create(const GLenum target, const GLsizeiptr bytes, const void *data, const GLenum usage) {
+    BufferHandle result = HANDLE_NULL;
+    BufferObject *buffer = Resource_alloc(&g_buffer_pool, sizeof(BufferObject), RESOURCE_BUFFER_CAPACITY, &result);
+    if (!buffer) {
+        return HANDLE_NULL;
+    }
+
+    buffer->target = target;
+    buffer->usage = usage;
+    buffer->bytes = bytes;
+
+    glGenBuffers(1, &buffer->id);
+    assert(buffer->id != 0);
+
+    VertexLayout_invalidateBuffer(target);
+    glBindBuffer(target, buffer->id);
+    glBufferData(target, bytes, data, usage);
+    glBindBuffer(target, 0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    return result;
+}
+
+/**
+ * ハンドルが指すバッファを取得する
+ */
+BufferObject* BufferObject_get(const BufferHandle handle) {
+    return Resource_get(g_buffer_pool, handle);
+}
+
+/**
+ * ハンドルが指すバッファのIDを取得する
+ */
+GLuint BufferObject_getId(const BufferHandle handle) {
+    const BufferObject *buffer = BufferObject_get(handle);
+    return buffer ? buffer->id : 0;
+}
+
+/**
+ * バッファを解放する
+ */
+bool BufferObject_free(const BufferHandle handle) {
+    BufferObject buffer;
+    if (!Resource_release(g_buffer_pool, handle, &buffer)) {
+        return false;
+    }
+
+    glDeleteBuffers(1, &buffer.id);
+    assert(glGetError() == GL_NO_ERROR);
+    return true;
+}
+
+/**
+ * シェーダープログラムを生成する
+ */
+ProgramHandle ShaderProgram_create(const char* vertex_shader_source, const char* fragment_shader_source) {
+    ProgramHandle result = HANDLE_NULL;
+    ShaderProgram *program = Resource_alloc(&g_program_pool, sizeof(ShaderProgram), RESOURCE_PROGRAM_CAPACITY, &result);
+    if (!program) {
+        return HANDLE_NULL;
+    }
+
+    program->id = Shader_createProgramFromSource(vertex_shader_source, fragment_shader_source);
+    return result;
+}
+
+/**
+ * ハンドルが指すシェーダープログラムを取得する
+ */
+ShaderProgram* ShaderProgram_get(const ProgramHandle handle) {
+    return Resource_get(g_program_pool, handle);
+}
+
+/**
+ * ハンドルが指すシェーダープログラムのIDを取得する
+ */
+GLuint ShaderProgram_getId(const ProgramHandle handle) {
+    const ShaderProgram *program = ShaderProgram_get(handle);
+    return program ? program->id : 0;
+}
+
+/**
+ * シェーダープログラムを解放する
+ */
+bool ShaderProgram_free(const ProgramHandle handle) {
+    ShaderProgram program;
+    if (!Resource_release(g_program_pool, handle, &program)) {
+        return false;
+    }
+
+    glDeleteProgram(program.id);
+    assert(glGetError() == GL_NO_ERROR);
+    return true;
+}
+
+/**
+ * RGBAテクスチャをカラーバッファとするフレームバッファを生成する
+ */
+FramebufferHandle FramebufferObject_create(const GLint width, const GLint height, const bool depth) {
+    FramebufferHandle result = HANDLE_NULL;
+    FramebufferObject *framebuffer = Resource_alloc(&g_framebuffer_pool, sizeof(FramebufferObject), RESOURCE_FRAMEBUFFER_CAPACITY, &result);
+    if (!framebuffer) {
+        return HANDLE_NULL;
+    }
+
+    framebuffer->width = width;
+    framebuffer->height = height;
+
+    // 呼び出し元のフレームバッファを復元するため、現在の設定を保持する
+    GLint bindFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bindFramebuffer);
+
+    // カラーバッファとなるテクスチャを生成する
+    {
+        Texture *texture = Texture_alloc();
+        if (!texture) {
+            FramebufferObject discard;
+            Resource_release(g_framebuffer_pool, result, &discard);
+            return HANDLE_NULL;
+        }
+        texture->width = width;
+        texture->height = height;
+
+        glGenTextures(1, &texture->id);
+        assert(texture->id != 0);
+
+        glBindTexture(GL_TEXTURE_2D, texture->id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        assert(glGetError() == GL_NO_ERROR);
+
+        framebuffer->color = Texture_getHandle(texture);
+    }
+
+    // 深度バッファを生成する
+    if (depth) {
+        glGenRenderbuffers(1, &framebuffer->depth_renderbuffer);
+        assert(framebuffer->depth_renderbuffer != 0);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, framebuffer->depth_renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+
+    // テクスチャとバッファをフレームバッファへアタッチする
+    {
+        glGenFramebuffers(1, &framebuffer->id);
+        assert(framebuffer->id != 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->id);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Texture_fromHandle(framebuffer->color)->id, 0);
+        if (framebuffer->depth_renderbuffer) {
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, framebuffer->depth_renderbuffer);
+        }
+        assert(glGetError() == GL_NO_ERROR);
+
+        // フレームバッファとして有効な状態になっていることを確認する
+        assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint) bindFramebuffer);
+    }
+
+    return result;
+}
+
+/**
+ * ハンドルが指すフレームバッファを取得する
+ */
+FramebufferObject* FramebufferObject_get(const FramebufferHandle handle) {
+    return Resource_get(g_framebuffer_pool, handle);
+}
+
+/**
+ * ハンドルが指すフレームバッファのIDを取得する
+ */
+GLuint FramebufferObject_getId(const FramebufferHandle handle) {
+    const FramebufferObject *framebuffer = FramebufferObject_get(handle);
+    return framebuffer ? framebuffer->id : 0;
+}
+
+/**
+ * フレームバッファとカラーバッファ・深度バッファを解放する
+ */
+bool FramebufferObject_free(const FramebufferHandle handle) {
+    FramebufferObject framebuffer;
+    if (!Resource_release(g_framebuffer_pool, handle, &framebuffer)) {
+        return false;
+    }
+
+    glDeleteFramebuffers(1, &framebuffer.id);
+    if (framebuffer.depth_renderbuffer) {
+        glDeleteRenderbuffers(1, &framebuffer.depth_renderbuffer);
+    }
+    Texture_freeHandle(framebuffer.color);
+    assert(glGetError() == GL_NO_ERROR);
+    return true;
+}
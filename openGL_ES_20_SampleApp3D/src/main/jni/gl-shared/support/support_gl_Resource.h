@@ -0,0 +1,182 @@
+/*
+ * support_gl_Resource.h
+ *
+ * バッファ・シェーダープログラム・フレームバッファをハンドルで管理する
+ * 資源の種類ごとに固定長のプールを持ち、描画側はGLのIDやポインタの代わりに32bitのハンドルを保持する。
+ * 解放・再生成された資源を指すハンドルは無効となり、取得関数はNULLまたは0を返す。
+ */
+
+#ifndef SUPPORT_GL_RESOURCE_H_
+#define SUPPORT_GL_RESOURCE_H_
+
+/**
+ * 同時に保持できるバッファ数
+ */
+#define RESOURCE_BUFFER_CAPACITY        1024
+
+/**
+ * 同時に保持できるシェーダープログラム数
+ */
+#define RESOURCE_PROGRAM_CAPACITY       128
+
+/**
+ * 同時に保持できるフレームバッファ数
+ */
+#define RESOURCE_FRAMEBUFFER_CAPACITY   64
+
+/**
+ * バッファを参照するハンドル
+ */
+typedef Handle BufferHandle;
+
+/**
+ * シェーダープログラムを参照するハンドル
+ */
+typedef Handle ProgramHandle;
+
+/**
+ * フレームバッファを参照するハンドル
+ */
+typedef Handle FramebufferHandle;
+
+/**
+ * バッファオブジェクト
+ */
+typedef struct BufferObject {
+    /**
+     * GL側のバッファID
+     */
+    GLuint id;
+
+    /**
+     * GL_ARRAY_BUFFER / GL_ELEMENT_ARRAY_BUFFER
+     */
+    GLenum target;
+
+    /**
+     * GL_STATIC_DRAW / GL_DYNAMIC_DRAW / GL_STREAM_DRAW
+     */
+    GLenum usage;
+
+    /**
+     * 確保したバイト数
+     */
+    GLsizeiptr bytes;
+} BufferObject;
+
+/**
+ * シェーダープログラム
+ */
+typedef struct ShaderProgram {
+    /**
+     * GL側のプログラムID
+     */
+    GLuint id;
+} ShaderProgram;
+
+/**
+ * フレームバッファオブジェクト
+ */
+typedef struct FramebufferObject {
+    /**
+     * GL側のフレームバッファID
+     */
+    GLuint id;
+
+    /**
+     * 深度レンダリングバッファ
+     * 深度バッファを持たない場合は0
+     */
+    GLuint depth_renderbuffer;
+
+    /**
+     * カラーバッファとして書き込むテクスチャ
+     */
+    TextureHandle color;
+
+    /**
+     * 幅
+     */
+    GLint width;
+
+    /**
+     * 高さ
+     */
+    GLint height;
+} FramebufferObject;
+
+/**
+ * バッファを生成する
+ * dataがNULLの場合は領域の確保のみ行う。
+ * RESOURCE_BUFFER_CAPACITYを超えた場合はHANDLE_NULLを返す。
+ */
+extern BufferHandle BufferObject_create(const GLenum target, const GLsizeiptr bytes, const void *data, const GLenum usage);
+
+/**
+ * ハンドルが指すバッファを取得する
+ * 解放済みの場合はNULLを返す。
+ */
+extern BufferObject* BufferObject_get(const BufferHandle handle);
+
+/**
+ * ハンドルが指すバッファのIDを取得する
+ * 解放済みの場合は0を返す。
+ */
+extern GLuint BufferObject_getId(const BufferHandle handle);
+
+/**
+ * バッファを解放する
+ * 既に解放されていた場合は何もせずfalseを返す。
+ */
+extern bool BufferObject_free(const BufferHandle handle);
+
+/**
+ * シェーダープログラムを生成する
+ * RESOURCE_PROGRAM_CAPACITYを超えた場合はHANDLE_NULLを返す。
+ */
+extern ProgramHandle ShaderProgram_create(const char* vertex_shader_source, const char* fragment_shader_source);
+
+/**
+ * ハンドルが指すシェーダープログラムを取得する
+ * 解放済みの場合はNULLを返す。
+ */
+extern ShaderProgram* ShaderProgram_get(const ProgramHandle handle);
+
+/**
+ * ハンドルが指すシェーダープログラムのIDを取得する
+ * 解放済みの場合は0を返す。
+ */
+extern GLuint ShaderProgram_getId(const ProgramHandle handle);
+
+/**
+ * シェーダープログラムを解放する
+ * 既に解放されていた場合は何もせずfalseを返す。
+ */
+extern bool ShaderProgram_free(const ProgramHandle handle);
+
+/**
+ * RGBAテクスチャをカラーバッファとするフレームバッファを生成する
+ * depthがtrueの場合、16bitの深度バッファも生成する。
+ * RESOURCE_FRAMEBUFFER_CAPACITYかTEXTURE_POOL_CAPACITYを超えた場合はHANDLE_NULLを返す。
+ */
+extern FramebufferHandle FramebufferObject_create(const GLint width, const GLint height, const bool depth);
+
+/**
+ * ハンドルが指すフレームバッファを取得する
+ * 解放済みの場合はNULLを返す。
+ */
+extern FramebufferObject* FramebufferObject_get(const FramebufferHandle handle);
+
+/**
+ * ハンドルが指すフレームバッファのIDを取得する
+ * 解放済みの場合は0を返す。
+ */
+extern GLuint FramebufferObject_getId(const FramebufferHandle handle);
+
+/**
+ * フレームバッファとカラーバッファ・深度バッファを解放する
+ * 既に解放されていた場合は何もせずfalseを返す。
+ */
+extern bool FramebufferObject_free(const FramebufferHandle handle);
+
+#endif /* SUPPORT_GL_RESOURCE_H_ */
@@ -0,0 +1,182 @@
+/*
+ * support_gl_SceneGraph.c
+ */
+
+#include    "support.h"
+
+/**
+ * ノードごとの配列を指定の件数で確保し直す
+ */
+static void SceneGraph_reserve(SceneGraph *graph, const GLuint capacity) {
+    if (capacity <= graph->capacity) {
+        return;
+    }
+
+    graph->parents = realloc(graph->parents, sizeof(GLint) * capacity);
+    graph->bounds = realloc(graph->bounds, sizeof(PmdBounds) * capacity);
+    graph->flags = realloc(graph->flags, sizeof(GLubyte) * capacity);
+    graph->updated_frames = realloc(graph->updated_frames, sizeof(GLuint) * capacity);
+
+    {
+        affine *worlds = util_alignedAlloc(SIMD4F_ALIGNMENT, sizeof(affine) * capacity);
+        if (graph->num) {
+            memcpy(worlds, graph->worlds, sizeof(affine) * graph->num);
+        }
+        util_alignedFree(graph->worlds);
+        graph->worlds = worlds;
+    }
+
+    graph->capacity = capacity;
+}
+
+/**
+ * シーングラフを生成する
+ */
+SceneGraph* SceneGraph_create(const GLuint capacity) {
+    SceneGraph *result = calloc(1, sizeof(SceneGraph));
+    const GLuint initial = capacity ? capacity : 4;
+
+    result->locals = TransformList_create(initial);
+    result->culling = CullingList_create(initial);
+    SceneGraph_reserve(result, initial);
+    return result;
+}
+
+/**
+ * ノードを登録する。
+ */
+GLuint SceneGraph_add(SceneGraph *graph, const GLint parent, const vec3 position, const quat rotation, const vec3 scale, const PmdBounds *bounds) {
+    // 親が子より前に並んでいなければ、1回の走査で伝搬できない
+    assert(parent == SCENEGRAPH_ROOT || (parent >= 0 && (GLuint) parent < graph->num));
+
+    if (graph->num == graph->capacity) {
+        SceneGraph_reserve(graph, graph->capacity * 2);
+    }
+
+    const GLuint node = graph->num++;
+    TransformList_add(graph->locals, position, rotation, scale);
+
+    graph->parents[node] = parent;
+    graph->flags[node] = SCENEGRAPH_FLAG_DIRTY;
+    graph->updated_frames[node] = 0;
+
+    if (bounds) {
+        graph->bounds[node] = *bounds;
+        graph->flags[node] |= SCENEGRAPH_FLAG_BOUNDS;
+    } else {
+        memset(&graph->bounds[node], 0x00, sizeof(PmdBounds));
+    }
+
+    // 要素番号をノード番号と揃えるため、境界を持たないノードも登録する
+    CullingList_add(graph->culling, &graph->bounds[node], mat4_identity());
+
+    if (node < graph->dirty_begin) {
+        graph->dirty_begin = node;
+    }
+    return node;
+}
+
+/**
+ * ノードの位置・回転・拡縮を書き換える。
+ */
+void SceneGraph_setTransform(SceneGraph *graph, const GLuint node, const vec3 position, const quat rotation, const vec3 scale) {
+    assert(node < graph->num);
+
+    TransformList_set(graph->locals, node, position, rotation, scale);
+    graph->flags[node] |= SCENEGRAPH_FLAG_DIRTY;
+
+    if (node < graph->dirty_begin) {
+        graph->dirty_begin = node;
+    }
+}
+
+/**
+ * 全ノードを再計算の対象にする
+ */
+void SceneGraph_invalidate(SceneGraph *graph) {
+    GLuint i = 0;
+    for (i = 0; i < graph->num; ++i) {
+        graph->flags[i] |= SCENEGRAPH_FLAG_DIRTY;
+    }
+    graph->dirty_begin = 0;
+}
+
+/**
+ * 変更されたノードと子孫のワールド行列・境界ボリュームを更新する。
+ */
+GLuint SceneGraph_update(SceneGraph *graph) {
+    graph->updated_num = 0;
+
+    // 何も変更されていなければ走査しない
+    if (graph->dirty_begin >= graph->num) {
+        return 0;
+    }
+
+    ++graph->frame;
+
+    TransformList *locals = graph->locals;
+    const GLuint frame = graph->frame;
+    GLuint updated = 0;
+    GLuint i = 0;
+
+    // 親は必ず子より前にあるため、先頭から走査すれば親の更新が先に終わっている
+    for (i = graph->dirty_begin; i < graph->num; ++i) {
+        GLubyte flags = graph->flags[i];
+        const GLint parent = graph->parents[i];
+        const bool parentUpdated = parent != SCENEGRAPH_ROOT && graph->updated_frames[parent] == frame;
+
+        if (!(flags & SCENEGRAPH_FLAG_DIRTY) && !parentUpdated) {
+            continue;
+        }
+
+        // ローカル行列は自身が変更された場合のみ計算する
+        if (flags & SCENEGRAPH_FLAG_DIRTY) {
+            const quat rotation = { locals->rotation_x[i], locals->rotation_y[i], locals->rotation_z[i], locals->rotation_w[i] };
+            locals->worlds[i] = affine_create( //
+                    vec3_create(locals->position_x[i], locals->position_y[i], locals->position_z[i]), rotation, //
+                    vec3_create(locals->scale_x[i], locals->scale_y[i], locals->scale_z[i]));
+            graph->flags[i] = flags & ~SCENEGRAPH_FLAG_DIRTY;
+        }
+
+        if (parent == SCENEGRAPH_ROOT) {
+            graph->worlds[i] = locals->worlds[i];
+        } else {
+            affine_multiply_to(&graph->worlds[i], &graph->worlds[parent], &locals->worlds[i]);
+        }
+
+        CullingList_set(graph->culling, i, &graph->bounds[i], mat4_fromAffine(&graph->worlds[i]));
+
+        graph->updated_frames[i] = frame;
+        ++updated;
+    }
+
+    graph->dirty_begin = graph->num;
+    graph->updated_num = updated;
+    return updated;
+}
+
+/**
+ * ノードのワールド行列を取得する
+ */
+mat4 SceneGraph_getWorld(const SceneGraph *graph, const GLuint node) {
+    assert(node < graph->num);
+    return mat4_fromAffine(&graph->worlds[node]);
+}
+
+/**
+ * シーングラフを解放する
+ */
+void SceneGraph_free(SceneGraph *graph) {
+    if (!graph) {
+        return;
+    }
+
+    TransformList_free(graph->locals);
+    CullingList_free(graph->culling);
+    util_alignedFree(graph->worlds);
+    free(graph->parents);
+    free(graph->bounds);
+    free(graph->flags);
+    free(graph->updated_frames);
+    free(graph);
+}
@@ -0,0 +1,137 @@
+/*
+ * support_gl_SceneGraph.h
+ *
+ * 親子関係を持つノードのワールド行列を差分で更新するシーングラフ
+ * ノードは親が子より前に並ぶ配列として保持し、先頭から1回走査するだけで親の結果を子へ伝搬する。
+ * 変更されたノードとその子孫だけを再計算し、動かない背景の更新コストをほぼ0にする。
+ */
+
+#ifndef SUPPORT_GL_SCENEGRAPH_H_
+#define SUPPORT_GL_SCENEGRAPH_H_
+
+/**
+ * 親を持たないノードの親番号
+ */
+#define SCENEGRAPH_ROOT     -1
+
+/**
+ * ローカル行列の再計算が必要
+ */
+#define SCENEGRAPH_FLAG_DIRTY   0x01
+
+/**
+ * 境界ボリュームを持つ
+ */
+#define SCENEGRAPH_FLAG_BOUNDS  0x02
+
+/**
+ * シーングラフ
+ */
+typedef struct SceneGraph {
+    /**
+     * ローカルの位置・回転・拡縮
+     * locals->worldsには親を含まないローカル行列が格納される。
+     */
+    TransformList *locals;
+
+    /**
+     * 親ノード番号
+     * 親を持たない場合はSCENEGRAPH_ROOT
+     */
+    GLint *parents;
+
+    /**
+     * ワールド行列
+     */
+    affine *worlds;
+
+    /**
+     * ローカル座標系の境界ボリューム
+     */
+    PmdBounds *bounds;
+
+    /**
+     * SCENEGRAPH_FLAG_XXXの組み合わせ
+     */
+    GLubyte *flags;
+
+    /**
+     * ワールド行列を最後に更新したSceneGraph_updateの回数
+     */
+    GLuint *updated_frames;
+
+    /**
+     * ワールド座標系の境界ボリューム
+     * ノード番号と要素番号が一致し、更新されたノードだけが書き換えられる。
+     * 境界ボリュームを持たないノードは半径0の点として登録される。
+     */
+    CullingList *culling;
+
+    /**
+     * SceneGraph_updateを呼び出した回数
+     */
+    GLuint frame;
+
+    /**
+     * 登録されているノード数
+     */
+    GLuint num;
+
+    /**
+     * 登録できるノード数
+     */
+    GLuint capacity;
+
+    /**
+     * 再計算が必要なノードの最小番号
+     * 再計算が不要な場合はnumと同じ値となる
+     */
+    GLuint dirty_begin;
+
+    /**
+     * 直前のSceneGraph_updateで更新されたノード数
+     */
+    GLuint updated_num;
+} SceneGraph;
+
+/**
+ * シーングラフを生成する
+ */
+extern SceneGraph* SceneGraph_create(const GLuint capacity);
+
+/**
+ * ノードを登録する。
+ * parentは登録済みのノード番号かSCENEGRAPH_ROOTを指定する。
+ * boundsがNULLでない場合、ワールド座標系の境界ボリュームをcullingへ反映する。
+ * 登録したノード番号を返す。
+ */
+extern GLuint SceneGraph_add(SceneGraph *graph, const GLint parent, const vec3 position, const quat rotation, const vec3 scale, const PmdBounds *bounds);
+
+/**
+ * ノードの位置・回転・拡縮を書き換える。
+ * 次回のSceneGraph_updateで、ノードと全ての子孫が再計算される。
+ */
+extern void SceneGraph_setTransform(SceneGraph *graph, const GLuint node, const vec3 position, const quat rotation, const vec3 scale);
+
+/**
+ * 全ノードを再計算の対象にする
+ */
+extern void SceneGraph_invalidate(SceneGraph *graph);
+
+/**
+ * 変更されたノードと子孫のワールド行列・境界ボリュームを更新する。
+ * 更新したノード数を返す。
+ */
+extern GLuint SceneGraph_update(SceneGraph *graph);
+
+/**
+ * ノードのワールド行列を取得する
+ */
+extern mat4 SceneGraph_getWorld(const SceneGraph *graph, const GLuint node);
+
+/**
+ * シーングラフを解放する
+ */
+extern void SceneGraph_free(SceneGraph *graph);
+
+#endif /* SUPPORT_GL_SCENEGRAPH_H_ */
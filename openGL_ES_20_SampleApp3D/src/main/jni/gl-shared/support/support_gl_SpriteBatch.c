@@ -0,0 +1,259 @@
+/*
+ * support_gl_SpriteBatch.c
+ */
+
+#include    "support.h"
+
+/**
+ * qsortへ渡すスプライト配列
+ */
+static const SpriteBatchSprite *g_sort_sprites = NULL;
+
+/**
+ * レイヤー、テクスチャ、登録順で並べる
+ */
+static int SpriteBatch_compare(const void *a, const void *b) {
+    const SpriteBatchSprite *sa = &g_sort_sprites[*((const GLuint*) a)];
+    const SpriteBatchSprite *sb = &g_sort_sprites[*((const GLuint*) b)];
+
+    if (sa->layer != sb->layer) {
+        return sa->layer < sb->layer ? -1 : 1;
+    }
+    if (sa->texture != sb->texture) {
+        return sa->texture->id < sb->texture->id ? -1 : 1;
+    }
+    return sa->sequence < sb->sequence ? -1 : (sa->sequence > sb->sequence ? 1 : 0);
+}
+
+/**
+ * スプライトの四隅を計算して頂点へ書き込む。
+ * 頂点はv0(左上), v1(左下), v2(右上), v3(右下)の順となる。
+ */
+static void SpriteBatch_transform(const SpriteBatch *batch, const SpriteBatchSprite *sprite, SpriteBatchVertex *vertices) {
+    // Sprite_createPositionMatrixの translate * aspect * rotate * scale を展開する
+    const GLfloat surfaceAspect = (GLfloat) batch->surface_width / (GLfloat) batch->surface_height;
+    const GLfloat xScale = sprite->width / (GLfloat) batch->surface_width * 2.0f;
+    const GLfloat yScale = sprite->height / (GLfloat) batch->surface_width * 2.0f;
+
+    const GLfloat vertexLeft = 0.5f + (1.0f - xScale) * 0.5f;
+    const GLfloat vertexTop = 0.5f + (1.0f - (yScale * surfaceAspect)) * 0.5f;
+    const GLfloat moveX = sprite->x / (GLfloat) batch->surface_width * 2.0f;
+    const GLfloat moveY = -(sprite->y / (GLfloat) batch->surface_height * 2.0f);
+
+    GLfloat c = 1.0f;
+    GLfloat s = 0.0f;
+    if (sprite->rotate != 0) {
+        fastmath_sincos(degree2radianf(sprite->rotate), &s, &c);
+    }
+
+    // 四隅をSIMDの4要素として同時に計算する
+    float x[4] __attribute__((aligned(SIMD4F_ALIGNMENT)));
+    float y[4] __attribute__((aligned(SIMD4F_ALIGNMENT)));
+    {
+        const simd4f sx = simd4f_mul(simd4f_set(-0.5f, -0.5f, 0.5f, 0.5f), simd4f_splat(xScale));
+        const simd4f sy = simd4f_mul(simd4f_set(0.5f, -0.5f, 0.5f, -0.5f), simd4f_splat(yScale));
+
+        // mat4_rotateのZ軸回転と同じ向きとなる
+        simd4f rx = simd4f_madd(sy, simd4f_splat(s), simd4f_mul(sx, simd4f_splat(c)));
+        simd4f ry = simd4f_sub(simd4f_mul(sy, simd4f_splat(c)), simd4f_mul(sx, simd4f_splat(s)));
+
+        rx = simd4f_add(rx, simd4f_splat(-vertexLeft + moveX));
+        ry = simd4f_madd(ry, simd4f_splat(surfaceAspect), simd4f_splat(vertexTop + moveY));
+
+        simd4f_store(x, rx);
+        simd4f_store(y, ry);
+    }
+
+    const GLubyte r = (GLubyte) (sprite->color >> 24);
+    const GLubyte g = (GLubyte) (sprite->color >> 16);
+    const GLubyte b = (GLubyte) (sprite->color >> 8);
+    const GLubyte a = (GLubyte) (sprite->color);
+    const GLfloat us[4] = { sprite->u0, sprite->u0, sprite->u1, sprite->u1 };
+    const GLfloat vs[4] = { sprite->v0, sprite->v1, sprite->v0, sprite->v1 };
+
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        vertices[i].position.x = x[i];
+        vertices[i].position.y = y[i];
+        vertices[i].uv.x = us[i];
+        vertices[i].uv.y = vs[i];
+        vertices[i].color[0] = r;
+        vertices[i].color[1] = g;
+        vertices[i].color[2] = b;
+        vertices[i].color[3] = a;
+    }
+}
+
+/**
+ * スプライトバッチを生成する。
+ */
+SpriteBatch* SpriteBatch_create(const GLuint sprites_max) {
+    assert(sprites_max > 0 && sprites_max <= SPRITEBATCH_SPRITES_MAX);
+
+    SpriteBatch *result = calloc(1, sizeof(SpriteBatch));
+    result->sprites_max = sprites_max;
+    result->sprites = malloc(sizeof(SpriteBatchSprite) * sprites_max);
+    result->order = malloc(sizeof(GLuint) * sprites_max);
+
+    // 四角形ごとに2枚の三角形を構成する
+    {
+        GLushort *indices = malloc(sizeof(GLushort) * sprites_max * 6);
+        GLuint i = 0;
+        for (i = 0; i < sprites_max; ++i) {
+            const GLushort v = (GLushort) (i * 4);
+            indices[i * 6 + 0] = v + 0;
+            indices[i * 6 + 1] = v + 1;
+            indices[i * 6 + 2] = v + 2;
+            indices[i * 6 + 3] = v + 2;
+            indices[i * 6 + 4] = v + 1;
+            indices[i * 6 + 5] = v + 3;
+        }
+
+        glGenBuffers(1, &result->indices_buffer);
+        assert(result->indices_buffer);
+        VertexLayout_invalidateBuffer(GL_ELEMENT_ARRAY_BUFFER);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, result->indices_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * sprites_max * 6, indices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        free(indices);
+    }
+
+    // 1フレームで上限まで登録した後に残りを描画しても、折り返さずに収まる大きさとする
+    result->vertices_stream = StreamBuffer_create(GL_ARRAY_BUFFER, sizeof(SpriteBatchVertex) * sprites_max * 4 * 2);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    return result;
+}
+
+/**
+ * スプライトの登録を開始する。
+ */
+void SpriteBatch_begin(SpriteBatch *batch, const int surface_width, const int surface_height, const GLint attr_pos, const GLint attr_uv, const GLint attr_color) {
+    batch->surface_width = surface_width;
+    batch->surface_height = surface_height;
+    batch->attr_pos = attr_pos;
+    batch->attr_uv = attr_uv;
+    batch->attr_color = attr_color;
+    batch->sprites_num = 0;
+    batch->draws_num = 0;
+
+    StreamBuffer_nextFrame(batch->vertices_stream);
+}
+
+/**
+ * スプライトを登録する。
+ */
+void SpriteBatch_draw(SpriteBatch *batch, const Texture *texture, const GLint src_x, const GLint src_y, const GLint src_width, const GLint src_height, const GLint x, const GLint y, const GLint width, const GLint height, const GLfloat rotate, const GLint layer, const GLuint color) {
+    assert(texture);
+
+    if (batch->sprites_num == batch->sprites_max) {
+        SpriteBatch_flush(batch);
+    }
+
+    SpriteBatchSprite *sprite = &batch->sprites[batch->sprites_num];
+    sprite->texture = texture;
+    sprite->layer = layer;
+    sprite->sequence = batch->sprites_num;
+    sprite->x = (GLfloat) x;
+    sprite->y = (GLfloat) y;
+    sprite->width = (GLfloat) width;
+    sprite->height = (GLfloat) height;
+    sprite->rotate = rotate;
+    sprite->u0 = (GLfloat) src_x / (GLfloat) texture->width;
+    sprite->v0 = (GLfloat) src_y / (GLfloat) texture->height;
+    sprite->u1 = (GLfloat) (src_x + src_width) / (GLfloat) texture->width;
+    sprite->v1 = (GLfloat) (src_y + src_height) / (GLfloat) texture->height;
+    sprite->color = color;
+
+    ++batch->sprites_num;
+}
+
+/**
+ * 登録されたスプライトをレイヤーとテクスチャの順に並べて描画する。
+ */
+void SpriteBatch_flush(SpriteBatch *batch) {
+    if (!batch->sprites_num) {
+        return;
+    }
+
+    GLuint i = 0;
+
+    // 描画順を決める
+    for (i = 0; i < batch->sprites_num; ++i) {
+        batch->order[i] = i;
+    }
+    g_sort_sprites = batch->sprites;
+    qsort(batch->order, batch->sprites_num, sizeof(GLuint), SpriteBatch_compare);
+    g_sort_sprites = NULL;
+
+    // 描画順に頂点を書き込む
+    // 同じフレーム内の先行する描画が参照している領域は書き換えず、後ろへ追記する
+    GLintptr offset = 0;
+    {
+        SpriteBatchVertex *vertices = StreamBuffer_map(batch->vertices_stream, sizeof(SpriteBatchVertex) * batch->sprites_num * 4, &offset);
+        for (i = 0; i < batch->sprites_num; ++i) {
+            SpriteBatch_transform(batch, &batch->sprites[batch->order[i]], vertices + i * 4);
+        }
+        StreamBuffer_unmap(batch->vertices_stream);
+    }
+    // 属性を直接設定するため、VertexLayoutのバインドを解除する
+    VertexLayout_unbind();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->indices_buffer);
+    assert(glGetError() == GL_NO_ERROR);
+
+    glVertexAttribPointer(batch->attr_pos, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteBatchVertex), (GLvoid*) offset);
+    glVertexAttribPointer(batch->attr_uv, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteBatchVertex), (GLvoid*) (offset + sizeof(vec2)));
+    if (batch->attr_color >= 0) {
+        glVertexAttribPointer(batch->attr_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteBatchVertex), (GLvoid*) (offset + sizeof(vec2) * 2));
+    }
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 同じレイヤー・テクスチャが続く範囲を1回で描画する
+    GLuint begin = 0;
+    while (begin < batch->sprites_num) {
+        const SpriteBatchSprite *head = &batch->sprites[batch->order[begin]];
+        GLuint end = begin + 1;
+        while (end < batch->sprites_num) {
+            const SpriteBatchSprite *sprite = &batch->sprites[batch->order[end]];
+            if (sprite->layer != head->layer || sprite->texture != head->texture) {
+                break;
+            }
+            ++end;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, head->texture->id);
+        glDrawElements(GL_TRIANGLES, (end - begin) * 6, GL_UNSIGNED_SHORT, (GLvoid*) (sizeof(GLushort) * begin * 6));
+        assert(glGetError() == GL_NO_ERROR);
+
+        ++batch->draws_num;
+        begin = end;
+    }
+
+    batch->sprites_num = 0;
+}
+
+/**
+ * 残りのスプライトを描画して登録を終了する。
+ */
+GLuint SpriteBatch_end(SpriteBatch *batch) {
+    SpriteBatch_flush(batch);
+    return batch->draws_num;
+}
+
+/**
+ * スプライトバッチを解放する
+ */
+void SpriteBatch_free(SpriteBatch *batch) {
+    if (!batch) {
+        return;
+    }
+
+    StreamBuffer_free(batch->vertices_stream);
+    glDeleteBuffers(1, &batch->indices_buffer);
+    assert(glGetError() == GL_NO_ERROR);
+
+    free(batch->sprites);
+    free(batch->order);
+    free(batch);
+}
@@ -0,0 +1,170 @@
+/*
+ * support_gl_SpriteBatch.h
+ *
+ * スプライトのまとめ描画
+ * Sprite_createPositionMatrixと同じ配置を行列を作らずに四隅の座標として計算し、
+ * ストリーミング用の頂点バッファへ書き込んでテクスチャごとに1回で描画する。
+ */
+
+#ifndef SUPPORT_GL_SPRITEBATCH_H_
+#define SUPPORT_GL_SPRITEBATCH_H_
+
+/**
+ * 1回の描画でまとめられる最大スプライト数
+ * 16bitインデックスで参照できる頂点数 / 4となる
+ */
+#define SPRITEBATCH_SPRITES_MAX     16384
+
+/**
+ * スプライトの頂点
+ */
+typedef struct SpriteBatchVertex {
+    /**
+     * 正規化デバイス座標
+     */
+    vec2 position;
+
+    /**
+     * UV
+     */
+    vec2 uv;
+
+    /**
+     * 乗算色(RGBA)
+     */
+    GLubyte color[4];
+} SpriteBatchVertex;
+
+/**
+ * 登録されたスプライト
+ */
+typedef struct SpriteBatchSprite {
+    /**
+     * テクスチャ
+     */
+    const Texture *texture;
+
+    /**
+     * 描画順の優先度
+     * 小さい値から描画され、同じ値の中でテクスチャごとにまとめられる
+     */
+    GLint layer;
+
+    /**
+     * 登録順
+     * 同じレイヤー・テクスチャの中では登録順に描画する
+     */
+    GLuint sequence;
+
+    /**
+     * 描画位置（左上）と大きさ（ピクセル）
+     */
+    GLfloat x;
+    GLfloat y;
+    GLfloat width;
+    GLfloat height;
+
+    /**
+     * 回転角（度）
+     */
+    GLfloat rotate;
+
+    /**
+     * UVの範囲
+     */
+    GLfloat u0;
+    GLfloat v0;
+    GLfloat u1;
+    GLfloat v1;
+
+    /**
+     * 乗算色(0xRRGGBBAA)
+     */
+    GLuint color;
+} SpriteBatchSprite;
+
+/**
+ * スプライトバッチ
+ */
+typedef struct SpriteBatch {
+    /**
+     * 登録されたスプライト
+     */
+    SpriteBatchSprite *sprites;
+    GLuint sprites_num;
+    GLuint sprites_max;
+
+    /**
+     * 描画順に並べたスプライト番号
+     */
+    GLuint *order;
+
+    /**
+     * ストリーミング用の頂点バッファ
+     * 描画ごとに後ろへ追記し、SpriteBatch_beginでページを切り替える
+     */
+    StreamBuffer *vertices_stream;
+
+    /**
+     * 四角形のインデックスバッファ
+     * 内容は固定のため初期化時に転送する
+     */
+    GLuint indices_buffer;
+
+    /**
+     * 描画先の大きさ
+     */
+    GLint surface_width;
+    GLint surface_height;
+
+    /**
+     * 頂点属性
+     * attr_colorは利用しない場合に負の値を指定する
+     */
+    GLint attr_pos;
+    GLint attr_uv;
+    GLint attr_color;
+
+    /**
+     * SpriteBatch_begin以降の描画回数
+     */
+    GLuint draws_num;
+} SpriteBatch;
+
+/**
+ * スプライトバッチを生成する。
+ * sprites_maxはSPRITEBATCH_SPRITES_MAX以下を指定する。
+ */
+extern SpriteBatch* SpriteBatch_create(const GLuint sprites_max);
+
+/**
+ * スプライトの登録を開始する。
+ * フレームごとに1回呼び出す。
+ * 頂点属性は描画時に利用中のシェーダーのlocationを指定する。
+ */
+extern void SpriteBatch_begin(SpriteBatch *batch, const int surface_width, const int surface_height, const GLint attr_pos, const GLint attr_uv, const GLint attr_color);
+
+/**
+ * スプライトを登録する。
+ * 引数の意味はSprite_createPositionMatrix / Sprite_createUvMatrixと同じとなる。
+ * 登録数が上限に達した場合はその時点で描画する。
+ */
+extern void SpriteBatch_draw(SpriteBatch *batch, const Texture *texture, const GLint src_x, const GLint src_y, const GLint src_width, const GLint src_height, const GLint x, const GLint y, const GLint width, const GLint height, const GLfloat rotate, const GLint layer, const GLuint color);
+
+/**
+ * 登録されたスプライトをレイヤーとテクスチャの順に並べて描画する。
+ */
+extern void SpriteBatch_flush(SpriteBatch *batch);
+
+/**
+ * 残りのスプライトを描画して登録を終了する。
+ * SpriteBatch_begin以降の描画回数を返す。
+ */
+extern GLuint SpriteBatch_end(SpriteBatch *batch);
+
+/**
+ * スプライトバッチを解放する
+ */
+extern void SpriteBatch_free(SpriteBatch *batch);
+
+#endif /* SUPPORT_GL_SPRITEBATCH_H_ */
@@ -0,0 +1,291 @@
+/*
+ * support_gl_StaticBatch.c
+ */
+
+#include    "support.h"
+
+/**
+ * ページの作業情報
+ */
+typedef struct StaticBatchBuilder {
+    /**
+     * 書き込み中の頂点とインデックス
+     */
+    PmdVertex *vertices;
+    GLuint vertices_num;
+    GLushort *indices;
+    GLuint indices_num;
+    GLuint indices_capacity;
+
+    /**
+     * 書き込み中の描画
+     */
+    StaticBatchDraw *draws;
+    GLuint draws_num;
+    GLuint draws_capacity;
+
+    /**
+     * 元の頂点番号 -> ページの頂点番号
+     * remap_stamps[i] == stampの場合のみ有効
+     */
+    GLuint *remap;
+    GLuint *remap_stamps;
+    GLuint stamp;
+
+    GLenum usage;
+} StaticBatchBuilder;
+
+/**
+ * 材質を検索し、見つからなければ追加する
+ */
+static GLuint StaticBatch_findMaterial(StaticBatch *batch, Texture *texture, const vec4 diffuse_color) {
+    GLuint i = 0;
+    for (i = 0; i < batch->materials_num; ++i) {
+        const StaticBatchMaterial *material = &batch->materials[i];
+        if (material->texture != texture) {
+            continue;
+        }
+        // テクスチャを持つ場合は色を使わない
+        if (texture || !memcmp(&material->diffuse_color, &diffuse_color, sizeof(vec4))) {
+            return i;
+        }
+    }
+
+    batch->materials = realloc(batch->materials, sizeof(StaticBatchMaterial) * (batch->materials_num + 1));
+    batch->materials[batch->materials_num].texture = texture;
+    batch->materials[batch->materials_num].diffuse_color = diffuse_color;
+    return batch->materials_num++;
+}
+
+/**
+ * 書き込み中のページをバッファオブジェクトへ転送する
+ */
+static void StaticBatchBuilder_flush(StaticBatchBuilder *builder, StaticBatch *batch) {
+    if (!builder->indices_num) {
+        return;
+    }
+
+    batch->pages = realloc(batch->pages, sizeof(StaticBatchPage) * (batch->pages_num + 1));
+    StaticBatchPage *page = &batch->pages[batch->pages_num++];
+
+    page->vertices_num = builder->vertices_num;
+    page->indices_num = builder->indices_num;
+    page->draws_num = builder->draws_num;
+    page->draws = malloc(sizeof(StaticBatchDraw) * builder->draws_num);
+    memcpy(page->draws, builder->draws, sizeof(StaticBatchDraw) * builder->draws_num);
+
+    GLuint i = 0;
+    page->aabb_min = builder->vertices[0].position;
+    page->aabb_max = builder->vertices[0].position;
+    for (i = 1; i < builder->vertices_num; ++i) {
+        const vec3 p = builder->vertices[i].position;
+        page->aabb_min = vec3_create(fminf(page->aabb_min.x, p.x), fminf(page->aabb_min.y, p.y), fminf(page->aabb_min.z, p.z));
+        page->aabb_max = vec3_create(fmaxf(page->aabb_max.x, p.x), fmaxf(page->aabb_max.y, p.y), fmaxf(page->aabb_max.z, p.z));
+    }
+
+    glGenBuffers(1, &page->vertices_buffer);
+    glGenBuffers(1, &page->indices_buffer);
+    assert(page->vertices_buffer && page->indices_buffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, page->vertices_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(PmdVertex) * builder->vertices_num, builder->vertices, builder->usage);
+    VertexLayout_invalidateBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->indices_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * builder->indices_num, builder->indices, builder->usage);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 次のページは空から始める
+    builder->vertices_num = 0;
+    builder->indices_num = 0;
+    builder->draws_num = 0;
+    ++builder->stamp;
+}
+
+/**
+ * 三角形をページへ追加する
+ */
+static void StaticBatchBuilder_addTriangle(StaticBatchBuilder *builder, StaticBatch *batch, const StaticBatchInstance *instance, const GLuint material, const GLuint *triangle) {
+    const PmdFile *pmd = instance->pmd;
+    const mat4 *world = &instance->world;
+    const mat3 *normal_matrix = &instance->normal_matrix;
+    int k = 0;
+
+    // 収まらなければ新しいページへ移る
+    {
+        GLuint required = 0;
+        for (k = 0; k < 3; ++k) {
+            required += builder->remap_stamps[triangle[k]] != builder->stamp;
+        }
+        if (builder->vertices_num + required > STATICBATCH_PAGE_VERTICES_MAX) {
+            StaticBatchBuilder_flush(builder, batch);
+        }
+    }
+
+    // 材質が変わったら描画を分ける
+    if (!builder->draws_num || builder->draws[builder->draws_num - 1].material != material) {
+        if (builder->draws_num == builder->draws_capacity) {
+            builder->draws_capacity *= 2;
+            builder->draws = realloc(builder->draws, sizeof(StaticBatchDraw) * builder->draws_capacity);
+        }
+        StaticBatchDraw *draw = &builder->draws[builder->draws_num++];
+        draw->material = material;
+        draw->indices_begin = builder->indices_num;
+        draw->indices_num = 0;
+    }
+
+    if (builder->indices_num + 3 > builder->indices_capacity) {
+        builder->indices_capacity *= 2;
+        builder->indices = realloc(builder->indices, sizeof(GLushort) * builder->indices_capacity);
+    }
+
+    for (k = 0; k < 3; ++k) {
+        const GLuint index = triangle[k];
+        if (builder->remap_stamps[index] != builder->stamp) {
+            // ワールド座標系へ変換して追加する
+            const PmdVertex *src = &pmd->vertices[index];
+            PmdVertex *dst = &builder->vertices[builder->vertices_num];
+            const vec3 n = src->normal;
+
+            dst->position = mat4_transformPoint(*world, src->position);
+            dst->uv = src->uv;
+            dst->normal = vec3_normalize(vec3_create( //
+                    normal_matrix->m[0][0] * n.x + normal_matrix->m[1][0] * n.y + normal_matrix->m[2][0] * n.z, //
+                    normal_matrix->m[0][1] * n.x + normal_matrix->m[1][1] * n.y + normal_matrix->m[2][1] * n.z, //
+                    normal_matrix->m[0][2] * n.x + normal_matrix->m[1][2] * n.y + normal_matrix->m[2][2] * n.z));
+
+            builder->remap[index] = builder->vertices_num++;
+            builder->remap_stamps[index] = builder->stamp;
+        }
+        builder->indices[builder->indices_num++] = (GLushort) builder->remap[index];
+    }
+    builder->draws[builder->draws_num - 1].indices_num += 3;
+}
+
+/**
+ * 空のバッチを生成する
+ */
+StaticBatch* StaticBatch_create() {
+    StaticBatch *result = calloc(1, sizeof(StaticBatch));
+    result->instances_capacity = 16;
+    result->instances = malloc(sizeof(StaticBatchInstance) * result->instances_capacity);
+    return result;
+}
+
+/**
+ * モデルを登録する。
+ */
+void StaticBatch_addPmd(StaticBatch *batch, const PmdFile *pmd, const mat4 world) {
+    if (batch->instances_num == batch->instances_capacity) {
+        batch->instances_capacity *= 2;
+        batch->instances = realloc(batch->instances, sizeof(StaticBatchInstance) * batch->instances_capacity);
+    }
+
+    batch->instances[batch->instances_num].pmd = pmd;
+    batch->instances[batch->instances_num].world = world;
+    batch->instances[batch->instances_num].normal_matrix = mat4_normalMatrix(&world);
+    ++batch->instances_num;
+}
+
+/**
+ * 登録したモデルを材質ごとに連結してバッファオブジェクトへ転送する。
+ */
+GLuint StaticBatch_build(StaticBatch *batch, const GLenum usage) {
+    GLuint i = 0;
+    GLuint m = 0;
+    GLuint t = 0;
+    GLuint vertices_max = 1;
+
+    // モデルの材質をバッチの材質へ対応付ける
+    GLuint **materialMaps = calloc(batch->instances_num ? batch->instances_num : 1, sizeof(GLuint*));
+    for (i = 0; i < batch->instances_num; ++i) {
+        const PmdFile *pmd = batch->instances[i].pmd;
+        materialMaps[i] = malloc(sizeof(GLuint) * (pmd->materials_num ? pmd->materials_num : 1));
+        for (m = 0; m < pmd->materials_num; ++m) {
+            materialMaps[i][m] = StaticBatch_findMaterial(batch, pmd->diffuse_textures ? pmd->diffuse_textures[m] : NULL, pmd->diffuse_colors[m]);
+        }
+        vertices_max = pmd->vertices_num > vertices_max ? pmd->vertices_num : vertices_max;
+    }
+
+    StaticBatchBuilder builder = { 0 };
+    builder.vertices = malloc(sizeof(PmdVertex) * STATICBATCH_PAGE_VERTICES_MAX);
+    builder.indices_capacity = 1024 * 3;
+    builder.indices = malloc(sizeof(GLushort) * builder.indices_capacity);
+    builder.draws_capacity = 16;
+    builder.draws = malloc(sizeof(StaticBatchDraw) * builder.draws_capacity);
+    builder.remap = malloc(sizeof(GLuint) * vertices_max);
+    builder.remap_stamps = calloc(vertices_max, sizeof(GLuint));
+    builder.stamp = 1;
+    builder.usage = usage;
+
+    // 材質ごとに全モデルの三角形を連結する
+    for (m = 0; m < batch->materials_num; ++m) {
+        for (i = 0; i < batch->instances_num; ++i) {
+            const StaticBatchInstance *instance = &batch->instances[i];
+            const PmdFile *pmd = instance->pmd;
+            GLuint pmdMaterial = 0;
+
+            for (pmdMaterial = 0; pmdMaterial < pmd->materials_num; ++pmdMaterial) {
+                if (materialMaps[i][pmdMaterial] != m) {
+                    continue;
+                }
+
+                const PmdDrawRange *range = &pmd->draw_ranges[pmdMaterial];
+                for (t = 0; t < range->indices_num; t += 3) {
+                    GLuint triangle[3];
+                    triangle[0] = PmdFile_getIndex((PmdFile*) pmd, range->indices_begin + t + 0);
+                    triangle[1] = PmdFile_getIndex((PmdFile*) pmd, range->indices_begin + t + 1);
+                    triangle[2] = PmdFile_getIndex((PmdFile*) pmd, range->indices_begin + t + 2);
+                    StaticBatchBuilder_addTriangle(&builder, batch, instance, m, triangle);
+                }
+            }
+
+            // 頂点番号の対応はモデルごとに作り直す
+            ++builder.stamp;
+        }
+    }
+    StaticBatchBuilder_flush(&builder, batch);
+
+    free(builder.vertices);
+    free(builder.indices);
+    free(builder.draws);
+    free(builder.remap);
+    free(builder.remap_stamps);
+    for (i = 0; i < batch->instances_num; ++i) {
+        free(materialMaps[i]);
+    }
+    free(materialMaps);
+
+    // 登録情報は不要になる
+    batch->instances_num = 0;
+
+    GLuint result = 0;
+    for (i = 0; i < batch->pages_num; ++i) {
+        result += batch->pages[i].draws_num;
+    }
+    return result;
+}
+
+/**
+ * バッチを解放する
+ */
+void StaticBatch_free(StaticBatch *batch) {
+    if (!batch) {
+        return;
+    }
+
+    GLuint i = 0;
+    for (i = 0; i < batch->pages_num; ++i) {
+        StaticBatchPage *page = &batch->pages[i];
+        glDeleteBuffers(1, &page->vertices_buffer);
+        glDeleteBuffers(1, &page->indices_buffer);
+        free(page->draws);
+    }
+    assert(glGetError() == GL_NO_ERROR);
+
+    free(batch->pages);
+    free(batch->materials);
+    free(batch->instances);
+    free(batch);
+}
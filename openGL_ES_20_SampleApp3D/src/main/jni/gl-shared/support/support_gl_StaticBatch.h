@@ -0,0 +1,151 @@
+/*
+ * support_gl_StaticBatch.h
+ *
+ * 静的バッチ
+ * 動かない背景のモデルをワールド座標系へ変換して材質ごとに連結し、
+ * 共有の頂点・インデックスバッファ（ページ）へまとめて描画回数を減らす。
+ */
+
+#ifndef SUPPORT_GL_STATICBATCH_H_
+#define SUPPORT_GL_STATICBATCH_H_
+
+/**
+ * 1ページの最大頂点数
+ * 16bitインデックスで参照できる範囲に収める
+ */
+#define STATICBATCH_PAGE_VERTICES_MAX   65536
+
+/**
+ * バッチの材質
+ * テクスチャと色が一致する材質は同じ描画にまとめる
+ */
+typedef struct StaticBatchMaterial {
+    /**
+     * Diffuseテクスチャ
+     * テクスチャを持たない場合はNULL
+     */
+    Texture *texture;
+
+    /**
+     * Diffuse色
+     */
+    vec4 diffuse_color;
+} StaticBatchMaterial;
+
+/**
+ * ページ内の1回の描画
+ */
+typedef struct StaticBatchDraw {
+    /**
+     * StaticBatch::materialsの番号
+     */
+    GLuint material;
+
+    /**
+     * ページのインデックスバッファ上の範囲
+     */
+    GLuint indices_begin;
+    GLuint indices_num;
+} StaticBatchDraw;
+
+/**
+ * 頂点・インデックスバッファの組
+ */
+typedef struct StaticBatchPage {
+    /**
+     * 頂点バッファ
+     * ワールド座標系へ変換済みのPmdVertexが格納される
+     */
+    GLuint vertices_buffer;
+
+    /**
+     * インデックスバッファ
+     * GL_UNSIGNED_SHORTで格納される
+     */
+    GLuint indices_buffer;
+
+    /**
+     * 頂点数
+     */
+    GLuint vertices_num;
+
+    /**
+     * インデックス数
+     */
+    GLuint indices_num;
+
+    /**
+     * 材質ごとの描画
+     */
+    StaticBatchDraw *draws;
+    GLuint draws_num;
+
+    /**
+     * ワールド座標系でのAABB
+     */
+    vec3 aabb_min;
+    vec3 aabb_max;
+} StaticBatchPage;
+
+/**
+ * 登録されたモデル
+ */
+typedef struct StaticBatchInstance {
+    const PmdFile *pmd;
+    mat4 world;
+
+    /**
+     * 法線の変換行列
+     * 非一様な拡縮を含むworldでも法線を正しく変換するため、登録時に逆転置行列を求めておく
+     */
+    mat3 normal_matrix;
+} StaticBatchInstance;
+
+/**
+ * 静的バッチ
+ */
+typedef struct StaticBatch {
+    /**
+     * 登録されたモデル
+     * StaticBatch_build後に破棄される
+     */
+    StaticBatchInstance *instances;
+    GLuint instances_num;
+    GLuint instances_capacity;
+
+    /**
+     * 材質一覧
+     */
+    StaticBatchMaterial *materials;
+    GLuint materials_num;
+
+    /**
+     * ページ
+     */
+    StaticBatchPage *pages;
+    GLuint pages_num;
+} StaticBatch;
+
+/**
+ * 空のバッチを生成する
+ */
+extern StaticBatch* StaticBatch_create();
+
+/**
+ * モデルを登録する。
+ * pmdはStaticBatch_buildを呼び出すまで保持しておく必要がある。
+ */
+extern void StaticBatch_addPmd(StaticBatch *batch, const PmdFile *pmd, const mat4 world);
+
+/**
+ * 登録したモデルを材質ごとに連結してバッファオブジェクトへ転送する。
+ * 生成した描画回数を返す。
+ */
+extern GLuint StaticBatch_build(StaticBatch *batch, const GLenum usage);
+
+/**
+ * バッチを解放する
+ */
+extern void StaticBatch_free(StaticBatch *batch);
+
+#endif /* SUPPORT_GL_STATICBATCH_H_ */
@@ -0,0 +1,202 @@
+/*
+ * support_gl_StreamBuffer.c
+ */
+
+#include    "support.h"
+
+#ifndef __APPLE__
+#include    <EGL/egl.h>
+#endif
+
+/**
+ * GL_OES_mapbufferの関数
+ */
+typedef GLvoid* (GL_APIENTRY *StreamBuffer_mapFunction)(GLenum target, GLenum access);
+typedef GLboolean (GL_APIENTRY *StreamBuffer_unmapFunction)(GLenum target);
+
+static StreamBuffer_mapFunction g_map_buffer = NULL;
+static StreamBuffer_unmapFunction g_unmap_buffer = NULL;
+
+/**
+ * GL_OES_mapbufferの関数を取得する
+ * 対応していない場合はfalseを返す。
+ */
+static bool StreamBuffer_loadMapBuffer() {
+    if (g_map_buffer && g_unmap_buffer) {
+        return true;
+    }
+
+    if (!ES20_hasExtension("GL_OES_mapbuffer")) {
+        return false;
+    }
+
+#ifdef __APPLE__
+    g_map_buffer = (StreamBuffer_mapFunction) glMapBufferOES;
+    g_unmap_buffer = (StreamBuffer_unmapFunction) glUnmapBufferOES;
+#else
+    g_map_buffer = (StreamBuffer_mapFunction) eglGetProcAddress("glMapBufferOES");
+    g_unmap_buffer = (StreamBuffer_unmapFunction) eglGetProcAddress("glUnmapBufferOES");
+#endif
+    return g_map_buffer && g_unmap_buffer;
+}
+
+/**
+ * 書き込み中のページをtargetへバインドする
+ * GL_ELEMENT_ARRAY_BUFFERの場合にVAOを書き換えないよう、先にVertexLayoutへ通知する。
+ */
+static void StreamBuffer_bindPage(const StreamBuffer *stream) {
+    VertexLayout_invalidateBuffer(stream->target);
+    glBindBuffer(stream->target, stream->buffers[stream->page]);
+}
+
+/**
+ * 書き込み中のバッファの旧領域を破棄し、先頭から書き込めるようにする
+ * GPUが旧領域を参照中でも、ドライバが新しい領域を割り当てるため待たずに書き込める。
+ */
+static void StreamBuffer_orphan(StreamBuffer *stream) {
+    StreamBuffer_bindPage(stream);
+    glBufferData(stream->target, stream->capacity, NULL, GL_STREAM_DRAW);
+    assert(glGetError() == GL_NO_ERROR);
+
+    stream->offset = 0;
+    ++stream->orphans_num;
+}
+
+/**
+ * sizeバイトの領域を予約し、書き込み位置を返す
+ * 書き込み中のページに収まらない場合は次のページへ折り返す。
+ */
+static GLintptr StreamBuffer_allocate(StreamBuffer *stream, const GLsizeiptr size) {
+    assert(size <= stream->capacity);
+    assert(!stream->mapped);
+
+    GLintptr offset = (stream->offset + (STREAMBUFFER_ALIGNMENT - 1)) & ~((GLintptr) STREAMBUFFER_ALIGNMENT - 1);
+    if (offset + size > stream->capacity) {
+        stream->page = (stream->page + 1) % STREAMBUFFER_PAGES;
+        StreamBuffer_orphan(stream);
+        ++stream->wraps_num;
+        offset = 0;
+    } else {
+        StreamBuffer_bindPage(stream);
+    }
+
+    stream->offset = offset + size;
+    stream->written_bytes += size;
+    return offset;
+}
+
+/**
+ * ストリーミング用バッファを生成する
+ */
+StreamBuffer* StreamBuffer_create(const GLenum target, const GLsizeiptr capacity) {
+    StreamBuffer *result = calloc(1, sizeof(StreamBuffer));
+    int i = 0;
+
+    result->target = target;
+    result->capacity = capacity > 0 ? capacity : STREAMBUFFER_ALIGNMENT;
+    result->mapbuffer = StreamBuffer_loadMapBuffer();
+    result->staging = malloc(result->capacity);
+
+    glGenBuffers(STREAMBUFFER_PAGES, result->buffers);
+    assert(glGetError() == GL_NO_ERROR);
+
+    // 容量は最初に確保し、以降はオーファンで同じ容量を割り当て直す
+    VertexLayout_invalidateBuffer(target);
+    for (i = 0; i < STREAMBUFFER_PAGES; ++i) {
+        glBindBuffer(target, result->buffers[i]);
+        glBufferData(target, result->capacity, NULL, GL_STREAM_DRAW);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+    glBindBuffer(target, 0);
+
+    __logf("StreamBuffer capacity(%d bytes x %d) mapbuffer(%s)", (int) result->capacity, STREAMBUFFER_PAGES, result->mapbuffer ? "true" : "false");
+    return result;
+}
+
+/**
+ * 次のページへ移り、旧領域を破棄して先頭から書き込めるようにする。
+ */
+void StreamBuffer_nextFrame(StreamBuffer *stream) {
+    assert(!stream->mapped);
+
+    stream->page = (stream->page + 1) % STREAMBUFFER_PAGES;
+    StreamBuffer_orphan(stream);
+}
+
+/**
+ * データを書き込み、書き込んだ位置を返す。
+ */
+GLintptr StreamBuffer_write(StreamBuffer *stream, const GLvoid *data, const GLsizeiptr size) {
+    const GLintptr offset = StreamBuffer_allocate(stream, size);
+    if (size > 0) {
+        glBufferSubData(stream->target, offset, size, data);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+    return offset;
+}
+
+/**
+ * sizeバイトの書き込み先を取得する。
+ */
+GLvoid* StreamBuffer_map(StreamBuffer *stream, const GLsizeiptr size, GLintptr *offset) {
+    stream->mapped_offset = StreamBuffer_allocate(stream, size);
+    stream->mapped_size = size;
+    stream->mapped_direct = false;
+    stream->mapped = NULL;
+
+    // GL_OES_mapbufferはバッファ全体を対象とするため、
+    // 先行する描画が参照していない、破棄直後のページ先頭のみ直接書き込む
+    if (stream->mapbuffer && stream->mapped_offset == 0) {
+        stream->mapped = (*g_map_buffer)(stream->target, GL_WRITE_ONLY_OES);
+        stream->mapped_direct = stream->mapped != NULL;
+    }
+
+    if (!stream->mapped) {
+        stream->mapped = stream->staging;
+    }
+
+    *offset = stream->mapped_offset;
+    return stream->mapped;
+}
+
+/**
+ * StreamBuffer_mapで書き込んだ内容を確定し、targetへバインドする。
+ */
+void StreamBuffer_unmap(StreamBuffer *stream) {
+    assert(stream->mapped);
+
+    StreamBuffer_bindPage(stream);
+    if (stream->mapped_direct) {
+        if (!(*g_unmap_buffer)(stream->target)) {
+            // 画面モードの切り替え等で内容が失われた場合は、このフレームの描画が崩れる
+            __logf("StreamBuffer unmap failed");
+        }
+    } else if (stream->mapped_size > 0) {
+        glBufferSubData(stream->target, stream->mapped_offset, stream->mapped_size, stream->staging);
+    }
+    assert(glGetError() == GL_NO_ERROR);
+
+    stream->mapped = NULL;
+    stream->mapped_direct = false;
+}
+
+/**
+ * 書き込み中のバッファをtargetへバインドする
+ */
+void StreamBuffer_bind(StreamBuffer *stream) {
+    StreamBuffer_bindPage(stream);
+}
+
+/**
+ * ストリーミング用バッファを解放する
+ */
+void StreamBuffer_free(StreamBuffer *stream) {
+    if (!stream) {
+        return;
+    }
+
+    glDeleteBuffers(STREAMBUFFER_PAGES, stream->buffers);
+    assert(glGetError() == GL_NO_ERROR);
+    free(stream->staging);
+    free(stream);
+}
@@ -0,0 +1,128 @@
+/*
+ * support_gl_StreamBuffer.h
+ *
+ * 毎フレーム書き換える頂点・インデックスのストリーミング用バッファ
+ * 複数のページを順番に使い、ページへ戻る際と末尾で折り返す際に旧領域を破棄（オーファン）する。
+ * 書き込んだデータはバッファ内のオフセットとして返すため、クライアント側配列を使わずに描画できる。
+ */
+
+#ifndef SUPPORT_GL_STREAMBUFFER_H_
+#define SUPPORT_GL_STREAMBUFFER_H_
+
+/**
+ * 巡回させるバッファ数
+ */
+#define STREAMBUFFER_PAGES      3
+
+/**
+ * 書き込み位置の境界（byte）
+ * 頂点属性・インデックスの読み出し位置を揃える
+ */
+#define STREAMBUFFER_ALIGNMENT  4
+
+/**
+ * ストリーミング用バッファ
+ */
+typedef struct StreamBuffer {
+    /**
+     * GL_ARRAY_BUFFER / GL_ELEMENT_ARRAY_BUFFER
+     */
+    GLenum target;
+
+    /**
+     * バッファオブジェクト
+     */
+    GLuint buffers[STREAMBUFFER_PAGES];
+
+    /**
+     * 各バッファの容量（byte）
+     */
+    GLsizeiptr capacity;
+
+    /**
+     * 書き込み中のバッファ
+     */
+    int page;
+
+    /**
+     * 次の書き込み位置
+     */
+    GLintptr offset;
+
+    /**
+     * GL_OES_mapbufferで直接書き込める場合はtrue
+     */
+    bool mapbuffer;
+
+    /**
+     * StreamBuffer_map中の領域
+     * 直接書き込めない場合はstagingへ書き込み、StreamBuffer_unmapで転送する。
+     */
+    GLvoid *mapped;
+    GLintptr mapped_offset;
+    GLsizeiptr mapped_size;
+    bool mapped_direct;
+
+    /**
+     * 直接書き込めない場合の書き込み先
+     */
+    GLvoid *staging;
+
+    /**
+     * 旧領域を破棄した回数
+     */
+    GLuint orphans_num;
+
+    /**
+     * 1ページに収まらず折り返した回数
+     */
+    GLuint wraps_num;
+
+    /**
+     * 転送したbyte数
+     */
+    GLsizeiptr written_bytes;
+} StreamBuffer;
+
+/**
+ * ストリーミング用バッファを生成する
+ * capacityには1フレームで書き込む最大のbyte数を指定する。
+ */
+extern StreamBuffer* StreamBuffer_create(const GLenum target, const GLsizeiptr capacity);
+
+/**
+ * 次のページへ移り、旧領域を破棄して先頭から書き込めるようにする。
+ * フレームの先頭で1回呼び出す。
+ */
+extern void StreamBuffer_nextFrame(StreamBuffer *stream);
+
+/**
+ * データを書き込み、書き込んだ位置を返す。
+ * 書き込んだバッファはtargetへバインドされる。
+ * 返した位置は次にページが破棄されるまで描画に利用できる。
+ */
+extern GLintptr StreamBuffer_write(StreamBuffer *stream, const GLvoid *data, const GLsizeiptr size);
+
+/**
+ * sizeバイトの書き込み先を取得する。
+ * offsetには書き込み位置が格納され、書き込み後はStreamBuffer_unmapを呼び出す。
+ * ページの先頭であればGL_OES_mapbufferで直接書き込み、それ以外は一時領域を経由する。
+ */
+extern GLvoid* StreamBuffer_map(StreamBuffer *stream, const GLsizeiptr size, GLintptr *offset);
+
+/**
+ * StreamBuffer_mapで書き込んだ内容を確定し、targetへバインドする。
+ */
+extern void StreamBuffer_unmap(StreamBuffer *stream);
+
+/**
+ * 書き込み中のバッファをtargetへバインドする
+ */
+extern void StreamBuffer_bind(StreamBuffer *stream);
+
+/**
+ * ストリーミング用バッファを解放する
+ */
+extern void StreamBuffer_free(StreamBuffer *stream);
+
+#endif /* SUPPORT_GL_STREAMBUFFER_H_ */
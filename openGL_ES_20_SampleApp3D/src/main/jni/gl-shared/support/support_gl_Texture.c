@@ -11,6 +11,17 @@ extern Texture* PvrtcImage_loadTexture(GLApplication *app, const char* file_name
 extern Texture* KtxImage_loadTexture(GLApplication *app, const char* file_name);
 extern Texture* RawPixelImage_loadTexture(GLApplication *app, const char* file_name, const int pixel_fotmat);
 
+/**
+ * テクスチャ構造体のプール
+ * 最初のテクスチャ確保時に生成し、プロセス終了まで保持する。
+ */
+static HandlePool *g_texture_pool = NULL;
+
+/**
+ * 非同期読み込みスレッドからも確保されるため、確保と解放は排他する
+ */
+static pthread_mutex_t g_texture_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /**
  * サイズがpotならTEXTURE_POTを返す。npotなら、TEXTURE_NPOTを返す。
  */
@@ -64,11 +75,107 @@ bool Texture_isPowerOfTwo(Texture *texture) {
     return Texture_checkPowerOfTwo(texture->width) && Texture_checkPowerOfTwo(texture->height);
 }
 
+/**
+ * テクスチャ構造体をプールから確保する。
+ */
+Texture* Texture_alloc(void) {
+    Handle handle = HANDLE_NULL;
+
+    pthread_mutex_lock(&g_texture_mutex);
+    if (!g_texture_pool) {
+        g_texture_pool = HandlePool_create(sizeof(Texture), TEXTURE_POOL_CAPACITY);
+    }
+    Texture *result = HandlePool_alloc(g_texture_pool, &handle);
+    pthread_mutex_unlock(&g_texture_mutex);
+
+    // TEXTURE_POOL_CAPACITYを超えた場合、読み込み処理はテクスチャ無しとして扱う
+    if (!result) {
+        __log("Texture pool is full");
+    }
+    return result;
+}
+
+/**
+ * テクスチャのハンドルを取得する
+ */
+TextureHandle Texture_getHandle(const Texture *texture) {
+    if (!texture || !g_texture_pool) {
+        return HANDLE_NULL;
+    }
+    return HandlePool_getHandle(g_texture_pool, texture);
+}
+
+/**
+ * ハンドルが指すテクスチャを取得する。
+ * 参照は描画ループから頻繁に行われるため排他しない。
+ */
+Texture* Texture_fromHandle(const TextureHandle handle) {
+    if (handle == HANDLE_NULL || !g_texture_pool) {
+        return NULL;
+    }
+    return HandlePool_get(g_texture_pool, handle);
+}
+
+/**
+ * テクスチャをプールへ返却する。
+ * g_texture_mutexをロックした状態で呼び出す。返却に成功した場合のみ、削除すべきGL側のIDをidへ格納する。
+ */
+static bool Texture_releaseLocked(const TextureHandle handle, GLuint *id) {
+    const Texture *texture = Texture_fromHandle(handle);
+    if (!texture) {
+        return false;
+    }
+
+    // 返却後は他のスレッドが再確保して書き換えるため、先に取り出す
+    *id = texture->id;
+    return HandlePool_release(g_texture_pool, handle);
+}
+
 /**
  * テクスチャを解放する。
  */
 void Texture_free(Texture *texture) {
-    glDeleteTextures(1, &texture->id);
-    free((void*) texture);
+    if (!texture) {
+        return;
+    }
+
+    GLuint id = 0;
+    bool pooled = false;
+    bool released = false;
+
+    pthread_mutex_lock(&g_texture_mutex);
+    if (g_texture_pool && HandlePool_contains(g_texture_pool, texture)) {
+        pooled = true;
+        // 解放済みであればハンドルは無効となり、何もしない
+        released = Texture_releaseLocked(HandlePool_getHandle(g_texture_pool, texture), &id);
+    }
+    pthread_mutex_unlock(&g_texture_mutex);
+
+    if (!pooled) {
+        // プール外の構造体は所有者が分からないため、GL側のテクスチャのみ削除する
+        __log("Texture_free : not allocated by Texture_alloc()");
+        glDeleteTextures(1, &texture->id);
+        return;
+    }
+
+    if (released && id) {
+        glDeleteTextures(1, &id);
+    }
 }
 
+/**
+ * ハンドルが指すテクスチャを解放する。
+ */
+bool Texture_freeHandle(const TextureHandle handle) {
+    GLuint id = 0;
+
+    // 同じハンドルを複数スレッドが解放しても、返却に成功するのは1スレッドのみとなる
+    pthread_mutex_lock(&g_texture_mutex);
+    const bool result = Texture_releaseLocked(handle, &id);
+    pthread_mutex_unlock(&g_texture_mutex);
+
+    if (result && id) {
+        glDeleteTextures(1, &id);
+    }
+    return result;
+}
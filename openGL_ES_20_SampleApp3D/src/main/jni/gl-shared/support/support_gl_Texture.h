@@ -87,8 +87,20 @@ extern void RawPixelImage_convertColorRGB(const void *rgb888_pixels, const int p
  */
 extern void RawPixelImage_convertColorRGBA(const void *rgba8888_pixels, const int pixel_format, void *dst_pixels, const int pixel_num);
 
+/**
+ * 同時に保持できるテクスチャ数
+ */
+#define TEXTURE_POOL_CAPACITY   512
+
+/**
+ * テクスチャを参照するハンドル
+ * テクスチャが解放・再読み込みされた後は無効となり、Texture_fromHandle()はNULLを返す。
+ */
+typedef Handle TextureHandle;
+
 /**
  * テクスチャ用構造体
+ * 全てのテクスチャは固定長のプールに格納され、アドレスは解放するまで変化しない。
  */
 typedef struct Texture {
     /**
@@ -128,9 +140,36 @@ extern Texture* Texture_load(GLApplication *app, const char* file_name, const in
  */
 extern bool Texture_isPowerOfTwo(Texture *texture);
 
+/**
+ * テクスチャ構造体をプールから確保する。
+ * 読み込み処理から呼び出し、解放はTexture_free()で行う。
+ * TEXTURE_POOL_CAPACITYを超えた場合はNULLを返すため、読み込み処理は失敗として扱う。
+ */
+extern Texture* Texture_alloc(void);
+
+/**
+ * テクスチャのハンドルを取得する
+ */
+extern TextureHandle Texture_getHandle(const Texture *texture);
+
+/**
+ * ハンドルが指すテクスチャを取得する。
+ * 解放済みのテクスチャを指している場合はNULLを返す。
+ */
+extern Texture* Texture_fromHandle(const TextureHandle handle);
+
 /**
  * テクスチャを解放する。
+ * 解放済みのテクスチャを指定した場合は何もしない。
+ * Texture_alloc()以外で用意した構造体はGL側のテクスチャのみ削除し、構造体は呼び出し元が解放する。
  */
 extern void Texture_free(Texture *texture);
 
+/**
+ * ハンドルが指すテクスチャを解放する。
+ * 既に解放されていた場合は何もせずfalseを返す。
+ * 複数スレッドから同じハンドルを解放しても、GL側のテクスチャを削除するのは1度のみとなる。
+ */
+extern bool Texture_freeHandle(const TextureHandle handle);
+
 #endif /* SUPPORT_GL_TEXTURE_H_ */
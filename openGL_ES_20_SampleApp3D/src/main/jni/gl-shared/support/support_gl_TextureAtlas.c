@@ -0,0 +1,604 @@
+/*
+ * support_gl_TextureAtlas.c
+ */
+
+#include    "support.h"
+
+/**
+ * skylineの1区間
+ */
+typedef struct TextureAtlasSkyline {
+    GLint x;
+    GLint y;
+    GLint width;
+} TextureAtlasSkyline;
+
+/**
+ * 詰め込み中のページ
+ */
+typedef struct TextureAtlasPacker {
+    /**
+     * ページの上端の輪郭
+     * x順に並び、隙間なくページ幅を覆う
+     */
+    TextureAtlasSkyline *skyline;
+    GLint skyline_num;
+
+    /**
+     * ページのピクセル(RGBA8)
+     */
+    GLubyte *pixels;
+} TextureAtlasPacker;
+
+/**
+ * qsortへ渡す画像配列
+ */
+static const TextureAtlasRegion *g_sort_regions = NULL;
+
+/**
+ * 高い画像から順に詰め込む
+ */
+static int TextureAtlas_compare(const void *a, const void *b) {
+    const TextureAtlasRegion *ra = &g_sort_regions[*((const GLuint*) a)];
+    const TextureAtlasRegion *rb = &g_sort_regions[*((const GLuint*) b)];
+
+    if (ra->height != rb->height) {
+        return ra->height > rb->height ? -1 : 1;
+    }
+    if (ra->width != rb->width) {
+        return ra->width > rb->width ? -1 : 1;
+    }
+    return *((const GLuint*) a) < *((const GLuint*) b) ? -1 : 1;
+}
+
+/**
+ * 画像内容のハッシュ値を計算する
+ */
+static GLuint TextureAtlas_hashImage(const RawPixelImage *image) {
+    const GLubyte *bytes = (const GLubyte*) image->pixel_data;
+    const GLuint length = image->width * image->height * 4;
+    GLuint hash = 2166136261u;
+    GLuint i = 0;
+
+    hash = (hash ^ (GLuint) image->width) * 16777619u;
+    hash = (hash ^ (GLuint) image->height) * 16777619u;
+    for (i = 0; i < length; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * 名前を登録する
+ */
+static void TextureAtlas_addEntry(TextureAtlas *atlas, const GLchar *name, const GLint region) {
+    atlas->entries = realloc(atlas->entries, sizeof(TextureAtlasEntry) * (atlas->entries_num + 1));
+
+    TextureAtlasEntry *entry = &atlas->entries[atlas->entries_num++];
+    entry->name = malloc(strlen(name) + 1);
+    strcpy(entry->name, name);
+    entry->region = region;
+}
+
+/**
+ * 名前を指定して画像ファイルを読み込む
+ */
+static GLint TextureAtlas_loadNamedImage(TextureAtlas *atlas, GLApplication *app, const GLchar *name, const GLchar *file_name) {
+    GLint result = TextureAtlas_find(atlas, name);
+    if (result >= 0) {
+        return result;
+    }
+
+    RawPixelImage *image = RawPixelImage_load(app, file_name, TEXTURE_RAW_RGBA8);
+    if (!image) {
+        __logf("Texture load fail(%s)", file_name);
+        return -1;
+    }
+    return TextureAtlas_addImage(atlas, app, name, image);
+}
+
+/**
+ * ピクセル配列からテクスチャを生成する
+ * 設定はTexture_load()で読み込んだテクスチャと揃える
+ * テクスチャのプールが埋まっている場合はNULLを返す。
+ */
+static Texture* TextureAtlas_createTexture(const GLint width, const GLint height, const void *pixels) {
+    Texture *texture = Texture_alloc();
+    if (!texture) {
+        return NULL;
+    }
+    texture->width = width;
+    texture->height = height;
+
+    glGenTextures(1, &texture->id);
+    assert(texture->id > 0);
+
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    assert(glGetError() == GL_NO_ERROR);
+
+    return texture;
+}
+
+/**
+ * ページを末尾へ追加する
+ */
+static GLint TextureAtlas_addPage(TextureAtlas *atlas, Texture *texture) {
+    atlas->pages = realloc(atlas->pages, sizeof(Texture*) * (atlas->pages_num + 1));
+    atlas->pages[atlas->pages_num] = texture;
+    return atlas->pages_num++;
+}
+
+/**
+ * skylineのindex番目の区間から幅widthの画像を置いた場合の上端を返す。
+ * 置けない場合は-1を返す。
+ */
+static GLint TextureAtlasPacker_fit(const TextureAtlasPacker *packer, const GLint index, const GLint width, const GLint height, const GLint page_width, const GLint page_height) {
+    const GLint x = packer->skyline[index].x;
+    if (x + width > page_width) {
+        return -1;
+    }
+
+    GLint y = 0;
+    GLint remain = width;
+    GLint i = index;
+    while (remain > 0) {
+        y = packer->skyline[i].y > y ? packer->skyline[i].y : y;
+        if (y + height > page_height) {
+            return -1;
+        }
+        remain -= packer->skyline[i].width;
+        ++i;
+    }
+    return y;
+}
+
+/**
+ * 配置した画像でskylineを更新する
+ */
+static void TextureAtlasPacker_insert(TextureAtlasPacker *packer, const GLint index, const GLint x, const GLint y, const GLint width) {
+    GLint i = 0;
+
+    // 新しい区間を挿入する
+    memmove(packer->skyline + index + 1, packer->skyline + index, sizeof(TextureAtlasSkyline) * (packer->skyline_num - index));
+    packer->skyline[index].x = x;
+    packer->skyline[index].y = y;
+    packer->skyline[index].width = width;
+    ++packer->skyline_num;
+
+    // 隠れた区間を削る
+    i = index + 1;
+    while (i < packer->skyline_num) {
+        const TextureAtlasSkyline *prev = &packer->skyline[i - 1];
+        TextureAtlasSkyline *node = &packer->skyline[i];
+        const GLint shrink = prev->x + prev->width - node->x;
+        if (shrink <= 0) {
+            break;
+        }
+
+        node->x += shrink;
+        node->width -= shrink;
+        if (node->width > 0) {
+            break;
+        }
+        memmove(packer->skyline + i, packer->skyline + i + 1, sizeof(TextureAtlasSkyline) * (packer->skyline_num - i - 1));
+        --packer->skyline_num;
+    }
+
+    // 同じ高さの区間をまとめる
+    i = 0;
+    while (i < packer->skyline_num - 1) {
+        if (packer->skyline[i].y == packer->skyline[i + 1].y) {
+            packer->skyline[i].width += packer->skyline[i + 1].width;
+            memmove(packer->skyline + i + 1, packer->skyline + i + 2, sizeof(TextureAtlasSkyline) * (packer->skyline_num - i - 2));
+            --packer->skyline_num;
+        } else {
+            ++i;
+        }
+    }
+}
+
+/**
+ * ページへ画像の置き場所を探す。
+ * 見つかった場合はtrueを返してx/yへ左上の位置を書き込む。
+ */
+static bool TextureAtlasPacker_pack(TextureAtlasPacker *packer, const GLint width, const GLint height, const GLint page_width, const GLint page_height, GLint *x, GLint *y) {
+    GLint bestIndex = -1;
+    GLint bestTop = page_height + 1;
+    GLint bestX = 0;
+    GLint i = 0;
+
+    // 上端が最も低くなる位置を選ぶ
+    for (i = 0; i < packer->skyline_num; ++i) {
+        const GLint top = TextureAtlasPacker_fit(packer, i, width, height, page_width, page_height);
+        if (top < 0) {
+            continue;
+        }
+        if (top + height < bestTop || (top + height == bestTop && packer->skyline[i].x < bestX)) {
+            bestIndex = i;
+            bestTop = top + height;
+            bestX = packer->skyline[i].x;
+        }
+    }
+
+    if (bestIndex < 0) {
+        return false;
+    }
+
+    *x = bestX;
+    *y = bestTop - height;
+    TextureAtlasPacker_insert(packer, bestIndex, bestX, bestTop, width);
+    return true;
+}
+
+/**
+ * 画像を余白ごとページへ書き込む。
+ * 余白は画像の端のピクセルを引き伸ばして埋める。
+ */
+static void TextureAtlas_blit(const TextureAtlas *atlas, const TextureAtlasRegion *region, GLubyte *pixels) {
+    const GLuint *src = (const GLuint*) region->image->pixel_data;
+    GLuint *dst = (GLuint*) pixels;
+    const GLint padding = atlas->padding;
+    GLint px = 0;
+    GLint py = 0;
+
+    for (py = -padding; py < region->height + padding; ++py) {
+        const GLint sy = py < 0 ? 0 : (py >= region->height ? region->height - 1 : py);
+        GLuint *row = dst + (region->y + py) * atlas->page_width + region->x;
+        for (px = -padding; px < region->width + padding; ++px) {
+            const GLint sx = px < 0 ? 0 : (px >= region->width ? region->width - 1 : px);
+            row[px] = src[sy * region->width + sx];
+        }
+    }
+}
+
+/**
+ * 空のアトラスを生成する。
+ */
+TextureAtlas* TextureAtlas_create(const GLint page_width, const GLint page_height, const GLint padding) {
+    assert(Texture_checkPowerOfTwoWH(page_width, page_height));
+    assert(padding >= 0);
+
+    TextureAtlas *result = calloc(1, sizeof(TextureAtlas));
+    result->page_width = page_width;
+    result->page_height = page_height;
+    result->padding = padding;
+    return result;
+}
+
+/**
+ * 画像を登録し、画像番号を返す。
+ */
+GLint TextureAtlas_addImage(TextureAtlas *atlas, GLApplication *app, const GLchar *name, RawPixelImage *image) {
+    assert(image);
+    assert(image->format == TEXTURE_RAW_RGBA8);
+    assert(!atlas->pages_num);
+
+    GLint result = TextureAtlas_find(atlas, name);
+    if (result >= 0) {
+        RawPixelImage_free(app, image);
+        return result;
+    }
+
+    // 名前が異なっても内容が同じであれば共有する
+    const GLuint hash = TextureAtlas_hashImage(image);
+    GLuint i = 0;
+    for (i = 0; i < atlas->regions_num; ++i) {
+        const TextureAtlasRegion *region = &atlas->regions[i];
+        if (region->hash != hash || region->width != image->width || region->height != image->height) {
+            continue;
+        }
+        if (!memcmp(region->image->pixel_data, image->pixel_data, image->width * image->height * 4)) {
+            TextureAtlas_addEntry(atlas, name, (GLint) i);
+            RawPixelImage_free(app, image);
+            return (GLint) i;
+        }
+    }
+
+    atlas->regions = realloc(atlas->regions, sizeof(TextureAtlasRegion) * (atlas->regions_num + 1));
+    TextureAtlasRegion *region = &atlas->regions[atlas->regions_num];
+    memset(region, 0, sizeof(TextureAtlasRegion));
+    region->image = image;
+    region->hash = hash;
+    region->page = -1;
+    region->width = image->width;
+    region->height = image->height;
+    region->uv_scale = vec2_create(1, 1);
+
+    // 余白込みでページに収まらなければ専用ページとする
+    region->standalone = (image->width + atlas->padding * 2 > atlas->page_width) || (image->height + atlas->padding * 2 > atlas->page_height);
+
+    result = atlas->regions_num++;
+    TextureAtlas_addEntry(atlas, name, result);
+    return result;
+}
+
+/**
+ * 画像ファイルを読み込んで登録し、画像番号を返す。
+ */
+GLint TextureAtlas_loadImage(TextureAtlas *atlas, GLApplication *app, const GLchar *file_name) {
+    return TextureAtlas_loadNamedImage(atlas, app, file_name, file_name);
+}
+
+/**
+ * PMDの材質が参照するテクスチャを登録する。
+ */
+void TextureAtlas_addPmd(TextureAtlas *atlas, GLApplication *app, PmdFile *pmd) {
+    // 読み込み時の一時ファイル名
+    GLchar load_name[sizeof(((PmdMaterial*) NULL)->diffuse_texture_name) + 8] = { };
+
+    // 頂点ごとに最初に参照した画像番号 + 1
+    GLint *owners = calloc(pmd->vertices_num, sizeof(GLint));
+
+    GLuint m = 0;
+    GLuint i = 0;
+    for (m = 0; m < pmd->materials_num; ++m) {
+        const PmdMaterial *material = &pmd->materials[m];
+        if (!strlen(material->diffuse_texture_name)) {
+            continue;
+        }
+
+        sprintf(load_name, "%s.png", material->diffuse_texture_name);
+        const GLint region = TextureAtlas_loadNamedImage(atlas, app, material->diffuse_texture_name, load_name);
+        if (region < 0) {
+            continue;
+        }
+
+        const PmdDrawRange *range = &pmd->draw_ranges[m];
+        for (i = 0; i < range->indices_num; ++i) {
+            const GLuint index = PmdFile_getIndex(pmd, range->indices_begin + i);
+            const vec2 uv = pmd->vertices[index].uv;
+
+            // CLAMP_TO_EDGEの外側を参照する材質はページ内へ置けない
+            if (uv.x < -TEXTUREATLAS_UV_EPSILON || uv.x > 1.0f + TEXTUREATLAS_UV_EPSILON || uv.y < -TEXTUREATLAS_UV_EPSILON || uv.y > 1.0f + TEXTUREATLAS_UV_EPSILON) {
+                atlas->regions[region].standalone = true;
+            }
+
+            // 異なる画像の材質と共有する頂点は、どちらのUVへも書き換えられない
+            if (!owners[index]) {
+                owners[index] = region + 1;
+            } else if (owners[index] != region + 1) {
+                atlas->regions[region].standalone = true;
+                atlas->regions[owners[index] - 1].standalone = true;
+            }
+        }
+    }
+
+    free(owners);
+}
+
+/**
+ * 登録された画像をページへ詰め込み、テクスチャを生成する。
+ */
+GLuint TextureAtlas_build(TextureAtlas *atlas, GLApplication *app) {
+    assert(!atlas->pages_num);
+
+    const GLint padding = atlas->padding;
+    GLuint i = 0;
+    GLuint p = 0;
+
+    // 専用ページの画像はそのままテクスチャにする
+    for (i = 0; i < atlas->regions_num; ++i) {
+        TextureAtlasRegion *region = &atlas->regions[i];
+        if (!region->standalone) {
+            continue;
+        }
+
+        Texture *texture = TextureAtlas_createTexture(region->width, region->height, region->image->pixel_data);
+        if (!texture) {
+            // 生成できなかった画像は差し替えの対象外とする
+            region->page = -1;
+            continue;
+        }
+
+        region->page = TextureAtlas_addPage(atlas, texture);
+        region->x = 0;
+        region->y = 0;
+        region->uv_offset = vec2_create(0, 0);
+        region->uv_scale = vec2_create(1, 1);
+    }
+
+    // 残りの画像を高い順に並べる
+    GLuint *order = malloc(sizeof(GLuint) * (atlas->regions_num ? atlas->regions_num : 1));
+    GLuint order_num = 0;
+    for (i = 0; i < atlas->regions_num; ++i) {
+        if (!atlas->regions[i].standalone) {
+            order[order_num++] = i;
+        }
+    }
+    g_sort_regions = atlas->regions;
+    qsort(order, order_num, sizeof(GLuint), TextureAtlas_compare);
+    g_sort_regions = NULL;
+
+    // 入るページを先頭から探し、どこにも入らなければページを増やす
+    TextureAtlasPacker *packers = NULL;
+    GLuint packers_num = 0;
+    for (i = 0; i < order_num; ++i) {
+        TextureAtlasRegion *region = &atlas->regions[order[i]];
+        const GLint width = region->width + padding * 2;
+        const GLint height = region->height + padding * 2;
+        GLint x = 0;
+        GLint y = 0;
+
+        for (p = 0; p < packers_num; ++p) {
+            if (TextureAtlasPacker_pack(&packers[p], width, height, atlas->page_width, atlas->page_height, &x, &y)) {
+                break;
+            }
+        }
+
+        if (p == packers_num) {
+            packers = realloc(packers, sizeof(TextureAtlasPacker) * (packers_num + 1));
+            TextureAtlasPacker *packer = &packers[packers_num++];
+            packer->skyline = malloc(sizeof(TextureAtlasSkyline) * (atlas->page_width + 1));
+            packer->skyline[0].x = 0;
+            packer->skyline[0].y = 0;
+            packer->skyline[0].width = atlas->page_width;
+            packer->skyline_num = 1;
+            packer->pixels = calloc(atlas->page_width * atlas->page_height, 4);
+
+            const bool packed = TextureAtlasPacker_pack(packer, width, height, atlas->page_width, atlas->page_height, &x, &y);
+            assert(packed);
+        }
+
+        region->page = (GLint) p;
+        region->x = x + padding;
+        region->y = y + padding;
+        TextureAtlas_blit(atlas, region, packers[p].pixels);
+    }
+
+    // 使用した高さまでページを縮めて転送する
+    const GLint pages_begin = atlas->pages_num;
+    for (p = 0; p < packers_num; ++p) {
+        TextureAtlasPacker *packer = &packers[p];
+        GLint used = 1;
+        GLint height = 1;
+        GLint s = 0;
+
+        for (s = 0; s < packer->skyline_num; ++s) {
+            used = packer->skyline[s].y > used ? packer->skyline[s].y : used;
+        }
+        while (height < used) {
+            height <<= 1;
+        }
+
+        // 行は連続しているため、先頭から必要な行数だけ転送すれば良い
+        // 生成できなかった場合もページ番号を保つためNULLのまま追加する
+        TextureAtlas_addPage(atlas, TextureAtlas_createTexture(atlas->page_width, height, packer->pixels));
+
+        free(packer->skyline);
+        free(packer->pixels);
+    }
+    free(packers);
+
+    // ページが確定したのでUVの変換を求める
+    for (i = 0; i < order_num; ++i) {
+        TextureAtlasRegion *region = &atlas->regions[order[i]];
+        const Texture *page = atlas->pages[pages_begin + region->page];
+        if (!page) {
+            // 生成できなかったページの画像は差し替えの対象外とする
+            region->page = -1;
+            continue;
+        }
+
+        region->page += pages_begin;
+        region->uv_offset = vec2_create((GLfloat) region->x / (GLfloat) page->width, (GLfloat) region->y / (GLfloat) page->height);
+        region->uv_scale = vec2_create((GLfloat) region->width / (GLfloat) page->width, (GLfloat) region->height / (GLfloat) page->height);
+    }
+    free(order);
+
+    // 元画像は不要になる
+    for (i = 0; i < atlas->regions_num; ++i) {
+        RawPixelImage_free(app, atlas->regions[i].image);
+        atlas->regions[i].image = NULL;
+    }
+
+    return atlas->pages_num;
+}
+
+/**
+ * 指定した名前の画像番号を取得する。
+ */
+GLint TextureAtlas_find(TextureAtlas *atlas, const GLchar *name) {
+    if (!name[0]) {
+        return -1;
+    }
+
+    GLuint i = 0;
+    for (i = 0; i < atlas->entries_num; ++i) {
+        if (strcmp(atlas->entries[i].name, name) == 0) {
+            return atlas->entries[i].region;
+        }
+    }
+    return -1;
+}
+
+/**
+ * 画像番号のページテクスチャを取得する。
+ */
+Texture* TextureAtlas_getPage(TextureAtlas *atlas, const GLint region) {
+    assert(region >= 0 && region < (GLint) atlas->regions_num);
+    if (atlas->regions[region].page < 0) {
+        return NULL;
+    }
+    return atlas->pages[atlas->regions[region].page];
+}
+
+/**
+ * 画像のUVをページのUVへ変換する。
+ */
+vec2 TextureAtlas_mapUv(const TextureAtlas *atlas, const GLint region, const vec2 uv) {
+    const TextureAtlasRegion *r = &atlas->regions[region];
+    return vec2_create(uv.x * r->uv_scale.x + r->uv_offset.x, uv.y * r->uv_scale.y + r->uv_offset.y);
+}
+
+/**
+ * PMDの材質テクスチャをページへ差し替え、UVを書き換える。
+ */
+GLuint TextureAtlas_bindPmd(TextureAtlas *atlas, PmdFile *pmd) {
+    // 頂点は複数の材質から参照されるため、書き換え済みかを記録する
+    bool *remapped = calloc(pmd->vertices_num, sizeof(bool));
+    GLuint result = 0;
+    GLuint m = 0;
+    GLuint i = 0;
+
+    for (m = 0; m < pmd->materials_num; ++m) {
+        const GLint region = TextureAtlas_find(atlas, pmd->materials[m].diffuse_texture_name);
+        if (region < 0 || atlas->regions[region].page < 0) {
+            continue;
+        }
+
+        pmd->diffuse_textures[m] = TextureAtlas_getPage(atlas, region);
+        ++result;
+
+        // 専用ページであればUVはそのまま使える
+        if (atlas->regions[region].standalone) {
+            continue;
+        }
+
+        const PmdDrawRange *range = &pmd->draw_ranges[m];
+        for (i = 0; i < range->indices_num; ++i) {
+            const GLuint index = PmdFile_getIndex(pmd, range->indices_begin + i);
+            if (remapped[index]) {
+                continue;
+            }
+
+            PmdVertex *v = &pmd->vertices[index];
+            v->uv = TextureAtlas_mapUv(atlas, region, v->uv);
+            remapped[index] = true;
+        }
+    }
+
+    free(remapped);
+    return result;
+}
+
+/**
+ * アトラスを解放する
+ */
+void TextureAtlas_free(TextureAtlas *atlas, GLApplication *app) {
+    if (!atlas) {
+        return;
+    }
+
+    GLuint i = 0;
+    for (i = 0; i < atlas->pages_num; ++i) {
+        Texture_free(atlas->pages[i]);
+    }
+    for (i = 0; i < atlas->regions_num; ++i) {
+        RawPixelImage_free(app, atlas->regions[i].image);
+    }
+    for (i = 0; i < atlas->entries_num; ++i) {
+        free(atlas->entries[i].name);
+    }
+
+    free(atlas->pages);
+    free(atlas->regions);
+    free(atlas->entries);
+    free(atlas);
+}
@@ -0,0 +1,174 @@
+/*
+ * support_gl_TextureAtlas.h
+ *
+ * 実行時のテクスチャアトラス
+ * 読み込み時に小さな画像をskyline法で共有ページへ詰め込み、
+ * PMDの材質ごとのUVをページ上の範囲へ書き換える。
+ * 材質ごとのテクスチャ切り替えが減り、材質をまたいだ描画のまとめが行えるようになる。
+ */
+
+#ifndef SUPPORT_GL_TEXTUREATLAS_H_
+#define SUPPORT_GL_TEXTUREATLAS_H_
+
+/**
+ * UVが0.0〜1.0からはみ出していると判断する誤差
+ */
+#define TEXTUREATLAS_UV_EPSILON     0.001f
+
+/**
+ * アトラスへ登録された画像
+ */
+typedef struct TextureAtlasRegion {
+    /**
+     * 登録された画像
+     * TEXTURE_RAW_RGBA8のみ扱う。TextureAtlas_build()で解放される。
+     */
+    RawPixelImage *image;
+
+    /**
+     * 画像内容のハッシュ値
+     * 名前の異なる同一画像を見つけるために使う
+     */
+    GLuint hash;
+
+    /**
+     * 専用ページを割り当てる場合true
+     * ページに収まらない画像や、UVが範囲外を参照する材質の画像が該当する
+     */
+    bool standalone;
+
+    /**
+     * 配置先のページ番号
+     * ページのテクスチャを確保できなかった場合は-1となる。
+     */
+    GLint page;
+
+    /**
+     * ページ内の配置位置（ピクセル、余白を含まない）
+     */
+    GLint x;
+    GLint y;
+    GLint width;
+    GLint height;
+
+    /**
+     * 画像のUVからページのUVへの変換
+     * page_uv = uv * uv_scale + uv_offset
+     */
+    vec2 uv_offset;
+    vec2 uv_scale;
+} TextureAtlasRegion;
+
+/**
+ * 画像名と画像の対応
+ */
+typedef struct TextureAtlasEntry {
+    /**
+     * 画像名
+     */
+    GLchar *name;
+
+    /**
+     * 対応する画像番号
+     */
+    GLint region;
+} TextureAtlasEntry;
+
+/**
+ * テクスチャアトラス
+ */
+typedef struct TextureAtlas {
+    /**
+     * 1ページの最大サイズ
+     */
+    GLint page_width;
+    GLint page_height;
+
+    /**
+     * 画像の周囲に確保する余白（ピクセル）
+     * 余白は画像の端のピクセルで埋め、フィルタリング時のにじみを防ぐ
+     */
+    GLint padding;
+
+    /**
+     * 登録された画像
+     */
+    TextureAtlasRegion *regions;
+    GLuint regions_num;
+
+    /**
+     * 画像名の一覧
+     */
+    TextureAtlasEntry *entries;
+    GLuint entries_num;
+
+    /**
+     * 構築されたページ
+     */
+    Texture **pages;
+    GLuint pages_num;
+} TextureAtlas;
+
+/**
+ * 空のアトラスを生成する。
+ * ページサイズは2のn乗を指定する。
+ */
+extern TextureAtlas* TextureAtlas_create(const GLint page_width, const GLint page_height, const GLint padding);
+
+/**
+ * 画像を登録し、画像番号を返す。
+ * imageの所有権はアトラスへ移る。同じ名前や同じ内容の画像が登録済みの場合はそちらを返し、imageを解放する。
+ */
+extern GLint TextureAtlas_addImage(TextureAtlas *atlas, GLApplication *app, const GLchar *name, RawPixelImage *image);
+
+/**
+ * 画像ファイルを読み込んで登録し、画像番号を返す。
+ * 登録済みの名前であれば読み込まない。読み込みに失敗した場合は-1を返す。
+ */
+extern GLint TextureAtlas_loadImage(TextureAtlas *atlas, GLApplication *app, const GLchar *file_name);
+
+/**
+ * PMDの材質が参照するテクスチャを登録する。
+ * ファイル名の規則はPmdFile_createTextureList()と同じとなる。
+ * UVが範囲外を参照する材質や、異なるテクスチャの材質と頂点を共有する材質の画像は専用ページとする。
+ */
+extern void TextureAtlas_addPmd(TextureAtlas *atlas, GLApplication *app, PmdFile *pmd);
+
+/**
+ * 登録された画像をページへ詰め込み、テクスチャを生成する。
+ * 生成したページ数を返す。
+ * テクスチャのプールが埋まっている場合、確保できなかったページはNULLとなり、その画像は差し替えの対象外となる。
+ */
+extern GLuint TextureAtlas_build(TextureAtlas *atlas, GLApplication *app);
+
+/**
+ * 指定した名前の画像番号を取得する。
+ * 見つからない場合は-1を返す。
+ */
+extern GLint TextureAtlas_find(TextureAtlas *atlas, const GLchar *name);
+
+/**
+ * 画像番号のページテクスチャを取得する。
+ * ページが無い場合はNULLを返す。
+ */
+extern Texture* TextureAtlas_getPage(TextureAtlas *atlas, const GLint region);
+
+/**
+ * 画像のUVをページのUVへ変換する。
+ */
+extern vec2 TextureAtlas_mapUv(const TextureAtlas *atlas, const GLint region, const vec2 uv);
+
+/**
+ * PMDの材質テクスチャをページへ差し替え、材質の描画範囲が参照する頂点のUVを書き換える。
+ * TextureAtlas_build()の後、頂点バッファを作る前に1度だけ呼び出す。
+ * 差し替えた材質数を返す。
+ */
+extern GLuint TextureAtlas_bindPmd(TextureAtlas *atlas, PmdFile *pmd);
+
+/**
+ * アトラスを解放する
+ * ページテクスチャも解放されるため、以後はTextureAtlas_bindPmd()したPMDのdiffuse_texturesを参照しない。
+ */
+extern void TextureAtlas_free(TextureAtlas *atlas, GLApplication *app);
+
+#endif /* SUPPORT_GL_TEXTUREATLAS_H_ */
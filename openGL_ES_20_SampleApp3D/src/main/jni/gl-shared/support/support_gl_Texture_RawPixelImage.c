@@ -151,7 +151,13 @@ Texture* RawPixelImage_loadTexture(GLApplication *app, const char* file_name, co
         return NULL;
     }
 
-    Texture *texture = (Texture*) malloc(sizeof(Texture));
+    Texture *texture = Texture_alloc();
+
+    // プールが埋まっている場合は読み込み失敗として扱う
+    if (!texture) {
+        RawPixelImage_free(app, image);
+        return NULL;
+    }
 
     {
         // 元画像から必要情報をコピーする
@@ -0,0 +1,223 @@
+/*
+ * support_gl_Transform.c
+ */
+
+#include    "support.h"
+
+/**
+ * 並列処理へ渡す情報
+ */
+typedef struct TransformTask {
+    TransformList *list;
+    const mat4 *view_projection;
+} TransformTask;
+
+/**
+ * SoA配列を指定の件数で確保し直す
+ */
+static void TransformList_reserve(TransformList *list, GLuint capacity) {
+    capacity = (capacity + 3) & ~3;
+    if (capacity <= list->capacity) {
+        return;
+    }
+
+    // 全ての配列を1ブロックで確保する
+    // position_xがブロックの先頭になる
+    GLfloat *old = list->position_x;
+    GLfloat *block = util_alignedAlloc(SIMD4F_ALIGNMENT, sizeof(GLfloat) * capacity * TRANSFORMLIST_ARRAYS);
+    GLfloat **arrays[TRANSFORMLIST_ARRAYS] = { //
+            &list->position_x, &list->position_y, &list->position_z, //
+                    &list->rotation_x, &list->rotation_y, &list->rotation_z, &list->rotation_w, //
+                    &list->scale_x, &list->scale_y, &list->scale_z };
+
+    // 4件に満たない端数も計算されるため、未登録の要素は0で埋めておく
+    memset(block, 0, sizeof(GLfloat) * capacity * TRANSFORMLIST_ARRAYS);
+
+    int i = 0;
+    for (i = 0; i < TRANSFORMLIST_ARRAYS; ++i) {
+        GLfloat *array = block + capacity * i;
+        if (list->num) {
+            memcpy(array, *arrays[i], sizeof(GLfloat) * list->num);
+        }
+        *arrays[i] = array;
+    }
+    util_alignedFree(old);
+
+    {
+        affine *worlds = util_alignedAlloc(SIMD4F_ALIGNMENT, sizeof(affine) * capacity);
+        mat4 *wvps = util_alignedAlloc(SIMD4F_ALIGNMENT, sizeof(mat4) * capacity);
+        if (list->num) {
+            memcpy(worlds, list->worlds, sizeof(affine) * list->num);
+            memcpy(wvps, list->wvps, sizeof(mat4) * list->num);
+        }
+        util_alignedFree(list->worlds);
+        util_alignedFree(list->wvps);
+        list->worlds = worlds;
+        list->wvps = wvps;
+    }
+
+    list->capacity = capacity;
+}
+
+/**
+ * [begin, end)の要素を4件ずつ計算する
+ */
+static void TransformList_calcRange(void *userdata, const unsigned int begin, const unsigned int end) {
+    const TransformTask *task = (const TransformTask*) userdata;
+    TransformList *list = task->list;
+    const mat4 *vp = task->view_projection;
+
+    // ワールド行列の要素を4件分ずつ書き出す
+    // w[row * 4 + column][instance]
+    GLfloat w[12][4] __attribute__((aligned(SIMD4F_ALIGNMENT)));
+
+    simd4f vp0 = simd4f_splat(0);
+    simd4f vp1 = simd4f_splat(0);
+    simd4f vp2 = simd4f_splat(0);
+    simd4f vp3 = simd4f_splat(0);
+    // 呼び出し元の行列は境界が揃っているとは限らない
+    if (vp) {
+        vp0 = simd4f_loadu(vp->m[0]);
+        vp1 = simd4f_loadu(vp->m[1]);
+        vp2 = simd4f_loadu(vp->m[2]);
+        vp3 = simd4f_loadu(vp->m[3]);
+    }
+
+    const simd4f one = simd4f_splat(1.0f);
+    const simd4f two = simd4f_splat(2.0f);
+
+    unsigned int i = 0;
+    int k = 0;
+    for (i = begin; i < end; i += 4) {
+        const simd4f qx = simd4f_load(list->rotation_x + i);
+        const simd4f qy = simd4f_load(list->rotation_y + i);
+        const simd4f qz = simd4f_load(list->rotation_z + i);
+        const simd4f qw = simd4f_load(list->rotation_w + i);
+        const simd4f sx = simd4f_load(list->scale_x + i);
+        const simd4f sy = simd4f_load(list->scale_y + i);
+        const simd4f sz = simd4f_load(list->scale_z + i);
+
+        // クォータニオンから回転行列を求め、列ごとに拡縮を掛ける
+        {
+            const simd4f x2 = simd4f_mul(qx, two);
+            const simd4f y2 = simd4f_mul(qy, two);
+            const simd4f z2 = simd4f_mul(qz, two);
+            const simd4f xx = simd4f_mul(qx, x2);
+            const simd4f yy = simd4f_mul(qy, y2);
+            const simd4f zz = simd4f_mul(qz, z2);
+            const simd4f xy = simd4f_mul(qx, y2);
+            const simd4f xz = simd4f_mul(qx, z2);
+            const simd4f yz = simd4f_mul(qy, z2);
+            const simd4f wx = simd4f_mul(qw, x2);
+            const simd4f wy = simd4f_mul(qw, y2);
+            const simd4f wz = simd4f_mul(qw, z2);
+
+            simd4f_store(w[0], simd4f_mul(simd4f_sub(one, simd4f_add(yy, zz)), sx));
+            simd4f_store(w[1], simd4f_mul(simd4f_sub(xy, wz), sy));
+            simd4f_store(w[2], simd4f_mul(simd4f_add(xz, wy), sz));
+            simd4f_store(w[3], simd4f_load(list->position_x + i));
+
+            simd4f_store(w[4], simd4f_mul(simd4f_add(xy, wz), sx));
+            simd4f_store(w[5], simd4f_mul(simd4f_sub(one, simd4f_add(xx, zz)), sy));
+            simd4f_store(w[6], simd4f_mul(simd4f_sub(yz, wx), sz));
+            simd4f_store(w[7], simd4f_load(list->position_y + i));
+
+            simd4f_store(w[8], simd4f_mul(simd4f_sub(xz, wy), sx));
+            simd4f_store(w[9], simd4f_mul(simd4f_add(yz, wx), sy));
+            simd4f_store(w[10], simd4f_mul(simd4f_sub(one, simd4f_add(xx, yy)), sz));
+            simd4f_store(w[11], simd4f_load(list->position_z + i));
+        }
+
+        for (k = 0; k < 4 && i + k < list->num; ++k) {
+            affine *world = &list->worlds[i + k];
+            int e = 0;
+            for (e = 0; e < 12; ++e) {
+                world->m[e / 4][e % 4] = w[e][k];
+            }
+
+            if (!vp) {
+                continue;
+            }
+
+            // WVP = VP × World
+            // Worldの最終行は(0, 0, 0, 1)のため、VPの第4列は移動にのみ掛かる
+            mat4 *wvp = &list->wvps[i + k];
+            simd4f_store(wvp->m[0], simd4f_madd(vp0, simd4f_splat(w[0][k]), simd4f_madd(vp1, simd4f_splat(w[4][k]), simd4f_mul(vp2, simd4f_splat(w[8][k])))));
+            simd4f_store(wvp->m[1], simd4f_madd(vp0, simd4f_splat(w[1][k]), simd4f_madd(vp1, simd4f_splat(w[5][k]), simd4f_mul(vp2, simd4f_splat(w[9][k])))));
+            simd4f_store(wvp->m[2], simd4f_madd(vp0, simd4f_splat(w[2][k]), simd4f_madd(vp1, simd4f_splat(w[6][k]), simd4f_mul(vp2, simd4f_splat(w[10][k])))));
+            simd4f_store(wvp->m[3], simd4f_madd(vp0, simd4f_splat(w[3][k]), simd4f_madd(vp1, simd4f_splat(w[7][k]), simd4f_madd(vp2, simd4f_splat(w[11][k]), vp3))));
+        }
+    }
+}
+
+/**
+ * TRS配列を生成する
+ */
+TransformList* TransformList_create(const GLuint capacity) {
+    TransformList *result = calloc(1, sizeof(TransformList));
+    TransformList_reserve(result, capacity ? capacity : 4);
+    return result;
+}
+
+/**
+ * 登録を全て破棄する
+ */
+void TransformList_clear(TransformList *list) {
+    list->num = 0;
+}
+
+/**
+ * TRSを登録する。
+ */
+GLuint TransformList_add(TransformList *list, const vec3 position, const quat rotation, const vec3 scale) {
+    if (list->num == list->capacity) {
+        TransformList_reserve(list, list->capacity * 2);
+    }
+
+    const GLuint index = list->num++;
+    TransformList_set(list, index, position, rotation, scale);
+    return index;
+}
+
+/**
+ * 登録済みのTRSを書き換える。
+ */
+void TransformList_set(TransformList *list, const GLuint index, const vec3 position, const quat rotation, const vec3 scale) {
+    assert(index < list->num);
+
+    list->position_x[index] = position.x;
+    list->position_y[index] = position.y;
+    list->position_z[index] = position.z;
+    list->rotation_x[index] = rotation.x;
+    list->rotation_y[index] = rotation.y;
+    list->rotation_z[index] = rotation.z;
+    list->rotation_w[index] = rotation.w;
+    list->scale_x[index] = scale.x;
+    list->scale_y[index] = scale.y;
+    list->scale_z[index] = scale.z;
+}
+
+/**
+ * 全要素のワールド行列とWVP行列を計算する。
+ */
+void TransformList_calc(TransformList *list, const mat4 *view_projection, ThreadPool *pool) {
+    TransformTask task = { list, view_projection };
+
+    // 4件単位で計算する
+    const GLuint count = (list->num + 3) & ~3;
+    ThreadPool_parallelFor(pool, count, TRANSFORMLIST_CHUNK, TransformList_calcRange, &task);
+}
+
+/**
+ * TRS配列を解放する
+ */
+void TransformList_free(TransformList *list) {
+    if (!list) {
+        return;
+    }
+
+    util_alignedFree(list->position_x);
+    util_alignedFree(list->worlds);
+    util_alignedFree(list->wvps);
+    free(list);
+}
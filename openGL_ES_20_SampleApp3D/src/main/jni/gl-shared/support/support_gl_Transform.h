@@ -0,0 +1,103 @@
+/*
+ * support_gl_Transform.h
+ *
+ * 位置・回転・拡縮(TRS)からのワールド行列とWVP行列の一括生成
+ * インスタンスごとにmat4_translate / mat4_rotate / mat4_multiplyを呼ぶ代わりに、
+ * SoA配列から4件ずつSIMDでアフィン行列を求め、ビュープロジェクション行列を掛ける。
+ */
+
+#ifndef SUPPORT_GL_TRANSFORM_H_
+#define SUPPORT_GL_TRANSFORM_H_
+
+/**
+ * SoA配列の数
+ */
+#define TRANSFORMLIST_ARRAYS    10
+
+/**
+ * 並列処理時に1タスクで処理する件数
+ */
+#define TRANSFORMLIST_CHUNK     256
+
+/**
+ * 一括変換するTRSの配列
+ * SIMDで4件ずつ処理できるよう、要素ごとの配列(SoA)として保持する。
+ */
+typedef struct TransformList {
+    /**
+     * 位置
+     */
+    GLfloat *position_x;
+    GLfloat *position_y;
+    GLfloat *position_z;
+
+    /**
+     * 回転（単位クォータニオン）
+     */
+    GLfloat *rotation_x;
+    GLfloat *rotation_y;
+    GLfloat *rotation_z;
+    GLfloat *rotation_w;
+
+    /**
+     * 拡縮
+     */
+    GLfloat *scale_x;
+    GLfloat *scale_y;
+    GLfloat *scale_z;
+
+    /**
+     * 計算結果のワールド行列
+     */
+    affine *worlds;
+
+    /**
+     * 計算結果のWVP行列
+     */
+    mat4 *wvps;
+
+    /**
+     * 登録されている件数
+     */
+    GLuint num;
+
+    /**
+     * 登録できる件数
+     */
+    GLuint capacity;
+} TransformList;
+
+/**
+ * TRS配列を生成する
+ */
+extern TransformList* TransformList_create(const GLuint capacity);
+
+/**
+ * 登録を全て破棄する
+ */
+extern void TransformList_clear(TransformList *list);
+
+/**
+ * TRSを登録する。
+ * 登録した要素番号を返す。
+ */
+extern GLuint TransformList_add(TransformList *list, const vec3 position, const quat rotation, const vec3 scale);
+
+/**
+ * 登録済みのTRSを書き換える。
+ */
+extern void TransformList_set(TransformList *list, const GLuint index, const vec3 position, const quat rotation, const vec3 scale);
+
+/**
+ * 全要素のワールド行列とWVP行列を計算する。
+ * view_projectionがNULLの場合はワールド行列のみ計算する。
+ * poolを指定した場合はTRANSFORMLIST_CHUNK件ずつ並列で処理する。
+ */
+extern void TransformList_calc(TransformList *list, const mat4 *view_projection, ThreadPool *pool);
+
+/**
+ * TRS配列を解放する
+ */
+extern void TransformList_free(TransformList *list);
+
+#endif /* SUPPORT_GL_TRANSFORM_H_ */
@@ -25,15 +25,16 @@ vec3 vec3_create(const GLfloat x, const GLfloat y, const GLfloat z) {
  * 3次元ベクトルの長さを取得する
  */
 GLfloat vec3_length(const vec3 v) {
-    return (GLfloat) sqrt(((double) v.x * (double) v.x) + ((double) v.y * (double) v.y) + ((double) v.z * (double) v.z));
+    // doubleへの変換を行わず、単精度のまま計算する
+    return sqrtf((v.x * v.x) + (v.y * v.y) + (v.z * v.z));
 }
 
 /**
  * 3次元ベクトルを正規化する
  */
 vec3 vec3_normalize(const vec3 v) {
-    const GLfloat len = vec3_length(v);
-    return vec3_create(v.x / len, v.y / len, v.z / len);
+    const GLfloat inv = fastmath_rsqrt((v.x * v.x) + (v.y * v.y) + (v.z * v.z));
+    return vec3_create(v.x * inv, v.y * inv, v.z * inv);
 }
 
 /**
@@ -115,8 +116,9 @@ mat4 mat4_rotate(const vec3 axis, const GLfloat rotate) {
     const GLfloat y = axis.y;
     const GLfloat z = axis.z;
 
-    const GLfloat c = cos(degree2radian(rotate));
-    const GLfloat s = sin(degree2radian(rotate));
+    GLfloat c;
+    GLfloat s;
+    fastmath_sincos(degree2radianf(rotate), &s, &c);
     {
         result.m[0][0] = (x * x) * (1.0f - c) + c;
         result.m[0][1] = (x * y) * (1.0f - c) - z * s;
@@ -151,6 +153,37 @@ mat4 mat4_rotate(const vec3 axis, const GLfloat rotate) {
  */
 mat4 mat4_multiply(const mat4 a, const mat4 b) {
     mat4 result;
+    mat4_multiply_to(&result, &a, &b);
+    return result;
+}
+
+/**
+ * 行列A×行列Bを行い、resultへ書き込む。
+ * 結果の列iは、Aの各列をBの列iの要素で重み付けした和となる。
+ */
+void mat4_multiply_to(mat4 *result, const mat4 *a, const mat4 *b) {
+    // 先にAの全列を読み込むため、resultがA / Bと重なっていても良い
+    const simd4f a0 = simd4f_loadu(a->m[0]);
+    const simd4f a1 = simd4f_loadu(a->m[1]);
+    const simd4f a2 = simd4f_loadu(a->m[2]);
+    const simd4f a3 = simd4f_loadu(a->m[3]);
+
+    int i = 0;
+    for (i = 0; i < 4; ++i) {
+        const GLfloat *column = b->m[i];
+        simd4f r = simd4f_mul(a0, simd4f_splat(column[0]));
+        r = simd4f_madd(a1, simd4f_splat(column[1]), r);
+        r = simd4f_madd(a2, simd4f_splat(column[2]), r);
+        r = simd4f_madd(a3, simd4f_splat(column[3]), r);
+        simd4f_storeu(result->m[i], r);
+    }
+}
+
+/**
+ * 行列A×行列Bをスカラー演算で行う。
+ */
+mat4 mat4_multiplyReference(const mat4 a, const mat4 b) {
+    mat4 result;
 
     int i = 0;
     for (i = 0; i < 4; ++i) {
@@ -163,6 +196,533 @@ mat4 mat4_multiply(const mat4 a, const mat4 b) {
     return result;
 }
 
+/**
+ * 位置ベクトルを行列で変換する
+ */
+vec3 mat4_transformPoint(const mat4 m, const vec3 p) {
+    vec3 result;
+    result.x = m.m[0][0] * p.x + m.m[1][0] * p.y + m.m[2][0] * p.z + m.m[3][0];
+    result.y = m.m[0][1] * p.x + m.m[1][1] * p.y + m.m[2][1] * p.z + m.m[3][1];
+    result.z = m.m[0][2] * p.x + m.m[1][2] * p.y + m.m[2][2] * p.z + m.m[3][2];
+    return result;
+}
+
+/**
+ * アフィン変換行列を4x4行列へ変換する
+ */
+mat4 mat4_fromAffine(const affine *a) {
+    mat4 result;
+
+    int column = 0;
+    int row = 0;
+    for (column = 0; column < 4; ++column) {
+        for (row = 0; row < 3; ++row) {
+            result.m[column][row] = a->m[row][column];
+        }
+        result.m[column][3] = column == 3 ? 1.0f : 0.0f;
+    }
+
+    return result;
+}
+
+/**
+ * 位置・回転・拡縮からアフィン変換行列を生成する
+ */
+affine affine_create(const vec3 position, const quat rotation, const vec3 scale) {
+    affine result;
+
+    // TransformListと同じく、クォータニオンから回転行列を求めて列ごとに拡縮を掛ける
+    const GLfloat x2 = rotation.x * 2.0f;
+    const GLfloat y2 = rotation.y * 2.0f;
+    const GLfloat z2 = rotation.z * 2.0f;
+    const GLfloat xx = rotation.x * x2;
+    const GLfloat yy = rotation.y * y2;
+    const GLfloat zz = rotation.z * z2;
+    const GLfloat xy = rotation.x * y2;
+    const GLfloat xz = rotation.x * z2;
+    const GLfloat yz = rotation.y * z2;
+    const GLfloat wx = rotation.w * x2;
+    const GLfloat wy = rotation.w * y2;
+    const GLfloat wz = rotation.w * z2;
+
+    result.m[0][0] = (1.0f - (yy + zz)) * scale.x;
+    result.m[0][1] = (xy - wz) * scale.y;
+    result.m[0][2] = (xz + wy) * scale.z;
+    result.m[0][3] = position.x;
+
+    result.m[1][0] = (xy + wz) * scale.x;
+    result.m[1][1] = (1.0f - (xx + zz)) * scale.y;
+    result.m[1][2] = (yz - wx) * scale.z;
+    result.m[1][3] = position.y;
+
+    result.m[2][0] = (xz - wy) * scale.x;
+    result.m[2][1] = (yz + wx) * scale.y;
+    result.m[2][2] = (1.0f - (xx + yy)) * scale.z;
+    result.m[2][3] = position.z;
+
+    return result;
+}
+
+/**
+ * アフィン変換行列の積a × bを計算し、resultへ書き込む
+ * 各行はaの行の要素でbの行を重み付けして加算する。
+ */
+void affine_multiply_to(affine *result, const affine *a, const affine *b) {
+    const simd4f b0 = simd4f_loadu(b->m[0]);
+    const simd4f b1 = simd4f_loadu(b->m[1]);
+    const simd4f b2 = simd4f_loadu(b->m[2]);
+
+    // bの最終行(0, 0, 0, 1)は、aの移動成分にのみ掛かる
+    const simd4f translate = simd4f_set(0, 0, 0, 1);
+
+    simd4f rows[3];
+    int i = 0;
+    for (i = 0; i < 3; ++i) {
+        const GLfloat *row = a->m[i];
+        rows[i] = simd4f_madd(b0, simd4f_splat(row[0]), simd4f_madd(b1, simd4f_splat(row[1]), simd4f_madd(b2, simd4f_splat(row[2]), simd4f_mul(translate, simd4f_splat(row[3])))));
+    }
+
+    // resultがa / bと同じでも良いよう、最後に書き込む
+    for (i = 0; i < 3; ++i) {
+        simd4f_storeu(result->m[i], rows[i]);
+    }
+}
+
+/**
+ * 回転クォータニオンを生成する
+ */
+quat quat_rotate(const vec3 axis, const GLfloat rotate) {
+    // mat4_rotate()は右手系の回転と逆向きになるため、角度を反転する
+    GLfloat s;
+    GLfloat c;
+    fastmath_sincos(-degree2radianf(rotate) * 0.5f, &s, &c);
+
+    quat result = { axis.x * s, axis.y * s, axis.z * s, c };
+    return result;
+}
+
+/**
+ * 転置行列を生成する
+ */
+mat4 mat4_transpose(const mat4 m) {
+    mat4 result;
+
+    int column = 0;
+    int row = 0;
+    for (column = 0; column < 4; ++column) {
+        for (row = 0; row < 4; ++row) {
+            result.m[column][row] = m.m[row][column];
+        }
+    }
+
+    return result;
+}
+
+/**
+ * 逆行列を計算し、resultへ書き込む
+ * 上2行と下2行の2x2小行列式を共有して余因子を求める。
+ */
+bool mat4_inverse_to(mat4 *result, const mat4 *m) {
+    // a[行][列]として読み替える
+#define A(row, column) (m->m[column][row])
+    const GLfloat s0 = A(0, 0) * A(1, 1) - A(1, 0) * A(0, 1);
+    const GLfloat s1 = A(0, 0) * A(1, 2) - A(1, 0) * A(0, 2);
+    const GLfloat s2 = A(0, 0) * A(1, 3) - A(1, 0) * A(0, 3);
+    const GLfloat s3 = A(0, 1) * A(1, 2) - A(1, 1) * A(0, 2);
+    const GLfloat s4 = A(0, 1) * A(1, 3) - A(1, 1) * A(0, 3);
+    const GLfloat s5 = A(0, 2) * A(1, 3) - A(1, 2) * A(0, 3);
+
+    const GLfloat c5 = A(2, 2) * A(3, 3) - A(3, 2) * A(2, 3);
+    const GLfloat c4 = A(2, 1) * A(3, 3) - A(3, 1) * A(2, 3);
+    const GLfloat c3 = A(2, 1) * A(3, 2) - A(3, 1) * A(2, 2);
+    const GLfloat c2 = A(2, 0) * A(3, 3) - A(3, 0) * A(2, 3);
+    const GLfloat c1 = A(2, 0) * A(3, 2) - A(3, 0) * A(2, 2);
+    const GLfloat c0 = A(2, 0) * A(3, 1) - A(3, 0) * A(2, 1);
+
+    const GLfloat det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0.0f) {
+        return false;
+    }
+    const GLfloat inv = 1.0f / det;
+
+    mat4 b;
+    b.m[0][0] = (A(1, 1) * c5 - A(1, 2) * c4 + A(1, 3) * c3) * inv;
+    b.m[1][0] = (-A(0, 1) * c5 + A(0, 2) * c4 - A(0, 3) * c3) * inv;
+    b.m[2][0] = (A(3, 1) * s5 - A(3, 2) * s4 + A(3, 3) * s3) * inv;
+    b.m[3][0] = (-A(2, 1) * s5 + A(2, 2) * s4 - A(2, 3) * s3) * inv;
+
+    b.m[0][1] = (-A(1, 0) * c5 + A(1, 2) * c2 - A(1, 3) * c1) * inv;
+    b.m[1][1] = (A(0, 0) * c5 - A(0, 2) * c2 + A(0, 3) * c1) * inv;
+    b.m[2][1] = (-A(3, 0) * s5 + A(3, 2) * s2 - A(3, 3) * s1) * inv;
+    b.m[3][1] = (A(2, 0) * s5 - A(2, 2) * s2 + A(2, 3) * s1) * inv;
+
+    b.m[0][2] = (A(1, 0) * c4 - A(1, 1) * c2 + A(1, 3) * c0) * inv;
+    b.m[1][2] = (-A(0, 0) * c4 + A(0, 1) * c2 - A(0, 3) * c0) * inv;
+    b.m[2][2] = (A(3, 0) * s4 - A(3, 1) * s2 + A(3, 3) * s0) * inv;
+    b.m[3][2] = (-A(2, 0) * s4 + A(2, 1) * s2 - A(2, 3) * s0) * inv;
+
+    b.m[0][3] = (-A(1, 0) * c3 + A(1, 1) * c1 - A(1, 2) * c0) * inv;
+    b.m[1][3] = (A(0, 0) * c3 - A(0, 1) * c1 + A(0, 2) * c0) * inv;
+    b.m[2][3] = (-A(3, 0) * s3 + A(3, 1) * s1 - A(3, 2) * s0) * inv;
+    b.m[3][3] = (A(2, 0) * s3 - A(2, 1) * s1 + A(2, 2) * s0) * inv;
+#undef A
+
+    // resultがmと同じでも良いよう、最後に書き込む
+    *result = b;
+    return true;
+}
+
+/**
+ * 3x3行列の逆行列を列ベクトルから求める
+ * 逆行列の各行は、列ベクトル同士の外積を行列式で割ったものとなる。
+ */
+static bool mat3_inverseRows(const vec3 c0, const vec3 c1, const vec3 c2, vec3 *rows) {
+    const vec3 r0 = vec3_cross(c1, c2);
+    const GLfloat det = vec3_dot(c0, r0);
+    if (det == 0.0f) {
+        return false;
+    }
+
+    const GLfloat inv = 1.0f / det;
+    const vec3 r1 = vec3_cross(c2, c0);
+    const vec3 r2 = vec3_cross(c0, c1);
+    rows[0] = vec3_create(r0.x * inv, r0.y * inv, r0.z * inv);
+    rows[1] = vec3_create(r1.x * inv, r1.y * inv, r1.z * inv);
+    rows[2] = vec3_create(r2.x * inv, r2.y * inv, r2.z * inv);
+    return true;
+}
+
+/**
+ * 最終行が(0, 0, 0, 1)の行列の逆行列を計算し、resultへ書き込む
+ */
+bool mat4_affineInverse_to(mat4 *result, const mat4 *m) {
+    vec3 rows[3];
+    if (!mat3_inverseRows( //
+            vec3_create(m->m[0][0], m->m[0][1], m->m[0][2]), //
+            vec3_create(m->m[1][0], m->m[1][1], m->m[1][2]), //
+            vec3_create(m->m[2][0], m->m[2][1], m->m[2][2]), rows)) {
+        return false;
+    }
+
+    // 移動は逆回転・逆拡縮してから反転する
+    const vec3 t = vec3_create(m->m[3][0], m->m[3][1], m->m[3][2]);
+    int i = 0;
+    for (i = 0; i < 3; ++i) {
+        result->m[0][i] = rows[i].x;
+        result->m[1][i] = rows[i].y;
+        result->m[2][i] = rows[i].z;
+        result->m[3][i] = -vec3_dot(rows[i], t);
+    }
+    result->m[0][3] = 0;
+    result->m[1][3] = 0;
+    result->m[2][3] = 0;
+    result->m[3][3] = 1;
+    return true;
+}
+
+/**
+ * アフィン変換行列の逆行列を計算し、resultへ書き込む
+ */
+bool affine_inverse_to(affine *result, const affine *a) {
+    vec3 rows[3];
+    if (!mat3_inverseRows( //
+            vec3_create(a->m[0][0], a->m[1][0], a->m[2][0]), //
+            vec3_create(a->m[0][1], a->m[1][1], a->m[2][1]), //
+            vec3_create(a->m[0][2], a->m[1][2], a->m[2][2]), rows)) {
+        return false;
+    }
+
+    const vec3 t = vec3_create(a->m[0][3], a->m[1][3], a->m[2][3]);
+    int i = 0;
+    for (i = 0; i < 3; ++i) {
+        result->m[i][0] = rows[i].x;
+        result->m[i][1] = rows[i].y;
+        result->m[i][2] = rows[i].z;
+        result->m[i][3] = -vec3_dot(rows[i], t);
+    }
+    return true;
+}
+
+/**
+ * 法線の変換行列を取得する
+ * 逆行列の転置のため、逆行列の行がそのまま列となる。
+ */
+mat3 mat4_normalMatrix(const mat4 *m) {
+    mat3 result;
+    vec3 rows[3];
+
+    if (!mat3_inverseRows( //
+            vec3_create(m->m[0][0], m->m[0][1], m->m[0][2]), //
+            vec3_create(m->m[1][0], m->m[1][1], m->m[1][2]), //
+            vec3_create(m->m[2][0], m->m[2][1], m->m[2][2]), rows)) {
+        // 潰れた行列の場合は3x3部分をそのまま返す
+        int column = 0;
+        for (column = 0; column < 3; ++column) {
+            result.m[column][0] = m->m[column][0];
+            result.m[column][1] = m->m[column][1];
+            result.m[column][2] = m->m[column][2];
+        }
+        return result;
+    }
+
+    int i = 0;
+    for (i = 0; i < 3; ++i) {
+        result.m[i][0] = rows[i].x;
+        result.m[i][1] = rows[i].y;
+        result.m[i][2] = rows[i].z;
+    }
+    return result;
+}
+
+/**
+ * クォータニオンをSIMDレジスタへ読み込む
+ */
+static inline simd4f quat_load(const quat *q) {
+    return simd4f_loadu(&q->x);
+}
+
+/**
+ * SIMDレジスタからクォータニオンを取り出す
+ */
+static inline quat quat_store(const simd4f v) {
+    quat result;
+    simd4f_storeu(&result.x, v);
+    return result;
+}
+
+/**
+ * 4要素の内積を計算する
+ */
+static inline GLfloat quat_dotSimd(const simd4f a, const simd4f b) {
+    float v[4];
+    simd4f_storeu(v, simd4f_mul(a, b));
+    return (v[0] + v[1]) + (v[2] + v[3]);
+}
+
+/**
+ * 単位クォータニオンを生成する
+ */
+quat quat_identity() {
+    quat result = { 0, 0, 0, 1 };
+    return result;
+}
+
+/**
+ * クォータニオンの積a × bを計算する
+ * aの各要素でbの並べ替えを重み付けして加算する。
+ */
+quat quat_multiply(const quat a, const quat b) {
+    simd4f r = simd4f_mul(simd4f_splat(a.w), simd4f_set(b.x, b.y, b.z, b.w));
+    r = simd4f_madd(simd4f_splat(a.x), simd4f_set(b.w, -b.z, b.y, -b.x), r);
+    r = simd4f_madd(simd4f_splat(a.y), simd4f_set(b.z, b.w, -b.x, -b.y), r);
+    r = simd4f_madd(simd4f_splat(a.z), simd4f_set(-b.y, b.x, b.w, -b.z), r);
+    return quat_store(r);
+}
+
+/**
+ * 共役クォータニオンを取得する
+ */
+quat quat_conjugate(const quat q) {
+    quat result = { -q.x, -q.y, -q.z, q.w };
+    return result;
+}
+
+/**
+ * クォータニオンの内積を計算する
+ */
+GLfloat quat_dot(const quat a, const quat b) {
+    return (a.x * b.x + a.y * b.y) + (a.z * b.z + a.w * b.w);
+}
+
+/**
+ * クォータニオンを正規化する
+ */
+quat quat_normalize(const quat q) {
+    const simd4f v = quat_load(&q);
+    return quat_store(simd4f_mul(v, simd4f_splat(fastmath_rsqrt(quat_dotSimd(v, v)))));
+}
+
+/**
+ * 線形補間して正規化する
+ */
+quat quat_nlerp(const quat a, const quat b, const GLfloat t) {
+    const simd4f va = quat_load(&a);
+    simd4f vb = quat_load(&b);
+
+    // 遠回りにならないよう、同じ半球へ揃える
+    if (quat_dotSimd(va, vb) < 0) {
+        vb = simd4f_sub(simd4f_splat(0), vb);
+    }
+
+    const simd4f v = simd4f_madd(simd4f_sub(vb, va), simd4f_splat(t), va);
+    return quat_store(simd4f_mul(v, simd4f_splat(fastmath_rsqrt(quat_dotSimd(v, v)))));
+}
+
+/**
+ * 球面線形補間を行う
+ */
+quat quat_slerp(const quat a, const quat b, const GLfloat t) {
+    const simd4f va = quat_load(&a);
+    simd4f vb = quat_load(&b);
+
+    GLfloat cosTheta = quat_dotSimd(va, vb);
+    if (cosTheta < 0) {
+        vb = simd4f_sub(simd4f_splat(0), vb);
+        cosTheta = -cosTheta;
+    }
+
+    // ほぼ同じ回転ではsinθが0に近づき不安定になる
+    if (cosTheta > 0.9995f) {
+        return quat_nlerp(a, quat_store(vb), t);
+    }
+
+    const GLfloat theta = acosf(cosTheta);
+    const GLfloat invSin = 1.0f / fastmath_sin(theta);
+    const GLfloat wa = fastmath_sin((1.0f - t) * theta) * invSin;
+    const GLfloat wb = fastmath_sin(t * theta) * invSin;
+    return quat_store(simd4f_madd(va, simd4f_splat(wa), simd4f_mul(vb, simd4f_splat(wb))));
+}
+
+/**
+ * ベクトルを回転する
+ * v' = v + 2w(q × v) + 2q × (q × v)
+ */
+vec3 quat_transformVector(const quat q, const vec3 v) {
+    const vec3 u = vec3_create(q.x, q.y, q.z);
+    const vec3 c = vec3_cross(u, v);
+    const vec3 t = vec3_create(c.x * 2.0f, c.y * 2.0f, c.z * 2.0f);
+    const vec3 c2 = vec3_cross(u, t);
+    return vec3_create(v.x + q.w * t.x + c2.x, v.y + q.w * t.y + c2.y, v.z + q.w * t.z + c2.z);
+}
+
+/**
+ * 回転クォータニオンから回転行列を生成する
+ */
+mat4 mat4_fromQuat(const quat q) {
+    mat4 result;
+
+    const GLfloat x2 = q.x * 2.0f;
+    const GLfloat y2 = q.y * 2.0f;
+    const GLfloat z2 = q.z * 2.0f;
+    const GLfloat xx = q.x * x2;
+    const GLfloat yy = q.y * y2;
+    const GLfloat zz = q.z * z2;
+    const GLfloat xy = q.x * y2;
+    const GLfloat xz = q.x * z2;
+    const GLfloat yz = q.y * z2;
+    const GLfloat wx = q.w * x2;
+    const GLfloat wy = q.w * y2;
+    const GLfloat wz = q.w * z2;
+
+    result.m[0][0] = 1.0f - (yy + zz);
+    result.m[0][1] = xy + wz;
+    result.m[0][2] = xz - wy;
+    result.m[0][3] = 0;
+
+    result.m[1][0] = xy - wz;
+    result.m[1][1] = 1.0f - (xx + zz);
+    result.m[1][2] = yz + wx;
+    result.m[1][3] = 0;
+
+    result.m[2][0] = xz + wy;
+    result.m[2][1] = yz - wx;
+    result.m[2][2] = 1.0f - (xx + yy);
+    result.m[2][3] = 0;
+
+    result.m[3][0] = 0;
+    result.m[3][1] = 0;
+    result.m[3][2] = 0;
+    result.m[3][3] = 1;
+
+    return result;
+}
+
+/**
+ * 回転 → 移動の順に適用するデュアルクォータニオンを生成する
+ */
+dualquat dualquat_create(const quat rotation, const vec3 translation) {
+    dualquat result;
+    const quat t = { translation.x * 0.5f, translation.y * 0.5f, translation.z * 0.5f, 0 };
+
+    result.real = rotation;
+    result.dual = quat_multiply(t, rotation);
+    return result;
+}
+
+/**
+ * デュアルクォータニオンの積a × bを計算する
+ */
+dualquat dualquat_multiply(const dualquat a, const dualquat b) {
+    dualquat result;
+    const quat d0 = quat_multiply(a.real, b.dual);
+    const quat d1 = quat_multiply(a.dual, b.real);
+
+    result.real = quat_multiply(a.real, b.real);
+    result.dual = quat_store(simd4f_add(quat_load(&d0), quat_load(&d1)));
+    return result;
+}
+
+/**
+ * 重み付きで補間する
+ */
+dualquat dualquat_blend(const dualquat *dqs, const GLfloat *weights, const GLuint num) {
+    assert(num > 0);
+
+    const simd4f pivot = quat_load(&dqs[0].real);
+    simd4f real = simd4f_splat(0);
+    simd4f dual = simd4f_splat(0);
+
+    GLuint i = 0;
+    for (i = 0; i < num; ++i) {
+        const simd4f r = quat_load(&dqs[i].real);
+        const simd4f d = quat_load(&dqs[i].dual);
+
+        // 先頭の姿勢と逆の半球にある場合は符号を反転して加算する
+        const GLfloat w = quat_dotSimd(pivot, r) < 0 ? -weights[i] : weights[i];
+        real = simd4f_madd(r, simd4f_splat(w), real);
+        dual = simd4f_madd(d, simd4f_splat(w), dual);
+    }
+
+    // 回転部分の長さで正規化する
+    const simd4f inv = simd4f_splat(fastmath_rsqrt(quat_dotSimd(real, real)));
+
+    dualquat result;
+    result.real = quat_store(simd4f_mul(real, inv));
+    result.dual = quat_store(simd4f_mul(dual, inv));
+    return result;
+}
+
+/**
+ * 移動量を取得する
+ * t = 2 × dual × conj(real)
+ */
+vec3 dualquat_getTranslation(const dualquat dq) {
+    const quat t = quat_multiply(dq.dual, quat_conjugate(dq.real));
+    return vec3_create(t.x * 2.0f, t.y * 2.0f, t.z * 2.0f);
+}
+
+/**
+ * 位置ベクトルを変換する
+ */
+vec3 dualquat_transformPoint(const dualquat dq, const vec3 p) {
+    const vec3 r = quat_transformVector(dq.real, p);
+    const vec3 t = dualquat_getTranslation(dq);
+    return vec3_create(r.x + t.x, r.y + t.y, r.z + t.z);
+}
+
+/**
+ * デュアルクォータニオンから変換行列を生成する
+ */
+mat4 mat4_fromDualquat(const dualquat dq) {
+    mat4 result = mat4_fromQuat(dq.real);
+    const vec3 t = dualquat_getTranslation(dq);
+
+    result.m[3][0] = t.x;
+    result.m[3][1] = t.y;
+    result.m[3][2] = t.z;
+    return result;
+}
+
 /**
  * 視点変換行列を生成する
  */
@@ -202,7 +762,10 @@ mat4 mat4_perspective(const GLfloat near, const GLfloat far, const GLfloat fovY_
     mat4 result;
     memset(result.m, 0x00, sizeof(mat4));
 
-    const GLfloat f = (GLfloat) (1.0 / (tan(degree2radian(fovY_degree)) / 2.0)); // 1/tan(x) == cot(x)
+    GLfloat s;
+    GLfloat c;
+    fastmath_sincos(degree2radianf(fovY_degree), &s, &c);
+    const GLfloat f = 2.0f * c / s; // 1/(tan(x)/2) == 2cot(x)
 
     result.m[0][0] = f / aspect;
     result.m[1][1] = f;
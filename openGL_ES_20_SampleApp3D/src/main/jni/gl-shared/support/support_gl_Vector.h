@@ -10,7 +10,7 @@
 /**
  * 360度系からラジアン角度に修正する
  */
-#define degree2radian(degree) ((degree * M_PI) / 180.0)
+#define degree2radian(degree) (((degree) * M_PI) / 180.0)
 
 /**
  * 2次元ベクトルを保持する構造体
@@ -74,11 +74,56 @@ typedef struct vec4 {
 
 /**
  * 行列を保持する構造体
+ * mallocで確保した構造体にも埋め込まれるため、16byte境界には揃えない。SIMD演算側では境界を仮定しない。
  */
 typedef struct mat4 {
     GLfloat m[4][4];
 } mat4;
 
+/**
+ * 回転を表すクォータニオン
+ * 単位クォータニオンとして扱う
+ */
+typedef struct quat {
+    GLfloat x;
+    GLfloat y;
+    GLfloat z;
+    GLfloat w;
+} quat;
+
+/**
+ * デュアルクォータニオン
+ * 回転と移動を表し、スキニングで複数の姿勢を補間しても体積が潰れない。
+ */
+typedef struct dualquat {
+    /**
+     * 回転
+     */
+    quat real;
+
+    /**
+     * 移動 × 回転 × 0.5
+     */
+    quat dual;
+} dualquat;
+
+/**
+ * 3x3行列（列優先）
+ * 法線行列としてglUniformMatrix3fvへそのまま渡せる。
+ */
+typedef struct mat3 {
+    GLfloat m[3][3];
+} mat3;
+
+/**
+ * アフィン変換行列（3行4列）
+ * 行ごとに(回転・拡縮の3要素, 移動)を保持する。
+ * 最終行(0, 0, 0, 1)を省略するため、mat4より16byte小さい。
+ */
+typedef struct affine {
+    GLfloat m[3][4];
+} affine;
+
 /**
  * 2次元ベクトルを生成する
  */
@@ -139,6 +184,159 @@ extern mat4 mat4_rotate(const vec3 axis, const GLfloat rotate);
  */
 extern mat4 mat4_multiply(const mat4 a, const mat4 b);
 
+/**
+ * 行列の乗算を行い、resultへ書き込む
+ * 構造体のコピーを行わないため、描画ループではこちらを利用する。
+ * resultはa / bと同じアドレスを指定しても良い。
+ */
+extern void mat4_multiply_to(mat4 *result, const mat4 *a, const mat4 *b);
+
+/**
+ * 行列の乗算をスカラー演算で行う
+ * SIMD版の検証用
+ */
+extern mat4 mat4_multiplyReference(const mat4 a, const mat4 b);
+
+/**
+ * 位置ベクトルを行列で変換する
+ * w=1として扱い、結果のwは無視する
+ */
+extern vec3 mat4_transformPoint(const mat4 m, const vec3 p);
+
+/**
+ * アフィン変換行列を4x4行列へ変換する
+ */
+extern mat4 mat4_fromAffine(const affine *a);
+
+/**
+ * 位置・回転・拡縮からアフィン変換行列を生成する
+ * 拡縮 → 回転 → 移動の順に適用される。
+ */
+extern affine affine_create(const vec3 position, const quat rotation, const vec3 scale);
+
+/**
+ * アフィン変換行列の積a × bを計算し、resultへ書き込む
+ * resultはa / bと同じアドレスでも良い。
+ */
+extern void affine_multiply_to(affine *result, const affine *a, const affine *b);
+
+/**
+ * 回転クォータニオンを生成する
+ * 回転の向きはmat4_rotate()と同じとなる。
+ */
+extern quat quat_rotate(const vec3 axis, const GLfloat rotate);
+
+/**
+ * 転置行列を生成する
+ */
+extern mat4 mat4_transpose(const mat4 m);
+
+/**
+ * 逆行列を計算し、resultへ書き込む
+ * 行列式が0の場合はfalseを返し、resultは変更しない。
+ */
+extern bool mat4_inverse_to(mat4 *result, const mat4 *m);
+
+/**
+ * 最終行が(0, 0, 0, 1)の行列の逆行列を計算し、resultへ書き込む
+ * 3x3部分の逆行列と移動の変換のみで求めるため、mat4_inverse_to()より軽い。
+ * 行列式が0の場合はfalseを返し、resultは変更しない。
+ */
+extern bool mat4_affineInverse_to(mat4 *result, const mat4 *m);
+
+/**
+ * アフィン変換行列の逆行列を計算し、resultへ書き込む
+ * 行列式が0の場合はfalseを返し、resultは変更しない。
+ */
+extern bool affine_inverse_to(affine *result, const affine *a);
+
+/**
+ * 法線の変換行列（3x3部分の逆転置行列）を取得する
+ * 非一様な拡縮を含む行列でも法線が面に垂直なまま変換される。
+ */
+extern mat3 mat4_normalMatrix(const mat4 *m);
+
+/**
+ * 単位クォータニオンを生成する
+ */
+extern quat quat_identity();
+
+/**
+ * クォータニオンの積a × bを計算する
+ * 回転はb→aの順番で適用される。mat4_fromQuat(a × b) == mat4_fromQuat(a) × mat4_fromQuat(b)となる。
+ */
+extern quat quat_multiply(const quat a, const quat b);
+
+/**
+ * 共役クォータニオンを取得する
+ * 単位クォータニオンでは逆回転となる。
+ */
+extern quat quat_conjugate(const quat q);
+
+/**
+ * クォータニオンの内積を計算する
+ */
+extern GLfloat quat_dot(const quat a, const quat b);
+
+/**
+ * クォータニオンを正規化する
+ */
+extern quat quat_normalize(const quat q);
+
+/**
+ * 線形補間して正規化する
+ * 角速度は一定にならないが、slerpより軽く、ブレンドの重みが多い場合にも使える。
+ */
+extern quat quat_nlerp(const quat a, const quat b, const GLfloat t);
+
+/**
+ * 球面線形補間を行う
+ * 2つの回転が近い場合はnlerpで代用する。
+ */
+extern quat quat_slerp(const quat a, const quat b, const GLfloat t);
+
+/**
+ * ベクトルを回転する
+ */
+extern vec3 quat_transformVector(const quat q, const vec3 v);
+
+/**
+ * 回転クォータニオンから回転行列を生成する
+ */
+extern mat4 mat4_fromQuat(const quat q);
+
+/**
+ * 回転 → 移動の順に適用するデュアルクォータニオンを生成する
+ */
+extern dualquat dualquat_create(const quat rotation, const vec3 translation);
+
+/**
+ * デュアルクォータニオンの積a × bを計算する
+ * 変換はb→aの順番で適用される。
+ */
+extern dualquat dualquat_multiply(const dualquat a, const dualquat b);
+
+/**
+ * 重み付きで補間する(Dual quaternion Linear Blending)
+ * 回転の向きが反転しないよう、先頭の姿勢と半球を揃えてから加算する。
+ */
+extern dualquat dualquat_blend(const dualquat *dqs, const GLfloat *weights, const GLuint num);
+
+/**
+ * 移動量を取得する
+ */
+extern vec3 dualquat_getTranslation(const dualquat dq);
+
+/**
+ * 位置ベクトルを変換する
+ */
+extern vec3 dualquat_transformPoint(const dualquat dq, const vec3 p);
+
+/**
+ * デュアルクォータニオンから変換行列を生成する
+ */
+extern mat4 mat4_fromDualquat(const dualquat dq);
+
 /**
  * 視点変換行列を生成する
  */
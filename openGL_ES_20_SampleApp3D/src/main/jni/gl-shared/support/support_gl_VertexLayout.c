@@ -0,0 +1,349 @@
+/*
+ * support_gl_VertexLayout.c
+ */
+
+#include    "support.h"
+
+#ifndef __APPLE__
+#include    <EGL/egl.h>
+#endif
+
+/**
+ * GL_OES_vertex_array_objectの関数
+ */
+typedef void (GL_APIENTRY *VertexLayout_genFunction)(GLsizei n, GLuint *arrays);
+typedef void (GL_APIENTRY *VertexLayout_bindFunction)(GLuint array);
+typedef void (GL_APIENTRY *VertexLayout_deleteFunction)(GLsizei n, const GLuint *arrays);
+
+/**
+ * VAOを使わない場合に、GL側へ設定済みの状態を保持する
+ * GLの状態はコンテキストで1つのため、全ての構成で共有する。
+ */
+typedef struct VertexLayoutCache {
+    /**
+     * 保持している状態が正しい場合はtrue
+     * VertexLayout_unbind後はGL側の状態が分からないため、次のバインドで全て設定する
+     */
+    bool valid;
+
+    /**
+     * バインド中のインデックスバッファ
+     * GL_ARRAY_BUFFERは他の処理からも頻繁にバインドされるため保持せず、属性を設定する直前に必ずバインドする
+     */
+    GLuint element_array_buffer;
+
+    /**
+     * 有効な属性のlocation（bit）
+     */
+    GLuint enabled;
+
+    /**
+     * locationごとに設定済みの属性と、設定時の頂点バッファ
+     */
+    VertexLayoutAttribute attributes[VERTEXLAYOUT_LOCATIONS_MAX];
+    GLuint attribute_buffers[VERTEXLAYOUT_LOCATIONS_MAX];
+} VertexLayoutCache;
+
+/**
+ * 関数の読み込み状態
+ * 0=未確認 1=対応 -1=非対応
+ */
+static int g_vao_support = 0;
+static VertexLayout_genFunction g_gen_vertex_arrays = NULL;
+static VertexLayout_bindFunction g_bind_vertex_array = NULL;
+static VertexLayout_deleteFunction g_delete_vertex_arrays = NULL;
+
+/**
+ * バインド中のVAO
+ */
+static GLuint g_bound_vertex_array = 0;
+
+/**
+ * VAOを使わない場合のGL側の状態
+ */
+static VertexLayoutCache g_cache = { false };
+
+/**
+ * 追跡するlocation数
+ */
+static GLint g_locations_num = 0;
+
+/**
+ * 発行したGL呼び出し回数
+ */
+static GLuint g_state_changes = 0;
+
+/**
+ * GL_OES_vertex_array_objectの関数を取得する
+ * 対応していない場合はfalseを返す。
+ */
+static bool VertexLayout_loadVertexArrayObject() {
+    if (g_vao_support) {
+        return g_vao_support > 0;
+    }
+
+    GLint maxAttributes = 0;
+    glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttributes);
+    g_locations_num = maxAttributes < VERTEXLAYOUT_LOCATIONS_MAX ? maxAttributes : VERTEXLAYOUT_LOCATIONS_MAX;
+
+    g_vao_support = -1;
+    if (ES20_hasExtension("GL_OES_vertex_array_object")) {
+#ifdef __APPLE__
+        g_gen_vertex_arrays = (VertexLayout_genFunction) glGenVertexArraysOES;
+        g_bind_vertex_array = (VertexLayout_bindFunction) glBindVertexArrayOES;
+        g_delete_vertex_arrays = (VertexLayout_deleteFunction) glDeleteVertexArraysOES;
+#else
+        g_gen_vertex_arrays = (VertexLayout_genFunction) eglGetProcAddress("glGenVertexArraysOES");
+        g_bind_vertex_array = (VertexLayout_bindFunction) eglGetProcAddress("glBindVertexArrayOES");
+        g_delete_vertex_arrays = (VertexLayout_deleteFunction) eglGetProcAddress("glDeleteVertexArraysOES");
+#endif
+        if (g_gen_vertex_arrays && g_bind_vertex_array && g_delete_vertex_arrays) {
+            g_vao_support = 1;
+        }
+    }
+
+    __logf("VertexLayout locations(%d) vao(%s)", g_locations_num, g_vao_support > 0 ? "true" : "false");
+    return g_vao_support > 0;
+}
+
+/**
+ * 属性が同じ設定であればtrueを返す
+ */
+static bool VertexLayout_equalsAttribute(const VertexLayoutAttribute *a, const VertexLayoutAttribute *b) {
+    return a->size == b->size && a->type == b->type && a->normalized == b->normalized && a->stride == b->stride && a->offset == b->offset && a->buffer == b->buffer;
+}
+
+/**
+ * 構成の全ての状態を設定する
+ * VAOへの記録に利用する。
+ */
+static void VertexLayout_apply(const VertexLayout *layout) {
+    GLuint arrayBuffer = layout->vertices_buffer;
+    GLuint i = 0;
+
+    glBindBuffer(GL_ARRAY_BUFFER, arrayBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, layout->indices_buffer);
+    g_state_changes += 2;
+
+    for (i = 0; i < layout->attributes_num; ++i) {
+        const VertexLayoutAttribute *attr = &layout->attributes[i];
+        if (attr->buffer != arrayBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, attr->buffer);
+            arrayBuffer = attr->buffer;
+            ++g_state_changes;
+        }
+        glEnableVertexAttribArray(attr->location);
+        glVertexAttribPointer(attr->location, attr->size, attr->type, attr->normalized, attr->stride, (GLvoid*) attr->offset);
+        g_state_changes += 2;
+    }
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+/**
+ * 前回バインドした状態と比較し、変化した状態だけを設定する
+ */
+static void VertexLayout_applyDiff(const VertexLayout *layout) {
+    VertexLayoutCache *cache = &g_cache;
+    GLuint arrayBuffer = 0;
+    bool arrayBufferBound = false;
+    GLuint enabled = 0;
+    GLuint unknown = 0;
+    GLuint i = 0;
+
+    if (!cache->valid) {
+        // GL側の状態が分からないため、全て設定し直すように初期化する
+        memset(cache, 0x00, sizeof(VertexLayoutCache));
+        cache->element_array_buffer = (GLuint) -1;
+        unknown = (1u << g_locations_num) - 1;
+        for (i = 0; i < VERTEXLAYOUT_LOCATIONS_MAX; ++i) {
+            cache->attribute_buffers[i] = (GLuint) -1;
+        }
+        cache->valid = true;
+    }
+
+    if (cache->element_array_buffer != layout->indices_buffer) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, layout->indices_buffer);
+        cache->element_array_buffer = layout->indices_buffer;
+        ++g_state_changes;
+    }
+
+    for (i = 0; i < layout->attributes_num; ++i) {
+        const VertexLayoutAttribute *attr = &layout->attributes[i];
+        const GLuint bit = 1u << attr->location;
+        enabled |= bit;
+
+        if (!(cache->enabled & bit)) {
+            glEnableVertexAttribArray(attr->location);
+            ++g_state_changes;
+        }
+
+        // 設定時の頂点バッファも属性の一部として比較する
+        if (cache->attribute_buffers[attr->location] != attr->buffer || !VertexLayout_equalsAttribute(&cache->attributes[attr->location], attr)) {
+            // 呼び出し内で同じバッファをバインド済みの場合のみ省略する
+            if (!arrayBufferBound || arrayBuffer != attr->buffer) {
+                glBindBuffer(GL_ARRAY_BUFFER, attr->buffer);
+                arrayBuffer = attr->buffer;
+                arrayBufferBound = true;
+                ++g_state_changes;
+            }
+            glVertexAttribPointer(attr->location, attr->size, attr->type, attr->normalized, attr->stride, (GLvoid*) attr->offset);
+            cache->attributes[attr->location] = *attr;
+            cache->attribute_buffers[attr->location] = attr->buffer;
+            ++g_state_changes;
+        }
+    }
+
+    // 構成に含まれない属性を無効にする
+    {
+        const GLuint disabled = (cache->enabled | unknown) & ~enabled;
+        for (i = 0; i < (GLuint) g_locations_num; ++i) {
+            if (disabled & (1u << i)) {
+                glDisableVertexAttribArray(i);
+                ++g_state_changes;
+            }
+        }
+    }
+    cache->enabled = enabled;
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+/**
+ * 頂点属性の構成を生成する
+ */
+VertexLayout* VertexLayout_create(const GLuint vertices_buffer, const GLuint indices_buffer) {
+    VertexLayout *result = calloc(1, sizeof(VertexLayout));
+
+    result->vertices_buffer = vertices_buffer;
+    result->indices_buffer = indices_buffer;
+    result->dirty = true;
+
+    if (VertexLayout_loadVertexArrayObject()) {
+        (*g_gen_vertex_arrays)(1, &result->vertex_array);
+        assert(result->vertex_array != 0);
+    }
+
+    return result;
+}
+
+/**
+ * 頂点属性を追加する
+ */
+void VertexLayout_addAttribute(VertexLayout *layout, const GLint location, const GLint size, const GLenum type, const GLboolean normalized, const GLsizei stride, const GLintptr offset) {
+    VertexLayout_addBufferAttribute(layout, layout->vertices_buffer, location, size, type, normalized, stride, offset);
+}
+
+/**
+ * 構成の頂点バッファとは別のバッファから読み出す頂点属性を追加する
+ */
+void VertexLayout_addBufferAttribute(VertexLayout *layout, const GLuint buffer, const GLint location, const GLint size, const GLenum type, const GLboolean normalized, const GLsizei stride, const GLintptr offset) {
+    assert(location >= 0 && location < VERTEXLAYOUT_LOCATIONS_MAX);
+
+    GLuint index = 0;
+    while (index < layout->attributes_num && layout->attributes[index].location != location) {
+        ++index;
+    }
+    assert(index < VERTEXLAYOUT_ATTRIBUTES_MAX);
+
+    VertexLayoutAttribute *attr = &layout->attributes[index];
+    attr->location = location;
+    attr->size = size;
+    attr->type = type;
+    attr->normalized = normalized;
+    attr->stride = stride;
+    attr->offset = offset;
+    attr->buffer = buffer;
+
+    if (index == layout->attributes_num) {
+        ++layout->attributes_num;
+    }
+    layout->dirty = true;
+}
+
+/**
+ * 頂点バッファ・インデックスバッファと頂点属性をバインドする
+ */
+void VertexLayout_bind(VertexLayout *layout) {
+    if (!layout->vertex_array) {
+        VertexLayout_applyDiff(layout);
+        return;
+    }
+
+    if (g_bound_vertex_array != layout->vertex_array) {
+        (*g_bind_vertex_array)(layout->vertex_array);
+        g_bound_vertex_array = layout->vertex_array;
+        ++g_state_changes;
+    }
+
+    // 初回と変更後のみVAOへ記録する
+    if (layout->dirty) {
+        VertexLayout_apply(layout);
+        layout->dirty = false;
+    }
+}
+
+/**
+ * 頂点属性の構成のバインドを解除する
+ */
+void VertexLayout_unbind() {
+    if (g_bound_vertex_array) {
+        (*g_bind_vertex_array)(0);
+        g_bound_vertex_array = 0;
+        ++g_state_changes;
+    }
+    g_cache.valid = false;
+}
+
+/**
+ * VertexLayoutを介さずにtargetへバッファをバインドする前に呼び出す
+ */
+void VertexLayout_invalidateBuffer(const GLenum target) {
+    // GL_ARRAY_BUFFERはVAOの状態に含まれず、キャッシュもしていない
+    if (target != GL_ELEMENT_ARRAY_BUFFER) {
+        return;
+    }
+
+    // バインド中のVAOのインデックスバッファが書き換わらないよう、先に解除する
+    if (g_bound_vertex_array) {
+        (*g_bind_vertex_array)(0);
+        g_bound_vertex_array = 0;
+        ++g_state_changes;
+    }
+    g_cache.element_array_buffer = (GLuint) -1;
+}
+
+/**
+ * VAOを利用している場合はtrueを返す
+ */
+bool VertexLayout_hasVertexArrayObject() {
+    return VertexLayout_loadVertexArrayObject();
+}
+
+/**
+ * 前回の呼び出し以降に発行した頂点属性・バッファ関連のGL呼び出し回数を返す
+ */
+GLuint VertexLayout_takeStateChanges() {
+    const GLuint result = g_state_changes;
+    g_state_changes = 0;
+    return result;
+}
+
+/**
+ * 頂点属性の構成を解放する
+ */
+void VertexLayout_free(VertexLayout *layout) {
+    if (!layout) {
+        return;
+    }
+
+    if (layout->vertex_array) {
+        if (g_bound_vertex_array == layout->vertex_array) {
+            VertexLayout_unbind();
+        }
+        (*g_delete_vertex_arrays)(1, &layout->vertex_array);
+        assert(glGetError() == GL_NO_ERROR);
+    }
+
+    // 解放後に同じIDのバッファが生成される可能性があるため、保持している状態を破棄する
+    g_cache.valid = false;
+    free(layout);
+}
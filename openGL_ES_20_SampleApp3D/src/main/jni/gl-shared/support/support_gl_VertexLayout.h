@@ -0,0 +1,140 @@
+/*
+ * support_gl_VertexLayout.h
+ *
+ * メッシュ・描画パスごとの頂点属性の構成
+ * 頂点バッファ・インデックスバッファと属性の設定を初期化時に1度だけ記述し、描画時は1回の呼び出しでバインドする。
+ * GL_OES_vertex_array_objectに対応していればVAOへ記録し、対応していなければ
+ * 直前にバインドした状態と比較して、変化した属性だけを設定し直す。
+ *
+ * 比較に使う状態はVertexLayoutの外で変更されても検出できないため、以下を守る。
+ * ・glVertexAttribPointer・glEnableVertexAttribArray等を直接呼び出す前にVertexLayout_unbind()を呼び出す。
+ * ・GL_ELEMENT_ARRAY_BUFFERを直接バインドする前にVertexLayout_invalidateBuffer()を呼び出す。
+ *   supportのバッファ生成・StreamBuffer等はこれを内部で行う。
+ * ・GL_ARRAY_BUFFERはVAOの状態に含まれず、VertexLayout_bind()が属性の設定前に必ずバインドするため、自由にバインドしてよい。
+ */
+
+#ifndef SUPPORT_GL_VERTEXLAYOUT_H_
+#define SUPPORT_GL_VERTEXLAYOUT_H_
+
+/**
+ * 1つの構成に含められる最大属性数
+ */
+#define VERTEXLAYOUT_ATTRIBUTES_MAX     8
+
+/**
+ * 状態を追跡する属性のlocation数
+ * GL_MAX_VERTEX_ATTRIBSがこれより小さい場合はGL側の値に合わせる
+ */
+#define VERTEXLAYOUT_LOCATIONS_MAX      16
+
+/**
+ * 1つの頂点属性
+ * 引数の意味はglVertexAttribPointerと同じとなる
+ */
+typedef struct VertexLayoutAttribute {
+    GLint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei stride;
+
+    /**
+     * 頂点バッファ先頭からのオフセット（byte）
+     */
+    GLintptr offset;
+
+    /**
+     * 属性を読み出す頂点バッファ
+     */
+    GLuint buffer;
+} VertexLayoutAttribute;
+
+/**
+ * 頂点属性の構成
+ */
+typedef struct VertexLayout {
+    /**
+     * 頂点バッファ
+     * VertexLayout_addAttributeで追加した属性はこのバッファから読み出す
+     */
+    GLuint vertices_buffer;
+
+    /**
+     * インデックスバッファ
+     * インデックスを使わない場合は0
+     */
+    GLuint indices_buffer;
+
+    /**
+     * 頂点属性
+     */
+    VertexLayoutAttribute attributes[VERTEXLAYOUT_ATTRIBUTES_MAX];
+    GLuint attributes_num;
+
+    /**
+     * GL_OES_vertex_array_objectのVAO
+     * 対応していない場合は0
+     */
+    GLuint vertex_array;
+
+    /**
+     * VAOへ記録していない変更がある場合はtrue
+     */
+    bool dirty;
+} VertexLayout;
+
+/**
+ * 頂点属性の構成を生成する
+ * VAOに対応している場合はVAOも生成する。
+ */
+extern VertexLayout* VertexLayout_create(const GLuint vertices_buffer, const GLuint indices_buffer);
+
+/**
+ * 頂点属性を追加する
+ * 同じlocationを追加した場合は上書きする。
+ */
+extern void VertexLayout_addAttribute(VertexLayout *layout, const GLint location, const GLint size, const GLenum type, const GLboolean normalized, const GLsizei stride, const GLintptr offset);
+
+/**
+ * 構成の頂点バッファとは別のバッファから読み出す頂点属性を追加する
+ * 同じlocationを追加した場合は上書きする。
+ */
+extern void VertexLayout_addBufferAttribute(VertexLayout *layout, const GLuint buffer, const GLint location, const GLint size, const GLenum type, const GLboolean normalized, const GLsizei stride, const GLintptr offset);
+
+/**
+ * 頂点バッファ・インデックスバッファと頂点属性をバインドする
+ * 構成に含まれないlocationの属性は無効となる。
+ */
+extern void VertexLayout_bind(VertexLayout *layout);
+
+/**
+ * 頂点属性の構成のバインドを解除する
+ * VertexLayoutを使わずにglVertexAttribPointer・glBindBuffer等を呼び出す前に必ず呼び出す。
+ * バインド中にGL_ELEMENT_ARRAY_BUFFERを変更すると、VAOの内容が書き換わってしまう。
+ */
+extern void VertexLayout_unbind();
+
+/**
+ * VertexLayoutを介さずにtargetへバッファをバインドする前に呼び出す
+ * GL_ELEMENT_ARRAY_BUFFERの場合はVAOのバインドを解除し、保持しているインデックスバッファを破棄する。
+ * GL_ARRAY_BUFFERの場合は何もしない。
+ */
+extern void VertexLayout_invalidateBuffer(const GLenum target);
+
+/**
+ * VAOを利用している場合はtrueを返す
+ */
+extern bool VertexLayout_hasVertexArrayObject();
+
+/**
+ * 前回の呼び出し以降に発行した頂点属性・バッファ関連のGL呼び出し回数を返す
+ */
+extern GLuint VertexLayout_takeStateChanges();
+
+/**
+ * 頂点属性の構成を解放する
+ * バッファオブジェクトは解放しない。
+ */
+extern void VertexLayout_free(VertexLayout *layout);
+
+#endif /* SUPPORT_GL_VERTEXLAYOUT_H_ */
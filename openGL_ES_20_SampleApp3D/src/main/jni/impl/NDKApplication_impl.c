@@ -80,6 +80,9 @@ JNIEXPORT void JNICALL Java_com_eaglesakura_gles20_app_ndk_NDKApplication_initia
             app->platform = (void*) platform;
         }
 
+        // フレーム単位の一時領域を作成する
+        app->frame_arena = MemoryArena_create(64 * 1024);
+
         // 関数ポインタを設定する
         {
             jfieldID field_chapterNum = ndk_loadIntField(env, class_NDKApplication, "chapterNum");
@@ -139,6 +142,10 @@ JNIEXPORT void JNICALL Java_com_eaglesakura_gles20_app_ndk_NDKApplication_async(
 JNIEXPORT void JNICALL Java_com_eaglesakura_gles20_app_ndk_NDKApplication_rendering(JNIEnv *env, jobject _this) {
     GLApplication *app = (GLApplication*) (*env)->GetIntField(env, _this, field_GLApplication_ptr);
     assert(app != NULL);
+
+    // 前フレームの一時領域を巻き戻す
+    MemoryArena_reset(app->frame_arena);
+
     // サンプル関数に処理を行わせる
     (*app->rendering)(app);
 
@@ -159,6 +166,7 @@ JNIEXPORT void JNICALL Java_com_eaglesakura_gles20_app_ndk_NDKApplication_destro
 
     }
     // GLApplicationを廃棄する
+    MemoryArena_free(app->frame_arena);
     free(app->platform);
     free(app);
 }